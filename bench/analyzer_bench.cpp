@@ -0,0 +1,103 @@
+/**
+ * @file analyzer_bench.cpp
+ * @author agent
+ */
+
+#include "cpptoml.h"
+#include "meta/analyzers/analyzer.h"
+#include "meta/corpus/document.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * @param filters The filter chain, tokenizer first
+ * @return a configuration for a unigram analyzer using that chain
+ */
+std::shared_ptr<cpptoml::table>
+    make_analyzer_config(const std::vector<std::string>& filters)
+{
+    auto chain = cpptoml::make_table_array();
+    for (const auto& type : filters)
+    {
+        auto filter = cpptoml::make_table();
+        filter->insert("type", type);
+        if (type == "length")
+        {
+            filter->insert<int64_t>("min", 2);
+            filter->insert<int64_t>("max", 35);
+        }
+        else if (type == "icu")
+        {
+            filter->insert("id", "Any-Latin; Latin-ASCII");
+        }
+        chain->push_back(filter);
+    }
+
+    auto analyzer = cpptoml::make_table();
+    analyzer->insert("method", "ngram-word");
+    analyzer->insert<int64_t>("ngram", 1);
+    analyzer->insert("filter", chain);
+
+    auto analyzers = cpptoml::make_table_array();
+    analyzers->push_back(analyzer);
+
+    auto config = cpptoml::make_table();
+    config->insert("analyzers", analyzers);
+    return config;
+}
+}
+
+void analyzer_benchmarks(harness& h, const std::string&)
+{
+    if (!h.selected("analyzers/"))
+        return;
+
+    random_engine rng{47};
+    auto words = make_words(20000, rng);
+    zipf_distribution dist{words.size()};
+
+    std::vector<corpus::document> docs(1000);
+    uint64_t bytes = 0;
+    for (auto& doc : docs)
+    {
+        auto text = make_text(words, dist, 200, rng);
+        bytes += text.size();
+        doc.content(text);
+    }
+
+    const std::vector<std::pair<std::string, std::vector<std::string>>>
+        chains = {{"whitespace", {"whitespace-tokenizer"}},
+                  {"whitespace-lowercase",
+                   {"whitespace-tokenizer", "lowercase"}},
+                  {"icu", {"icu-tokenizer"}},
+                  {"icu-lowercase-alpha-length-porter2",
+                   {"icu-tokenizer", "lowercase", "alpha", "length",
+                    "porter2-filter"}},
+                  {"icu-transliterate-lowercase",
+                   {"icu-tokenizer", "icu", "lowercase"}}};
+
+    for (const auto& chain : chains)
+    {
+        auto name = "analyzers/" + chain.first;
+        if (!h.selected(name))
+            continue;
+
+        auto ana = analyzers::load(*make_analyzer_config(chain.second));
+        h.run(name, docs.size(), [&]()
+              {
+                  uint64_t features = 0;
+                  for (const auto& doc : docs)
+                      features += ana->analyze<uint64_t>(doc).size();
+                  do_not_optimize(features);
+              });
+    }
+}
+}
+}
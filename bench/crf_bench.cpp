@@ -0,0 +1,119 @@
+/**
+ * @file crf_bench.cpp
+ * @author agent
+ */
+
+#include <unordered_map>
+
+#include "meta/io/filesystem.h"
+#include "meta/sequence/crf/crf.h"
+#include "meta/sequence/crf/tagger.h"
+#include "meta/util/shim.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * Generates labeled sequences whose observation features are correlated
+ * with their labels, so training does real work.
+ */
+std::vector<sequence::sequence> make_sequences(uint64_t count,
+                                               uint64_t length,
+                                               uint64_t num_labels,
+                                               random_engine& rng)
+{
+    const uint64_t features_per_label = 1000;
+    std::uniform_int_distribution<uint32_t> label{
+        0, static_cast<uint32_t>(num_labels - 1)};
+    zipf_distribution feature{features_per_label};
+    std::uniform_int_distribution<uint64_t> noise{
+        0, num_labels * features_per_label - 1};
+
+    // the crf expects feature ids to be dense, as a sequence_analyzer
+    // would produce, so renumber them in order of first appearance
+    std::unordered_map<uint64_t, uint64_t> ids;
+    auto dense_id = [&](uint64_t raw)
+    {
+        auto it = ids.find(raw);
+        if (it == ids.end())
+            it = ids.emplace(raw, ids.size()).first;
+        return sequence::feature_id{it->second};
+    };
+
+    std::vector<sequence::sequence> seqs(count);
+    for (auto& seq : seqs)
+    {
+        for (uint64_t i = 0; i < length; ++i)
+        {
+            auto lbl = label(rng);
+            sequence::observation obs{sequence::symbol_t{"w"},
+                                      sequence::tag_t{std::to_string(lbl)}};
+            obs.label(label_id{lbl});
+
+            sequence::observation::feature_vector feats;
+            for (uint64_t f = 0; f < 8; ++f)
+                feats.emplace_back(
+                    dense_id(lbl * features_per_label + feature(rng)), 1.0);
+            for (uint64_t f = 0; f < 4; ++f)
+                feats.emplace_back(dense_id(noise(rng)), 1.0);
+            obs.features(std::move(feats));
+
+            seq.add_observation(std::move(obs));
+        }
+    }
+    return seqs;
+}
+}
+
+void crf_benchmarks(harness& h, const std::string& dir)
+{
+    if (!h.selected("crf/"))
+        return;
+
+    random_engine rng{47};
+    auto seqs = make_sequences(300, 20, 8, rng);
+
+    // the scorer that runs forward-backward is private to the crf, so
+    // measure it through a single training epoch (which also includes the
+    // learning rate calibration on a small sample)
+    sequence::crf::parameters params;
+    params.max_iters = 1;
+    params.calibration_samples = 50;
+    params.calibration_trials = 2;
+
+    auto prefix = dir + "/crf";
+    std::unique_ptr<sequence::crf> model;
+    h.run_with_setup("crf/train-epoch", seqs.size(),
+                     [&]()
+                     {
+                         model = nullptr;
+                         filesystem::remove_all(prefix);
+                         model = make_unique<sequence::crf>(prefix);
+                     },
+                     [&]()
+                     {
+                         do_not_optimize(model->train(params, seqs));
+                     });
+
+    if (!model)
+    {
+        model = make_unique<sequence::crf>(prefix);
+        model->train(params, seqs);
+    }
+
+    auto tagger = model->make_tagger();
+    h.run("crf/tag", seqs.size(), [&]()
+          {
+              for (auto& seq : seqs)
+                  tagger.tag(seq);
+              do_not_optimize(seqs.front()[0].label());
+          });
+}
+}
+}
@@ -0,0 +1,159 @@
+/**
+ * @file harness.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+#include "harness.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * @param samples A non-empty set of values (reordered by the call)
+ * @return the median of the values
+ */
+double median(std::vector<double>& samples)
+{
+    auto mid
+        = samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2);
+    std::nth_element(samples.begin(), mid, samples.end());
+    if (samples.size() % 2 == 1)
+        return *mid;
+    auto below = *std::max_element(samples.begin(), mid);
+    return (below + *mid) / 2;
+}
+}
+
+harness::harness(options opts) : opts_(std::move(opts))
+{
+    if (opts_.perf && !perf_.open())
+        std::cerr << "warning: hardware performance counters are unavailable"
+                  << std::endl;
+}
+
+bool harness::selected(const std::string& name) const
+{
+    // either the name lies under the filter or the filter lies under the
+    // name (so a suite is selected when any of its benchmarks could be)
+    auto len = static_cast<std::ptrdiff_t>(
+        std::min(name.size(), opts_.filter.size()));
+    return std::equal(name.begin(), name.begin() + len, opts_.filter.begin());
+}
+
+const std::string& harness::data_dir() const
+{
+    return opts_.data_dir;
+}
+
+double harness::seconds(clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration)
+        .count();
+}
+
+void harness::finish(const std::string& name, uint64_t items, uint64_t runs,
+                     std::vector<double> samples)
+{
+    result res;
+    res.name = name;
+    res.items = items;
+    res.runs = runs;
+    res.samples = samples;
+    res.min = *std::min_element(samples.begin(), samples.end());
+    res.mean = std::accumulate(samples.begin(), samples.end(), 0.0)
+               / samples.size();
+    res.median = median(samples);
+    for (auto& s : samples)
+        s = std::abs(s - res.median);
+    res.mad = median(samples);
+
+    auto total_items = static_cast<double>(items * runs * opts_.repetitions);
+    for (const auto& counter : perf_.totals())
+        res.counters.emplace_back(counter.first, counter.second / total_items);
+
+    auto flags = std::cerr.flags();
+    std::cerr << std::left << std::setw(44) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(12)
+              << res.median << " ns/item +- " << std::setw(8) << res.mad
+              << std::setw(14) << std::setprecision(0) << 1e9 / res.median
+              << " items/s";
+    for (const auto& counter : res.counters)
+        std::cerr << "  " << counter.first << "=" << std::setprecision(1)
+                  << counter.second;
+    std::cerr << std::endl;
+    std::cerr.flags(flags);
+
+    results_.push_back(std::move(res));
+}
+
+void harness::record(const std::string& metric, double value)
+{
+    if (results_.empty())
+        return;
+
+    auto& res = results_.back();
+    res.metrics.emplace_back(metric, value);
+
+    auto flags = std::cerr.flags();
+    std::cerr << std::left << std::setw(44) << ("  " + res.name + " " + metric)
+              << std::right << std::setprecision(4) << std::setw(12) << value
+              << std::endl;
+    std::cerr.flags(flags);
+}
+
+const std::vector<result>& harness::results() const
+{
+    return results_;
+}
+
+void harness::write_json(std::ostream& os) const
+{
+    os << std::setprecision(6);
+    os << "{\n  \"context\": {\"warmup\": " << opts_.warmup
+       << ", \"repetitions\": " << opts_.repetitions
+       << ", \"min_time\": " << opts_.min_time
+       << ", \"perf\": " << (perf_.available() ? "true" : "false") << "},\n";
+
+    os << "  \"benchmarks\": [";
+    bool first = true;
+    for (const auto& res : results_)
+    {
+        os << (first ? "\n" : ",\n");
+        first = false;
+        os << "    {\"name\": \"" << res.name << "\", \"items\": " << res.items
+           << ", \"runs\": " << res.runs << ", \"median_ns\": " << res.median
+           << ", \"mad_ns\": " << res.mad << ", \"min_ns\": " << res.min
+           << ", \"mean_ns\": " << res.mean
+           << ", \"items_per_second\": " << 1e9 / res.median;
+
+        os << ", \"samples_ns\": [";
+        for (std::size_t i = 0; i < res.samples.size(); ++i)
+            os << (i == 0 ? "" : ", ") << res.samples[i];
+        os << "]";
+
+        os << ", \"counters\": {";
+        for (std::size_t i = 0; i < res.counters.size(); ++i)
+            os << (i == 0 ? "" : ", ") << "\"" << res.counters[i].first
+               << "\": " << res.counters[i].second;
+        os << "}";
+
+        os << ", \"metrics\": {";
+        for (std::size_t i = 0; i < res.metrics.size(); ++i)
+            os << (i == 0 ? "" : ", ") << "\"" << res.metrics[i].first
+               << "\": " << res.metrics[i].second;
+        os << "}}";
+    }
+    os << "\n  ]\n}\n";
+}
+}
+}
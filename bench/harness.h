@@ -0,0 +1,254 @@
+/**
+ * @file harness.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_BENCH_HARNESS_H_
+#define META_BENCH_HARNESS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf_counters.h"
+
+namespace meta
+{
+
+/**
+ * Namespace for the meta-bench micro-benchmark suite.
+ */
+namespace bench
+{
+
+/**
+ * Prevents the compiler from optimizing away the computation of a value
+ * that is otherwise unused.
+ * @param value The value to keep alive
+ */
+template <class T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+    (void)*sink;
+#endif
+}
+
+/**
+ * Options controlling how benchmarks are run.
+ */
+struct options
+{
+    /// The number of untimed runs before measuring
+    uint64_t warmup = 3;
+
+    /// The number of timed repetitions
+    uint64_t repetitions = 15;
+
+    /// The minimum duration of a repetition, in seconds; benchmarks
+    /// without per-repetition setup are run several times per repetition
+    /// to reach it
+    double min_time = 0.01;
+
+    /// Whether to read hardware performance counters
+    bool perf = false;
+
+    /// Only benchmarks whose names start with this string are run
+    std::string filter;
+
+    /// The directory holding the datasets downloaded for the unit tests;
+    /// benchmarks on a dataset that is not there are skipped
+    std::string data_dir = "../data";
+};
+
+/**
+ * The summarized measurements for a single benchmark. All times are in
+ * nanoseconds per item.
+ */
+struct result
+{
+    /// The name of the benchmark
+    std::string name;
+
+    /// The number of items processed by a single run
+    uint64_t items;
+
+    /// The number of runs timed together in each repetition
+    uint64_t runs;
+
+    /// The time per item of every repetition
+    std::vector<double> samples;
+
+    /// The median time per item
+    double median;
+
+    /// The median absolute deviation of the time per item
+    double mad;
+
+    /// The fastest time per item
+    double min;
+
+    /// The mean time per item
+    double mean;
+
+    /// Hardware counter values per item, by name
+    std::vector<std::pair<std::string, double>> counters;
+
+    /// Other measured quantities (e.g., the accuracy a training run
+    /// reached), by name
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+/**
+ * Runs benchmarks and collects their results.
+ *
+ * A benchmark is a function that processes a fixed number of "items"
+ * (postings, documents, queries, ...) each time it is called. The harness
+ * runs it a few times to warm up, then times a number of repetitions and
+ * reports robust statistics (median and median absolute deviation) of the
+ * time per item, which are far less sensitive to the occasional
+ * descheduling or page fault than the mean.
+ */
+class harness
+{
+  public:
+    /**
+     * @param opts The options to run benchmarks with
+     */
+    harness(options opts);
+
+    /**
+     * @param name A benchmark (or suite) name
+     * @return whether the filter allows any benchmark under this name to
+     * run; suites use this to skip expensive setup
+     */
+    bool selected(const std::string& name) const;
+
+    /**
+     * @return the directory holding the datasets used by the unit tests
+     */
+    const std::string& data_dir() const;
+
+    /**
+     * Runs a benchmark that needs no per-repetition setup.
+     *
+     * @param name The name of the benchmark, as "suite/benchmark"
+     * @param items The number of items processed by a single call to fn
+     * @param fn The function to benchmark
+     */
+    template <class Function>
+    void run(const std::string& name, uint64_t items, Function&& fn)
+    {
+        run_impl(name, items, []() {}, fn, true);
+    }
+
+    /**
+     * Runs a benchmark that must be reset before every call (e.g., one
+     * that inserts into an initially empty container). The setup is not
+     * timed.
+     *
+     * @param name The name of the benchmark, as "suite/benchmark"
+     * @param items The number of items processed by a single call to fn
+     * @param setup The function that resets the benchmark's state
+     * @param fn The function to benchmark
+     */
+    template <class Setup, class Function>
+    void run_with_setup(const std::string& name, uint64_t items,
+                        Setup&& setup, Function&& fn)
+    {
+        run_impl(name, items, setup, fn, false);
+    }
+
+    /**
+     * Attaches a measured quantity other than time to the benchmark that
+     * was run last and prints it.
+     *
+     * @param metric The name of the quantity
+     * @param value Its value
+     */
+    void record(const std::string& metric, double value);
+
+    /**
+     * @return the results of every benchmark run so far
+     */
+    const std::vector<result>& results() const;
+
+    /**
+     * Writes every result as a JSON document.
+     * @param os The stream to write to
+     */
+    void write_json(std::ostream& os) const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    template <class Setup, class Function>
+    void run_impl(const std::string& name, uint64_t items, Setup&& setup,
+                  Function&& fn, bool batch)
+    {
+        if (!selected(name))
+            return;
+
+        uint64_t runs = 1;
+        for (uint64_t i = 0; i < opts_.warmup; ++i)
+        {
+            setup();
+            auto start = clock::now();
+            fn();
+            auto elapsed = seconds(clock::now() - start);
+            if (batch && elapsed > 0 && elapsed < opts_.min_time)
+                runs = static_cast<uint64_t>(opts_.min_time / elapsed) + 1;
+        }
+
+        std::vector<double> samples;
+        samples.reserve(opts_.repetitions);
+        perf_.clear();
+        for (uint64_t i = 0; i < opts_.repetitions; ++i)
+        {
+            setup();
+            perf_.start();
+            auto start = clock::now();
+            for (uint64_t r = 0; r < runs; ++r)
+                fn();
+            auto elapsed = seconds(clock::now() - start);
+            perf_.stop();
+            samples.push_back(elapsed * 1e9 / (runs * items));
+        }
+
+        finish(name, items, runs, std::move(samples));
+    }
+
+    /**
+     * @param duration A clock duration
+     * @return the duration in seconds
+     */
+    static double seconds(clock::duration duration);
+
+    /**
+     * Summarizes and records the samples for a benchmark.
+     */
+    void finish(const std::string& name, uint64_t items, uint64_t runs,
+                std::vector<double> samples);
+
+    /// The options benchmarks are run with
+    options opts_;
+
+    /// The hardware counters, if enabled
+    perf_counters perf_;
+
+    /// The results so far
+    std::vector<result> results_;
+};
+}
+}
+#endif
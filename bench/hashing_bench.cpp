@@ -0,0 +1,76 @@
+/**
+ * @file hashing_bench.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+
+#include "meta/hashing/probe_map.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+void hashing_benchmarks(harness& h, const std::string&)
+{
+    if (!h.selected("hashing/"))
+        return;
+
+    random_engine rng{47};
+    auto words = make_words(50000, rng);
+
+    // a token stream with a realistic amount of repetition
+    zipf_distribution dist{words.size()};
+    std::vector<std::string> tokens;
+    tokens.reserve(500000);
+    for (uint64_t i = 0; i < 500000; ++i)
+        tokens.push_back(words[dist(rng)]);
+
+    using map_type = hashing::probe_map<std::string, uint64_t>;
+    map_type map;
+    h.run_with_setup("hashing/probe-map-count", tokens.size(),
+                     [&]()
+                     {
+                         map = map_type{};
+                     },
+                     [&]()
+                     {
+                         for (const auto& token : tokens)
+                             ++map[token];
+                         do_not_optimize(map.size());
+                     });
+
+    h.run_with_setup("hashing/probe-map-insert", words.size(),
+                     [&]()
+                     {
+                         map = map_type{};
+                     },
+                     [&]()
+                     {
+                         for (uint64_t i = 0; i < words.size(); ++i)
+                             map.insert(words[i], i);
+                         do_not_optimize(map.size());
+                     });
+
+    std::vector<std::string> queries(words);
+    std::shuffle(queries.begin(), queries.end(), rng);
+    for (uint64_t i = 0; i < queries.size(); i += 10)
+        queries[i] += "~"; // some misses
+
+    h.run("hashing/probe-map-find", queries.size(), [&]()
+          {
+              uint64_t sum = 0;
+              for (const auto& query : queries)
+              {
+                  auto it = map.find(query);
+                  if (it != map.end())
+                      sum += it->value();
+              }
+              do_not_optimize(sum);
+          });
+}
+}
+}
@@ -0,0 +1,361 @@
+/**
+ * @file index_bench.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "cpptoml.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/hnsw_index.h"
+#include "meta/index/make_index.h"
+#include "meta/index/postings_buffer.h"
+#include "meta/index/vocabulary_map.h"
+#include "meta/index/vocabulary_map_writer.h"
+#include "meta/meta.h"
+#include "meta/util/multiway_merge.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+
+using buffer_type = index::postings_buffer<term_id, doc_id>;
+
+/**
+ * Generates postings lists whose lengths follow a Zipf-like curve, with
+ * geometrically distributed document id gaps.
+ */
+std::vector<std::vector<std::pair<doc_id, uint64_t>>>
+    make_postings(uint64_t num_terms, uint64_t num_docs, random_engine& rng)
+{
+    std::vector<std::vector<std::pair<doc_id, uint64_t>>> lists(num_terms);
+    zipf_distribution counts{16};
+    for (uint64_t t = 0; t < num_terms; ++t)
+    {
+        auto length = std::max<uint64_t>(1, num_docs / (4 * (t + 1)));
+        std::geometric_distribution<uint64_t> gap{
+            static_cast<double>(length) / num_docs};
+        uint64_t id = gap(rng);
+        while (id < num_docs && lists[t].size() < length)
+        {
+            lists[t].emplace_back(doc_id{id}, counts(rng) + 1);
+            id += gap(rng) + 1;
+        }
+    }
+    return lists;
+}
+
+void postings_benchmarks(harness& h)
+{
+    random_engine rng{47};
+    auto lists = make_postings(2000, 100000, rng);
+    uint64_t total = 0;
+    for (const auto& list : lists)
+        total += list.size();
+
+    h.run("index/postings-encode", total, [&]()
+          {
+              std::vector<buffer_type> buffers;
+              buffers.reserve(lists.size());
+              for (uint64_t t = 0; t < lists.size(); ++t)
+              {
+                  buffers.emplace_back(term_id{t});
+                  for (const auto& pr : lists[t])
+                      buffers.back().write_count(pr.first, pr.second);
+              }
+              do_not_optimize(buffers.back().bytes_used());
+          });
+
+    std::vector<buffer_type> buffers;
+    buffers.reserve(lists.size());
+    for (uint64_t t = 0; t < lists.size(); ++t)
+    {
+        buffers.emplace_back(term_id{t});
+        for (const auto& pr : lists[t])
+            buffers.back().write_count(pr.first, pr.second);
+    }
+
+    h.run("index/postings-decode", total, [&]()
+          {
+              uint64_t sum = 0;
+              for (const auto& buffer : buffers)
+              {
+                  for (const auto& pr : buffer.stream())
+                      sum += static_cast<uint64_t>(pr.first) + pr.second;
+              }
+              do_not_optimize(sum);
+          });
+}
+
+/**
+ * A (key, count) pair, as found in the chunks of a postings merge.
+ */
+struct merge_record
+{
+    uint64_t key;
+    uint64_t count;
+
+    void merge_with(merge_record&& other)
+    {
+        count += other.count;
+    }
+
+    bool operator<(const merge_record& other) const
+    {
+        return key < other.key;
+    }
+
+    bool operator==(const merge_record& other) const
+    {
+        return key == other.key;
+    }
+};
+
+/**
+ * A ChunkIterator over an in-memory sorted chunk, so the merge itself is
+ * measured without any I/O.
+ */
+class chunk_iterator
+{
+  public:
+    chunk_iterator() = default;
+
+    chunk_iterator(const std::vector<merge_record>& records)
+        : records_{&records}, pos_{0}
+    {
+        ++(*this);
+    }
+
+    chunk_iterator& operator++()
+    {
+        if (pos_ == records_->size())
+        {
+            records_ = nullptr;
+            pos_ = 0;
+            return *this;
+        }
+        current_ = (*records_)[pos_++];
+        return *this;
+    }
+
+    merge_record& operator*()
+    {
+        return current_;
+    }
+
+    const merge_record& operator*() const
+    {
+        return current_;
+    }
+
+    uint64_t total_bytes() const
+    {
+        return records_ ? records_->size() * sizeof(merge_record) : 0;
+    }
+
+    uint64_t bytes_read() const
+    {
+        return records_ ? pos_ * sizeof(merge_record) : 0;
+    }
+
+    bool operator==(const chunk_iterator& other) const
+    {
+        return records_ == other.records_ && pos_ == other.pos_;
+    }
+
+    bool operator!=(const chunk_iterator& other) const
+    {
+        return !(*this == other);
+    }
+
+  private:
+    const std::vector<merge_record>* records_ = nullptr;
+    uint64_t pos_ = 0;
+    merge_record current_;
+};
+
+void merge_benchmarks(harness& h)
+{
+    const uint64_t num_chunks = 16;
+    const uint64_t chunk_size = 50000;
+
+    random_engine rng{47};
+    std::uniform_int_distribution<uint64_t> key{0, num_chunks * chunk_size};
+    std::vector<std::vector<merge_record>> chunks(num_chunks);
+    for (auto& chunk : chunks)
+    {
+        for (uint64_t i = 0; i < chunk_size; ++i)
+            chunk.push_back({key(rng), 1});
+        std::sort(chunk.begin(), chunk.end());
+        chunk.erase(std::unique(chunk.begin(), chunk.end()), chunk.end());
+    }
+
+    uint64_t total = 0;
+    for (const auto& chunk : chunks)
+        total += chunk.size();
+
+    std::vector<chunk_iterator> iterators;
+    h.run_with_setup("index/multiway-merge", total,
+                     [&]()
+                     {
+                         iterators.assign(chunks.begin(), chunks.end());
+                     },
+                     [&]()
+                     {
+                         uint64_t sum = 0;
+                         util::multiway_merge(
+                             iterators.begin(), iterators.end(),
+                             [&](merge_record&& rec)
+                             {
+                                 sum += rec.count;
+                             });
+                         do_not_optimize(sum);
+                     });
+}
+
+void vocabulary_benchmarks(harness& h, const std::string& dir)
+{
+    random_engine rng{47};
+    auto words = make_words(100000, rng);
+    std::sort(words.begin(), words.end());
+
+    auto path = dir + "/vocab.bin";
+    {
+        index::vocabulary_map_writer writer{path};
+        for (const auto& word : words)
+            writer.insert(word);
+    }
+    index::vocabulary_map vocab{path};
+
+    std::vector<std::string> queries(words);
+    std::shuffle(queries.begin(), queries.end(), rng);
+    for (uint64_t i = 0; i < queries.size(); i += 10)
+        queries[i] += "~"; // some misses
+
+    h.run("index/vocabulary-map-find", queries.size(), [&]()
+          {
+              uint64_t found = 0;
+              for (const auto& query : queries)
+                  found += vocab.find(query) ? 1 : 0;
+              do_not_optimize(found);
+          });
+}
+
+void forward_value_benchmarks(harness& h, const std::string& dir)
+{
+    random_engine rng{47};
+    auto words = make_words(20000, rng);
+    auto config = make_line_corpus(dir + "/forward", words, 2000, 150, rng);
+    auto prefix = *config->get_as<std::string>("index");
+
+    for (const auto& format : {"double", "auto", "float", "quantized"})
+    {
+        auto name = std::string{"index/forward-scan-"} + format;
+        if (!h.selected(name))
+            continue;
+
+        config->insert("index", prefix + "-" + format);
+        config->insert("forward-index-values", std::string{format});
+        auto idx = index::make_index<index::forward_index>(*config);
+
+        uint64_t total = 0;
+        for (const auto& d_id : idx->docs())
+            total += idx->stream_for(d_id)->size();
+
+        h.run(name, total, [&]()
+              {
+                  double sum = 0;
+                  for (const auto& d_id : idx->docs())
+                  {
+                      for (const auto& count : *idx->stream_for(d_id))
+                          sum += count.second;
+                  }
+                  do_not_optimize(sum);
+              });
+    }
+}
+
+/**
+ * Generates sparse vectors drawn from a Zipf-like vocabulary, each with a
+ * share of terms from one of a few topics so that there are neighbors to
+ * find.
+ */
+std::vector<std::pair<doc_id, index::hnsw_index::vector_type>>
+    make_sparse_vectors(uint64_t num_docs, random_engine& rng)
+{
+    const uint64_t num_terms = 20000;
+    const uint64_t num_topics = 50;
+    zipf_distribution terms{num_terms};
+    std::uniform_int_distribution<uint64_t> topics{0, num_topics - 1};
+    std::uniform_int_distribution<uint64_t> topic_terms{0, 199};
+
+    std::vector<std::pair<doc_id, index::hnsw_index::vector_type>> vecs;
+    for (uint64_t d = 0; d < num_docs; ++d)
+    {
+        auto topic = topics(rng);
+        std::map<uint64_t, double> counts;
+        for (uint64_t i = 0; i < 60; ++i)
+        {
+            auto t_id = i % 3 == 0 ? num_terms + topic * 200 + topic_terms(rng)
+                                   : terms(rng);
+            counts[t_id] += 1;
+        }
+        index::hnsw_index::vector_type vec;
+        for (const auto& count : counts)
+            vec.emplace_back(term_id{count.first}, count.second);
+        vecs.emplace_back(doc_id{d}, std::move(vec));
+    }
+    return vecs;
+}
+
+void hnsw_benchmarks(harness& h)
+{
+    random_engine rng{47};
+    auto docs = make_sparse_vectors(5000, rng);
+    auto queries = make_sparse_vectors(1000, rng);
+
+    index::hnsw_options options;
+    options.num_threads = 1;
+    h.run("index/hnsw-build", docs.size(), [&]()
+          {
+              index::hnsw_index idx{docs, options};
+              do_not_optimize(idx.size());
+          });
+
+    index::hnsw_index idx{docs};
+    for (uint64_t ef : {10, 100})
+    {
+        h.run("index/hnsw-search-ef-" + std::to_string(ef), queries.size(),
+              [&]()
+              {
+                  uint64_t found = 0;
+                  for (const auto& query : queries)
+                      found += idx.search(query.second, 10, ef).size();
+                  do_not_optimize(found);
+              });
+    }
+}
+}
+
+void index_benchmarks(harness& h, const std::string& dir)
+{
+    if (h.selected("index/postings"))
+        postings_benchmarks(h);
+    if (h.selected("index/multiway-merge"))
+        merge_benchmarks(h);
+    if (h.selected("index/vocabulary-map"))
+        vocabulary_benchmarks(h, dir);
+    if (h.selected("index/forward-scan"))
+        forward_value_benchmarks(h, dir);
+    if (h.selected("index/hnsw"))
+        hnsw_benchmarks(h);
+}
+}
+}
@@ -0,0 +1,316 @@
+/**
+ * @file learn_bench.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "cpptoml.h"
+#include "meta/classify/classifier/linear_svm.h"
+#include "meta/classify/classifier/sgd.h"
+#include "meta/classify/multiclass_dataset_view.h"
+#include "meta/classify/models/linear_model.h"
+#include "meta/learn/loss/hinge.h"
+#include "meta/learn/loss/logistic.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/make_index.h"
+#include "meta/io/filesystem.h"
+#include "meta/learn/sgd.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * @param data_dir The directory holding the unit test datasets
+ * @param dir The directory to build the index in
+ * @param dataset "ceeaus" or "breast-cancer"
+ * @return the configuration the unit tests index the dataset with, or
+ * nullptr if the dataset was not downloaded
+ */
+std::shared_ptr<cpptoml::table> dataset_config(const std::string& data_dir,
+                                               const std::string& dir,
+                                               const std::string& dataset)
+{
+    auto corpus = dataset == "ceeaus" ? "line.toml" : "libsvm.toml";
+    if (!filesystem::file_exists(data_dir + "/" + dataset + "/" + corpus))
+        return nullptr;
+
+    auto ana = cpptoml::make_table();
+    auto config = cpptoml::make_table();
+    if (dataset == "ceeaus")
+    {
+        ana->insert("method", "ngram-word");
+        ana->insert<int64_t>("ngram", 1);
+        ana->insert("filter", "default-chain");
+        config->insert("stop-words", data_dir + "/lemur-stopwords.txt");
+        config->insert("encoding", "shift_jis");
+    }
+    else
+    {
+        ana->insert("method", "libsvm");
+    }
+    auto analyzers = cpptoml::make_table_array();
+    analyzers->push_back(ana);
+
+    config->insert("prefix", data_dir);
+    config->insert("dataset", dataset);
+    config->insert("corpus", corpus);
+    config->insert("index", dir + "/" + dataset);
+    config->insert("analyzers", analyzers);
+    return config;
+}
+
+/**
+ * Times Hogwild training of a one-class-versus-the-rest hinge SGD model
+ * on a dataset the unit tests use, to convergence, on 1 to 8 threads, and
+ * records the accuracy each reaches on a held-out fifth of the data. A
+ * single thread trains with the sequential loop, as the classifier does.
+ */
+void hogwild_dataset_benchmarks(harness& h, const std::string& dir,
+                                const std::string& dataset)
+{
+    auto prefix = "learn/sgd-hogwild-" + dataset + "-";
+    if (!h.selected(prefix))
+        return;
+
+    auto config = dataset_config(h.data_dir(), dir, dataset);
+    if (!config)
+    {
+        std::cerr << "skipping " << prefix << "*: no " << dataset << " in "
+                  << h.data_dir() << std::endl;
+        return;
+    }
+
+    auto idx = index::make_index<index::forward_index>(*config);
+    classify::multiclass_dataset dset{idx};
+    classify::multiclass_dataset_view all{dset, std::mt19937_64{47}};
+    auto positive = all.labels_begin()->first;
+    auto split = all.begin() + static_cast<std::ptrdiff_t>(all.size() * 4 / 5);
+    classify::multiclass_dataset_view train_mdv{all, all.begin(), split};
+    classify::multiclass_dataset_view test_mdv{all, split, all.end()};
+    auto labeler = [&](const learn::instance& inst)
+    {
+        return all.label(inst) == positive;
+    };
+    classify::binary_dataset_view train{train_mdv, labeler};
+    classify::binary_dataset_view test{test_mdv, labeler};
+
+    for (std::size_t threads : {1, 2, 4, 8})
+    {
+        auto name = prefix + std::to_string(threads) + "-threads";
+        if (!h.selected(name))
+            continue;
+
+        learn::sgd_model::training_options_type training;
+        training.num_threads = threads;
+        std::unique_ptr<classify::sgd> model;
+        h.run(name, train.size(), [&]()
+              {
+                  model = make_unique<classify::sgd>(
+                      train, make_unique<learn::loss::hinge>(),
+                      learn::sgd_model::options_type{},
+                      classify::sgd::default_gamma,
+                      classify::sgd::default_max_iter, false, training);
+              });
+
+        uint64_t correct = 0;
+        for (const auto& inst : test)
+            correct += model->classify(inst.weights) == test.label(inst);
+        h.record("accuracy", static_cast<double>(correct) / test.size());
+    }
+}
+}
+
+void learn_benchmarks(harness& h, const std::string& dir)
+{
+    if (!h.selected("learn/"))
+        return;
+
+    const uint64_t num_features = 100000;
+    random_engine rng{47};
+    zipf_distribution feature{num_features};
+    std::uniform_int_distribution<int> coin{0, 1};
+
+    // sparse instances with ~50 active features each, labeled by a hidden
+    // linear model so the updates look like those of a real training run
+    std::vector<double> truth(num_features);
+    std::normal_distribution<double> normal;
+    for (auto& w : truth)
+        w = normal(rng);
+
+    std::vector<learn::feature_vector> instances(5000);
+    std::vector<double> labels;
+    for (auto& inst : instances)
+    {
+        std::vector<uint64_t> ids;
+        for (uint64_t i = 0; i < 50; ++i)
+            ids.push_back(feature(rng));
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        double dot = 0;
+        for (const auto& id : ids)
+        {
+            double value = 1 + coin(rng);
+            inst.emplace_back(learn::feature_id{id}, value);
+            dot += truth[id] * value;
+        }
+        labels.push_back(dot >= 0 ? 1 : -1);
+    }
+
+    const learn::loss::hinge hinge;
+    const learn::loss::logistic logistic;
+    const std::vector<std::pair<std::string, const learn::loss::loss_function*>>
+        losses = {{"hinge", &hinge}, {"logistic", &logistic}};
+
+    for (const auto& loss : losses)
+    {
+        auto name = "learn/sgd-train-one-" + loss.first;
+        if (!h.selected(name))
+            continue;
+
+        learn::sgd_model model{num_features};
+        h.run(name, instances.size(), [&]()
+              {
+                  double total = 0;
+                  for (uint64_t i = 0; i < instances.size(); ++i)
+                      total += model.train_one(instances[i], labels[i],
+                                               *loss.second);
+                  do_not_optimize(total);
+              });
+    }
+
+    if (h.selected("learn/sgd-predict"))
+    {
+        learn::sgd_model model{num_features};
+        for (uint64_t i = 0; i < instances.size(); ++i)
+            model.train_one(instances[i], labels[i], hinge);
+        h.run("learn/sgd-predict", instances.size(), [&]()
+              {
+                  double total = 0;
+                  for (const auto& inst : instances)
+                      total += model.predict(inst);
+                  do_not_optimize(total);
+              });
+    }
+
+    // Hogwild training of a whole pass; the instances share few features
+    // beyond the head of the zipf distribution
+    std::vector<learn::sgd_model::example_type> examples;
+    for (uint64_t i = 0; i < instances.size(); ++i)
+        examples.emplace_back(&instances[i], labels[i]);
+    for (std::size_t threads : {1, 2, 4, 8})
+    {
+        auto name = "learn/sgd-hogwild-" + std::to_string(threads) + "-threads";
+        if (!h.selected(name))
+            continue;
+
+        parallel::thread_pool pool{threads};
+        learn::sgd_model model{num_features};
+        h.run(name, examples.size(), [&]()
+              {
+                  do_not_optimize(model.train_parallel(examples, hinge, pool));
+              });
+    }
+
+    // convergence and speedup on the unit test datasets, when present
+    for (const auto& dataset : {"ceeaus", "breast-cancer"})
+        hogwild_dataset_benchmarks(h, dir, dataset);
+
+    // one pass of mini-batches; the gradients are the same on any number
+    // of threads
+    for (std::size_t threads : {1, 4})
+    {
+        auto name = "learn/sgd-minibatch-" + std::to_string(threads)
+                    + "-threads";
+        if (!h.selected(name))
+            continue;
+
+        parallel::thread_pool pool{threads};
+        learn::sgd_model model{num_features};
+        learn::sgd_model::training_options_type options;
+        options.batch_size = 256;
+        h.run(name, examples.size(), [&]()
+              {
+                  double total = 0;
+                  std::vector<learn::sgd_model::example_type> batch;
+                  for (std::size_t i = 0; i < examples.size();
+                       i += options.batch_size)
+                  {
+                      auto last = std::min(examples.size(),
+                                           i + options.batch_size);
+                      batch.assign(examples.begin() + i,
+                                   examples.begin() + last);
+                      total += model.train_batch(batch, hinge, pool, options);
+                  }
+                  do_not_optimize(total);
+              });
+    }
+
+    if (h.selected("learn/linear-svm-train"))
+    {
+        std::vector<uint64_t> ids(instances.size());
+        std::iota(ids.begin(), ids.end(), 0);
+        classify::binary_dataset dset{ids.begin(), ids.end(), num_features,
+                                      [&](uint64_t i)
+                                      {
+                                          return instances[i];
+                                      },
+                                      [&](uint64_t i)
+                                      {
+                                          return labels[i] > 0;
+                                      }};
+        classify::linear_svm::options_type options;
+        h.run("learn/linear-svm-train", instances.size(), [&]()
+              {
+                  auto weights = classify::train_linear_svm(dset, options);
+                  do_not_optimize(weights);
+              });
+    }
+
+    // a tagger-sized multiclass model (45 classes) scored by feature
+    // strings, as the perceptron tagger and the parser do
+    if (h.selected("learn/linear-model-best-class"))
+    {
+        using model_type
+            = classify::linear_model<std::string, float, uint64_t>;
+        model_type model;
+        std::uniform_int_distribution<uint64_t> cls{0, 44};
+        for (const auto& inst : instances)
+            for (const auto& pr : inst)
+                model.update(cls(rng), std::to_string(pr.first),
+                             static_cast<float>(normal(rng)));
+
+        std::vector<std::vector<std::pair<std::string, float>>> docs;
+        for (const auto& inst : instances)
+        {
+            docs.emplace_back();
+            for (const auto& pr : inst)
+                docs.back().emplace_back(std::to_string(pr.first), 1.0f);
+        }
+
+        auto score_all = [&]()
+        {
+            uint64_t total = 0;
+            for (const auto& doc : docs)
+                total += model.best_class(doc);
+            do_not_optimize(total);
+        };
+        h.run("learn/linear-model-best-class-sparse", docs.size(), score_all);
+        model.compile();
+        h.run("learn/linear-model-best-class-compiled", docs.size(),
+              score_all);
+    }
+}
+}
+}
@@ -0,0 +1,136 @@
+/**
+ * @file lm_bench.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <tuple>
+
+#include "cpptoml.h"
+#include "meta/lm/language_model.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * Writes a trigram language model in ARPA format over the given
+ * vocabulary. Bigrams and trigrams are drawn with Zipf-distributed
+ * continuations so that lookups hit at every order.
+ *
+ * @return the bigrams in the model, for generating test sentences
+ */
+std::vector<std::pair<uint64_t, uint64_t>>
+    write_arpa(const std::string& filename,
+               const std::vector<std::string>& words, random_engine& rng)
+{
+    zipf_distribution dist{words.size()};
+    std::uniform_real_distribution<double> prob{-5.0, -0.5};
+    std::uniform_real_distribution<double> backoff{-1.0, 0.0};
+
+    std::set<std::pair<uint64_t, uint64_t>> bigrams;
+    for (uint64_t w = 0; w < words.size(); ++w)
+    {
+        for (uint64_t i = 0; i < 5; ++i)
+            bigrams.emplace(w, dist(rng));
+    }
+
+    std::set<std::tuple<uint64_t, uint64_t, uint64_t>> trigrams;
+    for (const auto& bigram : bigrams)
+    {
+        for (uint64_t i = 0; i < 2; ++i)
+            trigrams.emplace(bigram.first, bigram.second, dist(rng));
+    }
+
+    std::ofstream arpa{filename};
+    arpa << "\\data\\\n";
+    arpa << "ngram 1=" << words.size() + 3 << "\n";
+    arpa << "ngram 2=" << bigrams.size() << "\n";
+    arpa << "ngram 3=" << trigrams.size() << "\n\n";
+
+    arpa << "\\1-grams:\n";
+    arpa << prob(rng) << "\t<unk>\t0\n";
+    arpa << "0\t<s>\t" << backoff(rng) << "\n";
+    arpa << prob(rng) << "\t</s>\t0\n";
+    for (const auto& word : words)
+        arpa << prob(rng) << "\t" << word << "\t" << backoff(rng) << "\n";
+
+    arpa << "\n\\2-grams:\n";
+    for (const auto& bigram : bigrams)
+        arpa << prob(rng) << "\t" << words[bigram.first] << " "
+             << words[bigram.second] << "\t" << backoff(rng) << "\n";
+
+    arpa << "\n\\3-grams:\n";
+    for (const auto& trigram : trigrams)
+        arpa << prob(rng) << "\t" << words[std::get<0>(trigram)] << " "
+             << words[std::get<1>(trigram)] << " "
+             << words[std::get<2>(trigram)] << "\n";
+
+    arpa << "\n\\end\\\n";
+
+    return {bigrams.begin(), bigrams.end()};
+}
+}
+
+void lm_benchmarks(harness& h, const std::string& dir)
+{
+    if (!h.selected("lm/"))
+        return;
+
+    random_engine rng{47};
+    auto words = make_words(5000, rng);
+    auto arpa_file = dir + "/synthetic.arpa";
+    auto bigrams = write_arpa(arpa_file, words, rng);
+
+    auto lm_config = cpptoml::make_table();
+    lm_config->insert("arpa-file", arpa_file);
+    lm_config->insert("binary-file-prefix", dir + "/synthetic-");
+    auto config = cpptoml::make_table();
+    config->insert("language-model", lm_config);
+    lm::language_model model{*config};
+
+    // sentences mostly follow bigrams in the model, with the occasional
+    // jump to a random word (and an unknown word now and then)
+    const uint64_t length = 20;
+    std::uniform_int_distribution<uint64_t> start{0, bigrams.size() - 1};
+    std::uniform_int_distribution<uint64_t> any{0, words.size() - 1};
+    std::uniform_int_distribution<int> choice{0, 9};
+    std::vector<lm::sentence> sentences;
+    for (uint64_t s = 0; s < 1000; ++s)
+    {
+        std::string text;
+        auto current = bigrams[start(rng)].first;
+        for (uint64_t i = 0; i < length; ++i)
+        {
+            auto c = choice(rng);
+            text += (c == 0 ? "qqqqqq" : words[current]);
+            text += ' ';
+
+            auto it = std::lower_bound(
+                bigrams.begin(), bigrams.end(),
+                std::make_pair(current, uint64_t{0}));
+            if (c < 8 && it != bigrams.end() && it->first == current)
+                current = it->second;
+            else
+                current = any(rng);
+        }
+        sentences.emplace_back(text, false);
+    }
+
+    h.run("lm/log-prob", sentences.size() * length, [&]()
+          {
+              double total = 0;
+              for (const auto& sentence : sentences)
+                  total += model.log_prob(sentence);
+              do_not_optimize(total);
+          });
+}
+}
+}
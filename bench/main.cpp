@@ -0,0 +1,146 @@
+/**
+ * @file main.cpp
+ * @author agent
+ *
+ * Runs the meta-bench micro-benchmark suite. A table of results is
+ * printed to stderr as benchmarks finish; the full results are written as
+ * JSON (to stdout by default) so that runs can be saved and compared.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "harness.h"
+#include "meta/io/filesystem.h"
+#include "meta/logging/logger.h"
+#include "suites.h"
+
+using namespace meta;
+
+namespace
+{
+int print_usage(const std::string& prog)
+{
+    std::cerr << "Usage: " << prog << " [OPTION]..." << std::endl;
+    std::cerr << "where [OPTION] is one or more of:" << std::endl;
+    std::cerr << "\t--filter PREFIX\tonly run benchmarks whose names start "
+                 "with PREFIX"
+              << std::endl;
+    std::cerr << "\t--reps N\tnumber of timed repetitions (default 15)"
+              << std::endl;
+    std::cerr << "\t--warmup N\tnumber of untimed warmup runs (default 3)"
+              << std::endl;
+    std::cerr << "\t--min-time S\tminimum seconds per repetition (default "
+                 "0.01)"
+              << std::endl;
+    std::cerr << "\t--perf\tread hardware performance counters" << std::endl;
+    std::cerr << "\t--out FILE\twrite the JSON results to FILE instead of "
+                 "stdout"
+              << std::endl;
+    std::cerr << "\t--dir DIR\tscratch directory (default meta-bench-data)"
+              << std::endl;
+    std::cerr << "\t--data DIR\tdirectory of the unit test datasets (default "
+                 "../data)"
+              << std::endl;
+    std::cerr << "\t--list\tprint the benchmark suites and exit" << std::endl;
+    std::cerr << "\t--verbose\tshow log output from the library"
+              << std::endl;
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const std::vector<std::pair<std::string, bench::suite_function>> suites
+        = {{"index", bench::index_benchmarks},
+           {"hashing", bench::hashing_benchmarks},
+           {"analyzers", bench::analyzer_benchmarks},
+           {"ranker", bench::ranker_benchmarks},
+           {"learn", bench::learn_benchmarks},
+           {"crf", bench::crf_benchmarks},
+           {"lm", bench::lm_benchmarks},
+           {"topics", bench::topics_benchmarks}};
+
+    bench::options opts;
+    std::string out;
+    std::string dir = "meta-bench-data";
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto value = [&]()
+            {
+                if (i + 1 == argc)
+                    throw std::invalid_argument{arg + " needs a value"};
+                return std::string{argv[++i]};
+            };
+
+            if (arg == "--filter")
+                opts.filter = value();
+            else if (arg == "--reps")
+                opts.repetitions = std::stoul(value());
+            else if (arg == "--warmup")
+                opts.warmup = std::stoul(value());
+            else if (arg == "--min-time")
+                opts.min_time = std::stod(value());
+            else if (arg == "--perf")
+                opts.perf = true;
+            else if (arg == "--out")
+                out = value();
+            else if (arg == "--dir")
+                dir = value();
+            else if (arg == "--data")
+                opts.data_dir = value();
+            else if (arg == "--verbose")
+                logging::set_cerr_logging();
+            else if (arg == "--list")
+            {
+                for (const auto& suite : suites)
+                    std::cout << suite.first << std::endl;
+                return 0;
+            }
+            else
+                return print_usage(argv[0]);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return print_usage(argv[0]);
+    }
+
+    if (opts.repetitions == 0)
+        return print_usage(argv[0]);
+
+    bool created = !filesystem::exists(dir);
+    bench::harness h{opts};
+    for (const auto& suite : suites)
+    {
+        if (!h.selected(suite.first + "/"))
+            continue;
+
+        auto suite_dir = dir + "/" + suite.first;
+        filesystem::remove_all(suite_dir);
+        filesystem::make_directories(suite_dir);
+        suite.second(h, suite_dir);
+        filesystem::remove_all(suite_dir);
+    }
+    if (created)
+        filesystem::remove_all(dir);
+
+    if (out.empty())
+    {
+        h.write_json(std::cout);
+    }
+    else
+    {
+        std::ofstream output{out};
+        h.write_json(output);
+    }
+
+    return 0;
+}
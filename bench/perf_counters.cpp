@@ -0,0 +1,122 @@
+/**
+ * @file perf_counters.cpp
+ * @author agent
+ */
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace meta
+{
+namespace bench
+{
+
+#ifdef __linux__
+namespace
+{
+int open_event(uint64_t config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+}
+
+bool perf_counters::open()
+{
+    const std::pair<const char*, uint64_t> supported[]
+        = {{"cycles", PERF_COUNT_HW_CPU_CYCLES},
+           {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+           {"cache_misses", PERF_COUNT_HW_CACHE_MISSES},
+           {"branch_misses", PERF_COUNT_HW_BRANCH_MISSES}};
+
+    for (const auto& ev : supported)
+    {
+        auto fd = open_event(ev.second);
+        if (fd >= 0)
+            events_.push_back({ev.first, fd, 0});
+    }
+    return available();
+}
+
+perf_counters::~perf_counters()
+{
+    for (const auto& ev : events_)
+        ::close(ev.fd);
+}
+
+void perf_counters::start()
+{
+    for (const auto& ev : events_)
+    {
+        ::ioctl(ev.fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(ev.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters::stop()
+{
+    for (auto& ev : events_)
+    {
+        ::ioctl(ev.fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (::read(ev.fd, &value, sizeof(value))
+            == static_cast<ssize_t>(sizeof(value)))
+            ev.total += value;
+    }
+}
+#else
+bool perf_counters::open()
+{
+    return false;
+}
+
+perf_counters::~perf_counters() = default;
+
+void perf_counters::start()
+{
+    // nothing
+}
+
+void perf_counters::stop()
+{
+    // nothing
+}
+#endif
+
+bool perf_counters::available() const
+{
+    return !events_.empty();
+}
+
+void perf_counters::clear()
+{
+    for (auto& ev : events_)
+        ev.total = 0;
+}
+
+std::vector<std::pair<std::string, uint64_t>> perf_counters::totals() const
+{
+    std::vector<std::pair<std::string, uint64_t>> result;
+    result.reserve(events_.size());
+    for (const auto& ev : events_)
+        result.emplace_back(ev.name, ev.total);
+    return result;
+}
+}
+}
@@ -0,0 +1,97 @@
+/**
+ * @file perf_counters.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_BENCH_PERF_COUNTERS_H_
+#define META_BENCH_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace meta
+{
+namespace bench
+{
+
+/**
+ * A small set of hardware performance counters (cycles, instructions,
+ * cache misses, and branch misses) read through `perf_event_open` on
+ * Linux. Counters the kernel refuses to open (e.g., because of
+ * `perf_event_paranoid` or a virtualized PMU) are silently skipped; on
+ * other platforms no counters are ever available.
+ */
+class perf_counters
+{
+  public:
+    /**
+     * Creates an empty set of counters; call open() to use them.
+     */
+    perf_counters() = default;
+
+    /**
+     * Closes any open counters.
+     */
+    ~perf_counters();
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    /**
+     * Attempts to open every supported counter for the calling thread
+     * (and any threads it creates afterwards).
+     * @return whether at least one counter could be opened
+     */
+    bool open();
+
+    /**
+     * @return whether any counters are open
+     */
+    bool available() const;
+
+    /**
+     * Resets and starts the counters.
+     */
+    void start();
+
+    /**
+     * Stops the counters and adds their values to the running totals.
+     */
+    void stop();
+
+    /**
+     * Resets the running totals to zero.
+     */
+    void clear();
+
+    /**
+     * @return the running total for every open counter, by name
+     */
+    std::vector<std::pair<std::string, uint64_t>> totals() const;
+
+  private:
+    /**
+     * A single open counter.
+     */
+    struct event
+    {
+        /// The name reported for this counter
+        std::string name;
+        /// The file descriptor returned by perf_event_open
+        int fd;
+        /// The sum of the values read so far
+        uint64_t total;
+    };
+
+    /// The open counters
+    std::vector<event> events_;
+};
+}
+}
+#endif
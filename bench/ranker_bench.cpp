@@ -0,0 +1,97 @@
+/**
+ * @file ranker_bench.cpp
+ * @author agent
+ */
+
+#include "cpptoml.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/make_index.h"
+#include "meta/index/ranker/ranker_factory.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+void ranker_benchmarks(harness& h, const std::string& dir)
+{
+    if (!h.selected("ranker/"))
+        return;
+
+    random_engine rng{47};
+    auto words = make_words(20000, rng);
+    auto config = make_line_corpus(dir, words, 5000, 150, rng);
+    auto idx = index::make_index<index::inverted_index>(*config);
+
+    // the same index, loaded into RAM, for comparing latencies
+    config->insert("index-in-memory", true);
+    auto ram_idx = index::make_index<index::inverted_index>(*config);
+
+    // short queries made from the most frequent half of the vocabulary,
+    // so that postings lists of all lengths are touched
+    zipf_distribution dist{words.size() / 2};
+    std::uniform_int_distribution<uint64_t> length{2, 6};
+    std::vector<corpus::document> queries(200);
+    for (auto& query : queries)
+        query.content(make_text(words, dist, length(rng), rng));
+
+    for (const auto& method : {"bm25", "pivoted-length", "dirichlet-prior",
+                               "jelinek-mercer", "absolute-discount"})
+    {
+        auto ranker_config = cpptoml::make_table();
+        ranker_config->insert("method", std::string{method});
+        auto ranker = index::make_ranker(*ranker_config);
+
+        for (const auto& mode : {"", "-in-memory"})
+        {
+            auto name = std::string{"ranker/"} + method + mode;
+            if (!h.selected(name))
+                continue;
+
+            auto& index = *mode ? *ram_idx : *idx;
+            h.run(name, queries.size(), [&]()
+                  {
+                      uint64_t results = 0;
+                      for (const auto& query : queries)
+                          results += ranker->score(index, query, 10).size();
+                      do_not_optimize(results);
+                  });
+        }
+    }
+
+    // one to three term queries over the most frequent words, evaluated
+    // with each strategy
+    zipf_distribution head{200};
+    std::uniform_int_distribution<uint64_t> short_length{1, 3};
+    std::vector<corpus::document> short_queries(200);
+    for (auto& query : short_queries)
+        query.content(make_text(words, head, short_length(rng), rng));
+
+    auto ranker_config = cpptoml::make_table();
+    ranker_config->insert("method", std::string{"bm25"});
+    auto ranker = index::make_ranker(*ranker_config);
+    using strategy_type = index::evaluation_strategy;
+    const std::pair<const char*, strategy_type> strategies[]
+        = {{"document-at-a-time", strategy_type::DOCUMENT_AT_A_TIME},
+           {"term-at-a-time", strategy_type::TERM_AT_A_TIME},
+           {"automatic", strategy_type::AUTOMATIC}};
+    for (const auto& strategy : strategies)
+    {
+        auto name = std::string{"ranker/short-bm25-"} + strategy.first;
+        if (!h.selected(name))
+            continue;
+
+        ranker->strategy(strategy.second);
+        h.run(name, short_queries.size(), [&]()
+              {
+                  uint64_t results = 0;
+                  for (const auto& query : short_queries)
+                      results += ranker->score(*idx, query, 10).size();
+                  do_not_optimize(results);
+              });
+    }
+}
+}
+}
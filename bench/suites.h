@@ -0,0 +1,54 @@
+/**
+ * @file suites.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_BENCH_SUITES_H_
+#define META_BENCH_SUITES_H_
+
+#include <string>
+
+#include "harness.h"
+
+namespace meta
+{
+namespace bench
+{
+
+/**
+ * Every benchmark suite has this signature: it runs its benchmarks on the
+ * given harness, using the given (existing, empty) directory for any files
+ * it needs to create.
+ */
+using suite_function = void (*)(harness&, const std::string&);
+
+/// Postings encoding/decoding, multiway_merge, and vocabulary_map lookup
+void index_benchmarks(harness& h, const std::string& dir);
+
+/// probe_map insertion and lookup
+void hashing_benchmarks(harness& h, const std::string& dir);
+
+/// Analyzer filter chains
+void analyzer_benchmarks(harness& h, const std::string& dir);
+
+/// Query scoring with every ranker
+void ranker_benchmarks(harness& h, const std::string& dir);
+
+/// sgd_model updates
+void learn_benchmarks(harness& h, const std::string& dir);
+
+/// CRF training (forward-backward) and tagging
+void crf_benchmarks(harness& h, const std::string& dir);
+
+/// Language model scoring
+void lm_benchmarks(harness& h, const std::string& dir);
+
+/// LDA Gibbs sampling
+void topics_benchmarks(harness& h, const std::string& dir);
+}
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file synthetic.cpp
+ * @author agent
+ */
+
+#include <cctype>
+#include <fstream>
+#include <unordered_set>
+
+#include "meta/io/filesystem.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+std::vector<std::string> make_words(uint64_t count, random_engine& rng)
+{
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<uint64_t> length{2, 10};
+
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> words;
+    words.reserve(count);
+    while (words.size() < count)
+    {
+        std::string word(length(rng), ' ');
+        for (auto& c : word)
+            c = static_cast<char>(letter(rng));
+        if (seen.insert(word).second)
+            words.push_back(std::move(word));
+    }
+    return words;
+}
+
+std::string make_text(const std::vector<std::string>& words,
+                      const zipf_distribution& dist, uint64_t length,
+                      random_engine& rng)
+{
+    std::uniform_int_distribution<uint64_t> sentence_length{5, 20};
+    std::uniform_int_distribution<int> comma{0, 9};
+
+    std::string text;
+    uint64_t until_end = sentence_length(rng);
+    bool capitalize = true;
+    for (uint64_t i = 0; i < length; ++i)
+    {
+        if (i > 0)
+            text += ' ';
+        const auto& word = words[dist(rng)];
+        text += word;
+        if (capitalize)
+            text[text.size() - word.size()]
+                = static_cast<char>(std::toupper(word[0]));
+        capitalize = false;
+
+        if (--until_end == 0 || i + 1 == length)
+        {
+            text += '.';
+            until_end = sentence_length(rng);
+            capitalize = true;
+        }
+        else if (comma(rng) == 0)
+        {
+            text += ',';
+        }
+    }
+    return text;
+}
+
+std::shared_ptr<cpptoml::table>
+    make_line_corpus(const std::string& prefix,
+                     const std::vector<std::string>& words, uint64_t num_docs,
+                     uint64_t doc_length, random_engine& rng)
+{
+    const std::string dataset = "synthetic";
+    filesystem::make_directories(prefix + "/" + dataset);
+
+    {
+        std::ofstream corpus_config{prefix + "/" + dataset + "/line.toml"};
+        corpus_config << "type = \"line-corpus\"\n";
+    }
+
+    zipf_distribution dist{words.size()};
+    std::ofstream docs{prefix + "/" + dataset + "/" + dataset + ".dat"};
+    for (uint64_t d = 0; d < num_docs; ++d)
+        docs << make_text(words, dist, doc_length, rng) << "\n";
+
+    auto config = cpptoml::make_table();
+    config->insert("prefix", prefix);
+    config->insert("dataset", dataset);
+    config->insert("corpus", "line.toml");
+    config->insert("index", prefix + "/" + dataset + "-idx");
+
+    auto filters = cpptoml::make_table_array();
+    for (const auto& type : {"icu-tokenizer", "lowercase", "alpha"})
+    {
+        auto filter = cpptoml::make_table();
+        filter->insert("type", std::string{type});
+        filters->push_back(filter);
+    }
+
+    auto analyzers = cpptoml::make_table_array();
+    auto analyzer = cpptoml::make_table();
+    analyzer->insert("method", "ngram-word");
+    analyzer->insert<int64_t>("ngram", 1);
+    analyzer->insert("filter", filters);
+    analyzers->push_back(analyzer);
+    config->insert("analyzers", analyzers);
+
+    return config;
+}
+}
+}
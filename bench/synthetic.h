@@ -0,0 +1,73 @@
+/**
+ * @file synthetic.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_BENCH_SYNTHETIC_H_
+#define META_BENCH_SYNTHETIC_H_
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/stats/zipf.h"
+
+namespace meta
+{
+namespace bench
+{
+
+/// The random number generator used for all synthetic data; always
+/// seeded with a fixed value so runs are comparable
+using random_engine = std::mt19937_64;
+
+/// Zipf-distributed ranks model word frequencies in the synthetic text
+using stats::zipf_distribution;
+
+/**
+ * @param count The number of words to generate
+ * @param rng The random number generator to use
+ * @return a list of distinct random lowercase words
+ */
+std::vector<std::string> make_words(uint64_t count, random_engine& rng);
+
+/**
+ * Generates a passage of text with Zipf-distributed words, sentence
+ * capitalization, and punctuation.
+ *
+ * @param words The vocabulary, most frequent word first
+ * @param dist The distribution over the vocabulary
+ * @param length The number of words in the text
+ * @param rng The random number generator to use
+ * @return the text
+ */
+std::string make_text(const std::vector<std::string>& words,
+                      const zipf_distribution& dist, uint64_t length,
+                      random_engine& rng);
+
+/**
+ * Writes a line corpus of synthetic documents and creates a
+ * configuration for indexing it with a simple ICU-based unigram
+ * analyzer.
+ *
+ * @param prefix The directory to create the corpus and index in
+ * @param words The vocabulary, most frequent word first
+ * @param num_docs The number of documents
+ * @param doc_length The number of words per document
+ * @param rng The random number generator to use
+ * @return the configuration
+ */
+std::shared_ptr<cpptoml::table>
+    make_line_corpus(const std::string& prefix,
+                     const std::vector<std::string>& words, uint64_t num_docs,
+                     uint64_t doc_length, random_engine& rng);
+}
+}
+#endif
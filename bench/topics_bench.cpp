@@ -0,0 +1,63 @@
+/**
+ * @file topics_bench.cpp
+ * @author agent
+ */
+
+#include "meta/index/forward_index.h"
+#include "meta/index/make_index.h"
+#include "meta/topics/lda_gibbs.h"
+#include "suites.h"
+#include "synthetic.h"
+
+namespace meta
+{
+namespace bench
+{
+
+namespace
+{
+/**
+ * Exposes the sampler's individual iterations so they can be timed
+ * without the convergence checks done by run().
+ */
+class lda_gibbs_sampler : public topics::lda_gibbs
+{
+  public:
+    using topics::lda_gibbs::lda_gibbs;
+    using topics::lda_gibbs::initialize;
+    using topics::lda_gibbs::perform_iteration;
+};
+}
+
+void topics_benchmarks(harness& h, const std::string& dir)
+{
+    if (!h.selected("topics/"))
+        return;
+
+    random_engine rng{47};
+    auto words = make_words(10000, rng);
+    auto config = make_line_corpus(dir, words, 2000, 100, rng);
+    auto idx = index::make_index<index::forward_index>(*config);
+
+    uint64_t tokens = 0;
+    for (const auto& d_id : idx->docs())
+        tokens += idx->doc_size(d_id);
+
+    for (const uint64_t num_topics : {10, 50})
+    {
+        auto name = "topics/lda-gibbs-iteration-k"
+                    + std::to_string(num_topics);
+        if (!h.selected(name))
+            continue;
+
+        lda_gibbs_sampler model{idx, num_topics, 0.1, 0.1};
+        model.initialize();
+        uint64_t iter = 1;
+        h.run(name, tokens, [&]()
+              {
+                  model.perform_iteration(iter++);
+              });
+    }
+}
+}
+}
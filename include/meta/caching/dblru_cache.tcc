@@ -3,6 +3,7 @@
  */
 
 #include "meta/caching/dblru_cache.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
@@ -115,17 +116,30 @@ void dblru_cache<Key, Value, Map>::emplace(Args&&... args)
 template <class Key, class Value, template <class, class> class Map>
 util::optional<Value> dblru_cache<Key, Value, Map>::find(const Key& key)
 {
+    static auto& hits
+        = metrics::get_counter("meta_cache_hits_total{cache=\"dblru\"}");
+    static auto& misses
+        = metrics::get_counter("meta_cache_misses_total{cache=\"dblru\"}");
+
     auto primary = get_primary_map();
     auto opt = primary->find(key);
     if (opt)
+    {
+        hits.add();
         return opt;
+    }
     auto secondary = get_secondary_map();
     opt = secondary->find(key);
     if (opt)
     {
+        hits.add();
         primary->insert(key, *opt);
         handle_insert();
     }
+    else
+    {
+        misses.add();
+    }
     return opt;
 }
 
@@ -1,4 +1,5 @@
 #include "meta/caching/no_evict_cache.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
@@ -17,8 +18,17 @@ void no_evict_cache<Key, Value>::insert(const Key& key, const Value& value)
 template <class Key, class Value>
 util::optional<Value> no_evict_cache<Key, Value>::find(const Key& key) const
 {
-    if (key >= values_.size())
+    static auto& hits
+        = metrics::get_counter("meta_cache_hits_total{cache=\"no_evict\"}");
+    static auto& misses
+        = metrics::get_counter("meta_cache_misses_total{cache=\"no_evict\"}");
+
+    if (key >= values_.size() || !values_[key])
+    {
+        misses.add();
         return util::nullopt;
+    }
+    hits.add();
     return values_[key];
 }
 
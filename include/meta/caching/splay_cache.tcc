@@ -3,6 +3,7 @@
  */
 
 #include "meta/caching/splay_cache.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
@@ -100,13 +101,22 @@ void splay_cache
 template <class Key, class Value>
 util::optional<Value> splay_cache<Key, Value>::find(const Key& key)
 {
+    static auto& hits
+        = metrics::get_counter("meta_cache_hits_total{cache=\"splay\"}");
+    static auto& misses
+        = metrics::get_counter("meta_cache_misses_total{cache=\"splay\"}");
+
     std::lock_guard<std::mutex> lock{mutables_};
     if (root_ != nullptr)
     {
         find(root_, key);
         if (root_->key == key)
+        {
+            hits.add();
             return {root_->value};
+        }
     }
+    misses.add();
     return {util::nullopt};
 }
 
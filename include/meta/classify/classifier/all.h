@@ -1,4 +1,5 @@
 #include "meta/classify/classifier/knn.h"
+#include "meta/classify/classifier/linear_svm.h"
 #include "meta/classify/classifier/nearest_centroid.h"
 #include "meta/classify/classifier/one_vs_all.h"
 #include "meta/classify/classifier/one_vs_one.h"
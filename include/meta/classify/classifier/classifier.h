@@ -9,12 +9,15 @@
 #ifndef META_CLASSIFIER_H_
 #define META_CLASSIFIER_H_
 
+#include <algorithm>
+#include <future>
 #include <ostream>
 #include <vector>
 #include "meta/classify/confusion_matrix.h"
 #include "meta/index/forward_index.h"
 #include "meta/learn/dataset.h"
 #include "meta/classify/multiclass_dataset_view.h"
+#include "meta/parallel/thread_pool.h"
 
 namespace meta
 {
@@ -56,6 +59,33 @@ class classifier
      */
     virtual confusion_matrix test(dataset_view_type docs) const;
 
+    /**
+     * Classifies a collection of documents in parallel: the documents are
+     * split into one contiguous block per thread in the pool, each block
+     * is tallied in its own confusion_matrix, and the matrices are merged
+     * in block order. This makes concurrent calls to classify(), which
+     * must therefore be safe to call from several threads at once;
+     * classifiers for which it is not override this.
+     *
+     * @param docs The documents to classify
+     * @param pool The thread pool to classify with
+     * @return a confusion_matrix detailing the performance of the
+     * classifier
+     */
+    virtual confusion_matrix classify_batch(dataset_view_type docs,
+                                            parallel::thread_pool& pool) const;
+
+    /**
+     * Classifies unlabeled documents in parallel, as above.
+     *
+     * @param instances The documents to classify
+     * @param pool The thread pool to classify with
+     * @return the class of each document, in order
+     */
+    virtual std::vector<class_label>
+        classify_batch(const std::vector<feature_vector>& instances,
+                       parallel::thread_pool& pool) const;
+
     /**
      * Saves the classifier model to the output stream.
      * @param out The stream to write the model to
@@ -75,18 +105,31 @@ class classifier_exception : public std::runtime_error
 /**
  * Performs k-fold cross-validation on a set of documents.
  *
+ * The folds are independent, so up to max_parallel_folds of them are
+ * trained and tested at once; each fold's training and testing views
+ * share the documents with the others and only copy their indices. Fold
+ * i is built exactly as it would be after rotating the shuffled
+ * documents i times, and the per-fold matrices are added in fold order,
+ * so the result is the same for any degree of parallelism. With more
+ * than one fold at a time, creator must be safe to call concurrently
+ * (svm_wrapper, which trains through fixed files, is not; see
+ * max_parallel_folds()).
+ *
  * @param creator A function to create classifiers given a
  * multiclass_dataset_view
  * @param docs Testing documents
  * @param k The number of folds
  * @param even_split Whether to evenly split the data by class for a fair
  * baseline
+ * @param max_parallel_folds The most folds to run at once, which also
+ * bounds how many classifiers are in memory at once
  * @return a confusion_matrix containing the results over all the folds
  */
 template <class Creator>
 confusion_matrix cross_validate(Creator&& creator,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split = false)
+                                bool even_split = false,
+                                uint64_t max_parallel_folds = 1)
 {
     using diff_type = decltype(docs.begin())::difference_type;
     // docs might be ordered by class, so make sure things are shuffled
@@ -94,26 +137,58 @@ confusion_matrix cross_validate(Creator&& creator,
     if (even_split)
         docs = docs.create_even_split();
 
-    confusion_matrix matrix;
     auto step_size = docs.size() / k;
-    for (size_t i = 0; i < k; ++i)
+    auto run_fold = [&](size_t i)
     {
         LOG(info) << "Cross-validating fold " << (i + 1) << "/" << k << ENDLG;
+        auto fold = docs;
+        fold.rotate(i * step_size);
         multiclass_dataset_view train_view{
-            docs, docs.begin() + static_cast<diff_type>(step_size), docs.end()};
+            fold, fold.begin() + static_cast<diff_type>(step_size),
+            fold.end()};
 
         auto cls = creator(train_view);
         multiclass_dataset_view test_view{
-            docs, docs.begin(),
-            docs.begin() + static_cast<diff_type>(step_size)};
-        auto m = cls->test(test_view);
-        matrix += m;
-        docs.rotate(step_size);
+            fold, fold.begin(),
+            fold.begin() + static_cast<diff_type>(step_size)};
+        return cls->test(test_view);
+    };
+
+    confusion_matrix matrix;
+    if (max_parallel_folds <= 1)
+    {
+        for (size_t i = 0; i < k; ++i)
+            matrix += run_fold(i);
+        return matrix;
     }
 
+    parallel::thread_pool pool{std::min<uint64_t>(max_parallel_folds, k)};
+    std::vector<std::future<confusion_matrix>> folds;
+    folds.reserve(k);
+    for (size_t i = 0; i < k; ++i)
+        folds.emplace_back(pool.submit_task([&run_fold, i]()
+                                            {
+                                                return run_fold(i);
+                                            }));
+    for (auto& fold : folds)
+        matrix += fold.get();
     return matrix;
 }
 
+/**
+ * Determines how many cross-validation folds may run at once with the
+ * classifier a configuration creates. Classifiers that train or classify
+ * through fixed files (svm_wrapper, either itself or as the base of an
+ * ensemble) would have concurrent folds overwrite each other's files, so
+ * they are limited to one fold at a time.
+ *
+ * @param config The configuration used to create the classifier
+ * @param requested The number of folds requested to run at once
+ * @return the number of folds to run at once
+ * @throw classifier_exception if requested is not positive
+ */
+uint64_t max_parallel_folds(const cpptoml::table& config, int64_t requested);
+
 /**
  * Performs k-fold cross-validation on a set of documents.
  *
@@ -122,11 +197,14 @@ confusion_matrix cross_validate(Creator&& creator,
  * @param k The number of folds
  * @param even_split Whether to evenly split the data by class for a fair
  * baseline
+ * @param max_parallel_folds The most folds to run at once, which is
+ * further limited by max_parallel_folds(config, ...)
  * @return a confusion_matrix containing the results over all the folds
  */
 confusion_matrix cross_validate(const cpptoml::table& config,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split = false);
+                                bool even_split = false,
+                                uint64_t max_parallel_folds = 1);
 }
 }
 #endif
@@ -12,6 +12,7 @@
 #include <unordered_set>
 #include "meta/index/inverted_index.h"
 #include "meta/index/forward_index.h"
+#include "meta/index/hnsw_index.h"
 #include "meta/index/ranker/ranker.h"
 #include "meta/classify/classifier_factory.h"
 #include "meta/classify/classifier/classifier.h"
@@ -39,6 +40,18 @@ namespace classify
  * [classifier]
  * weighted = true # default is false
  * ~~~
+ *
+ * Instead of a ranker, the neighbors can be found approximately with an
+ * index::hnsw_index over the TF-IDF weighted training documents, scored
+ * by cosine similarity, which avoids a full retrieval query for each
+ * document classified:
+ * ~~~toml
+ * [classifier.hnsw]
+ * m = 16 # links per node; more is slower but more accurate
+ * ef-construction = 200 # candidates considered while building
+ * ef = 50 # candidates considered while classifying
+ * num-threads = 8 # defaults to the number of hardware threads
+ * ~~~
  */
 class knn : public classifier
 {
@@ -60,8 +73,28 @@ class knn : public classifier
         std::unique_ptr<index::ranker> ranker, bool weighted = false);
 
     /**
-     * Loads a knn classifier from a stream.
+     * Finds the neighbors with an approximate nearest neighbor graph
+     * instead of a ranker.
+     *
+     * @param docs The training documents
+     * @param idx The index to run the classifier on
+     * @param k The value of k in k-NN
+     * @param options The settings for building the graph
+     * @param ef The size of the candidate list when searching the graph
+     * @param weighted Whether to weight the neighbors by distance to the query
+     */
+    knn(multiclass_dataset_view docs,
+        std::shared_ptr<index::inverted_index> idx, uint16_t k,
+        const index::hnsw_options& options, uint64_t ef,
+        bool weighted = false);
+
+    /**
+     * Loads a knn classifier from a stream. Models saved before the
+     * format was versioned (which always rank the neighbors exactly) are
+     * still read.
+     *
      * @param in The stream to read from
+     * @throw knn_exception if the model was saved in a newer format
      */
     knn(std::istream& in);
 
@@ -75,7 +108,34 @@ class knn : public classifier
 
     void save(std::ostream& out) const override;
 
+    /**
+     * The default size of the candidate list when searching the graph.
+     */
+    const static constexpr uint64_t default_ef = 50;
+
+    /**
+     * The version of the format models are saved in. It is written where
+     * unversioned models stored their weighted flag (0 or 1), so it
+     * starts at 2.
+     */
+    const static constexpr uint64_t format_version = 2;
+
   private:
+    /**
+     * Loads a knn classifier saved in a given version of the format.
+     *
+     * @param in The stream to read from, after the version
+     * @param version The format version, or the weighted flag of an
+     * unversioned model
+     */
+    knn(std::istream& in, uint64_t version);
+
+    /**
+     * @param instance A document
+     * @return its TF-IDF weighted vector
+     */
+    index::hnsw_index::vector_type weigh(const feature_vector& instance) const;
+
     /**
      * @param scored
      * @param sorted
@@ -92,10 +152,20 @@ class knn : public classifier
     uint16_t k_;
 
     /**
-     * The ranker that is used to score the queries in the index.
+     * The ranker that is used to score the queries in the index, if the
+     * neighbors are found exactly.
      */
     std::unique_ptr<index::ranker> ranker_;
 
+    /** the graph the neighbors are found with, if they are approximated */
+    std::unique_ptr<index::hnsw_index> hnsw_;
+
+    /** the size of the candidate list when searching the graph */
+    uint64_t ef_;
+
+    /** the inverse document frequency of each term in the training set */
+    std::vector<double> idf_;
+
     /** documents that are "legal" to be used in the results */
     std::unordered_set<doc_id> legal_docs_;
 
@@ -0,0 +1,150 @@
+/**
+ * @file linear_svm.h
+ * @author agent
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_LINEAR_SVM_H_
+#define META_CLASSIFY_LINEAR_SVM_H_
+
+#include <thread>
+#include <vector>
+
+#include "meta/classify/binary_dataset_view.h"
+#include "meta/classify/classifier/classifier.h"
+#include "meta/classify/classifier_factory.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * Trains linear classifiers in-process by dual coordinate descent, the
+ * method used by liblinear (Hsieh et al., 2008 for the SVMs; Yu et al.,
+ * 2011 for logistic regression). Each pass updates one dual variable at a
+ * time in a random order while keeping the primal weight vector in sync,
+ * so an update costs a single sparse dot product. Instances whose dual
+ * variables are stuck at a bound are shrunk out of the active set until
+ * the solver looks converged, at which point everything is checked again.
+ *
+ * With more than two classes, one model is trained per class against the
+ * rest, in parallel; the class whose model scores a document highest is
+ * predicted.
+ *
+ * Required config parameters:
+ * ~~~toml
+ * [classifier]
+ * method = "linear-svm"
+ * ~~~
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [classifier]
+ * loss = "l2-svm" # or "l1-svm" or "logistic"
+ * c = 1.0 # the cost of misclassifying a training instance
+ * epsilon = 0.1 # the stopping tolerance
+ * max-iter = 1000 # the most passes over the data
+ * bias = true # whether to learn a bias term
+ * num-threads = 8 # defaults to the number of hardware threads
+ * ~~~
+ */
+class linear_svm : public classifier
+{
+  public:
+    /**
+     * The losses that can be minimized. All are L2-regularized.
+     */
+    enum class loss_type
+    {
+        /// The squared hinge loss
+        L2_SVM,
+        /// The hinge loss
+        L1_SVM,
+        /// The logistic loss
+        LOGISTIC
+    };
+
+    /**
+     * Training options.
+     */
+    struct options_type
+    {
+        loss_type loss = loss_type::L2_SVM;
+        double c = 1.0;
+        double epsilon = 0.1;
+        uint64_t max_iter = 1000;
+        bool bias = true;
+        uint64_t num_threads = std::thread::hardware_concurrency();
+
+        options_type()
+        {
+            // nothing; see learn::sgd_model::options_type
+        }
+    };
+
+    /**
+     * @param docs The training documents
+     * @param options The training options
+     */
+    linear_svm(multiclass_dataset_view docs, options_type options = {});
+
+    /**
+     * Loads a linear_svm from a stream.
+     * @param in The stream to read from
+     */
+    linear_svm(std::istream& in);
+
+    void save(std::ostream& out) const override;
+
+    class_label classify(const feature_vector& doc) const override;
+
+    /**
+     * The identifier for this classifier.
+     */
+    const static util::string_view id;
+
+  private:
+    /**
+     * @param model The index of a model
+     * @param doc A document
+     * @return the score of the document under that model
+     */
+    double score(uint64_t model, const feature_vector& doc) const;
+
+    /// The labels, in the order of their models; with two classes, the
+    /// single model separates the first label from the second
+    std::vector<class_label> labels_;
+
+    /// The weights of each model, with the bias weight last
+    std::vector<std::vector<double>> weights_;
+
+    /// The value of the bias feature (0 if there is no bias)
+    double bias_;
+};
+
+/**
+ * Trains a binary linear classifier by dual coordinate descent.
+ *
+ * @param docs The training documents
+ * @param options The training options (num_threads is ignored)
+ * @return the weight of each feature, followed by the bias weight;
+ * positive documents score above zero
+ */
+std::vector<double> train_linear_svm(binary_dataset_view docs,
+                                     const linear_svm::options_type& options);
+
+/**
+ * Specialization of the factory method used to create linear_svm
+ * classifiers.
+ */
+template <>
+std::unique_ptr<classifier>
+    make_classifier<linear_svm>(const cpptoml::table& config,
+                                multiclass_dataset_view training);
+}
+}
+#endif
@@ -65,7 +65,14 @@ namespace classify
  * bias = 1.0
  * lambda = 0.0001
  * max-iter = 50
+ * batch-size = 0 # more than zero trains on mini-batches
+ * optimizer = "adagrad" # or "adam", for mini-batches
+ * num-threads = 1 # per independent regression
  * ~~~
+ *
+ * The independent regressions are trained in parallel, unless each
+ * trains on several threads itself, in which case they are trained one
+ * at a time.
  */
 class logistic_regression : public classifier
 {
@@ -77,11 +84,14 @@ class logistic_regression : public classifier
      * independent regressions
      * @param max_iter The maximum number of iterations for training each
      * independent regression
+     * @param training How each independent regression makes its passes
+     * over the data
      */
     logistic_regression(multiclass_dataset_view docs,
                         learn::sgd_model::options_type options,
                         double gamma = sgd::default_gamma,
-                        uint64_t max_iter = sgd::default_max_iter);
+                        uint64_t max_iter = sgd::default_max_iter,
+                        learn::sgd_model::training_options_type training = {});
 
     /**
      * Loads a logistic_regression classifier from a stream.
@@ -9,12 +9,14 @@
 #ifndef META_NAIVE_BAYES_H_
 #define META_NAIVE_BAYES_H_
 
+#include <thread>
 #include <unordered_map>
 #include "meta/index/forward_index.h"
 #include "meta/classify/classifier/classifier.h"
 #include "meta/classify/classifier_factory.h"
 #include "meta/meta.h"
 #include "meta/stats/multinomial.h"
+#include "meta/util/padded_matrix.h"
 #include "meta/util/sparse_vector.h"
 
 #include "meta/classify/multiclass_dataset_view.h"
@@ -28,6 +30,13 @@ namespace classify
  * Implements the Naive Bayes classifier, a simplistic probabilistic classifier
  * that uses Bayes' theorem with strong feature independence assumptions.
  *
+ * Terms are counted in parallel over blocks of the training documents.
+ * Once trained (or loaded), the smoothed distributions are turned into a
+ * dense table of \f$\log P(term|class)\f$, one row of all the classes per
+ * term, plus the log-probability of a term no class has seen. Classifying
+ * a document is then a single pass over its terms adding each row into
+ * every class' score at once, with no lookups or logarithms.
+ *
  * Required config parameters: none.
  * Optional config parameters:
  * ~~~toml
@@ -35,6 +44,7 @@ namespace classify
  * method = "naive-bayes"
  * alpha = 0.1
  * beta = 0.1
+ * num-threads = 8 # defaults to the number of hardware threads
  * ~~~
  */
 class naive_bayes : public classifier
@@ -52,9 +62,11 @@ class naive_bayes : public classifier
      * @param docs The training data
      * @param alpha Optional smoothing parameter for term frequencies
      * @param beta Optional smoothing parameter for class frequencies
+     * @param num_threads The number of threads to count terms with
      */
     naive_bayes(dataset_view_type docs, double alpha = default_alpha,
-                double beta = default_beta);
+                double beta = default_beta,
+                uint64_t num_threads = std::thread::hardware_concurrency());
 
     /**
      * Constructor: loads a pre-trained model from an input stream.
@@ -82,8 +94,17 @@ class naive_bayes : public classifier
     const static util::string_view id;
 
   private:
+    /**
+     * Counts the terms of each class and the documents of each class.
+     * @param docs The training data
+     * @param num_threads The number of threads to count with
+     */
+    void train(const dataset_view_type& docs, uint64_t num_threads);
 
-    void train(const dataset_view_type& docs);
+    /**
+     * Builds the log-probability table from the distributions.
+     */
+    void finalize();
 
     /**
      * Contains P(term|class) for each class.
@@ -94,6 +115,19 @@ class naive_bayes : public classifier
      * Contains the number of documents in each class
      */
     stats::multinomial<class_label> class_probs_;
+
+    /// The classes, in the order of the columns of the table
+    std::vector<class_label> labels_;
+
+    /// log P(term|class), one row per term id and one column per class
+    /// (padded to whole SSE vectors)
+    util::padded_matrix<float, 16> log_probs_;
+
+    /// log P(term|class) for a term outside the table
+    std::vector<double> unseen_log_probs_;
+
+    /// log P(class)
+    std::vector<double> log_priors_;
 };
 
 class naive_bayes_exception : public std::runtime_error
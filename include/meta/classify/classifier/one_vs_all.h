@@ -13,6 +13,7 @@
 #include "meta/classify/classifier_factory.h"
 #include "meta/classify/classifier/online_classifier.h"
 #include "meta/meta.h"
+#include "meta/util/padded_matrix.h"
 
 namespace meta
 {
@@ -32,6 +33,28 @@ namespace classify
  * loss = "hinge" # for example
  * prefix = "sgd-model" # for example
  * ~~~
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [classifier]
+ * packed-weights-mb = 0 # the most memory packed weights may take
+ * ~~~
+ *
+ * The binary classifiers are trained in parallel, unless the base
+ * classifier sets `num-threads` above one, in which case they are trained
+ * one at a time on that many threads each.
+ *
+ * When every base classifier is an sgd classifier, their weights can
+ * also be packed into a util::padded_matrix with a row per feature and a
+ * column per class, so that classify() scores every class in a single
+ * pass over the document's features rather than one pass per class. The
+ * packed weights are dense: they take 8 bytes per feature per class
+ * (with the classes rounded up to a multiple of 8), e.g. 4 GB for a
+ * million features and 500 classes, on top of the base classifiers'
+ * own weights. They are therefore only built, after training, when they
+ * fit in `packed-weights-mb` (which is 0, disabling them, by default),
+ * or when compile() is called. train_one() drops them until compile() is
+ * called again, and they are not saved with the model.
  */
 class one_vs_all : public online_classifier
 {
@@ -44,8 +67,11 @@ class one_vs_all : public online_classifier
      *
      * @param docs The training data
      * @param base The configuration for the individual binary_classifiers
+     * @param max_packed_bytes The most memory the packed weights may take
+     * for them to be built after training
      */
-    one_vs_all(multiclass_dataset_view docs, const cpptoml::table& base);
+    one_vs_all(multiclass_dataset_view docs, const cpptoml::table& base,
+               uint64_t max_packed_bytes = 0);
 
     /**
      * Loads a one_vs_all classifier from a stream.
@@ -62,17 +88,60 @@ class one_vs_all : public online_classifier
     void train_one(const feature_vector& doc,
                    const class_label& label) override;
 
+    /**
+     * Packs the weights of the base classifiers for classify(), if they
+     * are all sgd classifiers, regardless of the memory they take. Scores
+     * match those of the individual classifiers up to rounding.
+     */
+    void compile();
+
+    /**
+     * @return whether classify() is using packed weights
+     */
+    bool compiled() const;
+
     /**
      * The identifier for this classifier.
      */
     const static util::string_view id;
 
   private:
+    /**
+     * Packs the weights of the base classifiers if they are all sgd
+     * classifiers and the packed weights would fit in the given memory.
+     *
+     * @param max_bytes The most memory the packed weights may take
+     */
+    void compile(uint64_t max_bytes);
+
+    /**
+     * Discards the packed weights.
+     */
+    void decompile();
+
     /**
      * The set of classifiers this ensemble uses for classification.
      */
     std::unordered_map<class_label, std::unique_ptr<binary_classifier>>
         classifiers_;
+
+    /// The most memory the packed weights may take to be built after
+    /// training (not saved with the model)
+    uint64_t max_packed_bytes_ = 0;
+
+    /// The label of each column of the packed weights, in the iteration
+    /// order of classifiers_ (empty when not compiled)
+    std::vector<class_label> labels_;
+
+    /// The stored weights of every class, one row per feature and one
+    /// column per class
+    util::padded_matrix<double> weights_;
+
+    /// The stored bias of each class
+    std::vector<double> biases_;
+
+    /// The scale factor of each class' stored weights
+    std::vector<double> scales_;
 };
 
 /**
@@ -44,7 +44,13 @@ namespace classify
  * l1-regularization = 0
  * max-iter = 5
  * calibrate = false
+ * num-threads = 1 # more than one trains Hogwild style
+ * batch-size = 0 # more than zero trains on mini-batches
+ * optimizer = "adagrad" # or "adam", for mini-batches
  * ~~~
+ *
+ * With mini-batches, the learning rate defaults to
+ * learn::sgd_model::default_adam_learning_rate for Adam.
  */
 class sgd : public online_binary_classifier
 {
@@ -62,11 +68,14 @@ class sgd : public online_binary_classifier
      * @param bias \f$b\f$, the bias
      * @param lambda \f$\lambda\f$, the regularization constant
      * @param max_iter The maximum number of iterations for training.
+     * @param calibrate Whether to calibrate the learning rate first
+     * @param training How to make the passes over the data
      */
     sgd(binary_dataset_view docs,
         std::unique_ptr<learn::loss::loss_function> loss,
         learn::sgd_model::options_type options, double gamma = default_gamma,
-        size_t max_iter = default_max_iter, bool calibrate = false);
+        size_t max_iter = default_max_iter, bool calibrate = false,
+        learn::sgd_model::training_options_type training = {});
 
     /**
      * Loads an sgd classifier from a stream.
@@ -90,6 +99,16 @@ class sgd : public online_binary_classifier
      */
     double predict(const feature_vector& doc) const override;
 
+    /**
+     * @return the underlying linear model
+     */
+    const learn::sgd_model& model() const;
+
+    /**
+     * @return how the model makes its passes over the data
+     */
+    const learn::sgd_model::training_options_type& training() const;
+
     /**
      * The identifier for this classifier.
      */
@@ -110,6 +129,9 @@ class sgd : public online_binary_classifier
     /// The maximum number of iterations for training.
     const size_t max_iter_;
 
+    /// How to make the passes over the data (not saved with the model)
+    learn::sgd_model::training_options_type training_;
+
     /// The loss function to be used for the update.
     std::unique_ptr<learn::loss::loss_function> loss_;
 };
@@ -31,6 +31,8 @@ namespace classify
  * submodule and have compiled both libsvm and liblinear.
  *
  * If no kernel is selected, liblinear is used. Otherwise, libsvm is used.
+ * For linear models, prefer linear_svm, which runs the same solvers
+ * in-process instead of through files and subprocesses.
  *
  * Required config parameters:
  * ~~~toml
@@ -98,6 +100,30 @@ class svm_wrapper : public classifier
      */
     confusion_matrix test(dataset_view_type docs) const override;
 
+    /**
+     * The external predictor writes to fixed files, so documents are
+     * classified with a single call to it rather than in parallel.
+     *
+     * @param docs The documents to classify
+     * @param pool Unused
+     * @return a confusion_matrix detailing the performance of the
+     * classifier
+     */
+    confusion_matrix classify_batch(dataset_view_type docs,
+                                    parallel::thread_pool& pool) const override;
+
+    /**
+     * Classifies unlabeled documents with a single call to the external
+     * predictor.
+     *
+     * @param instances The documents to classify
+     * @param pool Unused
+     * @return the class of each document, in order
+     */
+    std::vector<class_label>
+        classify_batch(const std::vector<feature_vector>& instances,
+                       parallel::thread_pool& pool) const override;
+
     /**
      * The identifier for this classifier.
      */
@@ -14,6 +14,7 @@
 #include <unordered_map>
 
 #include "meta/meta.h"
+#include "meta/util/padded_matrix.h"
 #include "meta/util/sparse_vector.h"
 
 namespace meta
@@ -33,6 +34,12 @@ class linear_model_exception : public std::runtime_error
 /**
  * A storage class for multiclass linear classifier models. This class
  * should be used to store classifiers that fit in memory.
+ *
+ * Once a model is done being trained, it can be compiled: each feature is
+ * given a row of a util::padded_matrix holding a weight for every class,
+ * so scoring a feature vector costs one lookup per feature instead of a
+ * lookup followed by a merge of sparse class weights. Any change to the
+ * weights discards the compiled form.
  */
 template <class FeatureId, class FeatureValue, class ClassId>
 class linear_model
@@ -178,11 +185,73 @@ class linear_model
      */
     const weight_vectors& weights() const;
 
+    /**
+     * The most memory, in bytes, that compile() lets the dense
+     * representation take by default.
+     */
+    const static constexpr uint64_t default_max_compiled_bytes = 128 << 20;
+
+    /**
+     * Builds the dense representation of the weights that best_class()
+     * and best_classes() use until the weights next change. Scores are
+     * the same as those of the sparse representation.
+     *
+     * The dense representation takes a padded row of weights for every
+     * feature, on top of the sparse weights. If that would take more than
+     * max_bytes (as for models with millions of features and hundreds of
+     * classes), the model is left uncompiled and keeps scoring with the
+     * sparse representation.
+     *
+     * @param max_bytes The most memory the dense representation may take
+     */
+    void compile(uint64_t max_bytes = default_max_compiled_bytes);
+
+    /**
+     * @return whether the model is currently compiled
+     */
+    bool compiled() const;
+
   private:
+    /**
+     * Discards the compiled representation, if there is one.
+     */
+    void decompile();
+
+    /**
+     * Computes the scores of every class for a feature vector with the
+     * compiled representation.
+     *
+     * @param features The feature vector to score
+     * @param scores The score of each column (resized and overwritten)
+     * @param touched A bitmask of the columns any feature had a weight in
+     * (resized and overwritten)
+     */
+    template <class FeatureVector>
+    void score_compiled(FeatureVector&& features,
+                        std::vector<feature_value>& scores,
+                        std::vector<uint64_t>& touched) const;
+
     /**
      * The weights for the model
      */
     weight_vectors weights_;
+
+    /// Whether the compiled representation is up to date
+    bool compiled_ = false;
+
+    /// The row of each feature in the compiled matrix
+    std::unordered_map<feature_id, uint64_t> rows_;
+
+    /// The class of each column in the compiled matrix, in increasing
+    /// order
+    std::vector<class_id> classes_;
+
+    /// The compiled weights, one row per feature and one column per class
+    util::padded_matrix<feature_value> matrix_;
+
+    /// Which columns of each row had a weight in the sparse
+    /// representation, as a bitmask of ceil(classes / 64) words per row
+    std::vector<uint64_t> present_;
 };
 }
 }
@@ -6,12 +6,14 @@
  * consult the file LICENSE in the root of the project.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 
 #include "meta/classify/models/linear_model.h"
 #include "meta/io/packed.h"
 #include "meta/logging/logger.h"
+#include "meta/math/integer.h"
 #include "meta/util/fixed_heap.h"
 
 namespace meta
@@ -19,12 +21,17 @@ namespace meta
 namespace classify
 {
 
+template <class FeatureId, class FeatureValue, class ClassId>
+const constexpr uint64_t
+    linear_model<FeatureId, FeatureValue, ClassId>::default_max_compiled_bytes;
+
 template <class FeatureId, class FeatureValue, class ClassId>
 void linear_model<FeatureId, FeatureValue, ClassId>::load(std::istream& model)
 {
     if (!model)
         throw exception{"model not found"};
 
+    decompile();
     uint64_t num_feats;
     io::packed::read(model, num_feats);
 
@@ -83,6 +90,28 @@ template <class FeatureVector, class Filter>
 auto linear_model<FeatureId, FeatureValue, ClassId>::best_class(
     FeatureVector&& features, Filter&& filter) const -> class_id
 {
+    if (compiled_)
+    {
+        std::vector<feature_value> scores;
+        std::vector<uint64_t> touched;
+        score_compiled(std::forward<FeatureVector>(features), scores, touched);
+
+        auto best_score = std::numeric_limits<feature_value>::lowest();
+        class_id best_class{};
+        for (uint64_t col = 0; col < classes_.size(); ++col)
+        {
+            if (!(touched[col / 64] & (uint64_t{1} << (col % 64))))
+                continue;
+
+            if (scores[col] > best_score && filter(classes_[col]))
+            {
+                best_class = classes_[col];
+                best_score = scores[col];
+            }
+        }
+        return best_class;
+    }
+
     weight_vector class_scores;
     for (const auto& feat : features)
     {
@@ -134,6 +163,29 @@ auto linear_model<FeatureId, FeatureValue, ClassId>::best_classes(
     FeatureVector&& features, uint64_t num,
     Filter&& filter) const -> scored_classes
 {
+    auto comp = [](const scored_class& lhs, const scored_class& rhs)
+    {
+        return lhs.second > rhs.second;
+    };
+
+    util::fixed_heap<scored_class, decltype(comp)> heap{num, comp};
+    if (compiled_)
+    {
+        std::vector<feature_value> scores;
+        std::vector<uint64_t> touched;
+        score_compiled(std::forward<FeatureVector>(features), scores, touched);
+
+        for (uint64_t col = 0; col < classes_.size(); ++col)
+        {
+            if (!(touched[col / 64] & (uint64_t{1} << (col % 64))))
+                continue;
+
+            if (filter(classes_[col]))
+                heap.emplace(classes_[col], scores[col]);
+        }
+        return heap.extract_top();
+    }
+
     weight_vector class_scores;
     for (const auto& feat : features)
     {
@@ -153,12 +205,6 @@ auto linear_model<FeatureId, FeatureValue, ClassId>::best_classes(
         }
     }
 
-    auto comp = [](const scored_class& lhs, const scored_class& rhs)
-    {
-        return lhs.second > rhs.second;
-    };
-
-    util::fixed_heap<scored_class, decltype(comp)> heap{num, comp};
     for (const auto& score : class_scores)
     {
         auto cid = score.first;
@@ -185,6 +231,7 @@ template <class FeatureId, class FeatureValue, class ClassId>
 void linear_model<FeatureId, FeatureValue, ClassId>::update(
     const weight_vectors& updates, feature_value scale)
 {
+    decompile();
     for (const auto& feat_vec : updates)
     {
         const auto& feat = feat_vec.first;
@@ -199,12 +246,15 @@ template <class FeatureId, class FeatureValue, class ClassId>
 void linear_model<FeatureId, FeatureValue, ClassId>::update(
     const class_id& cid, const feature_id& fid, feature_value delta)
 {
+    decompile();
     weights_[fid][cid] += delta;
 }
 
 template <class FeatureId, class FeatureValue, class ClassId>
 void linear_model<FeatureId, FeatureValue, ClassId>::condense(bool log)
 {
+    decompile();
+
     // build feature set
     std::vector<feature_id> features;
     features.reserve(weights_.size());
@@ -235,5 +285,93 @@ auto linear_model<FeatureId, FeatureValue, ClassId>::weights() const -> const
 {
     return weights_;
 }
+
+template <class FeatureId, class FeatureValue, class ClassId>
+void linear_model<FeatureId, FeatureValue, ClassId>::compile(
+    uint64_t max_bytes)
+{
+    decompile();
+
+    for (const auto& feat_vec : weights_)
+        for (const auto& weight : feat_vec.second)
+            classes_.push_back(weight.first);
+    std::sort(classes_.begin(), classes_.end());
+    classes_.erase(std::unique(classes_.begin(), classes_.end()),
+                   classes_.end());
+
+    auto words = math::integer::div_ceil(classes_.size(), 64);
+    auto bytes = util::padded_matrix<feature_value>::bytes(weights_.size(),
+                                                           classes_.size())
+                 + weights_.size() * words * sizeof(uint64_t);
+    if (bytes > max_bytes)
+    {
+        classes_ = {};
+        return;
+    }
+
+    matrix_ = {weights_.size(), classes_.size()};
+    present_.assign(weights_.size() * words, 0);
+    rows_.reserve(weights_.size());
+
+    uint64_t row = 0;
+    for (const auto& feat_vec : weights_)
+    {
+        rows_[feat_vec.first] = row;
+        for (const auto& weight : feat_vec.second)
+        {
+            auto col = static_cast<uint64_t>(
+                std::lower_bound(classes_.begin(), classes_.end(), weight.first)
+                - classes_.begin());
+            matrix_(row, col) = weight.second;
+            present_[row * words + col / 64] |= uint64_t{1} << (col % 64);
+        }
+        ++row;
+    }
+    compiled_ = true;
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+bool linear_model<FeatureId, FeatureValue, ClassId>::compiled() const
+{
+    return compiled_;
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+void linear_model<FeatureId, FeatureValue, ClassId>::decompile()
+{
+    if (!compiled_)
+        return;
+
+    compiled_ = false;
+    rows_ = {};
+    classes_ = {};
+    matrix_ = {};
+    present_ = {};
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector>
+void linear_model<FeatureId, FeatureValue, ClassId>::score_compiled(
+    FeatureVector&& features, std::vector<feature_value>& scores,
+    std::vector<uint64_t>& touched) const
+{
+    auto words = math::integer::div_ceil(classes_.size(), 64);
+    scores.assign(matrix_.stride(), feature_value{});
+    touched.assign(words, 0);
+    for (const auto& feat : features)
+    {
+        auto it = rows_.find(feat.first);
+        if (it == rows_.end())
+            continue;
+
+        // the columns a feature has no weight for hold zeros, so adding
+        // the whole row leaves the other classes' scores unchanged
+        matrix_.add_row(it->second, feat.second, scores.data());
+
+        const auto* present = present_.data() + it->second * words;
+        for (uint64_t word = 0; word < words; ++word)
+            touched[word] |= present[word];
+    }
+}
 }
 }
@@ -11,18 +11,31 @@
 #define META_CORPUS_METADATA_H_
 
 #include <cstdint>
-#include <vector>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "cpptoml.h"
 #include "meta/io/packed.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
 namespace corpus
 {
 
+/**
+ * Exception class for metadata operations.
+ */
+class metadata_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * Represents the collection of metadata for a document.
  */
@@ -41,15 +54,19 @@ class metadata
     };
 
     /**
-     * Pair for storing the schema: contains its name and type.
+     * Pair for storing the schema: contains its name and type, along with
+     * whether the field should also be stored as a column for filtering
+     * (see index::metadata_column).
      */
     struct field_info
     {
         std::string name;
         field_type type;
+        bool column = false;
 
         field_info() = default;
-        field_info(std::string n, field_type ft) : name{std::move(n)}, type{ft}
+        field_info(std::string n, field_type ft, bool col = false)
+            : name{std::move(n)}, type{ft}, column{col}
         {
             // nothing
         }
@@ -64,6 +81,58 @@ class metadata
     // compiler error in that case... clang++ accepts it just fine. -sigh-
     using schema_type = std::vector<field_info>;
 
+    /**
+     * A precompiled handle to a single metadata field. Constructing an
+     * accessor looks the field up in the schema (and checks that its type
+     * is compatible with T) once; reading the field from a document's
+     * metadata through the accessor is then a constant-time operation
+     * that performs no string comparisons.
+     *
+     * T may be any arithmetic type for numeric fields, and either
+     * std::string or util::string_view for string fields. Requesting a
+     * util::string_view does not allocate: the view points directly into
+     * the (mapped) metadata database and remains valid for as long as the
+     * owning metadata_file is alive.
+     */
+    template <class T>
+    class accessor
+    {
+      public:
+        /**
+         * @param sch The schema to look the field up in
+         * @param name The name of the field to access
+         */
+        accessor(const schema_type& sch, const std::string& name)
+        {
+            for (index_ = 0; index_ < sch.size(); ++index_)
+            {
+                if (sch[index_].name == name)
+                    break;
+            }
+
+            if (index_ == sch.size())
+                throw metadata_exception{"no metadata field named \"" + name
+                                         + "\""};
+
+            if (std::is_arithmetic<T>::value
+                == (sch[index_].type == field_type::STRING))
+                throw metadata_exception{"type mismatch for metadata field \""
+                                         + name + "\""};
+        }
+
+        /**
+         * @return the position of the field within the schema
+         */
+        uint64_t index() const
+        {
+            return index_;
+        }
+
+      private:
+        /// the position of the field within the schema
+        uint64_t index_;
+    };
+
     metadata(const char* start, const schema_type& sch)
         : schema_{&sch}, start_{start}
     {
@@ -78,52 +147,25 @@ class metadata
     template <class T>
     util::optional<T> get(const std::string& name) const
     {
-        metadata_input_stream stream{start_};
         for (uint64_t i = 0; i < schema_->size(); ++i)
         {
-            switch ((*schema_)[i].type)
-            {
-                case field_type::SIGNED_INT:
-                {
-                    int64_t si;
-                    io::packed::read(stream, si);
-                    if ((*schema_)[i].name == name)
-                        return {field{si}};
-                    break;
-                }
-
-                case field_type::UNSIGNED_INT:
-                {
-                    uint64_t ui;
-                    io::packed::read(stream, ui);
-                    if ((*schema_)[i].name == name)
-                        return {field{ui}};
-                    break;
-                }
-
-                case field_type::DOUBLE:
-                {
-                    double d;
-                    io::packed::read(stream, d);
-                    if ((*schema_)[i].name == name)
-                        return {field{d}};
-                    break;
-                }
-
-                case field_type::STRING:
-                {
-                    std::string s{stream.input_};
-                    stream.input_ += s.size() + 1;
-                    if ((*schema_)[i].name == name)
-                        return {field{std::move(s)}};
-                    break;
-                }
-            }
+            if ((*schema_)[i].name == name)
+                return {value<T>(i)};
         }
 
         return util::nullopt;
     }
 
+    /**
+     * @param acc An accessor obtained from this metadata's schema
+     * @return the metadata associated with the accessor's field
+     */
+    template <class T>
+    T get(const accessor<T>& acc) const
+    {
+        return value<T>(acc.index());
+    }
+
     /**
      * Returns the schema for this metadata object.
      */
@@ -295,6 +337,73 @@ class metadata
     };
 
   private:
+    /**
+     * @param idx The position of the field in the schema
+     * @return a pointer to the beginning of that field's encoded value
+     */
+    const char* field_start(uint64_t idx) const
+    {
+        uint32_t offset;
+        std::memcpy(&offset, start_ + idx * sizeof(uint32_t),
+                    sizeof(uint32_t));
+        return start_ + offset;
+    }
+
+    /**
+     * Decodes a numeric field.
+     * @param idx The position of the field in the schema
+     */
+    template <class T>
+    typename std::enable_if<std::is_arithmetic<T>::value, T>::type
+        value(uint64_t idx) const
+    {
+        metadata_input_stream stream{field_start(idx)};
+        switch ((*schema_)[idx].type)
+        {
+            case field_type::SIGNED_INT:
+            {
+                int64_t si;
+                io::packed::read(stream, si);
+                return static_cast<T>(si);
+            }
+
+            case field_type::UNSIGNED_INT:
+            {
+                uint64_t ui;
+                io::packed::read(stream, ui);
+                return static_cast<T>(ui);
+            }
+
+            case field_type::DOUBLE:
+            {
+                double d;
+                io::packed::read(stream, d);
+                return static_cast<T>(d);
+            }
+
+            case field_type::STRING:
+                break;
+        }
+
+        throw metadata_exception{"metadata field \"" + (*schema_)[idx].name
+                                 + "\" is not numeric"};
+    }
+
+    /**
+     * Decodes a string field. Strings are stored null-terminated, so
+     * T may be a util::string_view to avoid copying.
+     * @param idx The position of the field in the schema
+     */
+    template <class T>
+    typename std::enable_if<!std::is_arithmetic<T>::value, T>::type
+        value(uint64_t idx) const
+    {
+        if ((*schema_)[idx].type != field_type::STRING)
+            throw metadata_exception{"metadata field \"" + (*schema_)[idx].name
+                                     + "\" is not a string"};
+        return T{field_start(idx)};
+    }
+
     struct metadata_input_stream
     {
         metadata_input_stream(const char* input) : input_{input}
@@ -325,13 +434,11 @@ class metadata
 metadata::schema_type metadata_schema(const cpptoml::table& config);
 
 /**
- * Exception class for metadata operations.
+ * @param schema The schema to search
+ * @param name The name of the field to look for
+ * @return whether the schema contains a field with the given name
  */
-class metadata_exception : public std::runtime_error
-{
-  public:
-    using std::runtime_error::runtime_error;
-};
+bool has_field(const metadata::schema_type& schema, const std::string& name);
 }
 }
 #endif
@@ -0,0 +1,210 @@
+/**
+ * @file synthetic_corpus.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_SYNTHETIC_CORPUS_H_
+#define META_SYNTHETIC_CORPUS_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/corpus/corpus.h"
+#include "meta/stats/zipf.h"
+
+namespace meta
+{
+namespace corpus
+{
+
+/**
+ * Generates synthetic corpora of arbitrary size for benchmarking. Word
+ * frequencies follow a Zipf distribution and document lengths follow a
+ * log-normal distribution. Each document is generated from its own
+ * random number generator, seeded from the global seed and its id, so
+ * the output is identical no matter how many threads are used.
+ *
+ * Documents may carry class labels (each label skews its documents
+ * towards a label-specific slice of the vocabulary) and metadata fields
+ * ("year", "source", and "score"). A set of queries and relevance
+ * judgements compatible with index::ir_eval can be generated alongside
+ * the corpus. Invalid options are reported with a corpus_exception.
+ *
+ * The generator is configured with a table like the following (shown
+ * with the defaults):
+ *
+ * ~~~toml
+ * format = "line"        # one of "line", "file", "gz", or "libsvm"
+ * num-docs = 10000
+ * seed = 1
+ * threads = 0            # 0 uses all hardware threads
+ * vocab-size = 50000
+ * zipf-exponent = 1.0
+ * length-mean = 250.0    # mean document length, in words
+ * length-sigma = 0.8     # shape of the log-normal length distribution
+ * min-length = 10
+ * max-length = 10000
+ * labels = 0             # number of class labels; 0 means unlabeled
+ * label-weight = 0.3     # fraction of words drawn from the label's slice
+ * metadata = false
+ * queries = 0
+ * query-length = 3
+ * ~~~
+ */
+class synthetic_corpus
+{
+  public:
+    /**
+     * The on-disk formats the generator can produce.
+     */
+    enum class format
+    {
+        LINE,
+        FILE,
+        GZ,
+        LIBSVM
+    };
+
+    /**
+     * The parameters for the generator.
+     */
+    struct options
+    {
+        format fmt = format::LINE;
+        uint64_t num_docs = 10000;
+        uint64_t seed = 1;
+        uint64_t threads = 0;
+        uint64_t vocab_size = 50000;
+        double zipf_exponent = 1.0;
+        double length_mean = 250.0;
+        double length_sigma = 0.8;
+        uint64_t min_length = 10;
+        uint64_t max_length = 10000;
+        uint64_t num_labels = 0;
+        double label_weight = 0.3;
+        bool metadata = false;
+        uint64_t num_queries = 0;
+        uint64_t query_length = 3;
+    };
+
+    /**
+     * A generated document, as term ids into the vocabulary.
+     */
+    struct document
+    {
+        /// The words of the document, in order
+        std::vector<uint64_t> words;
+        /// The document's label, or the number of labels if unlabeled
+        uint64_t label;
+        /// The year metadata field
+        uint64_t year;
+        /// The source metadata field, as an index into sources()
+        uint64_t source;
+        /// The score metadata field
+        double score;
+    };
+
+    /**
+     * @param config The table containing the generator parameters
+     * @return the options read from the table
+     */
+    static options parse_options(const cpptoml::table& config);
+
+    /**
+     * Builds the vocabulary and word distribution for the given options.
+     *
+     * @param opts The generator parameters
+     */
+    synthetic_corpus(options opts);
+
+    /**
+     * Writes the corpus, its corpus configuration file, and (when
+     * requested) its metadata, queries, and relevance judgements to
+     * prefix/dataset.
+     *
+     * @param prefix The prefix for the dataset folder
+     * @param dataset The name of the dataset
+     */
+    void write(const std::string& prefix, const std::string& dataset) const;
+
+    /**
+     * Deterministically generates a single document.
+     *
+     * @param id The id of the document
+     * @return the document
+     */
+    document generate(uint64_t id) const;
+
+    /**
+     * @param doc A generated document
+     * @return the document's text
+     */
+    std::string text(const document& doc) const;
+
+    /**
+     * @param doc A generated document
+     * @return the document's class label
+     */
+    std::string label(const document& doc) const;
+
+    /**
+     * @return the vocabulary, most frequent word first
+     */
+    const std::vector<std::string>& vocabulary() const;
+
+    /**
+     * @return the possible values of the "source" metadata field
+     */
+    static const std::vector<std::string>& sources();
+
+  private:
+    /// The random number generator used for all generated data
+    using random_engine = std::mt19937_64;
+
+    /**
+     * @param stream Distinguishes documents from queries
+     * @param id The id of the document or query
+     * @return a generator seeded from the global seed and the id
+     */
+    random_engine engine(uint64_t stream, uint64_t id) const;
+
+    /**
+     * A generated query.
+     */
+    struct query
+    {
+        /// The words of the query
+        std::vector<uint64_t> words;
+        /// The document the query was drawn from
+        uint64_t source;
+        /// The label of that document
+        uint64_t label;
+    };
+
+    /**
+     * Generates the queries, each drawn from the less common words of a
+     * random document.
+     *
+     * @return the queries
+     */
+    std::vector<query> make_queries() const;
+
+    /// The generator parameters
+    const options opts_;
+
+    /// The vocabulary, most frequent word first
+    std::vector<std::string> words_;
+
+    /// The distribution over word ranks
+    stats::zipf_distribution dist_;
+};
+}
+}
+#endif
@@ -27,6 +27,7 @@ namespace meta
 
 namespace index
 {
+class metadata_column;
 class string_list;
 class vocabulary_map;
 }
@@ -132,6 +133,19 @@ class disk_index
      */
     corpus::metadata metadata(doc_id d_id) const;
 
+    /**
+     * @return the schema for the metadata stored in this index, suitable
+     * for constructing corpus::metadata::accessor objects
+     */
+    const corpus::metadata::schema_type& metadata_schema() const;
+
+    /**
+     * @param name The name of a metadata field that was stored as a
+     * column when the index was created
+     * @return the column for that field, for use in building filters
+     */
+    const metadata_column& column(const std::string& name) const;
+
     /**
      * @param d_id
      * @return the number of unique terms in d_id
@@ -12,13 +12,17 @@
 
 #include <mutex>
 
+#include "meta/hashing/probe_map.h"
 #include "meta/index/disk_index.h"
 #include "meta/index/metadata_file.h"
 #include "meta/index/string_list.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/parallel/thread_pool.h"
 #include "meta/util/disk_vector.h"
+#include "meta/util/huge_page_allocator.h"
 #include "meta/util/invertible_map.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -56,6 +60,13 @@ class disk_index::disk_index_impl
      */
     const static std::vector<const char*> files;
 
+    /**
+     * Filename of the description of how a forward_index stores its
+     * postings' values. It is not among files: inverted indexes do not
+     * have one, and forward indexes without one store packed doubles.
+     */
+    const static char* const postings_values_file;
+
     /**
      * Loads the metadata file.
      */
@@ -105,7 +116,42 @@ class disk_index::disk_index_impl
      */
     std::vector<class_label> class_labels() const;
 
+    /**
+     * Copies the document lengths, unique term counts, and labels, along
+     * with the whole vocabulary, into RAM so that lookups no longer read
+     * the index files. The metadata, labels, and term_id mapping must
+     * already be loaded.
+     * @param pool The thread pool to load with
+     * @return the number of bytes of RAM used by the copies
+     */
+    uint64_t load_ram_tables(parallel::thread_pool& pool);
+
   private:
+    /**
+     * RAM-resident copies of the per-document and per-term lookup
+     * structures, used when an index is loaded in memory.
+     */
+    struct ram_tables
+    {
+        /// The length of each document
+        util::huge_page_vector<uint64_t> doc_sizes;
+
+        /// The number of unique terms in each document
+        util::huge_page_vector<uint64_t> unique_terms;
+
+        /// The label of each document
+        util::huge_page_vector<label_id> labels;
+
+        /// The text of every term, back to back in term_id order
+        util::huge_page_vector<char> term_text;
+
+        /// The offset of each term's text, with the total size at the end
+        util::huge_page_vector<uint64_t> term_offsets;
+
+        /// Maps the text of each term (in term_text) to its term_id
+        hashing::probe_map<util::string_view, term_id> term_ids;
+    };
+
     /**
      * @param lbl the string class label to find the id for
      * @return the label_id of a class_label, creating a new one if
@@ -125,9 +171,21 @@ class disk_index::disk_index_impl
     /// Stores additional metadata for each document
     util::optional<metadata_file> metadata_;
 
+    /// Accessor for the "length" metadata field
+    util::optional<corpus::metadata::accessor<uint64_t>> length_field_;
+
+    /// Accessor for the "unique-terms" metadata field
+    util::optional<corpus::metadata::accessor<uint64_t>> unique_terms_field_;
+
+    /// Accessor for the "path" metadata field, if the index has one
+    util::optional<corpus::metadata::accessor<util::string_view>> path_field_;
+
     /// Maps string terms to term_ids.
     util::optional<vocabulary_map> term_id_mapping_;
 
+    /// The RAM-resident lookup tables, if the index was loaded in memory
+    util::optional<ram_tables> ram_;
+
     /// Assigns an integer to each class label (used for liblinear mappings)
     util::invertible_map<class_label, label_id> label_ids_;
 
@@ -0,0 +1,225 @@
+/**
+ * @file doc_bitset.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_DOC_BITSET_H_
+#define META_INDEX_DOC_BITSET_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "meta/meta.h"
+#include "meta/succinct/broadword.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A dense set of document ids, stored as one bit per document. These are
+ * produced by filters over metadata columns (see metadata_column) and can
+ * be combined with the usual set operations before being handed to a
+ * ranker as its filter function, e.g.
+ *
+ * ~~~cpp
+ * auto filter = idx->column("year").range(2000, 2010)
+ *               & idx->column("source").any_of({"nyt", "wsj"});
+ * auto results = ranker->score(*idx, query, 10, std::cref(filter));
+ * ~~~
+ */
+class doc_bitset
+{
+  public:
+    /**
+     * Creates a set over the document ids [0, num_docs).
+     * @param num_docs The number of documents in the index
+     * @param value Whether the set should initially contain all documents
+     */
+    doc_bitset(uint64_t num_docs = 0, bool value = false)
+        : words_((num_docs + 63) / 64, value ? ~uint64_t{0} : 0),
+          num_docs_{num_docs}
+    {
+        clear_tail();
+    }
+
+    /**
+     * @param d_id The document to test
+     * @return whether the document is in the set
+     */
+    bool test(doc_id d_id) const
+    {
+        return (words_[d_id / 64] >> (d_id % 64)) & 1;
+    }
+
+    /**
+     * Allows the set to be used directly as a ranker filter.
+     * @param d_id The document to test
+     * @return whether the document is in the set
+     */
+    bool operator()(doc_id d_id) const
+    {
+        return test(d_id);
+    }
+
+    /**
+     * Adds a document to the set.
+     * @param d_id The document to add
+     */
+    void set(doc_id d_id)
+    {
+        words_[d_id / 64] |= uint64_t{1} << (d_id % 64);
+    }
+
+    /**
+     * Adds every document in [first, last) to the set.
+     * @param first The first document to add
+     * @param last One past the last document to add
+     */
+    void set(doc_id first, doc_id last)
+    {
+        // set partial words bit by bit and whole words at once
+        uint64_t i = first;
+        for (; i < last && i % 64 != 0; ++i)
+            set(doc_id{i});
+        for (; i + 64 <= last; i += 64)
+            words_[i / 64] = ~uint64_t{0};
+        for (; i < last; ++i)
+            set(doc_id{i});
+    }
+
+    /**
+     * Removes a document from the set.
+     * @param d_id The document to remove
+     */
+    void reset(doc_id d_id)
+    {
+        words_[d_id / 64] &= ~(uint64_t{1} << (d_id % 64));
+    }
+
+    /**
+     * @return the number of documents this set ranges over
+     */
+    uint64_t size() const
+    {
+        return num_docs_;
+    }
+
+    /**
+     * @return the number of documents in the set
+     */
+    uint64_t count() const
+    {
+        uint64_t total = 0;
+        for (const auto& word : words_)
+            total += succinct::broadword::popcount(word);
+        return total;
+    }
+
+    /**
+     * @return the ids of the documents in the set, in increasing order
+     */
+    std::vector<doc_id> docs() const
+    {
+        std::vector<doc_id> ret;
+        ret.reserve(count());
+        for (uint64_t w = 0; w < words_.size(); ++w)
+        {
+            auto word = words_[w];
+            while (word)
+            {
+                ret.emplace_back(w * 64 + succinct::broadword::lsb(word));
+                word &= word - 1;
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @return the underlying words of the set
+     */
+    const std::vector<uint64_t>& words() const
+    {
+        return words_;
+    }
+
+    /**
+     * @return the underlying words of the set
+     */
+    std::vector<uint64_t>& words()
+    {
+        return words_;
+    }
+
+    /**
+     * Intersects this set with another over the same documents.
+     */
+    doc_bitset& operator&=(const doc_bitset& other)
+    {
+        for (uint64_t i = 0; i < words_.size(); ++i)
+            words_[i] &= other.words_[i];
+        return *this;
+    }
+
+    /**
+     * Unions this set with another over the same documents.
+     */
+    doc_bitset& operator|=(const doc_bitset& other)
+    {
+        for (uint64_t i = 0; i < words_.size(); ++i)
+            words_[i] |= other.words_[i];
+        return *this;
+    }
+
+    /**
+     * @return the complement of this set
+     */
+    doc_bitset operator~() const
+    {
+        doc_bitset ret{*this};
+        for (auto& word : ret.words_)
+            word = ~word;
+        ret.clear_tail();
+        return ret;
+    }
+
+  private:
+    /**
+     * Ensures that bits past num_docs_ in the last word are never set.
+     */
+    void clear_tail()
+    {
+        if (num_docs_ % 64 != 0)
+            words_.back() &= (uint64_t{1} << (num_docs_ % 64)) - 1;
+    }
+
+    /// the bits for each document
+    std::vector<uint64_t> words_;
+
+    /// the number of documents in the set's universe
+    uint64_t num_docs_;
+};
+
+/**
+ * @return the intersection of two document sets
+ */
+inline doc_bitset operator&(doc_bitset lhs, const doc_bitset& rhs)
+{
+    return lhs &= rhs;
+}
+
+/**
+ * @return the union of two document sets
+ */
+inline doc_bitset operator|(doc_bitset lhs, const doc_bitset& rhs)
+{
+    return lhs |= rhs;
+}
+}
+}
+#endif
@@ -22,6 +22,11 @@
 
 namespace meta
 {
+namespace analyzers
+{
+class analyzer;
+}
+
 namespace corpus
 {
 class corpus;
@@ -149,6 +154,25 @@ class forward_index : public disk_index
      */
     learn::feature_vector tokenize(const corpus::document& doc);
 
+    /**
+     * Analyzes a document with a given analyzer instead of the index's
+     * own. Since analyzers keep state, this allows several threads to
+     * tokenize documents at once, each with its own clone() of analyzer().
+     *
+     * @param doc The document to tokenize
+     * @param ana The analyzer to use
+     * @return the analyzed version of the document as a feature vector
+     */
+    learn::feature_vector tokenize(const corpus::document& doc,
+                                   analyzers::analyzer& ana);
+
+    /**
+     * @return the analyzer used to tokenize documents
+     * @throw forward_index_exception if the index has none (it was built
+     * from libsvm data)
+     */
+    const analyzers::analyzer& analyzer() const;
+
   private:
     /**
      * Loads a forward index from its filesystem representation.
@@ -0,0 +1,221 @@
+/**
+ * @file hnsw_index.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_HNSW_INDEX_H_
+#define META_INDEX_HNSW_INDEX_H_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "meta/index/ranker/ranker.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Exception thrown for invalid hnsw_index settings or files.
+ */
+class hnsw_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Settings for building an hnsw_index.
+ */
+struct hnsw_options
+{
+    /// The number of neighbors each node links to on the upper layers
+    /// (twice as many are kept on the bottom layer)
+    uint64_t m = 16;
+
+    /// The size of the candidate list used while inserting a node
+    uint64_t ef_construction = 200;
+
+    /// The seed for drawing the layer of each node
+    uint64_t seed = 47;
+
+    /// The number of threads to build with
+    uint64_t num_threads = std::thread::hardware_concurrency();
+};
+
+/**
+ * An approximate nearest neighbor index over sparse document vectors,
+ * using a Hierarchical Navigable Small World graph (Malkov and Yashunin,
+ * 2016). Vectors are L2-normalized when they are added, and neighbors are
+ * the documents with the highest cosine similarity. While searching, the
+ * query is scattered into a dense array once, so its similarity to each
+ * node visited is a gather over only that node's terms.
+ *
+ * Each node is assigned a layer from an exponentially decaying
+ * distribution and linked, on every layer up to its own, to neighbors
+ * chosen by the diversity heuristic of the paper. A search descends
+ * greedily from the single node on the top layer and then runs a best
+ * first search on the bottom layer with a candidate list of size `ef`:
+ * larger values of `ef` (and of `m`, when building) trade latency for
+ * recall.
+ *
+ * Nodes are inserted in parallel, guarding each node's links with its own
+ * lock, so the graph built with more than one thread depends on
+ * scheduling; the layers themselves are always the same for a seed.
+ */
+class hnsw_index
+{
+  public:
+    /// A sparse vector, sorted by term id
+    using vector_type = std::vector<std::pair<term_id, double>>;
+
+    /**
+     * Builds the graph.
+     * @param docs The id and (sorted) vector of each document
+     * @param options The settings for building the graph
+     */
+    hnsw_index(const std::vector<std::pair<doc_id, vector_type>>& docs,
+               const hnsw_options& options = {});
+
+    /**
+     * Loads a graph from a stream.
+     * @param in The stream to read from
+     */
+    hnsw_index(std::istream& in);
+
+    /**
+     * Writes the graph, including its vectors, to a stream.
+     * @param out The stream to write to
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @param query The (sorted) vector to find neighbors of; it does not
+     * need to be normalized
+     * @param k The number of neighbors to return
+     * @param ef The size of the candidate list; at least k is used
+     * @return the (approximately) k most similar documents, most similar
+     * first, scored by cosine similarity
+     */
+    std::vector<search_result> search(const vector_type& query, uint64_t k,
+                                      uint64_t ef) const;
+
+    /**
+     * @return the number of documents in the graph
+     */
+    uint64_t size() const;
+
+  private:
+    /// A node's similarity to the query and its id
+    using candidate = std::pair<float, uint32_t>;
+
+    /// Where a normalized vector is stored
+    struct vector_ref
+    {
+        const uint32_t* terms;
+        const float* values;
+        uint64_t size;
+    };
+
+    /**
+     * Links a node into the graph.
+     * @param node The node to insert
+     */
+    void insert(uint32_t node);
+
+    /**
+     * @param node A node
+     * @return the stored vector of the node
+     */
+    vector_ref vector(uint32_t node) const;
+
+    /**
+     * @param a A vector
+     * @param b Another vector
+     * @return the dot product of the two vectors
+     */
+    static float similarity(const vector_ref& a, const vector_ref& b);
+
+    /**
+     * Runs a best first search on one layer.
+     * @param query The vector to search for
+     * @param entries The nodes to start from
+     * @param ef The size of the candidate list
+     * @param level The layer to search
+     * @param locked Whether the links are being modified concurrently
+     * @return the (at most ef) most similar nodes found, in no order
+     */
+    std::vector<candidate> search_layer(const vector_ref& query,
+                                        const std::vector<candidate>& entries,
+                                        uint64_t ef, uint64_t level,
+                                        bool locked) const;
+
+    /**
+     * Chooses neighbors by the heuristic of the paper: a candidate is
+     * kept only if it is more similar to the base than to every neighbor
+     * already kept, so the links spread out in different directions.
+     * @param candidates The candidates, which are sorted
+     * @param max_size The most neighbors to keep
+     * @return the neighbors
+     */
+    std::vector<uint32_t> select_neighbors(std::vector<candidate>& candidates,
+                                           uint64_t max_size) const;
+
+    /**
+     * @param level A layer
+     * @return the most links a node may have on that layer
+     */
+    uint64_t max_links(uint64_t level) const;
+
+    /// The number of neighbors linked on the upper layers
+    uint64_t m_;
+
+    /// The size of the candidate list used while inserting
+    uint64_t ef_construction_;
+
+    /// The document id of each node
+    std::vector<doc_id> ids_;
+
+    /// Where each node's vector begins (plus one past the end)
+    std::vector<uint64_t> offsets_;
+
+    /// The term ids of every vector, back to back
+    std::vector<uint32_t> terms_;
+
+    /// The normalized weights of every vector, back to back
+    std::vector<float> values_;
+
+    /// One more than the largest term id in any vector
+    uint64_t num_terms_;
+
+    /// The links of each node, one list per layer it is on
+    std::vector<std::vector<std::vector<uint32_t>>> links_;
+
+    /// The node every search starts from
+    uint32_t entry_;
+
+    /// The top layer of the graph
+    uint64_t max_level_;
+
+    /// Guards the links of each node while building
+    std::unique_ptr<std::mutex[]> locks_;
+
+    /// Guards the entry point while building
+    std::mutex entry_lock_;
+};
+}
+}
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file in_memory_postings.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_IN_MEMORY_POSTINGS_H_
+#define META_INDEX_IN_MEMORY_POSTINGS_H_
+
+#include <algorithm>
+
+#include "meta/index/postings_data.h"
+#include "meta/index/postings_stream.h"
+#include "meta/io/mmap_file.h"
+#include "meta/io/packed.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/disk_vector.h"
+#include "meta/util/huge_page_allocator.h"
+#include "meta/util/optional.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A postings file that has been read entirely into RAM. The compressed
+ * postings lists are copied into one contiguous huge-page-backed buffer,
+ * and the header of every list (its size and total count) is decoded up
+ * front into flat arrays, so that looking up a list, its document
+ * frequency, or its total count never touches the disk or decodes
+ * anything.
+ *
+ * It has the same interface as postings_file, plus constant time
+ * statistics.
+ */
+template <class PrimaryKey, class SecondaryKey, class FeatureValue = uint64_t>
+class in_memory_postings
+{
+  public:
+    using postings_data_type
+        = postings_data<PrimaryKey, SecondaryKey, FeatureValue>;
+
+    /**
+     * Reads a postings file into memory.
+     * @param filename The path to the postings file
+     * @param pool The thread pool to load with
+     */
+    in_memory_postings(const std::string& filename, parallel::thread_pool& pool)
+    {
+        io::mmap_file file{filename};
+        util::disk_vector<uint64_t> byte_locations{filename + "_index"};
+
+        postings_.resize(file.size());
+        parallel::parallel_blocks(file.size(), pool,
+                                  [&](uint64_t begin, uint64_t end)
+                                  {
+                                      std::copy(file.begin() + begin,
+                                                file.begin() + end,
+                                                postings_.begin() + begin);
+                                  });
+
+        starts_.resize(byte_locations.size());
+        sizes_.resize(byte_locations.size());
+        total_counts_.resize(byte_locations.size());
+        parallel::parallel_blocks(
+            byte_locations.size(), pool, [&](uint64_t begin, uint64_t end)
+            {
+                for (auto pk = begin; pk < end; ++pk)
+                {
+                    char_input_stream stream{postings_.data()
+                                             + byte_locations[pk]};
+                    auto bytes = io::packed::read(stream, sizes_[pk]);
+                    bytes += io::packed::read(stream, total_counts_[pk]);
+                    starts_[pk] = byte_locations[pk] + bytes;
+                }
+            });
+    }
+
+    /**
+     * Obtains a postings stream object for the given primary key.
+     * @param pk The primary key to look up
+     * @return a postings stream for this primary key, if it is in the
+     * postings file
+     */
+    util::optional<postings_stream<SecondaryKey, FeatureValue>>
+        find_stream(PrimaryKey pk) const
+    {
+        uint64_t idx{pk};
+        if (idx < starts_.size())
+            return postings_stream<SecondaryKey, FeatureValue>{
+                postings_.data() + starts_[idx], sizes_[idx],
+                total_counts_[idx]};
+        return util::nullopt;
+    }
+
+    /**
+     * Obtains a postings data object for the given primary key.
+     * @param pk The primary key to look up
+     * @return a shared pointer to the postings data
+     */
+    std::shared_ptr<postings_data_type> find(PrimaryKey pk) const
+    {
+        auto pdata = std::make_shared<postings_data_type>(pk);
+        if (auto stream = find_stream(pk))
+            pdata->set_counts(stream->begin(), stream->end());
+        return pdata;
+    }
+
+    /**
+     * @param pk The primary key to look up
+     * @return the number of secondary keys in its postings list
+     */
+    uint64_t size(PrimaryKey pk) const
+    {
+        uint64_t idx{pk};
+        return idx < sizes_.size() ? sizes_[idx] : 0;
+    }
+
+    /**
+     * @param pk The primary key to look up
+     * @return the sum of the counts in its postings list
+     */
+    FeatureValue total_counts(PrimaryKey pk) const
+    {
+        uint64_t idx{pk};
+        return idx < total_counts_.size() ? total_counts_[idx]
+                                          : FeatureValue{0};
+    }
+
+    /**
+     * @return the number of bytes of RAM used
+     */
+    uint64_t bytes_used() const
+    {
+        return postings_.capacity()
+               + starts_.capacity() * sizeof(uint64_t)
+               + sizes_.capacity() * sizeof(uint64_t)
+               + total_counts_.capacity() * sizeof(FeatureValue);
+    }
+
+  private:
+    /**
+     * Reads bytes from a buffer for io::packed.
+     */
+    struct char_input_stream
+    {
+        char get()
+        {
+            return *input_++;
+        }
+
+        const char* input_;
+    };
+
+    /// The compressed postings lists, back to back
+    util::huge_page_vector<char> postings_;
+
+    /// The offset of the first posting of each list (past its header)
+    util::huge_page_vector<uint64_t> starts_;
+
+    /// The number of postings in each list
+    util::huge_page_vector<uint64_t> sizes_;
+
+    /// The sum of the counts in each list
+    util::huge_page_vector<FeatureValue> total_counts_;
+};
+}
+}
+#endif
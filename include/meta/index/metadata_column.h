@@ -0,0 +1,243 @@
+/**
+ * @file metadata_column.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_METADATA_COLUMN_H_
+#define META_INDEX_METADATA_COLUMN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "meta/corpus/metadata.h"
+#include "meta/index/doc_bitset.h"
+#include "meta/io/mmap_file.h"
+#include "meta/meta.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Read-only access to a single metadata field stored column-wise, used
+ * for filtering documents on their metadata without touching the
+ * row-oriented metadata.db file.
+ *
+ * Every value is mapped to an order-preserving unsigned 64-bit "code":
+ * integers are offset so that signed values sort correctly, doubles have
+ * their bit patterns adjusted so that they compare as unsigned integers,
+ * and strings are replaced by their index in a sorted dictionary. The
+ * codes are stored bit-packed after subtracting the column's minimum.
+ *
+ * The following format is used for a column file:
+ *
+ * - <Column> => <Header> <BlockStats> <Dictionary> <Codes> <Bitmaps>
+ *   - <Header> => <Type> <NumDocs> <Width> <Base> <BlockSize>
+ *     <NumBlocks> <DictSize> <DictBytes> <NumBitmaps> <CodeWords>
+ *   - <BlockStats> => (<MinCode> <MaxCode>)^<NumBlocks>
+ *   - <Dictionary> => String^<DictSize>, padded to a multiple of 8 bytes
+ *   - <Codes> => uint64_t^<CodeWords>, <Width> bits per document
+ *   - <Bitmaps> => (uint64_t^((<NumDocs> + 63) / 64))^<NumBitmaps>
+ *
+ * All header fields are uint64_t. <BlockStats> record the smallest and
+ * largest code in each block of <BlockSize> consecutive documents so
+ * that range filters can skip (or wholesale accept) blocks without
+ * decoding them. String columns with a small dictionary additionally
+ * store one document bitmap per distinct value for equality filters.
+ */
+class metadata_column
+{
+  public:
+    /// The number of documents summarized by each block's min/max
+    const static constexpr uint64_t block_size = 1024;
+
+    /**
+     * The largest dictionary for which a string column stores
+     * per-value document bitmaps.
+     */
+    const static constexpr uint64_t max_bitmaps = 64;
+
+    /**
+     * Opens the column stored in the given file.
+     * @param filename The column file
+     */
+    metadata_column(const std::string& filename);
+
+    /**
+     * @return the type of the values in this column
+     */
+    corpus::metadata::field_type type() const;
+
+    /**
+     * @return the number of documents in this column
+     */
+    uint64_t size() const;
+
+    /**
+     * @param d_id The document to look up
+     * @return the value for that document. T must be int64_t,
+     * uint64_t, double, or util::string_view, matching the column's type.
+     */
+    template <class T>
+    T at(doc_id d_id) const;
+
+    /**
+     * @param lo The smallest accepted value
+     * @param hi The largest accepted value
+     * @return the documents whose (integer) value lies in [lo, hi]
+     */
+    doc_bitset range(int64_t lo, int64_t hi) const;
+
+    /**
+     * @param lo The smallest accepted value
+     * @param hi The largest accepted value
+     * @return the documents whose (double) value lies in [lo, hi]
+     */
+    doc_bitset range(double lo, double hi) const;
+
+    /**
+     * @param lo The smallest accepted value
+     * @param hi The largest accepted value
+     * @return the documents whose (string) value lies in [lo, hi],
+     * compared lexicographically
+     */
+    doc_bitset range(util::string_view lo, util::string_view hi) const;
+
+    /**
+     * @param value The value to look for
+     * @return the documents whose (string) value is exactly value
+     */
+    doc_bitset equal(util::string_view value) const;
+
+    /**
+     * @param values The values to look for
+     * @return the documents whose (string) value is any of values
+     */
+    doc_bitset any_of(const std::vector<std::string>& values) const;
+
+    /**
+     * @param value A signed integer
+     * @return the order-preserving code for value
+     */
+    static uint64_t encode(int64_t value);
+
+    /**
+     * @param value A double
+     * @return the order-preserving code for value
+     */
+    static uint64_t encode(double value);
+
+    /**
+     * @param code A code produced by encode(int64_t)
+     * @return the original value
+     */
+    static int64_t decode_signed(uint64_t code);
+
+    /**
+     * @param code A code produced by encode(double)
+     * @return the original value
+     */
+    static double decode_double(uint64_t code);
+
+  private:
+    /**
+     * @param d_id The document to look up
+     * @return the code stored for that document
+     */
+    uint64_t code(doc_id d_id) const;
+
+    /**
+     * @param lo The smallest accepted code
+     * @param hi The largest accepted code
+     * @return the documents whose code lies in [lo, hi]
+     */
+    doc_bitset code_range(uint64_t lo, uint64_t hi) const;
+
+    /**
+     * @param value A string
+     * @return the dictionary position of the first entry not less than
+     * value
+     */
+    uint64_t lower_bound(util::string_view value) const;
+
+    /**
+     * Adds the documents whose dictionary entry is code to the set.
+     */
+    void add_string(uint64_t code, doc_bitset& docs) const;
+
+    /**
+     * Throws if the column does not have the given type.
+     */
+    void check_type(corpus::metadata::field_type type) const;
+
+    /// the mapped column file
+    io::mmap_file file_;
+
+    /// the type of the values in the column
+    corpus::metadata::field_type type_;
+
+    /// the number of documents in the column
+    uint64_t num_docs_;
+
+    /// the number of bits used per document
+    uint8_t width_;
+
+    /// the smallest code in the column
+    uint64_t base_;
+
+    /// the number of blocks in the column
+    uint64_t num_blocks_;
+
+    /// pointer to the min/max code for every block
+    const uint64_t* block_stats_;
+
+    /// the (sorted) dictionary for string columns
+    std::vector<util::string_view> dictionary_;
+
+    /// pointer to the bit-packed codes
+    const uint64_t* codes_;
+
+    /// the number of words used by the codes
+    uint64_t code_words_;
+
+    /// pointer to the per-value bitmaps, or nullptr if not stored
+    const uint64_t* bitmaps_;
+};
+
+/**
+ * @param prefix The directory containing the index's metadata
+ * @param field The position of the field in the metadata schema
+ * @return the path of the column file for that field
+ */
+std::string metadata_column_path(const std::string& prefix, uint64_t field);
+
+template <>
+int64_t metadata_column::at(doc_id d_id) const;
+
+template <>
+uint64_t metadata_column::at(doc_id d_id) const;
+
+template <>
+double metadata_column::at(doc_id d_id) const;
+
+template <>
+util::string_view metadata_column::at(doc_id d_id) const;
+
+/**
+ * Exception thrown for metadata column errors.
+ */
+class metadata_column_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
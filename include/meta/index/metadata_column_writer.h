@@ -0,0 +1,98 @@
+/**
+ * @file metadata_column_writer.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_METADATA_COLUMN_WRITER_H_
+#define META_INDEX_METADATA_COLUMN_WRITER_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/corpus/metadata.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Collects the values of a single metadata field for every document and
+ * writes them out in the columnar format read by metadata_column when
+ * destroyed. Documents may be inserted in any order, but every document
+ * must be inserted exactly once. This class is not internally
+ * synchronized.
+ */
+class metadata_column_writer
+{
+  public:
+    /**
+     * @param filename The file to write the column to
+     * @param field The position of the field in the metadata schema
+     * @param type The type of the field
+     * @param num_docs The number of documents in the column
+     */
+    metadata_column_writer(const std::string& filename, uint64_t field,
+                           corpus::metadata::field_type type,
+                           uint64_t num_docs);
+
+    /**
+     * May be move constructed.
+     */
+    metadata_column_writer(metadata_column_writer&&);
+
+    /**
+     * May be move assigned.
+     */
+    metadata_column_writer& operator=(metadata_column_writer&&);
+
+    /**
+     * Writes the column file.
+     */
+    ~metadata_column_writer();
+
+    /**
+     * @return the position of this column's field in the schema
+     */
+    uint64_t field() const;
+
+    /**
+     * Sets the value for a document.
+     * @param d_id The document id
+     * @param fld The value of the field for that document
+     */
+    void insert(doc_id d_id, const corpus::metadata::field& fld);
+
+  private:
+    /**
+     * Maps dictionary ids to their sorted positions and writes the file.
+     */
+    void write();
+
+    /// the file to write to
+    std::string filename_;
+
+    /// the position of the field in the schema
+    uint64_t field_;
+
+    /// the type of the field
+    corpus::metadata::field_type type_;
+
+    /// the codes for each document (dictionary ids for strings)
+    std::vector<uint64_t> codes_;
+
+    /// the dictionary ids for string columns, in insertion order
+    std::unordered_map<std::string, uint64_t> dictionary_;
+
+    /// whether this writer still needs to write its file
+    bool active_;
+};
+}
+}
+#endif
@@ -11,7 +11,9 @@
 #define META_INDEX_METADATA_FILE_H_
 
 #include "meta/util/disk_vector.h"
+#include "meta/util/optional.h"
 #include "meta/corpus/metadata.h"
+#include "meta/index/metadata_column.h"
 #include "meta/io/mmap_file.h"
 
 namespace meta
@@ -34,7 +36,9 @@ namespace index
  *   - <FieldHeader> => <FieldName> <FieldType>
  *   - <FieldName> => String
  *   - <FieldType> => field_type
- *   - <DocumentMD> => <DocLength> <UniqueTerms> <UserMetadata>^FieldNum
+ *   - <DocumentMD> => <FieldOffsets> <DocLength> <UniqueTerms>
+ *     <UserMetadata>^FieldNum
+ *   - <FieldOffsets> => uint32_t^(<FieldCount> + 2)
  *   - <DocLength> => PackedInt
  *   - <UniqueTerms> => PackedInt
  *   - <UserMetaData> => PackedInt | PackedDouble | String (depending on
@@ -45,6 +49,14 @@ namespace index
  * always represent the length (integer) and unique-terms (integer) as
  * metadata. The "length", "unique-terms", and "path" metadata names are
  * **reserved**, but there can be more metadata if the user supplies it.
+ *
+ * <FieldOffsets> gives, for each field, the byte offset of its value
+ * relative to the start of the <DocumentMD>. This allows any single field
+ * to be read without decoding the fields that precede it (see
+ * corpus::metadata::accessor).
+ *
+ * Fields that were marked as columns when the index was created are also
+ * available through metadata_column for fast filtering.
  */
 class metadata_file
 {
@@ -70,6 +82,24 @@ class metadata_file
      */
     uint64_t size() const;
 
+    /**
+     * @return the schema for the metadata in this database, including the
+     * "length" and "unique-terms" fields
+     */
+    const corpus::metadata::schema_type& schema() const;
+
+    /**
+     * @param name The name of a metadata field
+     * @return whether that field is also stored as a column
+     */
+    bool has_column(const std::string& name) const;
+
+    /**
+     * @param name The name of a metadata field stored as a column
+     * @return the column for that field
+     */
+    const metadata_column& column(const std::string& name) const;
+
   private:
     /// the schema for this file
     corpus::metadata::schema_type schema_;
@@ -79,6 +109,9 @@ class metadata_file
 
     /// the mapped file for reading metadata from
     io::mmap_file md_db_;
+
+    /// the columns for each field in the schema, if present
+    std::vector<util::optional<metadata_column>> columns_;
 };
 }
 }
@@ -10,9 +10,13 @@
 #ifndef META_INDEX_METADATA_WRITER_H_
 #define META_INDEX_METADATA_WRITER_H_
 
+#include <fstream>
 #include <mutex>
+#include <vector>
+
 #include "meta/corpus/document.h"
 #include "meta/corpus/metadata.h"
+#include "meta/index/metadata_column_writer.h"
 #include "meta/util/disk_vector.h"
 
 namespace meta
@@ -21,7 +25,9 @@ namespace index
 {
 
 /**
- * Writes document metadata into the packed format for the index.
+ * Writes document metadata into the packed format for the index. Fields
+ * marked with `column = true` in the schema are additionally written
+ * column-wise (see metadata_column) into the metadata.columns directory.
  */
 class metadata_writer
 {
@@ -46,6 +52,35 @@ class metadata_writer
                const std::vector<corpus::metadata::field>& mdata);
 
   private:
+    /**
+     * Buffer a single document's fields are encoded into before they are
+     * written out, so that the per-field offsets can be computed.
+     */
+    struct row_buffer
+    {
+        row_buffer(uint64_t header) : header_size{header}
+        {
+            // nothing
+        }
+
+        void put(char c)
+        {
+            bytes.push_back(c);
+        }
+
+        /**
+         * @return the offset of the next byte to be written, relative to
+         * the start of the document's row (including its offset table)
+         */
+        uint32_t offset() const;
+
+        /// the size of the offset table preceding the encoded fields
+        uint64_t header_size;
+
+        /// the encoded fields
+        std::vector<char> bytes;
+    };
+
     /// a lock for thread safety
     std::mutex lock_;
 
@@ -60,6 +95,9 @@ class metadata_writer
 
     /// the schema of the metadata we are writing
     corpus::metadata::schema_type schema_;
+
+    /// writers for the fields that are also stored column-wise
+    std::vector<metadata_column_writer> columns_;
 };
 }
 }
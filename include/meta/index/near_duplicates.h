@@ -0,0 +1,183 @@
+/**
+ * @file near_duplicates.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_NEAR_DUPLICATES_H_
+#define META_INDEX_NEAR_DUPLICATES_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/analyzers/analyzer.h"
+#include "meta/corpus/corpus.h"
+#include "meta/index/ranker/ranker.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace index
+{
+
+class metadata_column;
+
+/**
+ * Exception thrown for invalid near-duplicate detection settings.
+ */
+class near_duplicate_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Finds clusters of near-duplicate documents from their analyzer output.
+ *
+ * Each document is summarized by a signature: either a MinHash signature
+ * of its set of features, which estimates the Jaccard similarity between
+ * two documents, or a 64-bit SimHash fingerprint of the same set, whose
+ * Hamming distance approximates the angle between the two sets. The
+ * signatures are split into bands and hashed into one table per band
+ * (locality sensitive hashing), so that a document is only compared
+ * against the first few earlier documents that share a band with it and
+ * started a cluster. Every step is linear in the number of documents.
+ *
+ * The settings are read from a table like the following:
+ *
+ * ~~~toml
+ * [near-duplicates]
+ * method = "minhash" # or "simhash"
+ * num-hashes = 64 # minhash: the size of each signature
+ * bands = 16 # minhash: must divide num-hashes
+ * threshold = 0.8 # minhash: the smallest Jaccard similarity to cluster
+ * max-distance = 3 # simhash: the most bits two fingerprints may differ in
+ * max-candidates = 8 # the most clusters remembered per band bucket
+ * ~~~
+ */
+class near_duplicate_detector
+{
+  public:
+    /**
+     * The kinds of signature that can be computed.
+     */
+    enum class method
+    {
+        MINHASH,
+        SIMHASH
+    };
+
+    /**
+     * @param config The near-duplicates configuration table
+     * @param num_docs The number of documents that will be added
+     */
+    near_duplicate_detector(const cpptoml::table& config, uint64_t num_docs);
+
+    /**
+     * Computes and stores the signature of a document. Documents may be
+     * added concurrently from many threads, as long as their ids differ.
+     *
+     * @param d_id The id of the document
+     * @param counts The analyzer output for the document
+     */
+    void add(doc_id d_id, const analyzers::feature_map<uint64_t>& counts);
+
+    /**
+     * Groups the documents into clusters of near-duplicates. Documents
+     * are visited in id order, so the result is deterministic and every
+     * cluster is identified by its first document.
+     *
+     * @return the id of the first document of each document's cluster
+     * (which is the document's own id if it has no earlier duplicate)
+     */
+    std::vector<doc_id> clusters() const;
+
+    /**
+     * @return the kind of signature being computed
+     */
+    method signature_method() const;
+
+  private:
+    /**
+     * @param d_id A document
+     * @return the key of each band of its signature
+     */
+    std::vector<uint64_t> band_keys(doc_id d_id) const;
+
+    /**
+     * @param a A document
+     * @param b Another document
+     * @return whether their signatures are similar enough to be in the
+     * same cluster
+     */
+    bool similar(doc_id a, doc_id b) const;
+
+    /// The kind of signature
+    method method_;
+
+    /// The number of minhashes per signature
+    uint64_t num_hashes_;
+
+    /// The number of bands signatures are split into
+    uint64_t bands_;
+
+    /// The smallest fraction of minhashes two duplicates must share
+    double threshold_;
+
+    /// The most bits two duplicate fingerprints may differ in
+    uint64_t max_distance_;
+
+    /// The most cluster leaders kept in each bucket of a band table
+    uint64_t max_candidates_;
+
+    /// The coefficients of the minhash functions, two per function
+    std::vector<uint64_t> coefficients_;
+
+    /// The minhash signatures, num_hashes_ per document
+    std::vector<uint32_t> minhashes_;
+
+    /// The simhash fingerprints, one per document
+    std::vector<uint64_t> simhashes_;
+
+    /// Whether each document had no features (and so no duplicates)
+    std::vector<uint8_t> empty_;
+};
+
+/**
+ * Analyzes every document in a corpus in parallel and finds its near
+ * duplicates.
+ *
+ * @param docs The corpus to read
+ * @param analyzer The analyzer to produce features with
+ * @param detector The detector to add the documents to
+ * @param num_threads The number of threads to analyze with
+ * @return the clusters found by the detector
+ */
+std::vector<doc_id> find_near_duplicates(corpus::corpus& docs,
+                                         const analyzers::analyzer& analyzer,
+                                         near_duplicate_detector& detector,
+                                         uint64_t num_threads);
+
+/**
+ * Removes near-duplicates from a ranking for query-time collapsing,
+ * keeping only the highest ranked document of each cluster. Rankings
+ * should be retrieved with more results than are needed, since each
+ * collapsed document shortens the ranking.
+ *
+ * @param results The ranking, as returned by a ranker
+ * @param clusters The "near-duplicate-of" column of the index
+ * @param num_results The most results to return
+ * @return the collapsed ranking
+ */
+std::vector<search_result>
+    collapse_near_duplicates(const std::vector<search_result>& results,
+                             const metadata_column& clusters,
+                             uint64_t num_results);
+}
+}
+#endif
@@ -13,6 +13,8 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
+#include <type_traits>
 
 #include "meta/index/postings_stream.h"
 #include "meta/io/packed.h"
@@ -26,27 +28,32 @@ namespace index
 namespace detail
 {
 /**
- * Gets the bytes used by a std::string.
+ * Gets the heap bytes used by a std::string, which is nothing if the
+ * string fits in its small buffer.
  */
 template <class T>
-uint64_t bytes_used(
+uint64_t heap_bytes(
     const T& elem,
     typename std::enable_if<std::is_same<T,
                                          std::string>::value>::type* = nullptr)
 {
-    return elem.capacity();
+    static const auto small_capacity = std::string{}.capacity();
+    if (elem.capacity() <= small_capacity)
+        return 0;
+    // one extra byte for the terminator
+    return elem.capacity() + 1;
 }
 
 /**
- * Gets the bytes used by anything not a std::string.
+ * Gets the heap bytes used by anything not a std::string (none).
  */
 template <class T>
-uint64_t bytes_used(
-    const T& elem,
+uint64_t heap_bytes(
+    const T&,
     typename std::enable_if<!std::is_same<T,
                                           std::string>::value>::type* = nullptr)
 {
-    return sizeof(elem);
+    return 0;
 }
 }
 
@@ -119,20 +126,13 @@ class postings_buffer
     }
 
     /**
-     * @return an estimate of the number of heap allocated bytes this
-     * structure uses
+     * @return the number of heap allocated bytes this structure uses
      */
     std::size_t bytes_used() const
     {
-        auto bytes = buffer_.size_;
-
-        // this only matters when PrimaryKey is std::string.
-        // if the capacity of the string is bigger than the size of the
-        // string itself, then we know it must also be using heap memory,
-        // which we haven't accounted for already.
-        if (detail::bytes_used(pk_) > sizeof(PrimaryKey))
-            bytes += detail::bytes_used(pk_);
-        return bytes;
+        // the byte buffer is allocated at exactly its size; the primary
+        // key only uses the heap when it is a long std::string
+        return buffer_.size_ + detail::heap_bytes(pk_);
     }
 
     /**
@@ -12,6 +12,7 @@
 
 #include "meta/index/postings_data.h"
 #include "meta/index/postings_stream.h"
+#include "meta/index/value_codec.h"
 #include "meta/io/mmap_file.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/optional.h"
@@ -36,9 +37,12 @@ class postings_file
     /**
      * Opens a postings file.
      * @param filename The path to the file
+     * @param codec How the values in the file are stored
      */
-    postings_file(const std::string& filename)
-        : postings_{filename}, byte_locations_{filename + "_index"}
+    postings_file(const std::string& filename, value_codec codec = {})
+        : postings_{filename},
+          byte_locations_{filename + "_index"},
+          codec_{codec}
     {
         // nothing
     }
@@ -54,7 +58,7 @@ class postings_file
     {
         if (pk < byte_locations_.size())
             return postings_stream<SecondaryKey, FeatureValue>{
-                postings_.begin() + byte_locations_.at(pk)};
+                postings_.begin() + byte_locations_.at(pk), codec_};
         return util::nullopt;
     }
 
@@ -82,6 +86,7 @@ class postings_file
   private:
     io::mmap_file postings_;
     util::disk_vector<uint64_t> byte_locations_;
+    value_codec codec_;
 };
 }
 }
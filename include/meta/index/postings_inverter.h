@@ -53,8 +53,8 @@ class postings_inverter
         /**
          * @param parent A back-pointer to the handler this producer is
          * operating on
-         * @param ram_budget The **estimated** allowed size of the buffer
-         * for this producer
+         * @param ram_budget The allowed size in bytes of the buffer for
+         * this producer
          */
         producer(postings_inverter* parent, uint64_t ram_budget);
 
@@ -79,16 +79,26 @@ class postings_inverter
          */
         void flush_chunk();
 
+        /**
+         * Reports the current chunk size to the inverter's memory
+         * category. Small changes are batched up unless forced.
+         * @param force Whether to report even a small change
+         */
+        void publish(bool force = false);
+
         /// Current in-memory chunk
         hashing::probe_set<postings_buffer_type> pdata_;
 
-        /// Current size of the in-memory chunk
+        /// Current size of the in-memory chunk, in heap bytes
         uint64_t chunk_size_;
 
+        /// The chunk size last reported to the memory category
+        uint64_t published_size_;
+
         /**
          * Maximum allowed size of a chunk in bytes before it is written.
-         * This is an *estimate*, so you should make sure there's some slop
-         * in this number to make sure you don't run out of memory.
+         * This counts the heap bytes of the hash table and every postings
+         * buffer, but not the allocator's own overhead.
          */
         uint64_t max_size_;
 
@@ -107,7 +117,7 @@ class postings_inverter
      * Creates a producer for this postings_inverter. Producers are designed to
      * be thread-local buffers of chunks that write to disk when their
      * buffer is full.
-     * @param ram_bugdet The estimated allowed size of this thread-local
+     * @param ram_budget The allowed size in bytes of this thread-local
      * buffer
      * @return a new producer
      */
@@ -10,6 +10,8 @@
 #include "meta/index/postings_inverter.h"
 #include "meta/index/disk_index.h"
 #include "meta/parallel/thread_pool.h"
+#include "meta/util/memory.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
@@ -19,10 +21,11 @@ namespace index
 template <class Index>
 postings_inverter<Index>::producer::producer(postings_inverter* parent,
                                              uint64_t ram_budget)
-    : max_size_{ram_budget}, parent_{parent}
+    : published_size_{0}, max_size_{ram_budget}, parent_{parent}
 {
     chunk_size_ = pdata_.bytes_used();
     assert(chunk_size_ < max_size_);
+    publish(true);
 }
 
 template <class Index>
@@ -77,6 +80,23 @@ operator()(const secondary_key_type& key, const Container& counts)
         if (chunk_size_ >= max_size_)
             flush_chunk();
     }
+    publish();
+}
+
+template <class Index>
+void postings_inverter<Index>::producer::publish(bool force)
+{
+    // every producer shares the category, so only touch it once the
+    // chunk has changed by a meaningful amount
+    const static constexpr uint64_t interval = 1 << 20;
+    auto delta = chunk_size_ > published_size_ ? chunk_size_ - published_size_
+                                               : published_size_ - chunk_size_;
+    if (!force && delta < interval)
+        return;
+
+    static auto& category = memory::get_category("index/postings-inverter");
+    category.update(published_size_, chunk_size_);
+    published_size_ = chunk_size_;
 }
 
 template <class Index>
@@ -85,6 +105,10 @@ void postings_inverter<Index>::producer::flush_chunk()
     if (pdata_.empty())
         return;
 
+    static auto& flush_time
+        = metrics::get_timer("meta_index_stage_seconds{stage=\"flush\"}");
+    metrics::scoped_timer timer{flush_time};
+
     // extract the keys, emptying the hash set
     auto pdata = pdata_.extract_keys();
     std::sort(pdata.begin(), pdata.end());
@@ -101,12 +125,15 @@ void postings_inverter<Index>::producer::flush_chunk()
         swap(tmp, pdata_);
         chunk_size_ = pdata_.bytes_used();
     }
+    publish(true);
 }
 
 template <class Index>
 postings_inverter<Index>::producer::~producer()
 {
     flush_chunk();
+    chunk_size_ = 0;
+    publish(true);
 }
 
 template <class Index>
@@ -14,6 +14,7 @@
 #include <utility>
 #include <tuple>
 
+#include "meta/index/value_codec.h"
 #include "meta/util/optional.h"
 #include "meta/io/packed.h"
 
@@ -26,6 +27,11 @@ namespace index
  * A stream for extracting the postings list for a specific key in a
  * postings file. This can be used instead of postings_data to avoid
  * reading in the entire postings list into memory at once.
+ *
+ * It is a non-owning view: creating one never allocates, and the list is
+ * decoded lazily as it is iterated (or all at once into a caller-supplied
+ * buffer with decode()). It is valid only as long as the index it came
+ * from.
  */
 template <class SecondaryKey, class FeatureValue = uint64_t>
 class postings_stream
@@ -53,8 +59,10 @@ class postings_stream
      * buffer.
      *
      * @param buffer The buffer position to the start of the postings
+     * @param codec How the values in the postings are stored
      */
-    postings_stream(const char* buffer) : start_{buffer}
+    postings_stream(const char* buffer, value_codec codec = {})
+        : start_{buffer}, codec_{codec}
     {
         char_input_stream stream{start_};
 
@@ -70,8 +78,11 @@ class postings_stream
      * construction.
      */
     postings_stream(const char* buffer, uint64_t size,
-                    FeatureValue total_counts)
-        : start_{buffer}, size_{size}, total_counts_{total_counts}
+                    FeatureValue total_counts, value_codec codec = {})
+        : start_{buffer},
+          size_{size},
+          total_counts_{total_counts},
+          codec_{codec}
     {
         // nothing
     }
@@ -93,6 +104,44 @@ class postings_stream
         return total_counts_;
     }
 
+    /**
+     * Decodes the whole list into a caller-supplied buffer, replacing its
+     * contents, for random access. Reusing the same buffer across lists
+     * avoids allocating once it has grown to fit the longest one.
+     *
+     * @param buffer The buffer to decode into (e.g., a
+     * std::vector<std::pair<SecondaryKey, FeatureValue>>)
+     * @return the buffer
+     */
+    template <class Container>
+    Container& decode(Container& buffer) const
+    {
+        buffer.clear();
+        buffer.reserve(size_);
+        for (const auto& pr : *this)
+            buffer.push_back(pr);
+        return buffer;
+    }
+
+    /**
+     * Finds the value for a SecondaryKey, decoding only as far into the
+     * list as needed (the list is sorted by key).
+     *
+     * @param key The SecondaryKey to look up
+     * @return the value for the key, or zero if it is not in the list
+     */
+    FeatureValue find(SecondaryKey key) const
+    {
+        for (const auto& pr : *this)
+        {
+            if (pr.first == key)
+                return pr.second;
+            if (key < pr.first)
+                break;
+        }
+        return FeatureValue{0};
+    }
+
     /**
      * Writes this postings stream to an output stream in packed format.
      * @return the number of bytes written
@@ -145,7 +194,7 @@ class postings_stream
                 io::packed::read(stream_, id);
                 // gap encoding
                 count_.first += id;
-                io::packed::read(stream_, count_.second);
+                codec_.read(stream_, count_.second);
                 ++pos_;
             }
             return *this;
@@ -168,23 +217,24 @@ class postings_stream
             return &count_;
         }
 
-        bool operator==(const iterator& other)
+        bool operator==(const iterator& other) const
         {
             return std::tie(stream_.input_, size_, pos_)
                    == std::tie(other.stream_.input_, other.size_, other.pos_);
         }
 
-        bool operator!=(const iterator& other)
+        bool operator!=(const iterator& other) const
         {
             return !(*this == other);
         }
 
       private:
-        iterator(const char* start, uint64_t size)
+        iterator(const char* start, uint64_t size, value_codec codec)
             : stream_{start},
               size_{size},
               pos_{0},
-              count_{std::make_pair(SecondaryKey{0}, 0.0)}
+              count_{std::make_pair(SecondaryKey{0}, 0.0)},
+              codec_{codec}
         {
             ++(*this);
         }
@@ -193,6 +243,7 @@ class postings_stream
         uint64_t size_;
         uint64_t pos_;
         value_type count_;
+        value_codec codec_;
     };
 
     /**
@@ -200,7 +251,7 @@ class postings_stream
      */
     iterator begin() const
     {
-        return {start_, size_};
+        return {start_, size_, codec_};
     }
 
     /**
@@ -215,6 +266,7 @@ class postings_stream
     const char* start_;
     uint64_t size_;
     FeatureValue total_counts_;
+    value_codec codec_;
 };
 }
 }
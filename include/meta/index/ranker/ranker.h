@@ -14,6 +14,7 @@
 
 #include "meta/meta.h"
 #include "meta/index/inverted_index.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
@@ -85,6 +86,10 @@ struct ranker_context
                    ForwardIterator end, FilterFunction&& filter)
         : idx(inv), cur_doc{idx.num_docs()}
     {
+        static auto& lookup_time
+            = metrics::get_timer("meta_query_stage_seconds{stage=\"lookup\"}");
+        metrics::scoped_timer timer{lookup_time};
+
         postings.reserve(static_cast<std::size_t>(std::distance(begin, end)));
 
         query_length = 0.0;
@@ -131,9 +136,28 @@ class ranker_exception : public std::runtime_error
     using std::runtime_error::runtime_error;
 };
 
+/**
+ * The ways a ranker can walk the postings lists of a query.
+ */
+enum class evaluation_strategy
+{
+    /// Pick a strategy for each query based on its cost
+    AUTOMATIC,
+    /// Merge the lists, scoring one document at a time
+    DOCUMENT_AT_A_TIME,
+    /// Read one list at a time into dense blocks of accumulated scores
+    TERM_AT_A_TIME
+};
+
 /**
  * A ranker scores a query against all the documents in an inverted index,
  * returning a list of documents sorted by relevance.
+ *
+ * Queries are evaluated either document-at-a-time or term-at-a-time. Both
+ * compute every score with the same operations in the same order, so
+ * they return identical results; by default, term-at-a-time is used for
+ * short queries whose postings are long enough to pay for the accumulator
+ * scan.
  */
 class ranker
 {
@@ -204,10 +228,47 @@ class ranker
      */
     virtual void save(std::ostream& out) const = 0;
 
+    /**
+     * @param strategy The strategy to evaluate queries with
+     */
+    void strategy(evaluation_strategy strategy);
+
+    /**
+     * @return the strategy queries are evaluated with
+     */
+    evaluation_strategy strategy() const;
+
+    /// The longest query evaluated term-at-a-time by AUTOMATIC
+    const static constexpr uint64_t max_term_at_a_time_terms = 3;
+
   private:
     std::vector<search_result> rank(detail::ranker_context& ctx,
                                     uint64_t num_results,
                                     const filter_function_type& filter);
+
+    /**
+     * Scores a query by merging its postings lists.
+     */
+    std::vector<search_result>
+        rank_documents(detail::ranker_context& ctx, uint64_t num_results,
+                       const filter_function_type& filter);
+
+    /**
+     * Scores a query by accumulating each postings list in turn into a
+     * dense array of scores.
+     */
+    std::vector<search_result>
+        rank_terms(detail::ranker_context& ctx, uint64_t num_results,
+                   const filter_function_type& filter);
+
+    /**
+     * @param ctx The query to evaluate
+     * @return whether term-at-a-time evaluation is expected to be faster
+     */
+    static bool prefer_term_at_a_time(const detail::ranker_context& ctx);
+
+    /// The strategy queries are evaluated with
+    evaluation_strategy strategy_ = evaluation_strategy::AUTOMATIC;
 };
 }
 }
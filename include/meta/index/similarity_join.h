@@ -0,0 +1,101 @@
+/**
+ * @file similarity_join.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_SIMILARITY_JOIN_H_
+#define META_INDEX_SIMILARITY_JOIN_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "meta/index/forward_index.h"
+#include "meta/index/ranker/ranker.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Exception thrown for invalid similarity join settings.
+ */
+class similarity_join_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Settings for similarity_join().
+ */
+struct similarity_join_options
+{
+    /**
+     * How the values in the forward index are weighted before the
+     * document vectors are normalized.
+     */
+    enum class weighting
+    {
+        /// The values as stored (e.g., term counts)
+        RAW,
+        /// log(1 + tf) * log(1 + N / df)
+        TF_IDF,
+        /// The Okapi BM25 weight of each term in the document
+        BM25
+    };
+
+    /// The weighting to apply
+    weighting weights = weighting::TF_IDF;
+
+    /// The smallest cosine similarity two neighbors may have, on (0, 1]
+    double threshold = 0.5;
+
+    /// The most neighbors to keep for each document
+    uint64_t k = 10;
+
+    /// The BM25 term frequency saturation parameter
+    double k1 = 1.2;
+
+    /// The BM25 length normalization parameter
+    double b = 0.75;
+
+    /// The number of threads to search with
+    uint64_t num_threads = std::thread::hardware_concurrency();
+};
+
+/**
+ * Finds, for every document in a forward index, its k most similar
+ * documents whose cosine similarity (after weighting) is at least a
+ * threshold, without comparing every pair of documents.
+ *
+ * This is the L2-bounded prefix filtering of the All-Pairs family
+ * (AllPairs, L2AP). Features are ordered from most to least frequent,
+ * and only the suffix of each normalized vector past the point where its
+ * prefix could contribute the threshold to a dot product (bounded by the
+ * prefix's norm and by its dot product with the largest weight of each
+ * feature) is put in an inverted index, so two documents that only share
+ * features in those prefixes are never compared. Each document scans the
+ * inverted lists of its features for earlier documents, rarest feature
+ * first, and stops admitting new candidates once the norm of its
+ * remaining features falls below the threshold; candidates must also
+ * pass a length filter. The survivors are verified against their
+ * prefixes. Documents are searched in parallel.
+ *
+ * @param idx The forward index holding the document vectors, whose
+ * values must be non-negative
+ * @param options The settings for the join
+ * @return the neighbors of each document, most similar first (ties are
+ * broken by id)
+ */
+std::vector<std::vector<search_result>>
+    similarity_join(forward_index& idx, const similarity_join_options& options);
+}
+}
+#endif
@@ -10,7 +10,10 @@
 #ifndef META_STRING_LIST_H_
 #define META_STRING_LIST_H_
 
+#include <iterator>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "meta/io/mmap_file.h"
 #include "meta/util/disk_vector.h"
@@ -20,15 +23,33 @@ namespace meta
 namespace index
 {
 
+/**
+ * Exception thrown for invalid uses of a string_list.
+ */
+class string_list_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * A class designed for reading large lists of strings that have been
  * persisted to disk. This class provides read-only
  * access---string_list_writer provides write-only access and is to be used
  * for building the string list and associated index this class reads.
+ *
+ * Lists may be stored either verbatim (every string in full, with one
+ * offset per string) or front-coded (see string_list_writer), in which
+ * case only every K-th string is stored in full. Strings in a verbatim
+ * list are read in place with at(); front-coded strings have to be
+ * rebuilt, so they are read with decode_at(), which decodes at most K
+ * strings.
  */
 class string_list
 {
   public:
+    class const_iterator;
+
     /**
      * Constructs the string list
      * @param path The path to where this object is stored
@@ -47,21 +68,130 @@ class string_list
 
     /**
      * @param idx
-     * @return the string at a given index.
+     * @return the string at a given index, read in place from the file.
+     * @throws string_list_exception if the list is front-coded
      */
     const char* at(uint64_t idx) const;
 
+    /**
+     * @param idx
+     * @return a copy of the string at a given index, decoding it if the
+     * list is front-coded
+     */
+    std::string decode_at(uint64_t idx) const;
+
     /**
      * @return the number of strings in the list.
      */
     uint64_t size() const;
 
+    /**
+     * @return the number of strings in each front-coded block, or zero
+     * if the list is stored verbatim
+     */
+    uint64_t block_size() const;
+
+    /**
+     * @return an iterator to the first string in the list
+     */
+    const_iterator begin() const;
+
+    /**
+     * @return an iterator past the last string in the list
+     */
+    const_iterator end() const;
+
   private:
+    /**
+     * Decodes the string starting at pos into str, given that str
+     * currently holds the string before it.
+     * @param pos The position of the encoded string; advanced past it
+     * @param str The previous string; replaced by the decoded one
+     * @param head Whether the string is the first one in its block
+     */
+    void decode(const char*& pos, std::string& str, bool head) const;
+
     /// The file containing the strings.
     io::mmap_file string_file_;
 
-    /// An index that gives the starting byte for each index.
+    /**
+     * An index that gives the starting byte for each index (or for each
+     * block, if front-coded).
+     */
     util::disk_vector<uint64_t> index_;
+
+    /// The number of strings per block, or zero if stored verbatim
+    uint64_t block_size_;
+
+    /// The number of strings in the list
+    uint64_t size_;
+
+    /// Common prefixes that front-coded block heads refer to
+    std::vector<std::string> dictionary_;
+};
+
+/**
+ * A forward iterator over the strings in a string_list. Advancing only
+ * decodes the next string, so a full scan costs a single pass over the
+ * list regardless of how it is stored.
+ */
+class string_list::const_iterator
+    : public std::iterator<std::forward_iterator_tag, std::string>
+{
+  public:
+    /**
+     * @return the current string
+     */
+    const std::string& operator*() const;
+
+    /**
+     * @return a pointer to the current string
+     */
+    const std::string* operator->() const;
+
+    /**
+     * Moves to the next string.
+     * @return the iterator
+     */
+    const_iterator& operator++();
+
+    /**
+     * @param other The iterator to compare with
+     * @return whether the iterators point to the same position
+     */
+    bool operator==(const const_iterator& other) const;
+
+    /**
+     * @param other The iterator to compare with
+     * @return whether the iterators point to different positions
+     */
+    bool operator!=(const const_iterator& other) const;
+
+  private:
+    friend string_list;
+
+    /**
+     * @param list The list to iterate over
+     * @param idx The starting index (zero or the list's size)
+     */
+    const_iterator(const string_list* list, uint64_t idx);
+
+    /**
+     * Decodes the string at the current position, if any.
+     */
+    void read();
+
+    /// The list being iterated over
+    const string_list* list_;
+
+    /// The index of the current string
+    uint64_t idx_;
+
+    /// The position of the next encoded string
+    const char* pos_;
+
+    /// The current string
+    std::string str_;
 };
 }
 }
@@ -11,12 +11,18 @@
 #define META_STRING_LIST_WRITER_H_
 
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "meta/io/moveable_stream.h"
 #include "meta/util/disk_vector.h"
 
+namespace cpptoml
+{
+class table;
+}
+
 namespace meta
 {
 namespace index
@@ -26,10 +32,28 @@ namespace index
  * A class for writing large lists of strings to disk with an associated
  * index file for fast random access. This class is used for writing the
  * output format read by the string_list class.
+ *
+ * By default, every string is written verbatim with one offset per
+ * string. Lists of strings that share long prefixes (paths, URLs) can
+ * instead be front-coded: every K-th string is written in full and the
+ * strings in between store only the length of the prefix they share with
+ * their predecessor followed by the rest of the string. Only one offset
+ * per block of K strings is kept. Optionally, the full strings at the
+ * start of each block may themselves refer to a small dictionary of
+ * common prefixes. This is configured by the following keys:
+ *
+ * ~~~toml
+ * front-coding = true           # default: false
+ * front-coding-block-size = 16  # default: 16
+ * prefix-dictionary = true      # default: false
+ * ~~~
  */
 class string_list_writer
 {
   public:
+    /// The default number of strings in each front-coded block
+    const static constexpr uint64_t default_block_size = 16;
+
     /**
      * Constructs the writer, writing the string file to the given path.
      * The index file will go alongside that path.
@@ -39,6 +63,17 @@ class string_list_writer
      */
     string_list_writer(const std::string& path, uint64_t size);
 
+    /**
+     * Constructs the writer, choosing the storage format from the given
+     * configuration.
+     *
+     * @param path The path to write the string file to.
+     * @param size The number of strings in the list (must be known)
+     * @param config The table containing the keys described above
+     */
+    string_list_writer(const std::string& path, uint64_t size,
+                       const cpptoml::table& config);
+
     /**
      * May be move constructed.
      */
@@ -50,16 +85,40 @@ class string_list_writer
     string_list_writer& operator=(string_list_writer&&);
 
     /**
-     * Sets the string at idx to be elem.
+     * Finishes writing a front-coded list.
+     */
+    ~string_list_writer();
+
+    /**
+     * Sets the string at idx to be elem. Front-coded lists are encoded in
+     * order, so strings inserted ahead of the ones still missing are
+     * buffered until the gap is filled.
+     *
      * @param idx
      * @param elem
      */
     void insert(uint64_t idx, const std::string& elem);
 
   private:
+    struct front_coder;
+
+    /**
+     * Writes out the given string at the next position in a front-coded
+     * list.
+     */
+    void encode(const std::string& elem);
+
+    /**
+     * Writes out the header file for a front-coded list.
+     */
+    void finish();
+
     /// Writes are internally synchronized
     std::mutex mutex_;
 
+    /// The path of the string file
+    std::string path_;
+
     /// The file containing the strings
     io::mofstream string_file_;
 
@@ -68,6 +127,9 @@ class string_list_writer
 
     /// Index vector---stores byte positions
     util::disk_vector<uint64_t> index_;
+
+    /// Front-coding state, or null if strings are written verbatim
+    std::unique_ptr<front_coder> coder_;
 };
 }
 }
@@ -0,0 +1,231 @@
+/**
+ * @file value_codec.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_VALUE_CODEC_H_
+#define META_INDEX_VALUE_CODEC_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Exception thrown for invalid value formats.
+ */
+class value_codec_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Describes how the feature values in a postings file are stored. By
+ * default, values are written with io::packed in their own type; a
+ * postings file of doubles can instead store its values as varints (when
+ * every value is a non-negative integer), as 32-bit floats, or as 16-bit
+ * integers quantized with a single scale for the whole file.
+ */
+struct value_codec
+{
+    /**
+     * The possible storage formats.
+     */
+    enum class format : uint8_t
+    {
+        PACKED,
+        VARINT,
+        FLOAT,
+        QUANTIZED
+    };
+
+    /// The format the values are stored in
+    format fmt = format::PACKED;
+
+    /// For QUANTIZED, the value of one quantization step
+    double scale = 1.0;
+
+    /// The largest value that can be quantized
+    const static constexpr int16_t max_quantized
+        = std::numeric_limits<int16_t>::max();
+
+    /**
+     * @param max_abs The largest absolute value that will be stored
+     * @return a QUANTIZED codec whose range covers [-max_abs, max_abs]
+     */
+    static value_codec quantized(double max_abs)
+    {
+        value_codec codec;
+        codec.fmt = format::QUANTIZED;
+        if (max_abs > 0)
+            codec.scale = max_abs / max_quantized;
+        return codec;
+    }
+
+    /**
+     * Reads a value.
+     * @param stream The stream to read from (supporting get())
+     * @param value The value to read into
+     * @return the number of bytes read
+     */
+    template <class InputStream, class FeatureValue>
+    uint64_t read(InputStream& stream, FeatureValue& value) const
+    {
+        switch (fmt)
+        {
+            case format::VARINT:
+            {
+                uint64_t count;
+                auto bytes = io::packed::read(stream, count);
+                value = static_cast<FeatureValue>(count);
+                return bytes;
+            }
+            case format::FLOAT:
+            {
+                float val;
+                read_raw(stream, val);
+                value = static_cast<FeatureValue>(val);
+                return sizeof(float);
+            }
+            case format::QUANTIZED:
+            {
+                int16_t val;
+                read_raw(stream, val);
+                value = static_cast<FeatureValue>(val * scale);
+                return sizeof(int16_t);
+            }
+            default:
+                return io::packed::read(stream, value);
+        }
+    }
+
+    /**
+     * Writes a value.
+     * @param stream The stream to write to (supporting put())
+     * @param value The value to write
+     * @return the number of bytes written
+     */
+    template <class OutputStream, class FeatureValue>
+    uint64_t write(OutputStream& stream, FeatureValue value) const
+    {
+        switch (fmt)
+        {
+            case format::VARINT:
+                return io::packed::write(stream,
+                                         static_cast<uint64_t>(value));
+            case format::FLOAT:
+                return write_raw(stream, static_cast<float>(value));
+            case format::QUANTIZED:
+            {
+                auto step = std::round(value / scale);
+                step = std::max<double>(-max_quantized,
+                                        std::min<double>(max_quantized, step));
+                return write_raw(stream, static_cast<int16_t>(step));
+            }
+            default:
+                return io::packed::write(stream, value);
+        }
+    }
+
+    /**
+     * Saves the codec to a file.
+     * @param filename The file to write
+     */
+    void save(const std::string& filename) const
+    {
+        std::ofstream file{filename};
+        file.precision(std::numeric_limits<double>::max_digits10);
+        file << to_string(fmt) << " " << scale << "\n";
+    }
+
+    /**
+     * Loads a codec saved with save().
+     * @param filename The file to read
+     * @return the codec, or the default (PACKED) codec if the file does
+     * not exist
+     */
+    static value_codec load(const std::string& filename)
+    {
+        value_codec codec;
+        std::ifstream file{filename};
+        std::string name;
+        if (file >> name >> codec.scale)
+            codec.fmt = from_string(name);
+        return codec;
+    }
+
+    /**
+     * @param fmt A format
+     * @return the name of the format
+     */
+    static std::string to_string(format fmt)
+    {
+        switch (fmt)
+        {
+            case format::VARINT:
+                return "varint";
+            case format::FLOAT:
+                return "float";
+            case format::QUANTIZED:
+                return "quantized";
+            default:
+                return "double";
+        }
+    }
+
+    /**
+     * @param name The name of a format
+     * @return the format with that name
+     */
+    static format from_string(const std::string& name)
+    {
+        if (name == "double")
+            return format::PACKED;
+        if (name == "varint")
+            return format::VARINT;
+        if (name == "float")
+            return format::FLOAT;
+        if (name == "quantized")
+            return format::QUANTIZED;
+        throw value_codec_exception{"unknown value format: " + name};
+    }
+
+  private:
+    template <class InputStream, class T>
+    static void read_raw(InputStream& stream, T& value)
+    {
+        char bytes[sizeof(T)];
+        for (auto& byte : bytes)
+            byte = stream.get();
+        std::memcpy(&value, bytes, sizeof(T));
+    }
+
+    template <class OutputStream, class T>
+    static uint64_t write_raw(OutputStream& stream, T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (const auto& byte : bytes)
+            stream.put(byte);
+        return sizeof(T);
+    }
+};
+}
+}
+#endif
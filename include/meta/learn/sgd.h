@@ -9,9 +9,16 @@
 #ifndef META_LEARN_SGD_H_
 #define META_LEARN_SGD_H_
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 #include <vector>
+#include "cpptoml.h"
 #include "meta/learn/dataset.h"
 #include "meta/learn/loss/loss_function.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/memory.h"
 
 namespace meta
 {
@@ -29,8 +36,14 @@ namespace learn
  * efficient shrinking during training, and L1 regularization is performed
  * using the cumulative penalty method of Tsuruoka, Tsujii, and Ananiadou.
  *
+ * Batches of instances may also be trained on several threads at once,
+ * either Hogwild style (Niu, Recht, Re, and Wright; see train_parallel())
+ * or as deterministic mini-batches whose gradients are summed in parallel
+ * and applied with AdaGrad or Adam (see train_batch()).
+ *
  * @see http://arxiv.org/abs/1305.6646
  * @see http://www.aclweb.org/anthology/P09-1054
+ * @see http://arxiv.org/abs/1106.5730
  */
 class sgd_model
 {
@@ -44,6 +57,22 @@ class sgd_model
     /// The default l1 regularization parameter (defaults to off)
     const static constexpr double default_l1_regularizer = 0;
 
+    /// The default learning rate for the Adam optimizer
+    const static constexpr double default_adam_learning_rate = 0.01;
+
+    /// The number of instances each thread trains on between
+    /// synchronizations of the global state in train_parallel()
+    const static constexpr std::size_t sync_interval = 256;
+
+    /// The number of instances whose gradients are summed together
+    /// before being merged into a mini-batch's gradient
+    const static constexpr std::size_t gradient_chunk_size = 64;
+
+    /**
+     * An instance to train on and its ground truth label.
+     */
+    using example_type = std::pair<const feature_vector*, double>;
+
     /**
      * Construction options for the model, specifying the learning rate
      * and the regularizer values.
@@ -63,6 +92,42 @@ class sgd_model
         }
     };
 
+    /**
+     * The update rules for mini-batches.
+     */
+    enum class optimizer_type
+    {
+        ADAGRAD,
+        ADAM
+    };
+
+    /**
+     * Options for how a learner built on the model makes its passes over
+     * the training data.
+     */
+    struct training_options_type
+    {
+        /// The number of threads to train on
+        std::size_t num_threads = 1;
+        /// The size of each mini-batch; 0 updates the model after every
+        /// instance (with train_one() or, on several threads,
+        /// train_parallel())
+        std::size_t batch_size = 0;
+        /// The update rule for mini-batches
+        optimizer_type optimizer = optimizer_type::ADAGRAD;
+        /// Adam's decay rate for the gradients
+        double beta1 = 0.9;
+        /// Adam's decay rate for the squared gradients
+        double beta2 = 0.999;
+        /// A small constant that keeps the adaptive steps finite
+        double epsilon = 1e-8;
+
+        training_options_type()
+        {
+            // nothing; see options_type
+        }
+    };
+
     /**
      * Constructs a new model with the specified number of features,
      * learning rate, and regularization.
@@ -89,12 +154,16 @@ class sgd_model
      * @param loss The loss function used to calculate the training loss
      * @param labeler A unary function object to convert an instance ->
      *  double label
+     * @param training How the model will be trained, so that mini-batch
+     *  optimizers are calibrated with mini-batches
      * @param calibration_rate How much to scale the learning rate by for
      *  each subsequent trial
      */
     template <class SampleView, class LabelFunction>
     void calibrate(SampleView view, const loss::loss_function& loss,
-                   LabelFunction&& labeler, double calibration_rate = 2.0,
+                   LabelFunction&& labeler,
+                   const training_options_type& training = {},
+                   double calibration_rate = 2.0,
                    std::size_t calibration_samples = 1000)
     {
         using diff_type = typename decltype(view.begin())::difference_type;
@@ -107,12 +176,14 @@ class sgd_model
         lr_ *= calibration_rate;
         reset();
         auto hi_loss = avg_loss_on_sample(view, loss,
-                                          std::forward<LabelFunction>(labeler));
+                                          std::forward<LabelFunction>(labeler),
+                                          training);
 
         lr_ /= calibration_rate;
         reset();
         auto lo_loss = avg_loss_on_sample(view, loss,
-                                          std::forward<LabelFunction>(labeler));
+                                          std::forward<LabelFunction>(labeler),
+                                          training);
 
         if (lo_loss < hi_loss)
         {
@@ -122,7 +193,7 @@ class sgd_model
                 hi_loss = lo_loss;
                 reset();
                 lo_loss = avg_loss_on_sample(
-                    view, loss, std::forward<LabelFunction>(labeler));
+                    view, loss, std::forward<LabelFunction>(labeler), training);
             }
             lr_ *= calibration_rate;
         }
@@ -135,7 +206,7 @@ class sgd_model
                 lo_loss = hi_loss;
                 reset();
                 hi_loss = avg_loss_on_sample(
-                    view, loss, std::forward<LabelFunction>(labeler));
+                    view, loss, std::forward<LabelFunction>(labeler), training);
             }
             lr_ /= calibration_rate;
         }
@@ -149,6 +220,31 @@ class sgd_model
      */
     double predict(const feature_vector& x) const;
 
+    /**
+     * @return the number of features the model has weights for
+     */
+    std::size_t num_features() const;
+
+    /**
+     * The weights are stored multiplied by a common scale factor:
+     * predict() computes scale() * (bias() + the dot product of the
+     * instance with the stored weights).
+     *
+     * @param feature A feature id
+     * @return the stored weight of the feature
+     */
+    double weight(std::size_t feature) const;
+
+    /**
+     * @return the stored bias weight (see weight())
+     */
+    double bias() const;
+
+    /**
+     * @return the scale factor of the stored weights (see weight())
+     */
+    double scale() const;
+
     /**
      * Updates the model for a specific instance.
      *
@@ -161,33 +257,174 @@ class sgd_model
     double train_one(const feature_vector& x, double expected_label,
                      const loss::loss_function& loss);
 
-  private:
     /**
-     * Per-feature representation of the weight vector.
+     * Updates the model for a batch of instances on several threads at
+     * once. Each thread trains on its own contiguous part of the batch
+     * (so the batch should already be shuffled) and updates the shared
+     * per-feature weights without any locking: on sparse data, two
+     * threads rarely touch the same feature at the same time, and a lost
+     * update costs little. Every access to the shared per-feature state
+     * is a relaxed atomic load or store, so such a collision only loses
+     * an update; it is not a data race. The global state (the L2 scale,
+     * the bias, and the NAG normalizer) is kept per thread and merged
+     * every sync_interval instances per thread, so it only ever changes
+     * while no thread is training.
      *
-     * This stores four values: the actual weight, the current scale
-     * factor, and the running sum of squared gradients in order to
-     * implement the normalized adaptive gradient algorithm from Ross,
-     * Mineiro, and Langford, as well as the total cumulative L1 penalty to
-     * implement the L1 regularization proposed by Tsuruoka, Tsujii, and
-     * Ananiadou.
+     * With a single thread, the result differs from calling train_one()
+     * on each instance only in when the L2 scale is applied.
+     *
+     * @param examples The instances to update with
+     * @param loss The loss function to use for the updates
+     * @param pool The thread pool to train on
+     *
+     * @return the total loss incurred for the examples
+     */
+    double train_parallel(const std::vector<example_type>& examples,
+                          const loss::loss_function& loss,
+                          parallel::thread_pool& pool);
+
+    /**
+     * Updates the model with the average gradient of a mini-batch. The
+     * batch is split into chunks of gradient_chunk_size instances, whose
+     * sparse gradients are computed in parallel against the current
+     * weights and then summed in order, so the result does not depend on
+     * the number of threads. Only the features in the batch are updated,
+     * using AdaGrad or (lazy) Adam with steps measured in units of each
+     * feature's scale, as in NAG; L2 regularization shrinks the whole
+     * vector once per batch, and L1 regularization uses the cumulative
+     * penalty as in train_one().
+     *
+     * AdaGrad shares its sums of squared gradients with train_one();
+     * Adam's moving averages are not saved with the model.
+     *
+     * @param batch The instances to update with
+     * @param loss The loss function to use for the gradients
+     * @param pool The thread pool to compute the gradients on
+     * @param options The optimizer settings
+     *
+     * @return the total loss incurred for the batch (before the update)
+     */
+    double train_batch(const std::vector<example_type>& batch,
+                       const loss::loss_function& loss,
+                       parallel::thread_pool& pool,
+                       const training_options_type& options);
+
+    /**
+     * Trains the model with mini-batches or on several threads, as chosen
+     * by the training options. Like the sequential loops of the learners
+     * built on the model, this shuffles the data on each pass and stops
+     * early once the average loss over every tenth of the data (or 1000
+     * instances, whichever is more) stops changing by more than a
+     * relative threshold.
+     *
+     * @param docs The training data (a dataset_view)
+     * @param labeler A unary function object to convert an instance to a
+     * double label
+     * @param loss The loss function to train with
+     * @param options The training options
+     * @param gamma The convergence threshold
+     * @param max_iter The most passes to make over the data
      */
-    struct weight_type
+    template <class View, class LabelFunction>
+    void train_batches(View& docs, LabelFunction&& labeler,
+                       const loss::loss_function& loss,
+                       const training_options_type& options, double gamma,
+                       std::size_t max_iter)
+    {
+        parallel::thread_pool pool{std::max<std::size_t>(options.num_threads,
+                                                         1)};
+        double prev_avg_loss = 0;
+        auto check_interval = std::max<std::size_t>(1000, docs.size() / 10);
+        std::vector<example_type> examples;
+        examples.reserve(check_interval);
+
+        auto train_examples = [&]()
+        {
+            if (options.batch_size == 0)
+                return train_parallel(examples, loss, pool);
+
+            double total = 0;
+            std::vector<example_type> batch;
+            for (std::size_t i = 0; i < examples.size();
+                 i += options.batch_size)
+            {
+                auto last = std::min(examples.size(), i + options.batch_size);
+                batch.assign(examples.begin() + i, examples.begin() + last);
+                total += train_batch(batch, loss, pool, options);
+            }
+            return total;
+        };
+
+        for (std::size_t iter = 0; iter < max_iter; ++iter)
+        {
+            docs.shuffle();
+            for (const auto& instance : docs)
+            {
+                examples.emplace_back(&instance.weights, labeler(instance));
+                if (examples.size() < check_interval)
+                    continue;
+
+                auto avg_loss = train_examples() / check_interval;
+                examples.clear();
+                if (prev_avg_loss > 0
+                    && std::abs(prev_avg_loss - avg_loss) / prev_avg_loss
+                           < gamma)
+                    return;
+                prev_avg_loss = avg_loss;
+            }
+        }
+        train_examples();
+    }
+
+  private:
+    /**
+     * The state kept for the bias term: its weight and the running sum of
+     * its squared gradients.
+     */
+    struct bias_type
     {
         double weight = 0;
-        double scale = 0;
         double grad_squared = 0;
-        double cumulative_penalty = 0;
+    };
+
+    /**
+     * Names the memory category the weights are charged to.
+     */
+    struct memory_tag
+    {
+        static const char* name()
+        {
+            return "learn/sgd-model";
+        }
     };
 
     template <class SampleView, class LabelFunction>
     double avg_loss_on_sample(const SampleView& sample,
                               const loss::loss_function& loss,
-                              LabelFunction&& labeler)
+                              LabelFunction&& labeler,
+                              const training_options_type& training)
     {
         auto avg_loss = 0.0;
-        for (const auto& inst : sample)
-            avg_loss += train_one(inst.weights, labeler(inst), loss);
+        if (training.batch_size == 0)
+        {
+            for (const auto& inst : sample)
+                avg_loss += train_one(inst.weights, labeler(inst), loss);
+        }
+        else
+        {
+            parallel::thread_pool pool{
+                std::max<std::size_t>(training.num_threads, 1)};
+            std::vector<example_type> batch;
+            for (const auto& inst : sample)
+            {
+                batch.emplace_back(&inst.weights, labeler(inst));
+                if (batch.size() < training.batch_size)
+                    continue;
+                avg_loss += train_batch(batch, loss, pool, training);
+                batch.clear();
+            }
+            avg_loss += train_batch(batch, loss, pool, training);
+        }
         avg_loss /= sample.size();
 
         if (l2_regularization_ > 0)
@@ -199,7 +436,37 @@ class sgd_model
         return avg_loss;
     }
 
-    void penalize(weight_type& weight_val);
+    /**
+     * The global state of one thread in train_parallel(), as changes
+     * relative to the model's state at the last synchronization.
+     */
+    struct hogwild_state
+    {
+        /// The number of examples trained on
+        std::size_t t = 0;
+        /// The increase in the update scale
+        double update_scale = 0;
+        /// The increase in the bias weight
+        double bias_weight = 0;
+        /// The increase in the bias' sum of squared gradients
+        double bias_grad_squared = 0;
+        /// The total loss of the examples
+        double loss = 0;
+    };
+
+    /**
+     * Updates the shared weights for a single instance in
+     * train_parallel().
+     */
+    void train_shared(const feature_vector& x, double expected_label,
+                      const loss::loss_function& loss, hogwild_state& state);
+
+    void penalize(std::size_t feature, std::size_t t);
+
+    /**
+     * Folds the scale into the weights once it gets too small.
+     */
+    void renormalize();
 
     void reset();
 
@@ -207,11 +474,49 @@ class sgd_model
 
     double l1norm() const;
 
-    /// The per-feature weight information
-    std::vector<weight_type> weights_;
+    /**
+     * The per-feature state is stored as one array per field, so that
+     * predict() only reads the weights. Training also uses the scale
+     * factor and running sum of squared gradients of each feature, which
+     * implement the normalized adaptive gradient algorithm from Ross,
+     * Mineiro, and Langford, and (only with L1 regularization) the total
+     * cumulative L1 penalty proposed by Tsuruoka, Tsujii, and Ananiadou.
+     */
+    using array_type = memory::tracked_vector<double, memory_tag>;
+
+    /// The weight of each feature
+    array_type weights_;
+
+    /// The scale factor of each feature
+    array_type scales_;
+
+    /// The running sum of squared gradients of each feature
+    array_type grad_squared_;
+
+    /// The cumulative L1 penalty of each feature (empty without L1
+    /// regularization)
+    array_type cumulative_penalty_;
 
-    /// The weight information for the bias term
-    weight_type bias_;
+    /// Adam's moving average of the gradient of each feature (empty until
+    /// Adam is used); AdaGrad uses grad_squared_ instead
+    array_type first_moments_;
+
+    /// Adam's moving average of the squared gradient of each feature
+    /// (empty until Adam is used)
+    array_type second_moments_;
+
+    /// The dense mini-batch gradient, kept zeroed between batches (empty
+    /// until mini-batches are used)
+    array_type batch_gradient_;
+
+    /// The number of mini-batches trained on
+    std::size_t batch_steps_ = 0;
+
+    /// Adam's moving averages for the bias' gradient
+    std::pair<double, double> bias_moments_;
+
+    /// The state of the bias term
+    bias_type bias_;
 
     /// The current scalar to multiply weights in the weight vector by
     double scale_;
@@ -231,6 +536,54 @@ class sgd_model
     /// The total number of observed examples
     std::size_t t_;
 };
+
+/**
+ * Exception thrown for invalid sgd_model training options.
+ */
+class sgd_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Reads the training options for a learner built on sgd_model from its
+ * configuration table:
+ *
+ * ~~~toml
+ * num-threads = 1 # more than one trains in parallel
+ * batch-size = 0 # more than zero trains on mini-batches
+ * optimizer = "adagrad" # or "adam", for mini-batches
+ * beta1 = 0.9 # adam only
+ * beta2 = 0.999 # adam only
+ * ~~~
+ *
+ * @param config The learner's configuration table
+ * @return the training options
+ * @throw sgd_exception if the batch size is negative or the optimizer is
+ * unknown
+ */
+sgd_model::training_options_type
+    make_training_options(const cpptoml::table& config);
+
+/**
+ * Reads the model options for a learner built on sgd_model from its
+ * configuration table:
+ *
+ * ~~~toml
+ * learning-rate = 0.5 # or 0.01 when training on mini-batches with adam
+ * l2-regularization = 1e-7
+ * l1-regularization = 0
+ * ~~~
+ *
+ * @param config The learner's configuration table
+ * @param training The learner's training options, from
+ * make_training_options(), which pick the default learning rate
+ * @return the model options
+ */
+sgd_model::options_type
+    make_model_options(const cpptoml::table& config,
+                       const sgd_model::training_options_type& training);
 }
 }
 
@@ -11,13 +11,21 @@
 #ifndef META_LOGGER_H_
 #define META_LOGGER_H_
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <vector>
 
+#include "meta/parallel/mpsc_queue.h"
+
 namespace meta
 {
 
@@ -30,10 +38,30 @@ namespace logging
 /**
  * logger: Main logging class. Keeps track of a list of sinks to write
  * lines to---these can be of any std::ostream-derived type.
+ *
+ * By default, log lines are written to the sinks by the thread that
+ * created them (serialized by an internal mutex). In asynchronous mode,
+ * the formatted message is instead pushed onto a lock-free queue and
+ * written by a background thread, so logging never blocks the caller: if
+ * the queue is full, the line is dropped and counted. Repeated lines from
+ * the same call site can additionally be rate limited.
  */
 class logger
 {
   public:
+    /**
+     * Creates a synchronous logger with no sinks.
+     */
+    logger() = default;
+
+    /**
+     * Stops the background thread (if any), writing any queued lines.
+     */
+    ~logger()
+    {
+        stop_async();
+    }
+
     /**
      * severity_level: A demarcation of how severe a given message
      * is. Can be used to filter out messages below a certain
@@ -342,6 +370,7 @@ class logger
      */
     void add_sink(const sink& s)
     {
+        std::lock_guard<std::mutex> lock{mutex_};
         sinks_.push_back(s);
     }
 
@@ -352,25 +381,277 @@ class logger
      */
     void add_sink(sink&& s)
     {
+        std::lock_guard<std::mutex> lock{mutex_};
         sinks_.emplace_back(std::move(s));
     }
 
     /**
-     * Writes the given log_line to all sinks.
+     * Writes the given log_line to all sinks, or queues it for the
+     * background thread in asynchronous mode.
      *
      * @param line The log_line to write
      */
     void write_to_sinks(const log_line& line)
     {
+        if (!within_rate_limit(line))
+            return;
+
+        if (!queue_)
+        {
+            if (suppressed_.load(std::memory_order_relaxed) > 0)
+                report_dropped();
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (sink& s : sinks_)
+                s.write(line);
+            return;
+        }
+
+        if (!queue_->try_push(
+                {line.severity(), line.line(), line.file(), line.str()}))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pushed_.fetch_add(1, std::memory_order_release);
+
+        if (line.severity() == severity_level::fatal)
+            flush();
+        else if (line.severity() == severity_level::error)
+            wake_.notify_one();
+    }
+
+    /**
+     * Switches the logger to asynchronous mode. This (and stop_async())
+     * must not be called while other threads are logging.
+     *
+     * @param capacity The number of log lines that can be queued before
+     * new ones are dropped
+     */
+    void start_async(uint64_t capacity = 8192)
+    {
+        if (queue_)
+            return;
+        queue_ = std::unique_ptr<parallel::mpsc_queue<record>>{
+            new parallel::mpsc_queue<record>{capacity}};
+        running_ = true;
+        writer_ = std::thread{[this]() { drain(); }};
+    }
+
+    /**
+     * Writes all queued log lines and switches the logger back to
+     * synchronous mode.
+     */
+    void stop_async()
+    {
+        if (!queue_)
+            return;
+        {
+            std::lock_guard<std::mutex> lock{wake_mutex_};
+            running_ = false;
+        }
+        wake_.notify_one();
+        writer_.join();
+        queue_ = nullptr;
+    }
+
+    /**
+     * @return whether the logger is in asynchronous mode
+     */
+    bool async() const
+    {
+        return static_cast<bool>(queue_);
+    }
+
+    /**
+     * Blocks until every log line queued so far has been written.
+     */
+    void flush()
+    {
+        if (!queue_)
+            return;
+        auto target = pushed_.load(std::memory_order_acquire);
+        while (written_.load(std::memory_order_acquire) < target)
+        {
+            wake_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    /**
+     * Limits how many lines a single call site may log per second.
+     * Progress lines and lines at error severity or above are never
+     * limited. Call sites are hashed into a fixed number of slots, so
+     * the limit is approximate.
+     *
+     * @param lines_per_second The maximum number of lines per call site
+     * per second, or zero for no limit
+     */
+    void set_rate_limit(uint64_t lines_per_second)
+    {
+        rate_limit_.store(lines_per_second, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return the number of lines dropped because the queue was full
+     * or the rate limit was exceeded, not yet reported to the sinks
+     */
+    uint64_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed)
+               + suppressed_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    /**
+     * A log line waiting to be written by the background thread.
+     */
+    struct record
+    {
+        /// The severity of the line
+        severity_level sev;
+        /// The line number the line was logged from
+        size_t line;
+        /// The file the line was logged from
+        std::string file;
+        /// The formatted message
+        std::string message;
+    };
+
+    /**
+     * Keeps track of how many lines a group of call sites has logged in
+     * the current second.
+     */
+    struct rate_slot
+    {
+        /// The second the count is for
+        std::atomic<int64_t> second{0};
+        /// The number of lines logged in that second
+        std::atomic<uint64_t> count{0};
+    };
+
+    /**
+     * @param line The line about to be logged
+     * @return whether the line's call site is within the rate limit
+     */
+    bool within_rate_limit(const log_line& line)
+    {
+        auto limit = rate_limit_.load(std::memory_order_relaxed);
+        if (limit == 0 || line.severity() == severity_level::progress
+            || line.severity() >= severity_level::error)
+            return true;
+
+        auto hash = std::hash<std::string>{}(line.file()) * 31 + line.line();
+        auto& slot = rate_slots_[hash % rate_slots_.size()];
+
+        namespace sc = std::chrono;
+        auto now = sc::duration_cast<sc::seconds>(
+                       sc::steady_clock::now().time_since_epoch())
+                       .count();
+        auto second = slot.second.load(std::memory_order_relaxed);
+        if (second != now
+            && slot.second.compare_exchange_strong(second, now,
+                                                   std::memory_order_relaxed))
+            slot.count.store(0, std::memory_order_relaxed);
+
+        if (slot.count.fetch_add(1, std::memory_order_relaxed) < limit)
+            return true;
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Writes queued lines to the sinks until stop_async() is called.
+     */
+    void drain()
+    {
+        while (true)
+        {
+            bool running;
+            {
+                std::unique_lock<std::mutex> lock{wake_mutex_};
+                running = running_;
+                if (running)
+                    wake_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+
+            record rec;
+            while (queue_->try_pop(rec))
+            {
+                log_line line{*this, rec.sev, rec.line, rec.file};
+                line << rec.message;
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    for (sink& s : sinks_)
+                        s.write(line);
+                }
+                written_.fetch_add(1, std::memory_order_release);
+            }
+            report_dropped();
+
+            if (!running)
+                return;
+        }
+    }
+
+    /**
+     * Writes a warning to the sinks if any lines have been dropped since
+     * the last report.
+     */
+    void report_dropped()
+    {
+        auto dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        auto suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        if (dropped == 0 && suppressed == 0)
+            return;
+
+        log_line line{*this, severity_level::warning, __LINE__, __FILE__};
+        line << "Dropped " << dropped << " log line(s) (queue full) and "
+             << suppressed << " repeated log line(s) (rate limited)";
+        std::lock_guard<std::mutex> lock{mutex_};
         for (sink& s : sinks_)
             s.write(line);
     }
 
-  private:
     /**
      * The list of sinks to write to.
      */
     std::vector<sink> sinks_;
+
+    /// Serializes writes to the sinks
+    std::mutex mutex_;
+
+    /// The queue of lines to be written, if in asynchronous mode
+    std::unique_ptr<parallel::mpsc_queue<record>> queue_;
+
+    /// The thread writing queued lines
+    std::thread writer_;
+
+    /// Whether the writer thread should keep running
+    bool running_ = false;
+
+    /// Protects running_ and is used to wake the writer thread
+    std::mutex wake_mutex_;
+
+    /// Wakes the writer thread early
+    std::condition_variable wake_;
+
+    /// The number of lines queued so far
+    std::atomic<uint64_t> pushed_{0};
+
+    /// The number of queued lines written so far
+    std::atomic<uint64_t> written_{0};
+
+    /// The number of lines dropped because the queue was full
+    std::atomic<uint64_t> dropped_{0};
+
+    /// The number of lines dropped because of the rate limit
+    std::atomic<uint64_t> suppressed_{0};
+
+    /// The maximum number of lines per call site per second (0 for none)
+    std::atomic<uint64_t> rate_limit_{0};
+
+    /// Per-call-site line counts for rate limiting
+    std::array<rate_slot, 256> rate_slots_;
 };
 
 /**
@@ -400,6 +681,16 @@ inline void add_sink(logger::sink&& s)
     get_logger().add_sink(std::move(s));
 }
 
+/**
+ * Switches the static logger instance to asynchronous mode.
+ * @param capacity The number of log lines that can be queued before new
+ * ones are dropped
+ */
+inline void set_async_logging(uint64_t capacity = 8192)
+{
+    get_logger().start_async(capacity);
+}
+
 /**
  * Sets up default logging to cerr. Useful for a lot of the demo apps
  * to reduce verbosity in setup.
@@ -0,0 +1,150 @@
+/**
+ * @file mpsc_queue.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For
+ * more details, consult the file LICENSE.mit and LICENSE.ncsa in the root
+ * of the project.
+ */
+
+#ifndef META_PARALLEL_MPSC_QUEUE_H_
+#define META_PARALLEL_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace meta
+{
+namespace parallel
+{
+
+/**
+ * A bounded, lock-free queue supporting any number of concurrent
+ * producers and a single consumer. Each slot carries a sequence number
+ * that tells producers and the consumer whether it is free or full, so
+ * neither side ever blocks: pushing onto a full queue and popping from an
+ * empty one simply fail.
+ */
+template <class T>
+class mpsc_queue
+{
+  public:
+    /**
+     * @param capacity The minimum number of elements the queue can hold;
+     * rounded up to a power of two
+     */
+    mpsc_queue(uint64_t capacity)
+    {
+        uint64_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        mask_ = size - 1;
+        cells_ = std::unique_ptr<cell[]>{new cell[size]};
+        for (uint64_t i = 0; i < size; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_ = 0;
+    }
+
+    /**
+     * Attempts to add an element to the queue. Safe to call from any
+     * number of threads at once.
+     *
+     * @param elem The element to add
+     * @return whether the element was added (false if the queue is full)
+     */
+    bool try_push(T&& elem)
+    {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell* c;
+        while (true)
+        {
+            c = &cells_[pos & mask_];
+            auto seq = c->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        c->data = std::move(elem);
+        c->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Attempts to remove the oldest element from the queue. Must only be
+     * called from one thread at a time.
+     *
+     * @param elem Where to move the removed element
+     * @return whether an element was removed (false if the queue is
+     * empty)
+     */
+    bool try_pop(T& elem)
+    {
+        auto& c = cells_[dequeue_pos_ & mask_];
+        if (c.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+            return false;
+
+        elem = std::move(c.data);
+        c.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    /**
+     * @return the number of elements the queue can hold
+     */
+    uint64_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+  private:
+    /**
+     * A single slot in the queue.
+     */
+    struct cell
+    {
+        /// The position this slot is next expected to be written (or,
+        /// plus one, read) at
+        std::atomic<uint64_t> sequence;
+        /// The element stored in the slot
+        T data;
+    };
+
+    /// The slots, used as a ring
+    std::unique_ptr<cell[]> cells_;
+
+    /// One less than the number of slots
+    uint64_t mask_;
+
+    /// Padding to keep producers and the consumer off each other's cache
+    /// lines
+    char pad0_[64];
+
+    /// The next position to be claimed by a producer
+    std::atomic<uint64_t> enqueue_pos_;
+
+    /// Padding to keep producers and the consumer off each other's cache
+    /// lines
+    char pad1_[64];
+
+    /// The next position to be read by the consumer
+    uint64_t dequeue_pos_;
+};
+}
+}
+#endif
@@ -11,6 +11,7 @@
 #define META_PARALLEL_FOR_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <thread>
 #include <vector>
@@ -78,6 +79,34 @@ void parallel_for(Iterator begin, Iterator end, thread_pool& pool,
     for (auto& fut : futures)
         fut.get();
 }
+
+/**
+ * Splits the range [0, size) into one contiguous block per thread in the
+ * pool and runs the given function on each block in parallel. This is
+ * useful when each block can be processed with a single bulk operation
+ * (like a copy) rather than element by element.
+ *
+ * @param size The size of the range
+ * @param pool The thread pool to use
+ * @param func The function to run, called with the [begin, end) bounds of
+ * each block
+ */
+template <class Function>
+void parallel_blocks(uint64_t size, thread_pool& pool, Function func)
+{
+    auto num_blocks = std::max<uint64_t>(pool.thread_ids().size(), 1);
+    auto block_size = (size + num_blocks - 1) / num_blocks;
+
+    std::vector<std::future<void>> futures;
+    for (uint64_t begin = 0; begin < size; begin += block_size)
+    {
+        auto end = std::min(size, begin + block_size);
+        futures.emplace_back(pool.submit_task([=]()
+        { func(begin, end); }));
+    }
+    for (auto& fut : futures)
+        fut.get();
+}
 }
 }
 
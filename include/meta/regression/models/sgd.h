@@ -38,7 +38,13 @@ namespace regression
  * l1-regularization = 0
  * max-iter = 5
  * calibrate = true
+ * num-threads = 1 # more than one trains Hogwild style
+ * batch-size = 0 # more than zero trains on mini-batches
+ * optimizer = "adagrad" # or "adam", for mini-batches
  * ~~~
+ *
+ * With mini-batches, the learning rate defaults to
+ * learn::sgd_model::default_adam_learning_rate for Adam.
  */
 class sgd : public regressor
 {
@@ -55,11 +61,14 @@ class sgd : public regressor
      * @param options The options for the SGD learner
      * @param gamma The convergence threshold
      * @param max_iter The maximum allowed iterations
+     * @param calibrate Whether to calibrate the learning rate first
+     * @param training How to make the passes over the data
      */
     sgd(dataset_view_type docs,
         std::unique_ptr<learn::loss::loss_function> loss,
         learn::sgd_model::options_type options, double gamma = default_gamma,
-        size_t max_iter = default_max_iter, bool calibrate = true);
+        size_t max_iter = default_max_iter, bool calibrate = true,
+        learn::sgd_model::training_options_type training = {});
 
     /**
      * Loads an sgd regressor from a stream.
@@ -99,6 +108,9 @@ class sgd : public regressor
     /// The maximum number of iterations for training.
     const size_t max_iter_;
 
+    /// How to make the passes over the data (not saved with the model)
+    learn::sgd_model::training_options_type training_;
+
     /// The loss function to be used for the update.
     std::unique_ptr<learn::loss::loss_function> loss_;
 };
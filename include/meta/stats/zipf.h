@@ -0,0 +1,75 @@
+/**
+ * @file zipf.h
+ * @author agent
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_STATS_ZIPF_H_
+#define META_STATS_ZIPF_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace meta
+{
+namespace stats
+{
+
+/**
+ * Draws ranks in [0, n) from a Zipf distribution, where the probability
+ * of rank \f$r\f$ is proportional to \f$1 / (r + 1)^s\f$. This is a
+ * reasonable model of word frequencies in natural language text.
+ */
+class zipf_distribution
+{
+  public:
+    /**
+     * @param n The number of distinct ranks
+     * @param s The exponent of the distribution
+     */
+    zipf_distribution(uint64_t n, double s = 1.0) : cdf_(n)
+    {
+        double total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            total += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf_[i] = total;
+        }
+        for (auto& p : cdf_)
+            p /= total;
+    }
+
+    /**
+     * @param gen The random number generator to use
+     * @return a rank in [0, n)
+     */
+    template <class Generator>
+    uint64_t operator()(Generator& gen) const
+    {
+        std::uniform_real_distribution<double> uniform{0.0, 1.0};
+        auto it = std::lower_bound(cdf_.begin(), cdf_.end(), uniform(gen));
+        if (it == cdf_.end())
+            --it;
+        return static_cast<uint64_t>(it - cdf_.begin());
+    }
+
+    /**
+     * @return the number of distinct ranks
+     */
+    uint64_t size() const
+    {
+        return cdf_.size();
+    }
+
+  private:
+    /// The cumulative probability of each rank
+    std::vector<double> cdf_;
+};
+}
+}
+#endif
@@ -11,6 +11,7 @@
 #define META_UTF8_H_
 
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -31,6 +32,19 @@ namespace detail
 void utf8_append_codepoint(std::string& dest, UChar32 codepoint);
 }
 
+/**
+ * @param str The string to check
+ * @return whether the string is entirely ASCII, in which case every byte
+ * is a code point and ASCII fast paths may be used
+ */
+inline bool is_ascii(const std::string& str)
+{
+    uint8_t bits = 0;
+    for (auto c : str)
+        bits |= static_cast<uint8_t>(c);
+    return bits < 0x80;
+}
+
 /**
  * Converts a string from the given charset to utf8.
  * @param str The string to convert
@@ -112,6 +126,16 @@ std::string remove_if(const std::string& str, Predicate&& pred)
 {
     std::string result;
     result.reserve(str.size());
+    if (is_ascii(str))
+    {
+        for (auto c : str)
+        {
+            if (!pred(static_cast<uint32_t>(c)))
+                result += c;
+        }
+        return result;
+    }
+
     const char* s = str.c_str();
     auto length = static_cast<int32_t>(str.length());
     for (int32_t i = 0; i < length;)
@@ -139,6 +163,20 @@ std::string transform(const std::string& str, Function&& fun)
     auto s = str.c_str();
     std::string result;
     result.reserve(str.size()); // not always accurate, but close
+    if (is_ascii(str))
+    {
+        for (auto c : str)
+        {
+            auto transformed = fun(static_cast<uint32_t>(c));
+            if (transformed < 0x80)
+                result += static_cast<char>(transformed);
+            else
+                detail::utf8_append_codepoint(
+                    result, static_cast<UChar32>(transformed));
+        }
+        return result;
+    }
+
     auto length = static_cast<int32_t>(str.length());
     for (int32_t i = 0; i < length;)
     {
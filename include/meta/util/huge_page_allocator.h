@@ -0,0 +1,101 @@
+/**
+ * @file huge_page_allocator.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTIL_HUGE_PAGE_ALLOCATOR_H_
+#define META_UTIL_HUGE_PAGE_ALLOCATOR_H_
+
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "meta/util/aligned_allocator.h"
+
+namespace meta
+{
+namespace util
+{
+
+/**
+ * An allocator for large, long-lived arrays that are accessed randomly
+ * (e.g., an index held entirely in RAM). Allocations of at least one huge
+ * page are aligned to the huge page size and, where the platform supports
+ * it, marked as eligible for transparent huge pages to cut down on TLB
+ * misses. Smaller allocations are served by std::allocator.
+ */
+template <class T>
+struct huge_page_allocator
+{
+    using value_type = T;
+
+    /// The size of a (transparent) huge page on x86-64 Linux
+    const static constexpr std::size_t page_size = 2 * 1024 * 1024;
+
+    huge_page_allocator() = default;
+
+    template <class U>
+    huge_page_allocator(const huge_page_allocator<U>&)
+    {
+        // nothing
+    }
+
+    template <class U>
+    struct rebind
+    {
+        using other = huge_page_allocator<U>;
+    };
+
+    T* allocate(std::size_t n)
+    {
+        if (n * sizeof(T) < page_size)
+            return std::allocator<T>{}.allocate(n);
+
+        auto size = page_size
+                    * math::integer::div_ceil(n * sizeof(T), page_size);
+        auto ptr = static_cast<T*>(detail::aligned_alloc(page_size, size));
+        if (!ptr)
+            throw std::bad_alloc{};
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // this is only advice, so failure is not an error
+        ::madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+        return ptr;
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (n * sizeof(T) < page_size)
+            std::allocator<T>{}.deallocate(p, n);
+        else
+            detail::aligned_free(p);
+    }
+};
+
+template <class T>
+constexpr std::size_t huge_page_allocator<T>::page_size;
+
+template <class T, class U>
+bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&)
+{
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&)
+{
+    return false;
+}
+
+template <class T>
+using huge_page_vector = std::vector<T, huge_page_allocator<T>>;
+}
+}
+#endif
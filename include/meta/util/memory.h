@@ -0,0 +1,248 @@
+/**
+ * @file memory.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTIL_MEMORY_H_
+#define META_UTIL_MEMORY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace meta
+{
+
+/**
+ * Namespace for memory accounting: live heap bytes are attributed to named
+ * categories (e.g., "index/postings-inverter" or "learn/sgd-model"), and
+ * the peak of each category is recorded both over the whole run and per
+ * stage of a run.
+ *
+ * Accounting is opt-in per data structure: containers use a
+ * tracking_allocator, and structures that manage their own buffers report
+ * their actual size to a category directly.
+ */
+namespace memory
+{
+
+/**
+ * A named count of live bytes along with its high-water marks. All
+ * operations are thread safe.
+ */
+class category
+{
+  public:
+    /**
+     * @param name The name of the category
+     */
+    category(std::string name);
+
+    /**
+     * Records that bytes were allocated.
+     * @param bytes The number of bytes
+     */
+    void allocate(uint64_t bytes);
+
+    /**
+     * Records that bytes were freed.
+     * @param bytes The number of bytes
+     */
+    void deallocate(uint64_t bytes);
+
+    /**
+     * Records a change in the size of a structure.
+     * @param old_bytes The size it was last reported at
+     * @param new_bytes Its current size
+     */
+    void update(uint64_t old_bytes, uint64_t new_bytes);
+
+    /**
+     * @return the name of the category
+     */
+    const std::string& name() const;
+
+    /**
+     * @return the number of bytes currently live
+     */
+    uint64_t live() const;
+
+    /**
+     * @return the most bytes ever live at once
+     */
+    uint64_t peak() const;
+
+    /**
+     * @return the most bytes live at once since the current stage began
+     */
+    uint64_t stage_peak() const;
+
+    /**
+     * Starts a new stage: the stage peak becomes the current live count.
+     */
+    void reset_stage_peak();
+
+  private:
+    /// The name of the category
+    const std::string name_;
+
+    /// The bytes currently live
+    std::atomic<uint64_t> live_;
+
+    /// The high-water mark over the whole run
+    std::atomic<uint64_t> peak_;
+
+    /// The high-water mark for the current stage
+    std::atomic<uint64_t> stage_peak_;
+};
+
+/**
+ * @param name The name of the category
+ * @return the category with that name, created if needed; categories
+ * live for the rest of the program, so references may be cached
+ */
+category& get_category(const std::string& name);
+
+/**
+ * @return the bytes live across every category
+ */
+uint64_t total_live();
+
+/**
+ * The peak usage of every category during one stage of a run.
+ */
+struct stage_usage
+{
+    /// The name of the stage
+    std::string name;
+    /// The peak bytes of each category that was used during the stage
+    std::vector<std::pair<std::string, uint64_t>> peaks;
+};
+
+/**
+ * Marks a stage of a run (e.g., tokenizing or merging) for the lifetime
+ * of the object. When the stage ends, the peak of every category during
+ * the stage is recorded and can be retrieved with stages(). Stages should
+ * not overlap.
+ */
+class stage
+{
+  public:
+    /**
+     * Begins a stage.
+     * @param name The name of the stage
+     */
+    stage(std::string name);
+
+    /**
+     * Ends the stage and records its peaks.
+     */
+    ~stage();
+
+  private:
+    /// The name of the stage
+    std::string name_;
+};
+
+/**
+ * @return the usage of every stage that has ended, in order
+ */
+std::vector<stage_usage> stages();
+
+/**
+ * Forgets every recorded stage.
+ */
+void clear_stages();
+
+/**
+ * @param first The first recorded stage to include
+ * @return a human readable summary of the peak usage of the recorded
+ * stages, one line per stage
+ */
+std::string stage_summary(uint64_t first = 0);
+
+/**
+ * @return every category and stage as a JSON object with "categories"
+ * and "stages" members
+ */
+std::string to_json();
+
+/**
+ * Tag types name the category a tracking_allocator charges. A tag is any
+ * type with a static `name()` function returning the category name.
+ *
+ * @return the category for the given tag
+ */
+template <class Tag>
+category& tagged_category()
+{
+    static category& cat = get_category(Tag::name());
+    return cat;
+}
+
+/**
+ * An allocator that charges every allocation to the category named by
+ * Tag. It is stateless, so it can be used anywhere std::allocator can.
+ */
+template <class T, class Tag>
+struct tracking_allocator
+{
+    using value_type = T;
+
+    tracking_allocator() = default;
+
+    template <class U>
+    tracking_allocator(const tracking_allocator<U, Tag>&)
+    {
+        // nothing
+    }
+
+    template <class U>
+    struct rebind
+    {
+        using other = tracking_allocator<U, Tag>;
+    };
+
+    T* allocate(std::size_t n)
+    {
+        auto ptr = std::allocator<T>{}.allocate(n);
+        tagged_category<Tag>().allocate(n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        std::allocator<T>{}.deallocate(p, n);
+        tagged_category<Tag>().deallocate(n * sizeof(T));
+    }
+};
+
+template <class T, class U, class Tag>
+bool operator==(const tracking_allocator<T, Tag>&,
+                const tracking_allocator<U, Tag>&)
+{
+    return true;
+}
+
+template <class T, class U, class Tag>
+bool operator!=(const tracking_allocator<T, Tag>&,
+                const tracking_allocator<U, Tag>&)
+{
+    return false;
+}
+
+/**
+ * A vector whose storage is charged to the category named by Tag.
+ */
+template <class T, class Tag>
+using tracked_vector = std::vector<T, tracking_allocator<T, Tag>>;
+}
+}
+#endif
@@ -0,0 +1,350 @@
+/**
+ * @file metrics.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTIL_METRICS_H_
+#define META_UTIL_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace meta
+{
+
+/**
+ * Namespace for run-time instrumentation: counters, histograms, and
+ * timers that are registered by name and can be dumped on demand.
+ *
+ * Collection is disabled by default; every update first checks a single
+ * global flag, so instrumented code pays only a relaxed load and a branch
+ * until metrics::set_enabled(true) is called.
+ */
+namespace metrics
+{
+
+/**
+ * @return whether metrics are currently being collected
+ */
+inline bool enabled();
+
+/**
+ * Turns metric collection on or off.
+ * @param enable Whether to collect metrics
+ */
+void set_enabled(bool enable);
+
+namespace detail
+{
+/// The global switch checked by every update
+extern std::atomic<bool> enabled_flag;
+
+/**
+ * @return a small per-thread number used to spread updates from
+ * different threads over different shards
+ */
+uint64_t thread_shard();
+}
+
+inline bool enabled()
+{
+    return detail::enabled_flag.load(std::memory_order_relaxed);
+}
+
+/**
+ * A monotonically increasing count. Updates go to one of several
+ * cache-line sized shards chosen by the calling thread, so concurrent
+ * increments rarely contend; reads sum the shards.
+ */
+class counter
+{
+  public:
+    /// The number of shards updates are spread over
+    const static constexpr uint64_t num_shards = 16;
+
+    /**
+     * Creates a counter starting at zero.
+     */
+    counter();
+
+    /**
+     * Adds to the counter if metrics are enabled.
+     * @param amount The amount to add
+     */
+    void add(uint64_t amount = 1)
+    {
+        if (!enabled())
+            return;
+        shards_[detail::thread_shard() % num_shards].value.fetch_add(
+            amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return the current value of the counter
+     */
+    uint64_t value() const;
+
+    /**
+     * Sets the counter back to zero.
+     */
+    void reset();
+
+  private:
+    /**
+     * A single shard, padded to its own cache line.
+     */
+    struct shard
+    {
+        std::atomic<uint64_t> value{0};
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    /// The shards
+    std::array<shard, num_shards> shards_;
+};
+
+/**
+ * A histogram of non-negative integer values (e.g., latencies in
+ * nanoseconds) using HDR-style log-linear buckets: values are grouped by
+ * their highest set bit and each group is split into a fixed number of
+ * linear sub-buckets, giving a bounded relative error (about 6%) over the
+ * whole 64-bit range with a fixed amount of memory.
+ */
+class histogram
+{
+  public:
+    /// The number of bits of precision kept below the highest set bit
+    const static constexpr uint64_t sub_bucket_bits = 4;
+
+    /// The number of linear sub-buckets per power of two
+    const static constexpr uint64_t sub_buckets = 1 << sub_bucket_bits;
+
+    /// The total number of buckets
+    const static constexpr uint64_t num_buckets
+        = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    /**
+     * @param scale The factor to multiply values by when reporting them
+     * (e.g., 1e-9 to report nanoseconds as seconds)
+     */
+    histogram(double scale = 1.0);
+
+    /**
+     * Records a value if metrics are enabled.
+     * @param value The value to record
+     */
+    void record(uint64_t value)
+    {
+        if (!enabled())
+            return;
+        buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return the number of values recorded
+     */
+    uint64_t count() const;
+
+    /**
+     * @return the sum of the values recorded (scaled)
+     */
+    double sum() const;
+
+    /**
+     * @param q The quantile, in [0, 1]
+     * @return an upper bound on the q-th quantile of the recorded values
+     * (scaled), accurate to the bucket resolution
+     */
+    double quantile(double q) const;
+
+    /**
+     * @return the factor values are multiplied by when reported
+     */
+    double scale() const;
+
+    /**
+     * Calls fn(upper_bound, cumulative_count) for every non-empty bucket
+     * in increasing order; upper_bound is scaled.
+     * @param fn The function to call
+     */
+    template <class Function>
+    void for_each_bucket(Function&& fn) const
+    {
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < num_buckets; ++i)
+        {
+            auto n = buckets_[i].load(std::memory_order_relaxed);
+            if (n == 0)
+                continue;
+            total += n;
+            fn(static_cast<double>(upper_bound(i)) * scale_, total);
+        }
+    }
+
+    /**
+     * Forgets all recorded values.
+     */
+    void reset();
+
+    /**
+     * @param value A value
+     * @return the bucket that value is counted in
+     */
+    static uint64_t bucket(uint64_t value);
+
+    /**
+     * @param idx A bucket
+     * @return the largest value counted in that bucket
+     */
+    static uint64_t upper_bound(uint64_t idx);
+
+  private:
+    /// The scale factor for reporting
+    double scale_;
+
+    /// The count for every bucket
+    std::array<std::atomic<uint64_t>, num_buckets> buckets_;
+
+    /// The number of values recorded
+    std::atomic<uint64_t> count_;
+
+    /// The sum of the values recorded
+    std::atomic<uint64_t> sum_;
+};
+
+/**
+ * Records the time between its construction and destruction (in
+ * nanoseconds) into a histogram. Does not read the clock at all when
+ * metrics are disabled.
+ */
+class scoped_timer
+{
+  public:
+    /**
+     * Starts the timer.
+     * @param hist The histogram to record into
+     */
+    scoped_timer(histogram& hist) : hist_{enabled() ? &hist : nullptr}
+    {
+        if (hist_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Records the elapsed time.
+     */
+    ~scoped_timer()
+    {
+        if (hist_)
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            hist_->record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count()));
+        }
+    }
+
+  private:
+    /// The histogram to record into, or null if disabled
+    histogram* hist_;
+
+    /// When the timer was started
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Owns every named metric. Metrics are created on first use and live as
+ * long as the registry, so references to them may be cached (typically
+ * in function-local statics at the instrumentation site).
+ *
+ * Names follow Prometheus conventions and may carry labels, e.g.
+ * `meta_cache_hits_total{cache="dblru"}`.
+ */
+class registry
+{
+  public:
+    /**
+     * @param name The name of the counter
+     * @return the counter with that name, created if needed
+     */
+    metrics::counter& counter(const std::string& name);
+
+    /**
+     * @param name The name of the histogram
+     * @param scale The reporting scale, used if the histogram is created
+     * @return the histogram with that name, created if needed
+     */
+    metrics::histogram& histogram(const std::string& name,
+                                  double scale = 1.0);
+
+    /**
+     * @param name The name of the timer; should end in "_seconds"
+     * @return the histogram with that name, created if needed, that
+     * records nanoseconds and reports seconds
+     */
+    metrics::histogram& timer(const std::string& name);
+
+    /**
+     * @return every metric as a JSON object with "counters" and
+     * "histograms" members
+     */
+    std::string to_json() const;
+
+    /**
+     * @return every metric in the Prometheus text exposition format
+     */
+    std::string to_prometheus() const;
+
+    /**
+     * Resets every metric to zero.
+     */
+    void reset();
+
+  private:
+    /// Protects the maps (but not the metrics themselves)
+    mutable std::mutex mutex_;
+
+    /// The counters, by name
+    std::map<std::string, std::unique_ptr<metrics::counter>> counters_;
+
+    /// The histograms, by name
+    std::map<std::string, std::unique_ptr<metrics::histogram>> histograms_;
+};
+
+/**
+ * @return the global metrics registry
+ */
+registry& get_registry();
+
+/**
+ * @param name The name of the counter
+ * @return the counter with that name in the global registry
+ */
+inline counter& get_counter(const std::string& name)
+{
+    return get_registry().counter(name);
+}
+
+/**
+ * @param name The name of the timer
+ * @return the timer histogram with that name in the global registry
+ */
+inline histogram& get_timer(const std::string& name)
+{
+    return get_registry().timer(name);
+}
+}
+}
+#endif
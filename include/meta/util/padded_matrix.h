@@ -0,0 +1,135 @@
+/**
+ * @file padded_matrix.h
+ * @author agent
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTIL_PADDED_MATRIX_H_
+#define META_UTIL_PADDED_MATRIX_H_
+
+#include <cstdint>
+
+#include "meta/util/aligned_allocator.h"
+
+namespace meta
+{
+namespace util
+{
+
+/**
+ * A dense matrix laid out in row-major order whose rows are padded with
+ * zeros to a multiple of Alignment bytes, so that every row starts
+ * aligned. The classifiers use it to score every class in one pass over a
+ * document: with a row per feature and a column per class, each feature
+ * adds its scaled row into the running scores (see add_row()), a
+ * contiguous loop over whole SIMD vectors that the compiler vectorizes.
+ *
+ * The matrix takes rows() * stride() * sizeof(T) bytes, so it only suits
+ * models whose features times classes fit comfortably in memory.
+ */
+template <class T, std::size_t Alignment = 64>
+class padded_matrix
+{
+  public:
+    static_assert(Alignment % sizeof(T) == 0,
+                  "padded_matrix alignment must be a multiple of the "
+                  "element size");
+
+    /**
+     * Default constructed matrices are empty.
+     */
+    padded_matrix() = default;
+
+    /**
+     * Constructs a padded_matrix with the specified number of rows and
+     * columns, with every element (including the padding) value
+     * initialized.
+     *
+     * @param rows The desired number of rows
+     * @param columns The desired number of columns
+     */
+    padded_matrix(uint64_t rows, uint64_t columns);
+
+    /**
+     * Obtains the column-th element of the row-th row.
+     *
+     * @param row The row index
+     * @param column The column index
+     * @return a reference to the element at that position
+     */
+    T& operator()(uint64_t row, uint64_t column);
+
+    /**
+     * Obtains the column-th element of the row-th row.
+     *
+     * @param row The row index
+     * @param column The column index
+     * @return a const reference to the element at that position
+     */
+    const T& operator()(uint64_t row, uint64_t column) const;
+
+    /**
+     * Adds a row, multiplied by a scalar, to a vector of sums. The
+     * padding holds zeros, so the sums past columns() are unchanged.
+     *
+     * @param row The row index
+     * @param scale The value to multiply the row by
+     * @param sums The sums to add to, at least stride() of them
+     */
+    template <class Scale, class Sum>
+    void add_row(uint64_t row, Scale scale, Sum* sums) const;
+
+    /**
+     * @return the number of rows in the matrix
+     */
+    uint64_t rows() const;
+
+    /**
+     * @return the number of columns in the matrix, excluding padding
+     */
+    uint64_t columns() const;
+
+    /**
+     * @return the number of elements in each row, including padding
+     */
+    uint64_t stride() const;
+
+    /**
+     * @return the number of bytes the elements take
+     */
+    uint64_t bytes() const;
+
+    /**
+     * @param rows A number of rows
+     * @param columns A number of columns
+     * @return the number of bytes the elements of a matrix of that size
+     * would take
+     */
+    static uint64_t bytes(uint64_t rows, uint64_t columns);
+
+  private:
+    /**
+     * @param columns A number of columns
+     * @return the number of elements in a row of that many columns,
+     * including padding
+     */
+    static uint64_t stride_for(uint64_t columns);
+
+    /// the underlying storage for the matrix
+    aligned_vector<T, Alignment> storage_;
+    /// the number of rows in the matrix
+    uint64_t rows_ = 0;
+    /// the number of columns in the matrix
+    uint64_t columns_ = 0;
+    /// the number of elements in each row, including padding
+    uint64_t stride_ = 0;
+};
+}
+}
+
+#include "meta/util/padded_matrix.tcc"
+
+#endif
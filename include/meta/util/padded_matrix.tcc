@@ -0,0 +1,83 @@
+/**
+ * @file padded_matrix.tcc
+ * @author agent
+ */
+
+#include "meta/math/integer.h"
+#include "meta/util/padded_matrix.h"
+
+namespace meta
+{
+namespace util
+{
+
+template <class T, std::size_t Alignment>
+padded_matrix<T, Alignment>::padded_matrix(uint64_t rows, uint64_t columns)
+    : rows_{rows},
+      columns_{columns},
+      stride_{stride_for(columns)}
+{
+    storage_.resize(rows * stride_);
+}
+
+template <class T, std::size_t Alignment>
+T& padded_matrix<T, Alignment>::operator()(uint64_t row, uint64_t column)
+{
+    return storage_[row * stride_ + column];
+}
+
+template <class T, std::size_t Alignment>
+const T& padded_matrix<T, Alignment>::operator()(uint64_t row,
+                                                 uint64_t column) const
+{
+    return storage_[row * stride_ + column];
+}
+
+template <class T, std::size_t Alignment>
+template <class Scale, class Sum>
+void padded_matrix<T, Alignment>::add_row(uint64_t row, Scale scale,
+                                          Sum* sums) const
+{
+    const auto* values = storage_.data() + row * stride_;
+    for (uint64_t col = 0; col < stride_; ++col)
+        sums[col] += scale * values[col];
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::rows() const
+{
+    return rows_;
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::columns() const
+{
+    return columns_;
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::stride() const
+{
+    return stride_;
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::bytes() const
+{
+    return storage_.size() * sizeof(T);
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::stride_for(uint64_t columns)
+{
+    const uint64_t per_block = Alignment / sizeof(T);
+    return per_block * math::integer::div_ceil(columns, per_block);
+}
+
+template <class T, std::size_t Alignment>
+uint64_t padded_matrix<T, Alignment>::bytes(uint64_t rows, uint64_t columns)
+{
+    return rows * stride_for(columns) * sizeof(T);
+}
+}
+}
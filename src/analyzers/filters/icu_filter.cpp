@@ -38,7 +38,7 @@ void icu_filter::set_content(std::string&& content)
 
 std::string icu_filter::next()
 {
-    auto tok = *token_;
+    auto tok = std::move(*token_);
     next_token();
     return tok;
 }
@@ -50,13 +50,13 @@ void icu_filter::next_token()
         auto tok = source_->next();
         if (tok == "<s>" || tok == "</s>")
         {
-            token_ = tok;
+            token_ = std::move(tok);
             return;
         }
         auto trans = trans_(tok);
         if (!trans.empty())
         {
-            token_ = trans;
+            token_ = std::move(trans);
             return;
         }
     }
@@ -3,11 +3,15 @@
  * @author Sean Massung
  */
 
+#include <map>
+#include <mutex>
 #include <random>
 #include <numeric>
 #include "meta/logging/logger.h"
 #include "meta/classify/classifier/classifier.h"
+#include "meta/classify/classifier/svm_wrapper.h"
 #include "meta/classify/classifier_factory.h"
+#include "meta/parallel/parallel_for.h"
 
 namespace meta
 {
@@ -25,16 +29,86 @@ confusion_matrix classifier::test(dataset_view_type docs) const
     return matrix;
 }
 
+confusion_matrix classifier::classify_batch(dataset_view_type docs,
+                                            parallel::thread_pool& pool) const
+{
+    using diff_type = decltype(docs.begin())::difference_type;
+
+    // each block's matrix is kept by where the block starts, so they are
+    // merged in the same order however the blocks finish
+    std::map<uint64_t, confusion_matrix> matrices;
+    std::mutex mutex;
+    parallel::parallel_blocks(
+        docs.size(), pool, [&](uint64_t begin, uint64_t end)
+        {
+            confusion_matrix matrix;
+            auto first = docs.begin() + static_cast<diff_type>(begin);
+            auto last = docs.begin() + static_cast<diff_type>(end);
+            for (; first != last; ++first)
+                matrix.add(predicted_label{classify(first->weights)},
+                           docs.label(*first));
+
+            std::lock_guard<std::mutex> lock{mutex};
+            matrices[begin] = std::move(matrix);
+        });
+
+    confusion_matrix matrix;
+    for (const auto& block : matrices)
+        matrix += block.second;
+    return matrix;
+}
+
+std::vector<class_label>
+    classifier::classify_batch(const std::vector<feature_vector>& instances,
+                               parallel::thread_pool& pool) const
+{
+    std::vector<class_label> labels(instances.size());
+    parallel::parallel_blocks(instances.size(), pool,
+                              [&](uint64_t begin, uint64_t end)
+                              {
+                                  for (auto i = begin; i < end; ++i)
+                                      labels[i] = classify(instances[i]);
+                              });
+    return labels;
+}
+
+uint64_t max_parallel_folds(const cpptoml::table& config, int64_t requested)
+{
+    if (requested < 1)
+        throw classifier_exception{"the number of folds to run at once must "
+                                   "be positive"};
+
+    for (auto cls = &config; cls;)
+    {
+        if (cls->get_as<std::string>("method").value_or("")
+            == svm_wrapper::id)
+        {
+            if (requested > 1)
+                LOG(warning) << svm_wrapper::id
+                             << " trains through fixed files, so folds are "
+                                "cross-validated one at a time"
+                             << ENDLG;
+            return 1;
+        }
+        // ensembles keep the configuration of their classifiers in "base"
+        cls = cls->get_table("base").get();
+    }
+    return static_cast<uint64_t>(requested);
+}
+
 confusion_matrix cross_validate(const cpptoml::table& config,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split /* = false */)
+                                bool even_split /* = false */,
+                                uint64_t max_parallel_folds /* = 1 */)
 {
+    auto parallel_folds = classify::max_parallel_folds(
+        config, static_cast<int64_t>(max_parallel_folds));
     return cross_validate(
         [&](multiclass_dataset_view fold)
         {
             return make_classifier(config, std::move(fold));
         },
-        std::move(docs), k, even_split);
+        std::move(docs), k, even_split, parallel_folds);
 }
 }
 }
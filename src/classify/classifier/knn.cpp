@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <cmath>
 #include <vector>
 #include <unordered_map>
 
@@ -19,6 +20,26 @@ namespace classify
 {
 
 const util::string_view knn::id = "knn";
+const constexpr uint64_t knn::default_ef;
+const constexpr uint64_t knn::format_version;
+
+namespace
+{
+/**
+ * @param version The format version a knn model was saved in
+ * @return the version, if this build can read it
+ * @throw knn_exception if the model was saved in a newer format
+ */
+uint64_t check_version(uint64_t version)
+{
+    if (version > knn::format_version)
+        throw knn_exception{"knn model was saved in format version "
+                            + std::to_string(version) + ", but only up to "
+                            + std::to_string(knn::format_version)
+                            + " can be read"};
+    return version;
+}
+}
 
 knn::knn(multiclass_dataset_view docs,
          std::shared_ptr<index::inverted_index> idx, uint16_t k,
@@ -26,6 +47,7 @@ knn::knn(multiclass_dataset_view docs,
     : inv_idx_{std::move(idx)},
       k_{k},
       ranker_{std::move(ranker)},
+      ef_{default_ef},
       weighted_{weighted}
 {
     legal_docs_.reserve(docs.size());
@@ -33,8 +55,50 @@ knn::knn(multiclass_dataset_view docs,
         legal_docs_.insert(doc_id(instance.id));
 }
 
+knn::knn(multiclass_dataset_view docs,
+         std::shared_ptr<index::inverted_index> idx, uint16_t k,
+         const index::hnsw_options& options, uint64_t ef,
+         bool weighted /* = false */)
+    : inv_idx_{std::move(idx)}, k_{k}, ef_{ef}, weighted_{weighted}
+{
+    legal_docs_.reserve(docs.size());
+    std::vector<uint64_t> doc_freqs;
+    for (const auto& instance : docs)
+    {
+        legal_docs_.insert(doc_id(instance.id));
+        for (const auto& weight : instance.weights)
+        {
+            if (weight.first >= doc_freqs.size())
+                doc_freqs.resize(weight.first + 1);
+            ++doc_freqs[weight.first];
+        }
+    }
+
+    idf_.resize(doc_freqs.size());
+    for (uint64_t t_id = 0; t_id < doc_freqs.size(); ++t_id)
+    {
+        if (doc_freqs[t_id] > 0)
+            idf_[t_id] = std::log(
+                1.0 + static_cast<double>(docs.size()) / doc_freqs[t_id]);
+    }
+
+    std::vector<std::pair<doc_id, index::hnsw_index::vector_type>> vectors;
+    vectors.reserve(docs.size());
+    for (const auto& instance : docs)
+        vectors.emplace_back(doc_id(instance.id), weigh(instance.weights));
+    hnsw_ = make_unique<index::hnsw_index>(vectors, options);
+}
+
 knn::knn(std::istream& in)
-    : weighted_{io::packed::read<bool>(in)}
+    : knn(in, check_version(io::packed::read<uint64_t>(in)))
+{
+    // nothing
+}
+
+// an unversioned model stores its weighted flag (0 or 1) where the
+// version now is, and always ranks its neighbors exactly
+knn::knn(std::istream& in, uint64_t version)
+    : weighted_{version < 2 ? version == 1 : io::packed::read<bool>(in)}
 {
     // hackily load in the index from its stored path
     auto path = io::packed::read<std::string>(in);
@@ -42,7 +106,19 @@ knn::knn(std::istream& in)
     inv_idx_ = index::make_index<index::inverted_index>(*config);
 
     io::packed::read(in, k_);
-    ranker_ = index::load_ranker(in);
+    if (version >= 2 && io::packed::read<bool>(in))
+    {
+        hnsw_ = make_unique<index::hnsw_index>(in);
+        io::packed::read(in, ef_);
+        idf_.resize(io::packed::read<uint64_t>(in));
+        for (auto& idf : idf_)
+            io::packed::read(in, idf);
+    }
+    else
+    {
+        ranker_ = index::load_ranker(in);
+        ef_ = default_ef;
+    }
 
     auto size = io::packed::read<std::size_t>(in);
     legal_docs_.reserve(size);
@@ -57,10 +133,23 @@ void knn::save(std::ostream& out) const
 {
     io::packed::write(out, id);
 
+    io::packed::write(out, format_version);
     io::packed::write(out, weighted_);
     io::packed::write(out, inv_idx_->index_name());
     io::packed::write(out, k_);
-    ranker_->save(out);
+    io::packed::write(out, hnsw_ != nullptr);
+    if (hnsw_)
+    {
+        hnsw_->save(out);
+        io::packed::write(out, ef_);
+        io::packed::write(out, idf_.size());
+        for (const auto& idf : idf_)
+            io::packed::write(out, idf);
+    }
+    else
+    {
+        ranker_->save(out);
+    }
 
     io::packed::write(out, legal_docs_.size());
     for (const auto& doc : legal_docs_)
@@ -74,16 +163,26 @@ class_label knn::classify(const feature_vector& instance) const
             "k must be smaller than the "
             "number of documents in the index (training documents)"};
 
-    analyzers::feature_map<uint64_t> query{instance.size()};
-    for (const auto& count : instance)
-        query[inv_idx_->term_text(count.first)] += count.second;
-    assert(query.size() > 0);
+    std::vector<index::search_result> scored;
+    if (hnsw_)
+    {
+        // the graph only holds the training documents, so there is nothing
+        // to filter
+        scored = hnsw_->search(weigh(instance), k_, ef_);
+    }
+    else
+    {
+        analyzers::feature_map<uint64_t> query{instance.size()};
+        for (const auto& count : instance)
+            query[inv_idx_->term_text(count.first)] += count.second;
+        assert(query.size() > 0);
 
-    auto scored = ranker_->score(
-        *inv_idx_, query.begin(), query.end(), k_, [&](doc_id d_id)
-        {
-            return legal_docs_.find(d_id) != legal_docs_.end();
-        });
+        scored = ranker_->score(
+            *inv_idx_, query.begin(), query.end(), k_, [&](doc_id d_id)
+            {
+                return legal_docs_.find(d_id) != legal_docs_.end();
+            });
+    }
 
     std::unordered_map<class_label, double> counts;
     for (auto& s : scored)
@@ -110,6 +209,22 @@ class_label knn::classify(const feature_vector& instance) const
     return select_best_label(scored, sorted);
 }
 
+index::hnsw_index::vector_type
+    knn::weigh(const feature_vector& instance) const
+{
+    index::hnsw_index::vector_type vec;
+    vec.reserve(instance.size());
+    for (const auto& weight : instance)
+    {
+        // terms that are not in the training set cannot match a neighbor
+        if (weight.first >= idf_.size() || idf_[weight.first] == 0)
+            continue;
+        vec.emplace_back(weight.first,
+                         std::log(1.0 + weight.second) * idf_[weight.first]);
+    }
+    return vec;
+}
+
 class_label knn::select_best_label(
     const std::vector<index::search_result>& scored,
     const std::vector<std::pair<class_label, uint16_t>>& sorted) const
@@ -152,12 +267,29 @@ std::unique_ptr<classifier> make_multi_index_classifier<knn>(
         throw classifier_factory::exception{
             "knn requires k to be specified in its configuration"};
 
+    auto use_weighted = config.get_as<bool>("weighted").value_or(false);
+
+    if (auto hnsw = config.get_table("hnsw"))
+    {
+        index::hnsw_options options;
+        options.m = static_cast<uint64_t>(
+            hnsw->get_as<int64_t>("m").value_or(options.m));
+        options.ef_construction = static_cast<uint64_t>(
+            hnsw->get_as<int64_t>("ef-construction")
+                .value_or(options.ef_construction));
+        options.num_threads = static_cast<uint64_t>(
+            hnsw->get_as<int64_t>("num-threads").value_or(options.num_threads));
+        auto ef = static_cast<uint64_t>(
+            hnsw->get_as<int64_t>("ef").value_or(knn::default_ef));
+        return make_unique<knn>(std::move(training), std::move(inv_idx), *k,
+                                options, ef, use_weighted);
+    }
+
     auto ranker = config.get_table("ranker");
     if (!ranker)
         throw classifier_factory::exception{
             "knn requires a ranker to be specified in its configuration"};
 
-    auto use_weighted = config.get_as<bool>("weighted").value_or(false);
     return make_unique<knn>(std::move(training), std::move(inv_idx), *k,
                             index::make_ranker(*ranker), use_weighted);
 }
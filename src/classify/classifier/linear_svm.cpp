@@ -0,0 +1,489 @@
+/**
+ * @file linear_svm.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+#include "cpptoml.h"
+#include "meta/classify/classifier/linear_svm.h"
+#include "meta/logging/logger.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/utf/utf.h"
+
+namespace meta
+{
+namespace classify
+{
+
+const util::string_view linear_svm::id = "linear-svm";
+
+namespace
+{
+/**
+ * The training instances in compressed sparse row form, shared by every
+ * model trained on them.
+ */
+struct problem
+{
+    template <class DatasetView>
+    problem(const DatasetView& docs, double bias_value)
+        : num_features{docs.total_features()}, bias{bias_value}
+    {
+        offsets.reserve(docs.size() + 1);
+        offsets.push_back(0);
+        sq_norms.reserve(docs.size());
+        for (const auto& instance : docs)
+        {
+            double sq_norm = bias * bias;
+            for (const auto& weight : instance.weights)
+            {
+                features.push_back(weight.first);
+                values.push_back(weight.second);
+                sq_norm += weight.second * weight.second;
+            }
+            offsets.push_back(features.size());
+            sq_norms.push_back(sq_norm);
+        }
+    }
+
+    uint64_t size() const
+    {
+        return sq_norms.size();
+    }
+
+    double dot(const std::vector<double>& w, uint64_t i) const
+    {
+        double result = w[num_features] * bias;
+        for (auto j = offsets[i]; j < offsets[i + 1]; ++j)
+            result += w[features[j]] * values[j];
+        return result;
+    }
+
+    void add(std::vector<double>& w, uint64_t i, double scale) const
+    {
+        w[num_features] += scale * bias;
+        for (auto j = offsets[i]; j < offsets[i + 1]; ++j)
+            w[features[j]] += scale * values[j];
+    }
+
+    uint64_t num_features;
+    double bias;
+    std::vector<uint64_t> offsets;
+    std::vector<term_id> features;
+    std::vector<double> values;
+    std::vector<double> sq_norms;
+};
+
+/**
+ * Permutes the first size entries of an index array, as each pass visits
+ * the active instances in a new random order.
+ */
+template <class RandomEngine>
+void shuffle_active(std::vector<uint64_t>& index, uint64_t size,
+                    RandomEngine& rng)
+{
+    for (uint64_t s = 0; s + 1 < size; ++s)
+    {
+        std::uniform_int_distribution<uint64_t> dist{s, size - 1};
+        std::swap(index[s], index[dist(rng)]);
+    }
+}
+
+/**
+ * Dual coordinate descent for the L1- and L2-loss SVMs, with shrinking.
+ */
+std::vector<double> solve_svm(const problem& prob, const std::vector<int8_t>& y,
+                              const linear_svm::options_type& options,
+                              uint64_t seed)
+{
+    auto l = prob.size();
+    std::vector<double> w(prob.num_features + 1, 0.0);
+    std::vector<double> alpha(l, 0.0);
+
+    // the L2 loss is an L1 loss with an unbounded dual and a diagonal
+    // term added to Q
+    double upper = std::numeric_limits<double>::infinity();
+    double diag = 0.5 / options.c;
+    if (options.loss == linear_svm::loss_type::L1_SVM)
+    {
+        upper = options.c;
+        diag = 0;
+    }
+
+    std::vector<double> qd(l);
+    for (uint64_t i = 0; i < l; ++i)
+        qd[i] = prob.sq_norms[i] + diag;
+
+    std::vector<uint64_t> index(l);
+    for (uint64_t i = 0; i < l; ++i)
+        index[i] = i;
+
+    std::mt19937_64 rng{seed};
+    auto active = l;
+    auto pg_max_old = std::numeric_limits<double>::infinity();
+    auto pg_min_old = -std::numeric_limits<double>::infinity();
+    uint64_t iter = 0;
+    for (; iter < options.max_iter; ++iter)
+    {
+        auto pg_max = -std::numeric_limits<double>::infinity();
+        auto pg_min = std::numeric_limits<double>::infinity();
+        shuffle_active(index, active, rng);
+
+        for (uint64_t s = 0; s < active; ++s)
+        {
+            auto i = index[s];
+            double g = y[i] * prob.dot(w, i) - 1 + diag * alpha[i];
+
+            // an instance at a bound whose gradient pushes it further out
+            // (by more than anything seen last pass) is shrunk
+            double pg = 0;
+            if (alpha[i] == 0)
+            {
+                if (g > pg_max_old)
+                {
+                    std::swap(index[s--], index[--active]);
+                    continue;
+                }
+                if (g < 0)
+                    pg = g;
+            }
+            else if (alpha[i] == upper)
+            {
+                if (g < pg_min_old)
+                {
+                    std::swap(index[s--], index[--active]);
+                    continue;
+                }
+                if (g > 0)
+                    pg = g;
+            }
+            else
+            {
+                pg = g;
+            }
+
+            pg_max = std::max(pg_max, pg);
+            pg_min = std::min(pg_min, pg);
+            if (qd[i] > 0 && std::abs(pg) > 1e-12)
+            {
+                auto old = alpha[i];
+                alpha[i]
+                    = std::min(std::max(alpha[i] - g / qd[i], 0.0), upper);
+                prob.add(w, i, (alpha[i] - old) * y[i]);
+            }
+        }
+
+        if (pg_max - pg_min <= options.epsilon)
+        {
+            // converged on the active set: check everything again before
+            // stopping
+            if (active == l)
+                break;
+            active = l;
+            pg_max_old = std::numeric_limits<double>::infinity();
+            pg_min_old = -std::numeric_limits<double>::infinity();
+            continue;
+        }
+
+        pg_max_old = pg_max <= 0 ? std::numeric_limits<double>::infinity()
+                                 : pg_max;
+        pg_min_old = pg_min >= 0 ? -std::numeric_limits<double>::infinity()
+                                 : pg_min;
+    }
+
+    if (iter == options.max_iter)
+        LOG(warning) << "linear-svm reached the maximum number of iterations"
+                     << ENDLG;
+    return w;
+}
+
+/**
+ * Dual coordinate descent for L2-regularized logistic regression. Each
+ * dual variable is paired with its complement (summing to C) and solved
+ * with a few Newton steps.
+ */
+std::vector<double> solve_logistic(const problem& prob,
+                                   const std::vector<int8_t>& y,
+                                   const linear_svm::options_type& options,
+                                   uint64_t seed)
+{
+    const uint64_t max_inner_iter = 100;
+    auto l = prob.size();
+    auto c = options.c;
+    std::vector<double> w(prob.num_features + 1, 0.0);
+
+    // starting strictly inside (0, C) keeps the logarithms finite
+    std::vector<double> alpha(2 * l);
+    for (uint64_t i = 0; i < l; ++i)
+    {
+        alpha[2 * i] = std::min(0.001 * c, 1e-8);
+        alpha[2 * i + 1] = c - alpha[2 * i];
+        prob.add(w, i, y[i] * alpha[2 * i]);
+    }
+
+    std::vector<uint64_t> index(l);
+    for (uint64_t i = 0; i < l; ++i)
+        index[i] = i;
+
+    std::mt19937_64 rng{seed};
+    double inner_eps = 1e-2;
+    double inner_eps_min = std::min(1e-8, options.epsilon);
+    uint64_t iter = 0;
+    for (; iter < options.max_iter; ++iter)
+    {
+        shuffle_active(index, l, rng);
+        uint64_t newton_iter = 0;
+        double g_max = 0;
+        for (uint64_t s = 0; s < l; ++s)
+        {
+            auto i = index[s];
+            auto a = prob.sq_norms[i];
+            auto b = y[i] * prob.dot(w, i);
+
+            // solve for whichever of the pair makes the subproblem
+            // better conditioned
+            auto first = 2 * i;
+            auto second = 2 * i + 1;
+            double sign = 1;
+            if (0.5 * a * (alpha[second] - alpha[first]) + b < 0)
+            {
+                std::swap(first, second);
+                sign = -1;
+            }
+
+            auto old = alpha[first];
+            auto z = old;
+            if (c - z < 0.5 * c)
+                z *= 0.1;
+            auto gp = a * (z - old) + sign * b + std::log(z / (c - z));
+            g_max = std::max(g_max, std::abs(gp));
+
+            uint64_t inner = 0;
+            for (; inner <= max_inner_iter && std::abs(gp) >= inner_eps;
+                 ++inner)
+            {
+                auto gpp = a + c / (c - z) / z;
+                auto next = z - gp / gpp;
+                z = next <= 0 ? z * 0.1 : next;
+                gp = a * (z - old) + sign * b + std::log(z / (c - z));
+            }
+            newton_iter += inner;
+
+            if (inner > 0)
+            {
+                alpha[first] = z;
+                alpha[second] = c - z;
+                prob.add(w, i, sign * (z - old) * y[i]);
+            }
+        }
+
+        if (g_max < options.epsilon)
+            break;
+        if (newton_iter <= l / 10)
+            inner_eps = std::max(inner_eps_min, 0.1 * inner_eps);
+    }
+
+    if (iter == options.max_iter)
+        LOG(warning) << "linear-svm reached the maximum number of iterations"
+                     << ENDLG;
+    return w;
+}
+
+std::vector<double> solve(const problem& prob, const std::vector<int8_t>& y,
+                          const linear_svm::options_type& options,
+                          uint64_t seed)
+{
+    if (options.c <= 0)
+        throw classifier_exception{"linear-svm c must be positive"};
+    if (options.epsilon <= 0)
+        throw classifier_exception{"linear-svm epsilon must be positive"};
+
+    if (options.loss == linear_svm::loss_type::LOGISTIC)
+        return solve_logistic(prob, y, options, seed);
+    return solve_svm(prob, y, options, seed);
+}
+}
+
+linear_svm::linear_svm(multiclass_dataset_view docs, options_type options)
+    : bias_{options.bias ? 1.0 : 0.0}
+{
+    if (docs.total_labels() == 0)
+        throw classifier_exception{"linear-svm needs at least one class"};
+
+    std::unordered_map<class_label, uint64_t> ids;
+    labels_.resize(docs.total_labels());
+    for (auto it = docs.labels_begin(), end = docs.labels_end(); it != end;
+         ++it)
+    {
+        labels_.at(it->second) = it->first;
+        ids[it->first] = it->second;
+    }
+
+    problem prob{docs, bias_};
+    std::vector<uint64_t> label_ids;
+    label_ids.reserve(docs.size());
+    for (const auto& instance : docs)
+        label_ids.push_back(ids.at(docs.label(instance)));
+
+    // two classes only need one model
+    auto num_models = labels_.size() == 2 ? 1 : labels_.size();
+    weights_.resize(num_models);
+
+    parallel::thread_pool pool{std::max<uint64_t>(options.num_threads, 1)};
+    auto train_model = [&](uint64_t model)
+    {
+        std::vector<int8_t> y(label_ids.size());
+        for (uint64_t i = 0; i < y.size(); ++i)
+            y[i] = label_ids[i] == model ? +1 : -1;
+        weights_[model] = solve(prob, y, options, model);
+    };
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(num_models);
+    for (uint64_t model = 0; model < num_models; ++model)
+    {
+        futures.emplace_back(pool.submit_task([&, model]()
+                                              {
+                                                  train_model(model);
+                                              }));
+    }
+    for (auto& fut : futures)
+        fut.get();
+}
+
+linear_svm::linear_svm(std::istream& in)
+{
+    io::packed::read(in, bias_);
+    auto num_labels = io::packed::read<uint64_t>(in);
+    labels_.resize(num_labels);
+    for (auto& lbl : labels_)
+        io::packed::read(in, lbl);
+
+    // the weights are stored sparsely, since most features are never
+    // updated in a one-vs-rest model of a rare class
+    auto num_models = io::packed::read<uint64_t>(in);
+    weights_.resize(num_models);
+    for (auto& weights : weights_)
+    {
+        weights.resize(io::packed::read<uint64_t>(in));
+        auto nnz = io::packed::read<uint64_t>(in);
+        for (uint64_t i = 0; i < nnz; ++i)
+        {
+            auto feature = io::packed::read<uint64_t>(in);
+            io::packed::read(in, weights.at(feature));
+        }
+    }
+}
+
+void linear_svm::save(std::ostream& out) const
+{
+    io::packed::write(out, id);
+
+    io::packed::write(out, bias_);
+    io::packed::write(out, labels_.size());
+    for (const auto& lbl : labels_)
+        io::packed::write(out, lbl);
+
+    io::packed::write(out, weights_.size());
+    for (const auto& weights : weights_)
+    {
+        io::packed::write(out, weights.size());
+        auto nnz = static_cast<uint64_t>(
+            std::count_if(weights.begin(), weights.end(), [](double weight)
+                          {
+                              return weight != 0;
+                          }));
+        io::packed::write(out, nnz);
+        for (uint64_t feature = 0; feature < weights.size(); ++feature)
+        {
+            if (weights[feature] == 0)
+                continue;
+            io::packed::write(out, feature);
+            io::packed::write(out, weights[feature]);
+        }
+    }
+}
+
+double linear_svm::score(uint64_t model, const feature_vector& doc) const
+{
+    const auto& weights = weights_[model];
+    auto num_features = weights.size() - 1;
+    double result = weights[num_features] * bias_;
+    for (const auto& count : doc)
+    {
+        // features unseen in training have no weight
+        if (count.first < num_features)
+            result += weights[count.first] * count.second;
+    }
+    return result;
+}
+
+class_label linear_svm::classify(const feature_vector& doc) const
+{
+    // a single class also has a single model, but no second label
+    if (labels_.size() == 2)
+        return score(0, doc) > 0 ? labels_[0] : labels_[1];
+
+    uint64_t best = 0;
+    auto best_score = std::numeric_limits<double>::lowest();
+    for (uint64_t model = 0; model < weights_.size(); ++model)
+    {
+        auto model_score = score(model, doc);
+        if (model_score > best_score)
+        {
+            best_score = model_score;
+            best = model;
+        }
+    }
+    return labels_[best];
+}
+
+std::vector<double> train_linear_svm(binary_dataset_view docs,
+                                     const linear_svm::options_type& options)
+{
+    problem prob{docs, options.bias ? 1.0 : 0.0};
+    std::vector<int8_t> y;
+    y.reserve(docs.size());
+    for (const auto& instance : docs)
+        y.push_back(docs.label(instance) ? +1 : -1);
+    return solve(prob, y, options, 0);
+}
+
+template <>
+std::unique_ptr<classifier>
+    make_classifier<linear_svm>(const cpptoml::table& config,
+                                multiclass_dataset_view training)
+{
+    linear_svm::options_type options;
+    if (auto loss = config.get_as<std::string>("loss"))
+    {
+        auto name = utf::tolower(*loss);
+        if (name == "l2-svm")
+            options.loss = linear_svm::loss_type::L2_SVM;
+        else if (name == "l1-svm")
+            options.loss = linear_svm::loss_type::L1_SVM;
+        else if (name == "logistic")
+            options.loss = linear_svm::loss_type::LOGISTIC;
+        else
+            throw classifier_factory::exception{
+                "unknown loss for linear-svm: " + *loss};
+    }
+
+    options.c = config.get_as<double>("c").value_or(options.c);
+    options.epsilon = config.get_as<double>("epsilon").value_or(options.epsilon);
+    options.max_iter = static_cast<uint64_t>(
+        config.get_as<int64_t>("max-iter").value_or(options.max_iter));
+    options.bias = config.get_as<bool>("bias").value_or(options.bias);
+    options.num_threads = static_cast<uint64_t>(
+        config.get_as<int64_t>("num-threads").value_or(options.num_threads));
+
+    return make_unique<linear_svm>(std::move(training), options);
+}
+}
+}
@@ -18,7 +18,9 @@ const util::string_view logistic_regression::id = "logistic-regression";
 
 logistic_regression::logistic_regression(multiclass_dataset_view docs,
                                          learn::sgd_model::options_type options,
-                                         double gamma, uint64_t max_iter)
+                                         double gamma, uint64_t max_iter,
+                                         learn::sgd_model::training_options_type
+                                             training)
 {
     using size_type = multiclass_dataset_view::size_type;
     using indices_type = std::vector<size_type>;
@@ -33,9 +35,14 @@ logistic_regression::logistic_regression(multiclass_dataset_view docs,
     for (auto it = docs.begin(), end = docs.end(); it != end; ++it)
         docs_by_class[docs.label(*it)].push_back(it.index());
 
+    // the regressions are trained one at a time when each trains on
+    // several threads itself, rather than oversubscribing the machine
+    parallel::thread_pool pool{training.num_threads > 1
+                                   ? 1
+                                   : std::thread::hardware_concurrency()};
     using T = decltype(*classifiers_.begin());
     parallel::parallel_for(
-        classifiers_.begin(), classifiers_.end(), [&](T& pair)
+        classifiers_.begin(), classifiers_.end(), pool, [&](T& pair)
         {
             auto train_docs = docs_by_class[pair.first];
             auto pivot_docs = docs_by_class[pivot_];
@@ -50,7 +57,7 @@ logistic_regression::logistic_regression(multiclass_dataset_view docs,
 
             pair.second = make_unique<sgd>(
                 bdv, learn::loss::make_loss_function<learn::loss::logistic>(),
-                options, gamma, max_iter);
+                options, gamma, max_iter, false, training);
         });
 }
 
@@ -114,23 +121,15 @@ std::unique_ptr<classifier>
     make_classifier<logistic_regression>(const cpptoml::table& config,
                                          multiclass_dataset_view training)
 {
-    learn::sgd_model::options_type options;
-
-    if (auto alpha = config.get_as<double>("learning-rate"))
-        options.learning_rate = *alpha;
-
-    if (auto l2_lambda = config.get_as<double>("l2-regularization"))
-        options.l2_regularizer = *l2_lambda;
-
-    if (auto l1_lambda = config.get_as<double>("l1-regularization"))
-        options.l1_regularizer = *l1_lambda;
+    auto training_options = learn::make_training_options(config);
+    auto options = learn::make_model_options(config, training_options);
 
     auto gamma = config.get_as<double>("gamma").value_or(sgd::default_gamma);
     auto max_iter
         = config.get_as<int64_t>("max-iter").value_or(sgd::default_max_iter);
 
     return make_unique<logistic_regression>(std::move(training), options, gamma,
-                                            max_iter);
+                                            max_iter, training_options);
 }
 }
 }
@@ -3,10 +3,15 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <map>
+#include <mutex>
 #include "cpptoml.h"
 #include "meta/classify/classifier/naive_bayes.h"
 #include "meta/io/packed.h"
+#include "meta/parallel/parallel_for.h"
 
 namespace meta
 {
@@ -17,7 +22,8 @@ const util::string_view naive_bayes::id = "naive-bayes";
 const constexpr double naive_bayes::default_alpha;
 const constexpr double naive_bayes::default_beta;
 
-naive_bayes::naive_bayes(dataset_view_type docs, double alpha, double beta)
+naive_bayes::naive_bayes(dataset_view_type docs, double alpha, double beta,
+                         uint64_t num_threads)
     : class_probs_{stats::dirichlet<class_label>{beta, docs.total_labels()}}
 {
     stats::dirichlet<term_id> term_prior{alpha, docs.total_features()};
@@ -34,7 +40,8 @@ naive_bayes::naive_bayes(dataset_view_type docs, double alpha, double beta)
     for (const auto& lbl : labels)
         term_probs_.emplace_back(lbl, term_prior);
 
-    train(docs);
+    train(docs, num_threads);
+    finalize();
 }
 
 naive_bayes::naive_bayes(std::istream& in)
@@ -54,6 +61,7 @@ naive_bayes::naive_bayes(std::istream& in)
         term_probs_[label].load(in);
     }
     class_probs_.load(in);
+    finalize();
 }
 
 void naive_bayes::save(std::ostream& os) const
@@ -71,43 +79,135 @@ void naive_bayes::save(std::ostream& os) const
     class_probs_.save(os);
 }
 
-void naive_bayes::train(const dataset_view_type& docs)
+void naive_bayes::train(const dataset_view_type& docs, uint64_t num_threads)
 {
-    for (const auto& instance : docs)
+    using diff_type = decltype(docs.begin())::difference_type;
+
+    std::unordered_map<class_label, uint64_t> columns;
+    for (const auto& cls : term_probs_)
+        columns.emplace(cls.first, columns.size());
+
+    /// The counts from one block of documents
+    struct block_counts
     {
-        for (const auto& p : instance.weights)
+        std::vector<std::unordered_map<term_id, double>> terms;
+        std::vector<double> docs;
+    };
+
+    // each block's counts are kept by where the block starts, so they are
+    // summed in the same order however the blocks finish
+    std::map<uint64_t, block_counts> blocks;
+    std::mutex mutex;
+    parallel::thread_pool pool{std::max<uint64_t>(num_threads, 1)};
+    parallel::parallel_blocks(
+        docs.size(), pool, [&](uint64_t begin, uint64_t end)
         {
-            term_probs_[docs.label(instance)].increment(p.first, p.second);
-            assert(term_probs_[docs.label(instance)].probability(p.first) > 0);
+            block_counts counts;
+            counts.terms.resize(columns.size());
+            counts.docs.resize(columns.size());
+            auto first = docs.begin() + static_cast<diff_type>(begin);
+            auto last = docs.begin() + static_cast<diff_type>(end);
+            for (; first != last; ++first)
+            {
+                auto col = columns.at(docs.label(*first));
+                for (const auto& p : first->weights)
+                    counts.terms[col][p.first] += p.second;
+                counts.docs[col] += 1;
+            }
+
+            std::lock_guard<std::mutex> lock{mutex};
+            blocks[begin] = std::move(counts);
+        });
+
+    for (auto& cls : term_probs_)
+    {
+        auto col = columns.at(cls.first);
+        std::unordered_map<term_id, double> merged;
+        double num_docs = 0;
+        for (const auto& block : blocks)
+        {
+            for (const auto& count : block.second.terms[col])
+                merged[count.first] += count.second;
+            num_docs += block.second.docs[col];
         }
-        class_probs_.increment(docs.label(instance), 1);
+
+        // the multinomial stores its counts sorted, so adding them in
+        // order only ever appends
+        std::vector<std::pair<term_id, double>> sorted{merged.begin(),
+                                                       merged.end()};
+        std::sort(sorted.begin(), sorted.end());
+        for (const auto& count : sorted)
+            cls.second.increment(count.first, count.second);
+        if (num_docs > 0)
+            class_probs_.increment(cls.first, num_docs);
     }
 }
 
-class_label naive_bayes::classify(const feature_vector& instance) const
+void naive_bayes::finalize()
 {
-    class_label label;
-    double best = std::numeric_limits<double>::lowest();
+    labels_.clear();
+    uint64_t num_terms = 0;
+    for (const auto& cls : term_probs_)
+    {
+        labels_.push_back(cls.first);
+        cls.second.each_seen_event([&](const term_id& t_id)
+                                   {
+                                       num_terms = std::max<uint64_t>(
+                                           num_terms, t_id + 1);
+                                   });
+    }
+
+    log_probs_ = {num_terms, labels_.size()};
+    unseen_log_probs_.assign(log_probs_.stride(), 0.0);
+    log_priors_.assign(log_probs_.stride(), 0.0);
 
-    // calculate prob of test doc for each class
+    uint64_t col = 0;
     for (const auto& cls : term_probs_)
     {
-        const auto& lbl = cls.first;
         const auto& term_dist = cls.second;
 
-        double sum = 0.0;
-        assert(class_probs_.probability(lbl) > 0);
-        sum += std::log(class_probs_.probability(lbl));
-        for (const auto& t : instance)
-        {
-            assert(term_dist.probability(t.first) > 0);
-            sum += t.second * std::log(term_dist.probability(t.first));
-        }
+        // the smoothing gives every term the class has not seen the same
+        // probability, which is the probability of any id past the table
+        unseen_log_probs_[col]
+            = std::log(term_dist.probability(term_id{num_terms}));
+        for (uint64_t t_id = 0; t_id < num_terms; ++t_id)
+            log_probs_(t_id, col) = static_cast<float>(unseen_log_probs_[col]);
+        term_dist.each_seen_event([&](const term_id& t_id)
+                                  {
+                                      log_probs_(t_id, col)
+                                          = static_cast<float>(std::log(
+                                              term_dist.probability(t_id)));
+                                  });
+
+        assert(class_probs_.probability(cls.first) > 0);
+        log_priors_[col] = std::log(class_probs_.probability(cls.first));
+        ++col;
+    }
+}
 
-        if (sum > best)
+class_label naive_bayes::classify(const feature_vector& instance) const
+{
+    // every class' score is accumulated in one pass over the document;
+    // terms past the table all share each class' unseen probability
+    std::vector<double> scores(log_priors_);
+    double unseen = 0;
+    for (const auto& t : instance)
+    {
+        if (t.first >= log_probs_.rows())
+            unseen += t.second;
+        else
+            log_probs_.add_row(t.first, t.second, scores.data());
+    }
+
+    class_label label;
+    double best = std::numeric_limits<double>::lowest();
+    for (uint64_t col = 0; col < labels_.size(); ++col)
+    {
+        auto score = scores[col] + unseen * unseen_log_probs_[col];
+        if (score > best)
         {
-            best = sum;
-            label = cls.first;
+            best = score;
+            label = labels_[col];
         }
     }
 
@@ -125,7 +225,12 @@ std::unique_ptr<classifier>
     auto beta
         = config.get_as<double>("beta").value_or(naive_bayes::default_beta);
 
-    return make_unique<naive_bayes>(std::move(training), alpha, beta);
+    auto num_threads = static_cast<uint64_t>(
+        config.get_as<int64_t>("num-threads")
+            .value_or(std::thread::hardware_concurrency()));
+
+    return make_unique<naive_bayes>(std::move(training), alpha, beta,
+                                    num_threads);
 }
 }
 }
@@ -3,9 +3,13 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "meta/classify/binary_classifier_factory.h"
 #include "meta/classify/classifier/one_vs_all.h"
 #include "meta/classify/classifier/online_binary_classifier.h"
+#include "meta/classify/classifier/sgd.h"
 #include "meta/parallel/parallel_for.h"
 
 namespace meta
@@ -15,15 +19,34 @@ namespace classify
 
 const util::string_view one_vs_all::id = "one-vs-all";
 
-one_vs_all::one_vs_all(multiclass_dataset_view docs, const cpptoml::table& base)
+namespace
+{
+/**
+ * @param inner_threads The most threads any binary classifier trains on
+ * @return the number of binary classifiers to train at once: one at a
+ * time when each trains on several threads itself, so that the machine is
+ * not oversubscribed
+ */
+std::size_t outer_threads(std::size_t inner_threads)
+{
+    return inner_threads > 1 ? 1 : std::thread::hardware_concurrency();
+}
+}
+
+one_vs_all::one_vs_all(multiclass_dataset_view docs, const cpptoml::table& base,
+                       uint64_t max_packed_bytes)
+    : max_packed_bytes_{max_packed_bytes}
 {
     classifiers_.reserve(docs.total_labels());
     for (auto it = docs.labels_begin(), end = docs.labels_end(); it != end;
          ++it)
         classifiers_[it->first] = nullptr;
 
+    auto inner_threads = base.get_as<int64_t>("num-threads").value_or(1);
+    parallel::thread_pool pool{
+        outer_threads(static_cast<std::size_t>(inner_threads))};
     parallel::parallel_for(
-        classifiers_.begin(), classifiers_.end(),
+        classifiers_.begin(), classifiers_.end(), pool,
         [&](std::pair<const class_label, std::unique_ptr<binary_classifier>>&
                 pr)
         {
@@ -33,6 +56,7 @@ one_vs_all::one_vs_all(multiclass_dataset_view docs, const cpptoml::table& base)
                                     }};
             pr.second = make_binary_classifier(base, bdv);
         });
+    compile(max_packed_bytes_);
 }
 
 one_vs_all::one_vs_all(std::istream& in)
@@ -60,8 +84,17 @@ void one_vs_all::save(std::ostream& out) const
 
 void one_vs_all::train(dataset_view_type docs)
 {
+    std::size_t inner_threads = 1;
+    for (const auto& pr : classifiers_)
+    {
+        if (auto cls = dynamic_cast<const sgd*>(pr.second.get()))
+            inner_threads
+                = std::max(inner_threads, cls->training().num_threads);
+    }
+
+    parallel::thread_pool pool{outer_threads(inner_threads)};
     parallel::parallel_for(
-        classifiers_.begin(), classifiers_.end(),
+        classifiers_.begin(), classifiers_.end(), pool,
         [&](std::pair<const class_label, std::unique_ptr<binary_classifier>>&
                 pr)
         {
@@ -82,10 +115,12 @@ void one_vs_all::train(dataset_view_type docs)
                                            "online_binary_classifier"};
             }
         });
+    compile(max_packed_bytes_);
 }
 
 void one_vs_all::train_one(const feature_vector& doc, const class_label& label)
 {
+    decompile();
     for (const auto& pr : classifiers_)
     {
         if (auto cls = dynamic_cast<online_binary_classifier*>(pr.second.get()))
@@ -100,8 +135,91 @@ void one_vs_all::train_one(const feature_vector& doc, const class_label& label)
     }
 }
 
+void one_vs_all::compile()
+{
+    compile(std::numeric_limits<uint64_t>::max());
+}
+
+void one_vs_all::compile(uint64_t max_bytes)
+{
+    decompile();
+    std::vector<const learn::sgd_model*> models;
+    for (const auto& pr : classifiers_)
+    {
+        auto cls = dynamic_cast<const sgd*>(pr.second.get());
+        if (!cls)
+            return;
+        models.push_back(&cls->model());
+    }
+
+    std::size_t num_features = 0;
+    for (const auto& model : models)
+        num_features = std::max(num_features, model->num_features());
+    if (util::padded_matrix<double>::bytes(num_features, models.size())
+        > max_bytes)
+        return;
+
+    weights_ = {num_features, models.size()};
+    biases_.assign(weights_.stride(), 0.0);
+    scales_.assign(weights_.stride(), 0.0);
+    for (uint64_t col = 0; col < models.size(); ++col)
+    {
+        const auto& model = *models[col];
+        for (std::size_t f = 0; f < model.num_features(); ++f)
+            weights_(f, col) = model.weight(f);
+        biases_[col] = model.bias();
+        scales_[col] = model.scale();
+    }
+
+    for (const auto& pr : classifiers_)
+        labels_.push_back(pr.first);
+}
+
+void one_vs_all::decompile()
+{
+    if (!compiled())
+        return;
+
+    labels_.clear();
+    weights_ = {};
+    biases_.clear();
+    scales_.clear();
+}
+
+bool one_vs_all::compiled() const
+{
+    return !labels_.empty();
+}
+
 class_label one_vs_all::classify(const feature_vector& doc) const
 {
+    if (compiled())
+    {
+        // accumulate every class' dot product in one pass over the
+        // document, then finish each score as sgd_model::predict() does
+        std::vector<double> scores(weights_.stride(), 0.0);
+        for (const auto& pr : doc)
+        {
+            if (pr.first >= weights_.rows())
+                throw std::out_of_range{
+                    "feature id out of range for one_vs_all"};
+            weights_.add_row(pr.first, pr.second, scores.data());
+        }
+
+        class_label best_label;
+        double best_prediction = std::numeric_limits<double>::lowest();
+        for (uint64_t col = 0; col < labels_.size(); ++col)
+        {
+            auto prediction = scales_[col] * (biases_[col] + scores[col]);
+            if (prediction > best_prediction)
+            {
+                best_prediction = prediction;
+                best_label = labels_[col];
+            }
+        }
+        return best_label;
+    }
+
     class_label best_label;
     double best_prediction = std::numeric_limits<double>::lowest();
     for (auto& pair : classifiers_)
@@ -125,7 +243,13 @@ std::unique_ptr<classifier>
     if (!base)
         throw classifier_factory::exception{
             "one-vs-all missing base-classifier parameter in config file"};
-    return make_unique<one_vs_all>(std::move(training), *base);
+
+    auto packed_mb = config.get_as<int64_t>("packed-weights-mb").value_or(0);
+    if (packed_mb < 0)
+        throw classifier_factory::exception{
+            "one-vs-all packed-weights-mb must be non-negative"};
+    return make_unique<one_vs_all>(std::move(training), *base,
+                                   static_cast<uint64_t>(packed_mb) << 20);
 }
 }
 }
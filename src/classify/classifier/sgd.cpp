@@ -22,18 +22,21 @@ const constexpr size_t sgd::default_max_iter;
 sgd::sgd(binary_dataset_view docs,
          std::unique_ptr<learn::loss::loss_function> loss,
          learn::sgd_model::options_type options, double gamma, size_t max_iter,
-         bool calibrate)
+         bool calibrate, learn::sgd_model::training_options_type training)
     : model_{docs.total_features(), options},
       gamma_{gamma},
       max_iter_{max_iter},
+      training_{training},
       loss_{std::move(loss)}
 {
     if (calibrate)
     {
-        model_.calibrate(docs, *loss_, [&](const learn::instance& inst)
+        model_.calibrate(docs, *loss_,
+                         [&](const learn::instance& inst)
                          {
                              return docs.label(inst) ? +1 : -1;
-                         });
+                         },
+                         training_);
     }
     train(std::move(docs));
 }
@@ -61,6 +64,17 @@ void sgd::save(std::ostream& out) const
 
 void sgd::train(binary_dataset_view docs)
 {
+    if (training_.num_threads > 1 || training_.batch_size > 0)
+    {
+        model_.train_batches(docs,
+                             [&](const learn::instance& inst)
+                             {
+                                 return docs.label(inst) ? +1 : -1;
+                             },
+                             *loss_, training_, gamma_, max_iter_);
+        return;
+    }
+
     size_t t = 0;
     double avg_loss = 0;
     double prev_avg_loss = 0;
@@ -101,6 +115,16 @@ double sgd::predict(const feature_vector& doc) const
     return model_.predict(doc);
 }
 
+const learn::sgd_model& sgd::model() const
+{
+    return model_;
+}
+
+const learn::sgd_model::training_options_type& sgd::training() const
+{
+    return training_;
+}
+
 template <>
 std::unique_ptr<binary_classifier>
 make_binary_classifier<sgd>(const cpptoml::table& config,
@@ -111,16 +135,8 @@ make_binary_classifier<sgd>(const cpptoml::table& config,
         throw binary_classifier_factory::exception{
             "loss function must be specified for sgd in config"};
 
-    learn::sgd_model::options_type options;
-
-    if (auto alpha = config.get_as<double>("learning-rate"))
-        options.learning_rate = *alpha;
-
-    if (auto l2_lambda = config.get_as<double>("l2-regularization"))
-        options.l2_regularizer = *l2_lambda;
-
-    if (auto l1_lambda = config.get_as<double>("l1-regularization"))
-        options.l1_regularizer = *l1_lambda;
+    auto training_options = learn::make_training_options(config);
+    auto options = learn::make_model_options(config, training_options);
 
     auto gamma = config.get_as<double>("convergence-threshold")
                      .value_or(sgd::default_gamma);
@@ -131,7 +147,7 @@ make_binary_classifier<sgd>(const cpptoml::table& config,
 
     return make_unique<sgd>(std::move(training),
                             learn::loss::make_loss_function(*loss), options,
-                            gamma, max_iter, calibrate);
+                            gamma, max_iter, calibrate, training_options);
 }
 }
 }
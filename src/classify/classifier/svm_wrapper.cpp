@@ -190,6 +190,55 @@ confusion_matrix svm_wrapper::test(multiclass_dataset_view docs) const
     return matrix;
 }
 
+confusion_matrix svm_wrapper::classify_batch(dataset_view_type docs,
+                                             parallel::thread_pool&) const
+{
+    return test(std::move(docs));
+}
+
+std::vector<class_label>
+    svm_wrapper::classify_batch(const std::vector<feature_vector>& instances,
+                                parallel::thread_pool&) const
+{
+    // create input for liblinear/libsvm
+    {
+        std::ofstream out{"svm-input"};
+        for (const auto& instance : instances)
+        {
+            out << "1 "; // dummy label
+            learn::print_liblinear(out, instance);
+            out << "\n";
+        }
+    }
+
+// run liblinear/libsvm
+#ifndef _WIN32
+    std::string command = svm_path_ + executable_
+                          + "predict svm-input svm-train.model svm-predicted";
+    command += " > /dev/null 2>&1";
+#else
+    // see comment in classify()
+    auto command = "\"\"" + svm_path_ + executable_
+                   + "predict.exe\" svm-input svm-train.model svm-predicted";
+    command += " > NUL 2>&1\"";
+#endif
+    system(command.c_str());
+
+    // extract answers
+    std::vector<class_label> labels;
+    labels.reserve(instances.size());
+    std::ifstream in{"svm-predicted"};
+    std::string str_val;
+    for (std::size_t i = 0; i < instances.size(); ++i)
+    {
+        std::getline(in, str_val);
+        auto value = std::stoul(str_val);
+        assert(value > 0);
+        labels.push_back(labels_.at(value - 1));
+    }
+    return labels;
+}
+
 template <>
 std::unique_ptr<classifier>
     make_classifier<svm_wrapper>(const cpptoml::table& config,
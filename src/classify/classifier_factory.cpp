@@ -36,6 +36,7 @@ classifier_factory::classifier_factory()
     reg<one_vs_one>();
     reg<naive_bayes>();
     reg<svm_wrapper>();
+    reg<linear_svm>();
     reg<winnow>();
     reg<dual_perceptron>();
     reg<logistic_regression>();
@@ -70,6 +71,7 @@ classifier_loader::classifier_loader()
     reg<one_vs_one>();
     reg<naive_bayes>();
     reg<svm_wrapper>();
+    reg<linear_svm>();
     reg<winnow>();
     reg<dual_perceptron>();
     reg<logistic_regression>();
@@ -7,10 +7,14 @@
 #include <string>
 #include <vector>
 
+#include "meta/analyzers/analyzer.h"
 #include "meta/caching/all.h"
 #include "meta/classify/classifier/all.h"
+#include "meta/corpus/document.h"
 #include "meta/index/forward_index.h"
 #include "meta/index/ranker/all.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/parallel/thread_pool.h"
 #include "meta/parser/analyzers/tree_analyzer.h"
 #include "meta/sequence/analyzers/ngram_pos_analyzer.h"
 #include "meta/util/printing.h"
@@ -24,14 +28,15 @@ using namespace meta;
 
 template <class Creator>
 classify::confusion_matrix cv(Creator&& creator,
-                              classify::multiclass_dataset_view docs, bool even)
+                              classify::multiclass_dataset_view docs, bool even,
+                              uint64_t parallel_folds = 1)
 {
     classify::confusion_matrix matrix;
     auto msec = common::time(
         [&]()
         {
             matrix = classify::cross_validate(std::forward<Creator>(creator),
-                                              docs, 5, even);
+                                              docs, 5, even, parallel_folds);
         });
     std::cerr << "time elapsed: " << msec.count() / 1000.0 << "s" << std::endl;
     matrix.print();
@@ -63,11 +68,55 @@ void compare_cv(Index& idx, Classifier& c, Alternatives&... alts)
     compare_cv(matrix, idx, alts...);
 }
 
+/**
+ * Reads documents from standard input, one per line, and writes the label
+ * predicted for each to standard output in the same order. The lines are
+ * read in chunks; each chunk is analyzed in parallel, each thread with its
+ * own clone of the index's analyzer, and then classified in parallel.
+ */
+void predict(const classify::classifier& cls, index::forward_index& idx)
+{
+    const uint64_t chunk_size = 4096;
+    parallel::thread_pool pool;
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::cin)
+    {
+        lines.clear();
+        while (lines.size() < chunk_size && std::getline(std::cin, line))
+            lines.push_back(line);
+        if (lines.empty())
+            break;
+
+        std::vector<classify::classifier::feature_vector> docs(lines.size());
+        parallel::parallel_blocks(
+            lines.size(), pool, [&](uint64_t begin, uint64_t end)
+            {
+                auto ana = idx.analyzer().clone();
+                for (auto i = begin; i < end; ++i)
+                {
+                    corpus::document doc;
+                    doc.content(lines[i]);
+                    docs[i] = idx.tokenize(doc, *ana);
+                }
+            });
+
+        for (const auto& label : cls.classify_batch(docs, pool))
+            cout << label << "\n";
+    }
+    cout << std::flush;
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc != 2 && (argc != 3 || std::string{argv[2]} != "--predict"))
     {
-        cerr << "Usage:\t" << argv[0] << " config.toml" << endl;
+        cerr << "Usage:\t" << argv[0] << " config.toml [--predict]" << endl;
+        cerr << "Cross-validates the classifier, or, with --predict, trains "
+                "it on the whole index and classifies documents read from "
+                "standard input, one per line"
+             << endl;
         return 1;
     }
 
@@ -111,7 +160,27 @@ int main(int argc, char* argv[])
         };
     }
 
-    cv(creator, dataset, even);
+    if (argc == 3)
+    {
+        auto cls = creator(dataset);
+        predict(*cls, *f_idx);
+        return 0;
+    }
+
+    uint64_t parallel_folds;
+    try
+    {
+        parallel_folds = classify::max_parallel_folds(
+            *class_config,
+            class_config->get_as<int64_t>("parallel-folds").value_or(1));
+    }
+    catch (const classify::classifier_exception& ex)
+    {
+        cerr << "Invalid parallel-folds in " << argv[1] << ": " << ex.what()
+             << endl;
+        return 1;
+    }
+    cv(creator, dataset, even, parallel_folds);
 
     return 0;
 }
@@ -3,6 +3,8 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
+
 #include "meta/corpus/metadata.h"
 
 namespace meta
@@ -50,10 +52,19 @@ metadata::schema_type metadata_schema(const cpptoml::table& config)
                 throw metadata_exception{"invalid metadata type: \"" + *type
                                          + "\""};
             }
-            schema.emplace_back(*name, ftype);
+            auto column = table->get_as<bool>("column").value_or(false);
+            schema.emplace_back(*name, ftype, column);
         }
     }
     return schema;
 }
+bool has_field(const metadata::schema_type& schema, const std::string& name)
+{
+    return std::any_of(schema.begin(), schema.end(),
+                       [&](const metadata::field_info& info)
+                       {
+                           return info.name == name;
+                       });
+}
 }
 }
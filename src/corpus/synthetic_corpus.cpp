@@ -0,0 +1,520 @@
+/**
+ * @file synthetic_corpus.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "meta/corpus/synthetic_corpus.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/gzstream.h"
+#include "meta/logging/logger.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/progress.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace corpus
+{
+
+namespace
+{
+/// The number of documents handed to a single task
+const uint64_t chunk_size = 64;
+
+/// The number of most frequent words that queries avoid
+const uint64_t stopwords = 100;
+
+/**
+ * A document rendered in the output format, along with the relevance
+ * judgements it received.
+ */
+struct rendered_document
+{
+    std::string content;
+    std::string label;
+    std::string metadata;
+    std::vector<std::pair<uint64_t, int>> judgements;
+};
+
+std::string format_name(synthetic_corpus::format fmt)
+{
+    switch (fmt)
+    {
+        case synthetic_corpus::format::LINE:
+            return "line";
+        case synthetic_corpus::format::FILE:
+            return "file";
+        case synthetic_corpus::format::GZ:
+            return "gz";
+        case synthetic_corpus::format::LIBSVM:
+            return "libsvm";
+    }
+    return "line";
+}
+
+/**
+ * @return the path of a document's file (relative to the dataset folder)
+ * for file corpora; documents are spread across subfolders so that no
+ * single folder grows too large
+ */
+std::string file_path(uint64_t id)
+{
+    return "docs/" + std::to_string(id / 1000) + "/" + std::to_string(id)
+           + ".txt";
+}
+
+template <class T>
+T get_option(const cpptoml::table& config, const std::string& key,
+             T default_value)
+{
+    return config.get_as<T>(key).value_or(default_value);
+}
+
+uint64_t get_count(const cpptoml::table& config, const std::string& key,
+                   uint64_t default_value)
+{
+    auto value = config.get_as<int64_t>(key).value_or(
+        static_cast<int64_t>(default_value));
+    if (value < 0)
+        throw corpus_exception{key + " must be non-negative"};
+    return static_cast<uint64_t>(value);
+}
+}
+
+auto synthetic_corpus::parse_options(const cpptoml::table& config) -> options
+{
+    options opts;
+
+    auto fmt = get_option<std::string>(config, "format", "line");
+    if (fmt == "line")
+        opts.fmt = format::LINE;
+    else if (fmt == "file")
+        opts.fmt = format::FILE;
+    else if (fmt == "gz")
+        opts.fmt = format::GZ;
+    else if (fmt == "libsvm")
+        opts.fmt = format::LIBSVM;
+    else
+        throw corpus_exception{"unrecognized synthetic corpus format: "
+                               + fmt};
+
+    opts.num_docs = get_count(config, "num-docs", opts.num_docs);
+    opts.seed = get_count(config, "seed", opts.seed);
+    opts.threads = get_count(config, "threads", opts.threads);
+    opts.vocab_size = get_count(config, "vocab-size", opts.vocab_size);
+    opts.zipf_exponent
+        = get_option(config, "zipf-exponent", opts.zipf_exponent);
+    opts.length_mean = get_option(config, "length-mean", opts.length_mean);
+    opts.length_sigma = get_option(config, "length-sigma", opts.length_sigma);
+    opts.min_length = get_count(config, "min-length", opts.min_length);
+    opts.max_length = get_count(config, "max-length", opts.max_length);
+    opts.num_labels = get_count(config, "labels", opts.num_labels);
+    opts.label_weight = get_option(config, "label-weight", opts.label_weight);
+    opts.metadata = get_option(config, "metadata", opts.metadata);
+    opts.num_queries = get_count(config, "queries", opts.num_queries);
+    opts.query_length = get_count(config, "query-length", opts.query_length);
+
+    return opts;
+}
+
+synthetic_corpus::synthetic_corpus(options opts)
+    : opts_(std::move(opts)), dist_{opts_.vocab_size, opts_.zipf_exponent}
+{
+    if (opts_.vocab_size == 0)
+        throw corpus_exception{"vocab-size must be positive"};
+    if (opts_.min_length == 0 || opts_.min_length > opts_.max_length)
+        throw corpus_exception{
+            "min-length must be positive and at most max-length"};
+    if (opts_.length_mean <= 0 || opts_.length_sigma < 0)
+        throw corpus_exception{"invalid document length distribution"};
+    if (opts_.label_weight < 0 || opts_.label_weight > 1)
+        throw corpus_exception{"label-weight must be in [0, 1]"};
+    if (opts_.num_queries > 0
+        && (opts_.num_docs == 0 || opts_.query_length == 0))
+        throw corpus_exception{
+            "queries need a non-empty corpus and a positive query-length"};
+
+    // words are random strings of lowercase letters; shorter words are
+    // more likely, and are assigned the more frequent ranks
+    auto rng = engine(0, 0);
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::binomial_distribution<uint64_t> extra{12, 0.3};
+
+    std::unordered_set<std::string> seen;
+    words_.reserve(opts_.vocab_size);
+    while (words_.size() < opts_.vocab_size)
+    {
+        std::string word(2 + extra(rng), ' ');
+        for (auto& c : word)
+            c = static_cast<char>(letter(rng));
+        if (seen.insert(word).second)
+            words_.push_back(std::move(word));
+    }
+    std::stable_sort(words_.begin(), words_.end(),
+                     [](const std::string& a, const std::string& b)
+                     {
+                         return a.size() < b.size();
+                     });
+}
+
+auto synthetic_corpus::engine(uint64_t stream, uint64_t id) const
+    -> random_engine
+{
+    std::seed_seq seq{static_cast<uint32_t>(opts_.seed),
+                      static_cast<uint32_t>(opts_.seed >> 32),
+                      static_cast<uint32_t>(stream),
+                      static_cast<uint32_t>(id),
+                      static_cast<uint32_t>(id >> 32)};
+    return random_engine{seq};
+}
+
+auto synthetic_corpus::generate(uint64_t id) const -> document
+{
+    auto rng = engine(1, id);
+    document doc;
+
+    doc.label = opts_.num_labels;
+    if (opts_.num_labels > 0)
+    {
+        std::uniform_int_distribution<uint64_t> label{0,
+                                                      opts_.num_labels - 1};
+        doc.label = label(rng);
+    }
+
+    // choose the location parameter so that the mean of the log-normal
+    // distribution is length_mean
+    auto sigma = opts_.length_sigma;
+    std::lognormal_distribution<double> length{
+        std::log(opts_.length_mean) - sigma * sigma / 2, sigma};
+    auto len = static_cast<uint64_t>(std::llround(length(rng)));
+    len = std::min(std::max(len, opts_.min_length), opts_.max_length);
+
+    // labeled documents draw some of their words from a shifted copy of
+    // the distribution, which makes a label-specific set of words common
+    std::bernoulli_distribution from_label{opts_.label_weight};
+    auto shift = opts_.vocab_size * (doc.label + 1) / (opts_.num_labels + 1);
+    doc.words.reserve(len);
+    for (uint64_t i = 0; i < len; ++i)
+    {
+        auto rank = dist_(rng);
+        if (opts_.num_labels > 0 && from_label(rng))
+            rank = (rank + shift) % opts_.vocab_size;
+        doc.words.push_back(rank);
+    }
+
+    std::uniform_int_distribution<uint64_t> year{1990, 2019};
+    std::uniform_int_distribution<uint64_t> source{0, sources().size() - 1};
+    std::uniform_real_distribution<double> score{0.0, 5.0};
+    doc.year = year(rng);
+    doc.source = source(rng);
+    doc.score = score(rng);
+
+    return doc;
+}
+
+std::string synthetic_corpus::text(const document& doc) const
+{
+    // sentence boundaries are derived from the words themselves so the
+    // text is a pure function of the document
+    std::string text;
+    bool capitalize = true;
+    uint64_t sentence = 0;
+    for (uint64_t i = 0; i < doc.words.size(); ++i)
+    {
+        if (i > 0)
+            text += ' ';
+        const auto& word = words_[doc.words[i]];
+        text += word;
+        if (capitalize)
+            text[text.size() - word.size()]
+                = static_cast<char>(std::toupper(word[0]));
+        capitalize = false;
+
+        ++sentence;
+        auto hash = doc.words[i] * 0x9e3779b97f4a7c15ULL;
+        if (i + 1 == doc.words.size() || (sentence >= 5 && hash % 10 == 0))
+        {
+            text += '.';
+            capitalize = true;
+            sentence = 0;
+        }
+        else if (hash % 16 == 1)
+        {
+            text += ',';
+        }
+    }
+    return text;
+}
+
+std::string synthetic_corpus::label(const document& doc) const
+{
+    if (doc.label >= opts_.num_labels)
+        return "[none]";
+    return "label" + std::to_string(doc.label);
+}
+
+const std::vector<std::string>& synthetic_corpus::vocabulary() const
+{
+    return words_;
+}
+
+const std::vector<std::string>& synthetic_corpus::sources()
+{
+    static const std::vector<std::string> names
+        = {"news", "blog", "forum", "review", "wiki", "paper"};
+    return names;
+}
+
+auto synthetic_corpus::make_queries() const -> std::vector<query>
+{
+    std::vector<query> queries;
+    queries.reserve(opts_.num_queries);
+    std::uniform_int_distribution<uint64_t> source{0, opts_.num_docs - 1};
+    for (uint64_t q = 0; q < opts_.num_queries; ++q)
+    {
+        auto rng = engine(2, q);
+        query qry;
+        qry.source = source(rng);
+        auto doc = generate(qry.source);
+        qry.label = doc.label;
+
+        auto terms = doc.words;
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+        // prefer words that are rare enough to be discriminative, but fall
+        // back on common ones for very short documents
+        auto first_rare = std::lower_bound(terms.begin(), terms.end(),
+                                           std::min(stopwords,
+                                                    opts_.vocab_size / 10));
+        if (static_cast<uint64_t>(terms.end() - first_rare)
+            >= opts_.query_length)
+            terms.erase(terms.begin(), first_rare);
+
+        std::shuffle(terms.begin(), terms.end(), rng);
+        terms.resize(std::min<uint64_t>(terms.size(), opts_.query_length));
+        qry.words = std::move(terms);
+        queries.push_back(std::move(qry));
+    }
+    return queries;
+}
+
+void synthetic_corpus::write(const std::string& prefix,
+                             const std::string& dataset) const
+{
+    auto folder = prefix + "/" + dataset + "/";
+    filesystem::make_directories(folder);
+
+    auto name = format_name(opts_.fmt);
+    auto labeled = opts_.num_labels > 0;
+    LOG(info) << "Generating " << name << " corpus " << folder << " with "
+              << opts_.num_docs << " documents" << ENDLG;
+
+    {
+        std::ofstream config{folder + name + ".toml"};
+        config << "type = \"" << name << "-corpus\"\n";
+        if (opts_.fmt == format::FILE)
+            config << "list = \"" << dataset << "\"\n";
+        else
+            config << "num-docs = " << opts_.num_docs << "\n";
+        if (opts_.metadata)
+        {
+            config << "\n[[metadata]]\nname = \"year\"\ntype = \"uint\"\n";
+            config << "\n[[metadata]]\nname = \"source\"\ntype = \"string\"\n";
+            config << "\n[[metadata]]\nname = \"score\"\ntype = \"double\"\n";
+        }
+    }
+
+    // each query is relevant to the document it was drawn from; other
+    // documents are relevant when they contain at least half of the
+    // query's words (and share its label, if there are labels)
+    auto queries = make_queries();
+    std::unordered_map<uint64_t, std::vector<uint64_t>> term_queries;
+    for (uint64_t q = 0; q < queries.size(); ++q)
+    {
+        for (const auto& term : queries[q].words)
+            term_queries[term].push_back(q);
+    }
+
+    auto render = [&](uint64_t id)
+    {
+        auto doc = generate(id);
+        rendered_document result;
+        result.label = label(doc);
+
+        if (opts_.fmt == format::LIBSVM)
+        {
+            auto terms = doc.words;
+            std::sort(terms.begin(), terms.end());
+            result.content = result.label;
+            for (auto it = terms.begin(); it != terms.end();)
+            {
+                auto next = std::upper_bound(it, terms.end(), *it);
+                // libsvm feature ids start at 1
+                result.content += ' ' + std::to_string(*it + 1) + ':'
+                                  + std::to_string(next - it);
+                it = next;
+            }
+        }
+        else
+        {
+            result.content = text(doc);
+        }
+
+        if (opts_.metadata)
+        {
+            result.metadata = std::to_string(doc.year) + '\t'
+                              + sources()[doc.source] + '\t'
+                              + std::to_string(doc.score);
+        }
+
+        if (!term_queries.empty())
+        {
+            std::sort(doc.words.begin(), doc.words.end());
+            doc.words.erase(std::unique(doc.words.begin(), doc.words.end()),
+                            doc.words.end());
+            std::unordered_map<uint64_t, uint64_t> matches;
+            for (const auto& term : doc.words)
+            {
+                auto it = term_queries.find(term);
+                if (it == term_queries.end())
+                    continue;
+                for (const auto& q : it->second)
+                    ++matches[q];
+            }
+            for (const auto& match : matches)
+            {
+                const auto& qry = queries[match.first];
+                if (qry.source == id)
+                    result.judgements.emplace_back(match.first, 2);
+                else if (2 * match.second >= qry.words.size()
+                         && qry.label == doc.label)
+                    result.judgements.emplace_back(match.first, 1);
+            }
+        }
+
+        return result;
+    };
+
+    std::unique_ptr<std::ostream> content;
+    std::unique_ptr<std::ostream> labels;
+    switch (opts_.fmt)
+    {
+        case format::LINE:
+            content = make_unique<std::ofstream>(folder + dataset + ".dat");
+            if (labeled)
+                labels = make_unique<std::ofstream>(folder + dataset
+                                                    + ".dat.labels");
+            break;
+        case format::FILE:
+            labels = make_unique<std::ofstream>(folder + dataset
+                                                + "-full-corpus.txt");
+            break;
+        case format::GZ:
+            content = make_unique<io::gzofstream>(folder + dataset
+                                                  + ".dat.gz");
+            if (labeled)
+                labels = make_unique<io::gzofstream>(folder + dataset
+                                                     + ".dat.labels.gz");
+            break;
+        case format::LIBSVM:
+            content = make_unique<std::ofstream>(folder + dataset + ".dat");
+            break;
+    }
+
+    std::unique_ptr<std::ofstream> metadata;
+    if (opts_.metadata)
+        metadata = make_unique<std::ofstream>(folder + "metadata.dat");
+
+    std::vector<std::vector<std::pair<uint64_t, int>>> qrels(queries.size());
+
+    auto threads = opts_.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    parallel::thread_pool pool{threads};
+
+    // documents are generated in parallel a batch at a time, and written
+    // out in order once the whole batch is done
+    const uint64_t batch_size = chunk_size * threads * 4;
+    std::vector<rendered_document> batch;
+    printing::progress progress{" > Generating documents: ", opts_.num_docs};
+    for (uint64_t start = 0; start < opts_.num_docs; start += batch_size)
+    {
+        auto end = std::min(start + batch_size, opts_.num_docs);
+        batch.clear();
+        batch.resize(end - start);
+
+        std::vector<std::future<void>> futures;
+        for (uint64_t first = start; first < end; first += chunk_size)
+        {
+            auto last = std::min(first + chunk_size, end);
+            futures.emplace_back(pool.submit_task([&, first, last]()
+            {
+                for (auto id = first; id < last; ++id)
+                    batch[id - start] = render(id);
+            }));
+        }
+        for (auto& fut : futures)
+            fut.get();
+
+        for (uint64_t i = 0; i < batch.size(); ++i)
+        {
+            auto id = start + i;
+            auto& doc = batch[i];
+            if (opts_.fmt == format::FILE)
+            {
+                auto path = file_path(id);
+                if (id % 1000 == 0)
+                    filesystem::make_directories(
+                        folder + path.substr(0, path.rfind('/')));
+                std::ofstream file{folder + path};
+                file << doc.content << "\n";
+                *labels << doc.label << " " << path << "\n";
+            }
+            else
+            {
+                *content << doc.content << "\n";
+                if (labels)
+                    *labels << doc.label << "\n";
+            }
+
+            if (metadata)
+                *metadata << doc.metadata << "\n";
+
+            for (const auto& judgement : doc.judgements)
+                qrels[judgement.first].emplace_back(id, judgement.second);
+        }
+        progress(end);
+    }
+    progress.end();
+
+    if (!queries.empty())
+    {
+        std::ofstream query_file{folder + dataset + "-queries.txt"};
+        for (const auto& qry : queries)
+        {
+            for (uint64_t i = 0; i < qry.words.size(); ++i)
+                query_file << (i > 0 ? " " : "") << words_[qry.words[i]];
+            query_file << "\n";
+        }
+
+        std::ofstream qrels_file{folder + dataset + "-qrels.txt"};
+        for (uint64_t q = 0; q < qrels.size(); ++q)
+        {
+            for (const auto& judgement : qrels[q])
+                qrels_file << q << " " << judgement.first << " "
+                           << judgement.second << "\n";
+        }
+    }
+}
+}
+}
@@ -0,0 +1,57 @@
+/**
+ * @file synthetic_corpus.cpp
+ * @author agent
+ *
+ * Generates a synthetic corpus for benchmarking. The configuration file
+ * gives the "prefix" and "dataset" to write to, and the generator
+ * parameters in a [synthetic-corpus] table (see
+ * corpus::synthetic_corpus). The generated corpus configuration file is
+ * named after the format, so setting corpus = "line.toml" (for example)
+ * in the same configuration file makes it indexable.
+ */
+
+#include <iostream>
+
+#include "cpptoml.h"
+#include "meta/corpus/synthetic_corpus.h"
+#include "meta/logging/logger.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage:\t" << argv[0] << " configFile" << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    auto config = cpptoml::parse_file(argv[1]);
+    auto prefix = config->get_as<std::string>("prefix");
+    if (!prefix)
+        throw std::runtime_error{"prefix missing from configuration file"};
+
+    auto dataset = config->get_as<std::string>("dataset");
+    if (!dataset)
+        throw std::runtime_error{"dataset missing from configuration file"};
+
+    auto gen_config = config->get_table("synthetic-corpus");
+    if (!gen_config)
+        throw std::runtime_error{
+            "[synthetic-corpus] missing from configuration file"};
+
+    auto time = common::time([&]()
+    {
+        corpus::synthetic_corpus gen{
+            corpus::synthetic_corpus::parse_options(*gen_config)};
+        gen.write(*prefix, *dataset);
+    });
+
+    std::cout << "Corpus generation took: " << time.count() / 1000.0
+              << " seconds" << std::endl;
+
+    return 0;
+}
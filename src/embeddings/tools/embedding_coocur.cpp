@@ -16,6 +16,7 @@
 #include "meta/hashing/probe_map.h"
 #include "meta/io/packed.h"
 #include "meta/logging/logger.h"
+#include "meta/util/memory.h"
 #include "meta/util/multiway_merge.h"
 #include "meta/util/progress.h"
 #include "meta/util/printing.h"
@@ -46,9 +47,15 @@ class coocur_buffer
     coocur_buffer(std::size_t max_ram, util::string_view prefix)
         : max_bytes_{max_ram},
           prefix_{prefix.to_string()},
-          coocur_{static_cast<std::size_t>(max_bytes_ / sizeof(count_t))}
+          coocur_{static_cast<std::size_t>(max_bytes_ / sizeof(count_t))},
+          memory_{memory::get_category("embeddings/cooccurrence")}
     {
-        // nothing
+        publish();
+    }
+
+    ~coocur_buffer()
+    {
+        memory_.deallocate(published_bytes_);
     }
 
     void flush()
@@ -77,6 +84,7 @@ class coocur_buffer
         }
 
         coocur_ = map_t{static_cast<std::size_t>(max_bytes_ / sizeof(count_t))};
+        publish();
         ++chunk_num_;
     }
 
@@ -102,6 +110,7 @@ class coocur_buffer
     uint64_t merge_chunks()
     {
         coocur_ = map_t{};
+        publish();
         std::vector<embeddings::coocur_iterator> chunks;
         chunks.reserve(num_chunks());
 
@@ -139,15 +148,34 @@ class coocur_buffer
             {
                 flush();
             }
+            else
+            {
+                // the table is about to grow
+                publish(static_cast<std::size_t>(bytes_used));
+            }
         }
     }
 
+    /**
+     * Reports the size of the table to the memory category.
+     * @param bytes The size to report (defaults to the current size)
+     */
+    void publish(std::size_t bytes = 0)
+    {
+        if (bytes == 0)
+            bytes = coocur_.bytes_used();
+        memory_.update(published_bytes_, bytes);
+        published_bytes_ = bytes;
+    }
+
     using count_t = std::pair<std::pair<uint64_t, uint64_t>, double>;
     using map_t
         = meta::hashing::probe_map<std::pair<uint64_t, uint64_t>, double>;
     const std::size_t max_bytes_;
     const std::string prefix_;
     map_t coocur_;
+    memory::category& memory_;
+    std::size_t published_bytes_ = 0;
     std::size_t chunk_num_ = 0;
 };
 
@@ -230,9 +258,11 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    memory::get_category("embeddings/vocabulary").allocate(vocab.bytes_used());
     coocur_buffer coocur{max_ram, prefix};
 
     {
+        memory::stage stage{"count"};
         auto docs = corpus::make_corpus(*config);
         printing::progress progress{" > Counting coocurrences: ", docs->size()};
         for (uint64_t i = 0; docs->has_next(); ++i)
@@ -286,7 +316,13 @@ int main(int argc, char** argv)
     coocur.flush();
 
     // merge all on-disk chunks
-    auto uniq = coocur.merge_chunks();
+    uint64_t uniq;
+    {
+        memory::stage stage{"merge"};
+        uniq = coocur.merge_chunks();
+    }
+    LOG(info) << "Peak tracked memory by stage:\n" << memory::stage_summary()
+              << ENDLG;
 
     LOG(info) << "Coocurrence matrix elements: " << uniq << ENDLG;
     LOG(info) << "Coocurrence matrix size: "
@@ -129,7 +129,8 @@ void feature_selector::calc_probs()
         prog(did);
         auto lid = idx_->lbl_id(did);
         ++class_prob_[lid - 1];
-        for (auto& count : idx_->search_primary(did)->counts())
+        auto stream = idx_->stream_for(did);
+        for (const auto& count : *stream)
         {
             term_prob_[count.first] += count.second;
             co_occur_[lid - 1][count.first] += count.second;
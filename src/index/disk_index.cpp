@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <cmath>
 #include <numeric>
 #include <stdexcept>
 
@@ -12,6 +13,7 @@
 #include "meta/index/string_list_writer.h"
 #include "meta/index/vocabulary_map.h"
 #include "meta/analyzers/analyzer.h"
+#include "meta/parallel/parallel_for.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/mapping.h"
 #include "meta/util/optional.h"
@@ -34,6 +36,15 @@ std::string disk_index::index_name() const
 
 term_id disk_index::get_term_id(const std::string& term)
 {
+    if (impl_->ram_)
+    {
+        const auto& term_ids = impl_->ram_->term_ids;
+        auto it = term_ids.find(util::string_view{term});
+        if (it != term_ids.end())
+            return it->value();
+        return term_id{impl_->ram_->term_ids.size()};
+    }
+
     std::lock_guard<std::mutex> lock{impl_->mutex_};
 
     auto termID = impl_->term_id_mapping_->find(term);
@@ -46,12 +57,12 @@ term_id disk_index::get_term_id(const std::string& term)
 
 class_label disk_index::label(doc_id d_id) const
 {
-    return class_label_from_id(impl_->labels_->at(d_id));
+    return class_label_from_id(lbl_id(d_id));
 }
 
 label_id disk_index::lbl_id(doc_id d_id) const
 {
-    return impl_->labels_->at(d_id);
+    return impl_->doc_label_id(d_id);
 }
 
 label_id disk_index::id(class_label label) const
@@ -83,9 +94,21 @@ corpus::metadata disk_index::metadata(doc_id d_id) const
     return impl_->metadata_->get(d_id);
 }
 
+const corpus::metadata::schema_type& disk_index::metadata_schema() const
+{
+    return impl_->metadata_->schema();
+}
+
+const metadata_column& disk_index::column(const std::string& name) const
+{
+    return impl_->metadata_->column(name);
+}
+
 uint64_t disk_index::unique_terms(doc_id d_id) const
 {
-    return *metadata(d_id).get<uint64_t>("unique-terms");
+    if (impl_->ram_)
+        return impl_->ram_->unique_terms.at(d_id);
+    return metadata(d_id).get(*impl_->unique_terms_field_);
 }
 
 uint64_t disk_index::unique_terms() const
@@ -95,7 +118,9 @@ uint64_t disk_index::unique_terms() const
 
 uint64_t disk_index::doc_size(doc_id d_id) const
 {
-    return *metadata(d_id).get<uint64_t>("length");
+    if (impl_->ram_)
+        return impl_->ram_->doc_sizes.at(d_id);
+    return metadata(d_id).get(*impl_->length_field_);
 }
 
 uint64_t disk_index::num_docs() const
@@ -111,8 +136,8 @@ std::string disk_index::doc_name(doc_id d_id) const
 
 std::string disk_index::doc_path(doc_id d_id) const
 {
-    if (auto path = impl_->metadata_->get(d_id).get<std::string>("path"))
-        return *path;
+    if (impl_->path_field_)
+        return metadata(d_id).get(*impl_->path_field_).to_string();
     return "[none]";
 }
 
@@ -130,6 +155,9 @@ const std::vector<const char*> disk_index::disk_index_impl::files
        "/postings.index_index", "/termids.mapping",  "/termids.mapping.inverse",
        "/metadata.db",          "/metadata.index"};
 
+const char* const disk_index::disk_index_impl::postings_values_file
+    = "/postings.values";
+
 label_id disk_index::disk_index_impl::get_label_id(const class_label& lbl)
 {
     std::lock_guard<std::mutex> lock{mutex_};
@@ -146,7 +174,18 @@ label_id disk_index::disk_index_impl::get_label_id(const class_label& lbl)
 
 void disk_index::disk_index_impl::initialize_metadata()
 {
+    using corpus::metadata;
+
     metadata_ = {index_name_};
+
+    const auto& schema = metadata_->schema();
+    length_field_ = metadata::accessor<uint64_t>{schema, "length"};
+    unique_terms_field_ = metadata::accessor<uint64_t>{schema, "unique-terms"};
+
+    if (corpus::has_field(schema, "path"))
+        path_field_ = metadata::accessor<util::string_view>{schema, "path"};
+    else
+        path_field_ = util::nullopt;
 }
 
 void disk_index::disk_index_impl::load_labels(uint64_t num_docs)
@@ -187,6 +226,8 @@ uint64_t disk_index::disk_index_impl::total_unique_terms() const
 
 label_id disk_index::disk_index_impl::doc_label_id(doc_id id) const
 {
+    if (ram_)
+        return ram_->labels.at(id);
     return labels_->at(id);
 }
 
@@ -199,8 +240,86 @@ std::vector<class_label> disk_index::disk_index_impl::class_labels() const
     return labels;
 }
 
+uint64_t disk_index::disk_index_impl::load_ram_tables(
+    parallel::thread_pool& pool)
+{
+    ram_ = util::nullopt;
+    ram_tables tables;
+
+    auto num_docs = metadata_->size();
+    tables.doc_sizes.resize(num_docs);
+    tables.unique_terms.resize(num_docs);
+    tables.labels.resize(num_docs);
+    parallel::parallel_blocks(num_docs, pool, [&](uint64_t begin, uint64_t end)
+    {
+        for (auto d_id = begin; d_id < end; ++d_id)
+        {
+            auto mdata = metadata_->get(doc_id{d_id});
+            tables.doc_sizes[d_id] = mdata.get(*length_field_);
+            tables.unique_terms[d_id] = mdata.get(*unique_terms_field_);
+            tables.labels[d_id] = labels_->at(d_id);
+        }
+    });
+
+    // the term text is copied in two passes: the first finds where each
+    // term goes, and the second copies it there
+    auto num_terms = term_id_mapping_->size();
+    tables.term_offsets.resize(num_terms + 1);
+    parallel::parallel_blocks(num_terms, pool, [&](uint64_t begin, uint64_t end)
+    {
+        for (auto t_id = begin; t_id < end; ++t_id)
+            tables.term_offsets[t_id + 1]
+                = term_id_mapping_->find_term(term_id{t_id}).size();
+    });
+    std::partial_sum(tables.term_offsets.begin(), tables.term_offsets.end(),
+                     tables.term_offsets.begin());
+
+    tables.term_text.resize(tables.term_offsets.back());
+    parallel::parallel_blocks(num_terms, pool, [&](uint64_t begin, uint64_t end)
+    {
+        for (auto t_id = begin; t_id < end; ++t_id)
+        {
+            auto term = term_id_mapping_->find_term(term_id{t_id});
+            std::copy(term.begin(), term.end(),
+                      tables.term_text.begin() + tables.term_offsets[t_id]);
+        }
+    });
+
+    using table_type = hashing::probe_map<util::string_view, term_id>;
+    tables.term_ids = table_type{static_cast<std::size_t>(
+        std::ceil(num_terms / table_type::default_max_load_factor()))};
+    for (uint64_t t_id = 0; t_id < num_terms; ++t_id)
+    {
+        auto offset = tables.term_offsets[t_id];
+        util::string_view term{tables.term_text.data() + offset,
+                               tables.term_offsets[t_id + 1] - offset};
+        tables.term_ids[term] = term_id{t_id};
+    }
+
+    auto bytes = tables.doc_sizes.capacity() * sizeof(uint64_t)
+                 + tables.unique_terms.capacity() * sizeof(uint64_t)
+                 + tables.labels.capacity() * sizeof(label_id)
+                 + tables.term_text.capacity()
+                 + tables.term_offsets.capacity() * sizeof(uint64_t)
+                 + tables.term_ids.bytes_used();
+
+    // moving the vectors keeps their buffers, so the term table's views
+    // remain valid
+    ram_ = std::move(tables);
+    return bytes;
+}
+
 std::string disk_index::term_text(term_id t_id) const
 {
+    if (impl_->ram_)
+    {
+        const auto& offsets = impl_->ram_->term_offsets;
+        if (t_id + 1 >= offsets.size())
+            return "";
+        return {impl_->ram_->term_text.data() + offsets[t_id],
+                offsets[t_id + 1] - offsets[t_id]};
+    }
+
     if (t_id >= impl_->term_id_mapping_->size())
         return "";
     return impl_->term_id_mapping_->find_term(t_id);
@@ -20,12 +20,14 @@
 #include "meta/index/string_list.h"
 #include "meta/index/string_list_writer.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/index/value_codec.h"
 #include "meta/index/vocabulary_map_writer.h"
 #include "meta/io/libsvm_parser.h"
 #include "meta/logging/logger.h"
 #include "meta/parallel/thread_pool.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/mapping.h"
+#include "meta/util/memory.h"
 #include "meta/util/pimpl.tcc"
 #include "meta/util/printing.h"
 #include "meta/util/shim.h"
@@ -98,6 +100,13 @@ class forward_index::impl
      */
     void compress(const std::string& filename, uint64_t num_docs);
 
+    /**
+     * Chooses how the feature values in the postings file are stored
+     * (based on the "forward-index-values" setting and the values
+     * themselves) and re-encodes the file if needed.
+     */
+    void encode_values();
+
     /**
      * Loads the postings file.
      * @param filename The path to the postings file to load
@@ -118,6 +127,11 @@ class forward_index::impl
   private:
     /// Pointer to the forward_index this is an implementation of
     forward_index* idx_;
+
+    /// How feature values should be stored: "auto" (varints if every
+    /// value is a count, doubles otherwise), "double", "float", or
+    /// "quantized"
+    std::string value_format_;
 };
 
 forward_index::forward_index(const cpptoml::table& config)
@@ -128,8 +142,15 @@ forward_index::forward_index(const cpptoml::table& config)
 }
 
 forward_index::impl::impl(forward_index* idx, const cpptoml::table& config)
-    : idx_{idx}
+    : idx_{idx},
+      value_format_{config.get_as<std::string>("forward-index-values")
+                        .value_or("auto")}
 {
+    if (value_format_ != "auto" && value_format_ != "double"
+        && value_format_ != "float" && value_format_ != "quantized")
+        throw forward_index_exception{"unknown forward-index-values: "
+                                      + value_format_};
+
     if (!is_libsvm_analyzer(config))
         analyzer_ = analyzers::load(config);
 }
@@ -168,11 +189,11 @@ std::string forward_index::liblinear_data(doc_id d_id) const
     if (d_id >= num_docs())
         throw forward_index_exception{"invalid doc_id in search_primary"};
 
-    auto pdata = search_primary(d_id);
+    auto stream = stream_for(d_id);
     std::stringstream out;
 
     out << lbl_id(d_id);
-    for (const auto& count : pdata->counts())
+    for (const auto& count : *stream)
         out << ' ' << (count.first + 1) << ':' << count.second;
     return out.str();
 }
@@ -206,6 +227,8 @@ void forward_index::create_index(const cpptoml::table& config,
         config_file << config;
     }
 
+    auto first_stage = memory::stages().size();
+
     // if the corpus is a single libsvm formatted file, then we are done;
     // otherwise, we will create an inverted index and the uninvert it
     if (fwd_impl_->is_libsvm_analyzer(config))
@@ -241,7 +264,10 @@ void forward_index::create_index(const cpptoml::table& config,
             fwd_impl_->create_uninverted_metadata(inv_idx->index_name());
             impl_->load_labels();
             // RAM budget is given in MB
-            fwd_impl_->uninvert(*inv_idx, ram_budget * 1024 * 1024);
+            {
+                memory::stage stage{"uninvert"};
+                fwd_impl_->uninvert(*inv_idx, ram_budget * 1024 * 1024);
+            }
             impl_->load_term_id_mapping();
             fwd_impl_->total_unique_terms_ = impl_->total_unique_terms();
         }
@@ -267,6 +293,7 @@ void forward_index::create_index(const cpptoml::table& config,
     }
 
     impl_->load_label_id_mapping();
+    fwd_impl_->encode_values();
     fwd_impl_->load_postings();
     impl_->initialize_metadata();
 
@@ -277,6 +304,8 @@ void forward_index::create_index(const cpptoml::table& config,
 
     assert(filesystem::file_exists(index_name() + "/corpus.uniqueterms"));
 
+    LOG(info) << "Peak tracked memory by stage:\n"
+              << memory::stage_summary(first_stage) << ENDLG;
     LOG(info) << "Done creating index: " << index_name() << ENDLG;
 }
 
@@ -290,6 +319,10 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
     printing::progress progress{" > Tokenizing Docs: ", docs.size()};
 
     hashing::probe_map<std::string, term_id> vocab;
+    // the heap bytes used by the vocabulary: the table plus any long keys
+    auto& vocab_memory = memory::get_category("index/vocabulary");
+    uint64_t key_bytes = 0;
+    uint64_t vocab_bytes = 0;
     bool exceeded_budget = false;
     auto task = [&](size_t chunk_id)
     {
@@ -318,7 +351,6 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
             // warn if there is an empty document
             if (counts.empty())
             {
-                std::lock_guard<std::mutex> lock{io_mutex};
                 LOG(progress) << '\n' << ENDLG;
                 LOG(warning) << "Empty document (id = " << doc->id()
                              << ") generated!" << ENDLG;
@@ -342,15 +374,21 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
                 {
                     auto it = vocab.find(count.key());
                     if (it == vocab.end())
+                    {
                         it = vocab.emplace(count.key(), term_id{vocab.size()});
+                        key_bytes += detail::heap_bytes(it->key());
+                    }
 
                     pd_counts.emplace_back(it->value(), count.value());
                 }
 
-                if (!exceeded_budget && vocab.bytes_used() > ram_budget)
+                auto bytes = vocab.bytes_used() + key_bytes;
+                vocab_memory.update(vocab_bytes, bytes);
+                vocab_bytes = bytes;
+
+                if (!exceeded_budget && vocab_bytes > ram_budget)
                 {
                     exceeded_budget = true;
-                    std::lock_guard<std::mutex> io_lock{io_mutex};
                     LOG(progress) << '\n' << ENDLG;
                     LOG(warning)
                         << "Exceeding RAM budget; indexing cannot "
@@ -367,17 +405,23 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
 
     parallel::thread_pool pool;
     auto num_threads = pool.thread_ids().size();
-    std::vector<std::future<void>> futures;
-    futures.reserve(num_threads);
-    for (size_t i = 0; i < num_threads; ++i)
-        futures.emplace_back(pool.submit_task(std::bind(task, i)));
+    {
+        memory::stage stage{"tokenize"};
+        std::vector<std::future<void>> futures;
+        futures.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i)
+            futures.emplace_back(pool.submit_task(std::bind(task, i)));
 
-    for (auto& fut : futures)
-        fut.get();
+        for (auto& fut : futures)
+            fut.get();
 
-    progress.end();
+        progress.end();
+    }
 
+    memory::stage stage{"merge"};
     merge_chunks(num_threads, docs.size(), std::move(vocab));
+    // the merge rebuilds the vocabulary in place and frees it when done
+    vocab_memory.deallocate(vocab_bytes);
 }
 
 void forward_index::impl::merge_chunks(
@@ -509,6 +553,17 @@ void forward_index::impl::create_uninverted_metadata(const std::string& name)
     for (const auto& file : files)
         filesystem::copy_file(name + idx_->impl_->files[file],
                               idx_->index_name() + idx_->impl_->files[file]);
+
+    metadata_file mdata{name};
+    for (uint64_t i = 0; i < mdata.schema().size(); ++i)
+    {
+        if (!mdata.schema()[i].column)
+            continue;
+
+        filesystem::make_directory(idx_->index_name() + "/metadata.columns");
+        filesystem::copy_file(metadata_column_path(name, i),
+                              metadata_column_path(idx_->index_name(), i));
+    }
 }
 
 bool forward_index::impl::is_libsvm_analyzer(const cpptoml::table& config) const
@@ -528,9 +583,14 @@ learn::feature_vector forward_index::tokenize(const corpus::document& doc)
 {
     if (!fwd_impl_->analyzer_)
         throw exception{"this forward index type can't analyze docs"};
+    return tokenize(doc, *fwd_impl_->analyzer_);
+}
 
+learn::feature_vector forward_index::tokenize(const corpus::document& doc,
+                                              analyzers::analyzer& ana)
+{
     learn::feature_vector f_vec;
-    auto map = fwd_impl_->analyzer_->analyze<double>(doc);
+    auto map = ana.analyze<double>(doc);
     for (auto& pr : map)
     {
         auto t_id = get_term_id(pr.key());
@@ -541,6 +601,13 @@ learn::feature_vector forward_index::tokenize(const corpus::document& doc)
     return f_vec;
 }
 
+const analyzers::analyzer& forward_index::analyzer() const
+{
+    if (!fwd_impl_->analyzer_)
+        throw exception{"this forward index type can't analyze docs"};
+    return *fwd_impl_->analyzer_;
+}
+
 uint64_t forward_index::unique_terms() const
 {
     return fwd_impl_->total_unique_terms_;
@@ -564,10 +631,11 @@ void forward_index::impl::uninvert(const inverted_index& inv_idx,
     postings_inverter<forward_index> handler{idx_->index_name()};
     {
         auto producer = handler.make_producer(ram_budget);
+        std::vector<std::pair<doc_id, uint64_t>> counts;
         for (term_id t_id{0}; t_id < inv_idx.unique_terms(); ++t_id)
         {
-            auto pdata = inv_idx.search_primary(t_id);
-            producer(pdata->primary_key(), pdata->counts());
+            auto stream = inv_idx.stream_for(t_id);
+            producer(t_id, stream->decode(counts));
         }
     }
 
@@ -633,9 +701,88 @@ void forward_index::impl::compress(const std::string& filename,
     filesystem::delete_file(ucfilename);
 }
 
+void forward_index::impl::encode_values()
+{
+    auto filename = idx_->index_name() + idx_->impl_->files[POSTINGS];
+
+    value_codec codec;
+    {
+        io::mmap_file file{filename};
+        util::disk_vector<uint64_t> locations{filename + "_index"};
+
+        // the largest double below which every integer is representable
+        const double max_integer = static_cast<double>(uint64_t{1} << 53);
+        bool integral = true;
+        double max_abs = 0;
+        for (uint64_t i = 0; i < locations.size(); ++i)
+        {
+            postings_stream<term_id, double> stream{file.begin()
+                                                    + locations[i]};
+            for (const auto& count : stream)
+            {
+                max_abs = std::max(max_abs, std::abs(count.second));
+                integral = integral && count.second >= 0
+                           && count.second < max_integer
+                           && count.second == std::floor(count.second);
+            }
+        }
+
+        if (value_format_ == "auto" && integral)
+            codec.fmt = value_codec::format::VARINT;
+        else if (value_format_ == "float")
+            codec.fmt = value_codec::format::FLOAT;
+        else if (value_format_ == "quantized")
+            codec = value_codec::quantized(max_abs);
+
+        if (codec.fmt != value_codec::format::PACKED)
+        {
+            std::ofstream out{filename + ".encoded", std::ios::binary};
+            util::disk_vector<uint64_t> out_locations{
+                filename + ".encoded_index", locations.size()};
+
+            printing::progress progress{" > Encoding values: ",
+                                        locations.size()};
+            uint64_t byte_pos = 0;
+            for (uint64_t i = 0; i < locations.size(); ++i)
+            {
+                progress(i);
+                out_locations[i] = byte_pos;
+                postings_stream<term_id, double> stream{file.begin()
+                                                        + locations[i]};
+                byte_pos += io::packed::write(out, stream.size());
+                byte_pos += io::packed::write(out, stream.total_counts());
+
+                uint64_t last_id = 0;
+                for (const auto& count : stream)
+                {
+                    byte_pos += io::packed::write(out, count.first - last_id);
+                    byte_pos += codec.write(out, count.second);
+                    last_id = count.first;
+                }
+            }
+        }
+    }
+
+    if (codec.fmt != value_codec::format::PACKED)
+    {
+        auto old_size = filesystem::file_size(filename);
+        filesystem::rename_file(filename + ".encoded", filename);
+        filesystem::rename_file(filename + ".encoded_index",
+                                filename + "_index");
+        LOG(info) << "Stored feature values as "
+                  << value_codec::to_string(codec.fmt) << " ("
+                  << printing::bytes_to_units(old_size) << " -> "
+                  << printing::bytes_to_units(filesystem::file_size(filename))
+                  << ")" << ENDLG;
+    }
+    codec.save(idx_->index_name() + idx_->impl_->postings_values_file);
+}
+
 void forward_index::impl::load_postings()
 {
-    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+    auto codec = value_codec::load(idx_->index_name()
+                                   + idx_->impl_->postings_values_file);
+    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS], codec};
 }
 }
 }
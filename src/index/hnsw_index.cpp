@@ -0,0 +1,454 @@
+/**
+ * @file hnsw_index.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <random>
+
+#include "meta/index/hnsw_index.h"
+#include "meta/io/packed.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/parallel/thread_pool.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Orders candidates from most to least similar, breaking ties by node so
+ * that searches do not depend on the order nodes are visited in.
+ */
+struct candidate_comparator
+{
+    bool operator()(const std::pair<float, uint32_t>& a,
+                    const std::pair<float, uint32_t>& b) const
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+};
+
+/**
+ * The reverse of candidate_comparator, so that a priority queue keeps the
+ * most similar candidate on top.
+ */
+struct reverse_candidate_comparator
+{
+    bool operator()(const std::pair<float, uint32_t>& a,
+                    const std::pair<float, uint32_t>& b) const
+    {
+        return candidate_comparator{}(b, a);
+    }
+};
+
+/**
+ * Buffers reused by every search a thread runs.
+ */
+struct search_scratch
+{
+    /// The weight of each term in the query, and zero for the rest
+    std::vector<float> query;
+
+    /// The search each node was last visited by
+    std::vector<uint32_t> visited;
+
+    /// The current search
+    uint32_t epoch = 0;
+};
+}
+
+hnsw_index::hnsw_index(
+    const std::vector<std::pair<doc_id, vector_type>>& docs,
+    const hnsw_options& options)
+    : m_{options.m},
+      ef_construction_{std::max(options.ef_construction, options.m)},
+      num_terms_{0},
+      entry_{0},
+      max_level_{0}
+{
+    if (m_ < 2)
+        throw hnsw_exception{"hnsw m must be at least 2"};
+    if (docs.size() >= std::numeric_limits<uint32_t>::max())
+        throw hnsw_exception{"too many documents for an hnsw index"};
+
+    ids_.reserve(docs.size());
+    offsets_.reserve(docs.size() + 1);
+    offsets_.push_back(0);
+    for (const auto& doc : docs)
+    {
+        double norm = 0;
+        for (const auto& weight : doc.second)
+            norm += weight.second * weight.second;
+        norm = std::sqrt(norm);
+
+        ids_.push_back(doc.first);
+        for (const auto& weight : doc.second)
+        {
+            if (weight.first >= std::numeric_limits<uint32_t>::max())
+                throw hnsw_exception{"too many terms for an hnsw index"};
+            if (weight.second == 0)
+                continue;
+            terms_.push_back(static_cast<uint32_t>(weight.first));
+            values_.push_back(static_cast<float>(weight.second / norm));
+            num_terms_ = std::max<uint64_t>(num_terms_, weight.first + 1);
+        }
+        offsets_.push_back(terms_.size());
+    }
+
+    // the layers are drawn up front so that they do not depend on the
+    // order the nodes are inserted in
+    std::mt19937_64 rng{options.seed};
+    std::uniform_real_distribution<double> dist{0, 1};
+    auto ml = 1.0 / std::log(static_cast<double>(m_));
+    links_.resize(ids_.size());
+    for (auto& links : links_)
+    {
+        auto level
+            = static_cast<uint64_t>(-std::log(1.0 - dist(rng)) * ml);
+        links.resize(level + 1);
+    }
+
+    if (ids_.empty())
+        return;
+
+    locks_.reset(new std::mutex[ids_.size()]);
+    max_level_ = links_[0].size() - 1;
+
+    // nodes are handed out one at a time, since later insertions search a
+    // larger graph
+    std::atomic<uint64_t> next_node{1};
+    parallel::thread_pool pool{std::max<uint64_t>(options.num_threads, 1)};
+    parallel::parallel_blocks(pool.thread_ids().size(), pool,
+                              [&](uint64_t, uint64_t)
+                              {
+                                  for (auto node = next_node++;
+                                       node < ids_.size(); node = next_node++)
+                                      insert(static_cast<uint32_t>(node));
+                              });
+    locks_.reset();
+}
+
+hnsw_index::hnsw_index(std::istream& in) : num_terms_{0}
+{
+    io::packed::read(in, m_);
+    io::packed::read(in, ef_construction_);
+    io::packed::read(in, entry_);
+    io::packed::read(in, max_level_);
+
+    auto size = io::packed::read<uint64_t>(in);
+    ids_.resize(size);
+    offsets_.resize(size + 1);
+    links_.resize(size);
+    offsets_[0] = 0;
+    for (uint64_t node = 0; node < size; ++node)
+    {
+        io::packed::read(in, ids_[node]);
+        auto length = io::packed::read<uint64_t>(in);
+        offsets_[node + 1] = offsets_[node] + length;
+        for (uint64_t i = 0; i < length; ++i)
+        {
+            terms_.push_back(io::packed::read<uint32_t>(in));
+            values_.push_back(io::packed::read<float>(in));
+            num_terms_ = std::max<uint64_t>(num_terms_, terms_.back() + 1);
+        }
+
+        links_[node].resize(io::packed::read<uint64_t>(in));
+        for (auto& links : links_[node])
+        {
+            links.resize(io::packed::read<uint64_t>(in));
+            for (auto& link : links)
+                io::packed::read(in, link);
+        }
+    }
+
+    if (!in)
+        throw hnsw_exception{"malformed hnsw index"};
+}
+
+void hnsw_index::save(std::ostream& out) const
+{
+    io::packed::write(out, m_);
+    io::packed::write(out, ef_construction_);
+    io::packed::write(out, entry_);
+    io::packed::write(out, max_level_);
+
+    io::packed::write(out, ids_.size());
+    for (uint32_t node = 0; node < ids_.size(); ++node)
+    {
+        io::packed::write(out, ids_[node]);
+        auto vec = vector(node);
+        io::packed::write(out, vec.size);
+        for (uint64_t i = 0; i < vec.size; ++i)
+        {
+            io::packed::write(out, vec.terms[i]);
+            io::packed::write(out, vec.values[i]);
+        }
+
+        io::packed::write(out, links_[node].size());
+        for (const auto& links : links_[node])
+        {
+            io::packed::write(out, links.size());
+            for (const auto& link : links)
+                io::packed::write(out, link);
+        }
+    }
+}
+
+uint64_t hnsw_index::size() const
+{
+    return ids_.size();
+}
+
+auto hnsw_index::vector(uint32_t node) const -> vector_ref
+{
+    return {terms_.data() + offsets_[node], values_.data() + offsets_[node],
+            offsets_[node + 1] - offsets_[node]};
+}
+
+float hnsw_index::similarity(const vector_ref& a, const vector_ref& b)
+{
+    float sum = 0;
+    uint64_t i = 0;
+    uint64_t j = 0;
+    while (i < a.size && j < b.size)
+    {
+        if (a.terms[i] < b.terms[j])
+            ++i;
+        else if (b.terms[j] < a.terms[i])
+            ++j;
+        else
+            sum += a.values[i++] * b.values[j++];
+    }
+    return sum;
+}
+
+uint64_t hnsw_index::max_links(uint64_t level) const
+{
+    return level == 0 ? 2 * m_ : m_;
+}
+
+auto hnsw_index::search_layer(const vector_ref& query,
+                              const std::vector<candidate>& entries,
+                              uint64_t ef, uint64_t level, bool locked) const
+    -> std::vector<candidate>
+{
+    thread_local search_scratch scratch;
+    if (scratch.query.size() < num_terms_)
+        scratch.query.resize(num_terms_);
+    if (scratch.visited.size() < ids_.size())
+        scratch.visited.resize(ids_.size());
+    if (++scratch.epoch == 0)
+    {
+        std::fill(scratch.visited.begin(), scratch.visited.end(), 0);
+        scratch.epoch = 1;
+    }
+
+    // the query is scattered into a dense array so that its similarity to
+    // a node is a gather over the node's terms; the sum is taken in the
+    // same order as similarity() takes it
+    for (uint64_t i = 0; i < query.size; ++i)
+    {
+        if (query.terms[i] < num_terms_)
+            scratch.query[query.terms[i]] = query.values[i];
+    }
+    auto gather = [&](uint32_t node)
+    {
+        auto vec = vector(node);
+        float sum = 0;
+        for (uint64_t i = 0; i < vec.size; ++i)
+            sum += scratch.query[vec.terms[i]] * vec.values[i];
+        return sum;
+    };
+
+    candidate_comparator comp;
+    // the candidates to expand, most similar on top
+    std::priority_queue<candidate, std::vector<candidate>,
+                        reverse_candidate_comparator> to_visit;
+    // the best nodes found so far, least similar on top
+    std::priority_queue<candidate, std::vector<candidate>,
+                        candidate_comparator> found;
+
+    for (const auto& entry : entries)
+    {
+        scratch.visited[entry.second] = scratch.epoch;
+        to_visit.push(entry);
+        found.push(entry);
+        if (found.size() > ef)
+            found.pop();
+    }
+
+    std::vector<uint32_t> neighbors;
+    while (!to_visit.empty())
+    {
+        auto current = to_visit.top();
+        to_visit.pop();
+        if (found.size() == ef && comp(found.top(), current))
+            break;
+
+        if (locked)
+        {
+            std::lock_guard<std::mutex> lock{locks_[current.second]};
+            neighbors = links_[current.second][level];
+        }
+        else
+        {
+            const auto& links = links_[current.second][level];
+            neighbors.assign(links.begin(), links.end());
+        }
+
+        for (const auto& neighbor : neighbors)
+        {
+            if (scratch.visited[neighbor] == scratch.epoch)
+                continue;
+            scratch.visited[neighbor] = scratch.epoch;
+
+            candidate next{gather(neighbor), neighbor};
+            if (found.size() < ef || comp(next, found.top()))
+            {
+                to_visit.push(next);
+                found.push(next);
+                if (found.size() > ef)
+                    found.pop();
+            }
+        }
+    }
+
+    for (uint64_t i = 0; i < query.size; ++i)
+    {
+        if (query.terms[i] < num_terms_)
+            scratch.query[query.terms[i]] = 0;
+    }
+
+    std::vector<candidate> results;
+    results.reserve(found.size());
+    for (; !found.empty(); found.pop())
+        results.push_back(found.top());
+    return results;
+}
+
+std::vector<uint32_t>
+    hnsw_index::select_neighbors(std::vector<candidate>& candidates,
+                                 uint64_t max_size) const
+{
+    std::sort(candidates.begin(), candidates.end(), candidate_comparator{});
+
+    std::vector<uint32_t> selected;
+    for (const auto& cand : candidates)
+    {
+        if (selected.size() == max_size)
+            break;
+
+        auto vec = vector(cand.second);
+        auto diverse = std::none_of(
+            selected.begin(), selected.end(), [&](uint32_t neighbor)
+            {
+                return similarity(vec, vector(neighbor)) > cand.first;
+            });
+        if (diverse)
+            selected.push_back(cand.second);
+    }
+    return selected;
+}
+
+void hnsw_index::insert(uint32_t node)
+{
+    auto level = links_[node].size() - 1;
+    auto query = vector(node);
+
+    // a node that raises the top of the graph holds the entry point until
+    // it is linked in, so no other insertion starts from a node it has not
+    // been linked to
+    std::unique_lock<std::mutex> entry_lock{entry_lock_};
+    auto entry = entry_;
+    auto top = max_level_;
+    if (level <= top)
+        entry_lock.unlock();
+
+    std::vector<candidate> entries{{similarity(query, vector(entry)), entry}};
+    for (auto lvl = top; lvl > level; --lvl)
+        entries = search_layer(query, entries, 1, lvl, true);
+
+    for (auto lvl = std::min(level, top) + 1; lvl-- > 0;)
+    {
+        entries = search_layer(query, entries, ef_construction_, lvl, true);
+        auto candidates = entries;
+        auto neighbors = select_neighbors(candidates, m_);
+        {
+            std::lock_guard<std::mutex> lock{locks_[node]};
+            links_[node][lvl] = neighbors;
+        }
+
+        for (const auto& neighbor : neighbors)
+        {
+            std::lock_guard<std::mutex> lock{locks_[neighbor]};
+            auto& links = links_[neighbor][lvl];
+            links.push_back(node);
+            if (links.size() <= max_links(lvl))
+                continue;
+
+            // too many links: keep the most diverse of them
+            auto base = vector(neighbor);
+            std::vector<candidate> existing;
+            existing.reserve(links.size());
+            for (const auto& link : links)
+                existing.emplace_back(similarity(base, vector(link)), link);
+            links = select_neighbors(existing, max_links(lvl));
+        }
+    }
+
+    if (level > top)
+    {
+        entry_ = node;
+        max_level_ = level;
+    }
+}
+
+std::vector<search_result> hnsw_index::search(const vector_type& query,
+                                              uint64_t k, uint64_t ef) const
+{
+    if (ids_.empty() || k == 0)
+        return {};
+
+    std::vector<uint32_t> terms;
+    std::vector<float> values;
+    terms.reserve(query.size());
+    values.reserve(query.size());
+    double norm = 0;
+    for (const auto& weight : query)
+        norm += weight.second * weight.second;
+    norm = std::sqrt(norm);
+    for (const auto& weight : query)
+    {
+        // terms the index has never seen cannot match anything
+        if (weight.second == 0
+            || weight.first >= std::numeric_limits<uint32_t>::max())
+            continue;
+        terms.push_back(static_cast<uint32_t>(weight.first));
+        values.push_back(static_cast<float>(weight.second / norm));
+    }
+    vector_ref vec{terms.data(), values.data(), terms.size()};
+
+    std::vector<candidate> entries{{similarity(vec, vector(entry_)), entry_}};
+    for (auto lvl = max_level_; lvl > 0; --lvl)
+        entries = search_layer(vec, entries, 1, lvl, false);
+    entries = search_layer(vec, entries, std::max(ef, k), 0, false);
+
+    std::sort(entries.begin(), entries.end(), candidate_comparator{});
+    if (entries.size() > k)
+        entries.resize(k);
+
+    std::vector<search_result> results;
+    results.reserve(entries.size());
+    for (const auto& entry : entries)
+        results.emplace_back(ids_[entry.second], entry.first);
+    return results;
+}
+}
+}
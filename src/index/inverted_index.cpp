@@ -9,8 +9,10 @@
 #include "meta/corpus/corpus_factory.h"
 #include "meta/corpus/metadata_parser.h"
 #include "meta/index/disk_index_impl.h"
+#include "meta/index/in_memory_postings.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/metadata_writer.h"
+#include "meta/index/near_duplicates.h"
 #include "meta/index/postings_file.h"
 #include "meta/index/postings_file_writer.h"
 #include "meta/index/postings_inverter.h"
@@ -19,10 +21,13 @@
 #include "meta/logging/logger.h"
 #include "meta/parallel/thread_pool.h"
 #include "meta/util/mapping.h"
+#include "meta/util/memory.h"
+#include "meta/util/metrics.h"
 #include "meta/util/pimpl.tcc"
 #include "meta/util/printing.h"
 #include "meta/util/progress.h"
 #include "meta/util/shim.h"
+#include "meta/util/time.h"
 
 namespace meta
 {
@@ -51,14 +56,21 @@ class inverted_index::impl
      * @param inverter The postings inverter for this index
      * @param mdata_parser The parser for reading metadata
      * @param mdata_writer The writer for metadata
-     * @param ram_budget The total **estimated** RAM budget
+     * @param ram_budget The total RAM budget, in bytes, for the in-memory
+     * postings chunks
      * @param num_threads The number of threads to tokenize and index docs with
+     * @param clusters The near-duplicate cluster of each document, if
+     * near-duplicate detection is enabled
+     * @param drop_duplicates Whether documents that are near-duplicates
+     * of an earlier document should be left out of the postings
      * @return the number of chunks created
      */
     void tokenize_docs(corpus::corpus& docs,
                        postings_inverter<inverted_index>& inverter,
                        metadata_writer& mdata_writer, uint64_t ram_budget,
-                       uint64_t num_threads);
+                       uint64_t num_threads,
+                       const std::vector<doc_id>* clusters,
+                       bool drop_duplicates);
 
     /**
      * Compresses the large postings file.
@@ -66,22 +78,48 @@ class inverted_index::impl
     void compress(const std::string& filename, uint64_t num_unique_terms);
 
     /**
-     * Loads the postings file.
+     * Loads the postings file, either by mapping it or, if the index is
+     * configured to be in memory, by reading it and the rest of the
+     * lookup structures into RAM.
      */
     void load_postings();
 
+    /**
+     * Sums the lengths of every document, so that total_corpus_terms()
+     * and avg_doc_length() need not write to the index when it is being
+     * searched from several threads.
+     */
+    void count_corpus_terms();
+
     /// The analyzer used to tokenize documents.
     std::unique_ptr<analyzers::analyzer> analyzer_;
 
     util::optional<postings_file<inverted_index::primary_key_type,
                                  inverted_index::secondary_key_type>> postings_;
 
+    /// The postings, if the index is held in RAM
+    util::optional<in_memory_postings<inverted_index::primary_key_type,
+                                      inverted_index::secondary_key_type>>
+        ram_postings_;
+
+    /// Whether the index should be loaded entirely into RAM
+    bool in_memory_;
+
+    /// The number of threads to load an in-memory index with
+    uint64_t load_threads_;
+
     /// the total number of term occurrences in the entire corpus
     uint64_t total_corpus_terms_;
 };
 
 inverted_index::impl::impl(inverted_index* idx, const cpptoml::table& config)
-    : idx_{idx}, analyzer_{analyzers::load(config)}, total_corpus_terms_{0}
+    : idx_{idx},
+      analyzer_{analyzers::load(config)},
+      in_memory_{config.get_as<bool>("index-in-memory").value_or(false)},
+      load_threads_{static_cast<uint64_t>(
+          config.get_as<int64_t>("indexer-num-threads")
+              .value_or(std::thread::hardware_concurrency()))},
+      total_corpus_terms_{0}
 {
     // nothing
 }
@@ -115,6 +153,17 @@ bool inverted_index::valid() const
 void inverted_index::create_index(const cpptoml::table& config,
                                   corpus::corpus& docs)
 {
+    auto dedup_config = config.get_table("near-duplicates");
+    bool drop_duplicates = false;
+    if (dedup_config)
+    {
+        auto action
+            = dedup_config->get_as<std::string>("action").value_or("mark");
+        if (action != "mark" && action != "drop")
+            throw exception{"unknown near-duplicates action: " + action};
+        drop_duplicates = action == "drop";
+    }
+
     if (!filesystem::make_directories(index_name()))
         throw exception{"Unable to create index directory: " + index_name()};
 
@@ -142,18 +191,51 @@ void inverted_index::create_index(const cpptoml::table& config,
                      << max_threads << ENDLG;
     }
 
+    auto first_stage = memory::stages().size();
+    auto schema = docs.schema();
+    util::optional<std::vector<doc_id>> clusters;
+    if (dedup_config)
+    {
+        // signatures are computed in a separate pass over the corpus so
+        // that duplicates are known before any document is inverted
+        memory::stage stage{"near-duplicates"};
+        metrics::scoped_timer timer{metrics::get_timer(
+            "meta_index_stage_seconds{stage=\"near-duplicates\"}")};
+        auto pass = corpus::make_corpus(config);
+        near_duplicate_detector detector{*dedup_config, pass->size()};
+        clusters = find_near_duplicates(*pass, *inv_impl_->analyzer_,
+                                        detector, num_threads);
+
+        uint64_t num_duplicates = 0;
+        for (doc_id d_id{0}; d_id < clusters->size(); ++d_id)
+            num_duplicates += (*clusters)[d_id] != d_id;
+        LOG(info) << "Found " << num_duplicates << " near-duplicate documents"
+                  << (drop_duplicates ? " (dropping)" : "") << ENDLG;
+
+        schema.emplace_back("near-duplicate-of",
+                            corpus::metadata::field_type::UNSIGNED_INT, true);
+    }
+
     postings_inverter<inverted_index> inverter{index_name(), max_writers};
     {
-        metadata_writer mdata_writer{index_name(), docs.size(), docs.schema()};
+        memory::stage stage{"tokenize"};
+        metadata_writer mdata_writer{index_name(), docs.size(), schema};
         uint64_t num_docs = docs.size();
         impl_->load_labels(num_docs);
 
         // RAM budget is given in megabytes
         inv_impl_->tokenize_docs(docs, inverter, mdata_writer,
-                                 ram_budget * 1024 * 1024, num_threads);
+                                 ram_budget * 1024 * 1024, num_threads,
+                                 clusters ? &*clusters : nullptr,
+                                 drop_duplicates);
     }
 
-    inverter.merge_chunks();
+    {
+        memory::stage stage{"merge"};
+        metrics::scoped_timer timer{
+            metrics::get_timer("meta_index_stage_seconds{stage=\"merge\"}")};
+        inverter.merge_chunks();
+    }
 
     LOG(info) << "Created uncompressed postings file " << index_name()
               << impl_->files[POSTINGS] << " ("
@@ -161,8 +243,11 @@ void inverted_index::create_index(const cpptoml::table& config,
               << ENDLG;
 
     uint64_t num_unique_terms = inverter.unique_primary_keys();
-    inv_impl_->compress(index_name() + impl_->files[POSTINGS],
-                        num_unique_terms);
+    {
+        memory::stage stage{"compress"};
+        inv_impl_->compress(index_name() + impl_->files[POSTINGS],
+                            num_unique_terms);
+    }
 
     impl_->load_term_id_mapping();
     impl_->initialize_metadata();
@@ -172,7 +257,10 @@ void inverted_index::create_index(const cpptoml::table& config,
 
     impl_->save_label_id_mapping();
     inv_impl_->load_postings();
+    inv_impl_->count_corpus_terms();
 
+    LOG(info) << "Peak tracked memory by stage:\n"
+              << memory::stage_summary(first_stage) << ENDLG;
     LOG(info) << "Done creating index: " << index_name() << ENDLG;
 }
 
@@ -185,15 +273,26 @@ void inverted_index::load_index()
     impl_->load_label_id_mapping();
     impl_->load_labels();
     inv_impl_->load_postings();
+    inv_impl_->count_corpus_terms();
 }
 
 void inverted_index::impl::tokenize_docs(
     corpus::corpus& docs, postings_inverter<inverted_index>& inverter,
-    metadata_writer& mdata_writer, uint64_t ram_budget, uint64_t num_threads)
+    metadata_writer& mdata_writer, uint64_t ram_budget, uint64_t num_threads,
+    const std::vector<doc_id>* clusters, bool drop_duplicates)
 {
     std::mutex mutex;
     printing::progress progress{" > Tokenizing Docs: ", docs.size()};
 
+    auto& read_time
+        = metrics::get_timer("meta_index_stage_seconds{stage=\"read\"}");
+    auto& analyze_time
+        = metrics::get_timer("meta_index_stage_seconds{stage=\"analyze\"}");
+    auto& invert_time
+        = metrics::get_timer("meta_index_stage_seconds{stage=\"invert\"}");
+    auto& num_docs = metrics::get_counter("meta_index_documents_total");
+    auto& empty_docs = metrics::get_counter("meta_index_empty_documents_total");
+
     auto task = [&](uint64_t ram_budget)
     {
         auto producer = inverter.make_producer(ram_budget);
@@ -207,16 +306,39 @@ void inverted_index::impl::tokenize_docs(
                 if (!docs.has_next())
                     return; // destructor for producer will write
                             // any intermediate chunks
+                metrics::scoped_timer timer{read_time};
                 doc = docs.next();
                 progress(doc->id());
             }
 
-            auto counts = analyzer->analyze<uint64_t>(*doc);
+            num_docs.add();
+            auto mdata = doc->mdata();
+            if (clusters)
+            {
+                auto cluster = (*clusters)[doc->id()];
+                mdata.emplace_back(uint64_t{cluster});
+
+                // a dropped duplicate keeps its id (and its metadata) so
+                // that ids still line up with the corpus, but it is never
+                // analyzed and contributes no postings
+                if (drop_duplicates && cluster != doc->id())
+                {
+                    mdata_writer.write(doc->id(), 0, 0, mdata);
+                    idx_->impl_->set_label(doc->id(), doc->label());
+                    continue;
+                }
+            }
+
+            auto counts = [&]()
+            {
+                metrics::scoped_timer timer{analyze_time};
+                return analyzer->analyze<uint64_t>(*doc);
+            }();
 
             // warn if there is an empty document
             if (counts.empty())
             {
-                std::lock_guard<std::mutex> lock{mutex};
+                empty_docs.add();
                 LOG(progress) << '\n' << ENDLG;
                 LOG(warning) << "Empty document (id = " << doc->id()
                              << ") generated!" << ENDLG;
@@ -229,10 +351,11 @@ void inverted_index::impl::tokenize_docs(
                     return acc + count.second;
                 });
 
-            mdata_writer.write(doc->id(), length, counts.size(), doc->mdata());
+            mdata_writer.write(doc->id(), length, counts.size(), mdata);
             idx_->impl_->set_label(doc->id(), doc->label());
 
             // update chunk
+            metrics::scoped_timer timer{invert_time};
             producer(doc->id(), counts);
         }
     };
@@ -252,6 +375,9 @@ void inverted_index::impl::tokenize_docs(
 void inverted_index::impl::compress(const std::string& filename,
                                     uint64_t num_unique_terms)
 {
+    metrics::scoped_timer timer{
+        metrics::get_timer("meta_index_stage_seconds{stage=\"compress\"}")};
+
     std::string ucfilename{filename + ".uncompressed"};
     filesystem::rename_file(filename, ucfilename);
 
@@ -290,35 +416,49 @@ void inverted_index::impl::compress(const std::string& filename,
 
 void inverted_index::impl::load_postings()
 {
-    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+    auto filename = idx_->index_name() + idx_->impl_->files[POSTINGS];
+    if (!in_memory_)
+    {
+        postings_ = {filename};
+        return;
+    }
+
+    LOG(info) << "Loading index into RAM: " << idx_->index_name() << ENDLG;
+    uint64_t bytes = 0;
+    auto time = common::time([&]()
+    {
+        parallel::thread_pool pool{std::max<uint64_t>(load_threads_, 1)};
+        ram_postings_ = util::nullopt;
+        ram_postings_ = {filename, pool};
+        bytes = ram_postings_->bytes_used()
+                + idx_->impl_->load_ram_tables(pool);
+    });
+    LOG(info) << "Loaded index into RAM (" << printing::bytes_to_units(bytes)
+              << ") in " << time.count() / 1000.0 << " seconds" << ENDLG;
 }
 
 uint64_t inverted_index::term_freq(term_id t_id, doc_id d_id) const
 {
-    auto pdata = search_primary(t_id);
-    return pdata->count(d_id);
+    auto stream = stream_for(t_id);
+    return stream ? stream->find(d_id) : 0;
 }
 
-uint64_t inverted_index::total_corpus_terms()
+void inverted_index::impl::count_corpus_terms()
 {
-    if (inv_impl_->total_corpus_terms_ == 0)
-    {
-        for (auto& id : docs())
-            inv_impl_->total_corpus_terms_ += doc_size(id);
-    }
+    total_corpus_terms_ = 0;
+    for (const auto& id : idx_->docs())
+        total_corpus_terms_ += idx_->doc_size(id);
+}
 
+uint64_t inverted_index::total_corpus_terms()
+{
     return inv_impl_->total_corpus_terms_;
 }
 
 uint64_t inverted_index::total_num_occurences(term_id t_id) const
 {
-    auto pdata = search_primary(t_id);
-
-    double sum = 0;
-    for (auto& c : pdata->counts())
-        sum += c.second;
-
-    return static_cast<uint64_t>(sum);
+    auto stream = stream_for(t_id);
+    return stream ? stream->total_counts() : 0;
 }
 
 float inverted_index::avg_doc_length()
@@ -334,18 +474,23 @@ inverted_index::tokenize(const corpus::document& doc)
 
 uint64_t inverted_index::doc_freq(term_id t_id) const
 {
-    return search_primary(t_id)->counts().size();
+    auto stream = stream_for(t_id);
+    return stream ? stream->size() : 0;
 }
 
 auto inverted_index::search_primary(term_id t_id) const
     -> std::shared_ptr<postings_data_type>
 {
+    if (inv_impl_->ram_postings_)
+        return inv_impl_->ram_postings_->find(t_id);
     return inv_impl_->postings_->find(t_id);
 }
 
 util::optional<postings_stream<doc_id>>
 inverted_index::stream_for(term_id t_id) const
 {
+    if (inv_impl_->ram_postings_)
+        return inv_impl_->ram_postings_->find_stream(t_id);
     return inv_impl_->postings_->find_stream(t_id);
 }
 }
@@ -0,0 +1,274 @@
+/**
+ * @file metadata_column.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "meta/index/metadata_column.h"
+#include "meta/succinct/bit_vector.h"
+
+namespace meta
+{
+namespace index
+{
+
+constexpr uint64_t metadata_column::block_size;
+constexpr uint64_t metadata_column::max_bitmaps;
+
+namespace
+{
+/// the number of uint64_t fields in a column header
+const constexpr uint64_t header_words = 10;
+}
+
+metadata_column::metadata_column(const std::string& filename)
+    : file_{filename}
+{
+    if (file_.size() < header_words * sizeof(uint64_t))
+        throw metadata_column_exception{"corrupt metadata column: "
+                                        + filename};
+
+    auto words = reinterpret_cast<const uint64_t*>(file_.begin());
+    type_ = static_cast<corpus::metadata::field_type>(words[0]);
+    num_docs_ = words[1];
+    width_ = static_cast<uint8_t>(words[2]);
+    base_ = words[3];
+    if (words[4] != block_size)
+        throw metadata_column_exception{"unsupported block size in column: "
+                                        + filename};
+    num_blocks_ = words[5];
+    auto dict_size = words[6];
+    auto dict_bytes = words[7];
+    auto num_bitmaps = words[8];
+    code_words_ = words[9];
+
+    block_stats_ = words + header_words;
+
+    auto dict_start = reinterpret_cast<const char*>(block_stats_
+                                                    + 2 * num_blocks_);
+    dictionary_.reserve(dict_size);
+    for (auto str = dict_start; dictionary_.size() < dict_size;)
+    {
+        dictionary_.emplace_back(str);
+        str += dictionary_.back().size() + 1;
+    }
+
+    auto dict_words = (dict_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    codes_ = reinterpret_cast<const uint64_t*>(dict_start) + dict_words;
+    bitmaps_ = num_bitmaps > 0 ? codes_ + code_words_ : nullptr;
+}
+
+corpus::metadata::field_type metadata_column::type() const
+{
+    return type_;
+}
+
+uint64_t metadata_column::size() const
+{
+    return num_docs_;
+}
+
+uint64_t metadata_column::encode(int64_t value)
+{
+    // flip the sign bit so that negative values sort before positive ones
+    return static_cast<uint64_t>(value) ^ (uint64_t{1} << 63);
+}
+
+uint64_t metadata_column::encode(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(double));
+    // negative values need all of their bits flipped to reverse their
+    // order; positive values just need the sign bit set
+    if (bits >> 63)
+        return ~bits;
+    return bits | (uint64_t{1} << 63);
+}
+
+int64_t metadata_column::decode_signed(uint64_t code)
+{
+    return static_cast<int64_t>(code ^ (uint64_t{1} << 63));
+}
+
+double metadata_column::decode_double(uint64_t code)
+{
+    uint64_t bits = (code >> 63) ? code & ~(uint64_t{1} << 63) : ~code;
+    double value;
+    std::memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+uint64_t metadata_column::code(doc_id d_id) const
+{
+    if (d_id >= num_docs_)
+        throw metadata_column_exception{"invalid doc id in column lookup"};
+
+    if (width_ == 0)
+        return base_;
+
+    succinct::bit_vector_view bvv{{codes_, code_words_}, code_words_ * 64};
+    return base_ + bvv.extract(d_id * width_, width_);
+}
+
+template <>
+int64_t metadata_column::at(doc_id d_id) const
+{
+    check_type(corpus::metadata::field_type::SIGNED_INT);
+    return decode_signed(code(d_id));
+}
+
+template <>
+uint64_t metadata_column::at(doc_id d_id) const
+{
+    check_type(corpus::metadata::field_type::UNSIGNED_INT);
+    return code(d_id);
+}
+
+template <>
+double metadata_column::at(doc_id d_id) const
+{
+    check_type(corpus::metadata::field_type::DOUBLE);
+    return decode_double(code(d_id));
+}
+
+template <>
+util::string_view metadata_column::at(doc_id d_id) const
+{
+    check_type(corpus::metadata::field_type::STRING);
+    return dictionary_[code(d_id)];
+}
+
+doc_bitset metadata_column::range(int64_t lo, int64_t hi) const
+{
+    if (type_ == corpus::metadata::field_type::UNSIGNED_INT)
+    {
+        if (hi < 0)
+            return doc_bitset{num_docs_};
+        return code_range(static_cast<uint64_t>(std::max<int64_t>(lo, 0)),
+                          static_cast<uint64_t>(hi));
+    }
+
+    check_type(corpus::metadata::field_type::SIGNED_INT);
+    return code_range(encode(lo), encode(hi));
+}
+
+doc_bitset metadata_column::range(double lo, double hi) const
+{
+    check_type(corpus::metadata::field_type::DOUBLE);
+    return code_range(encode(lo), encode(hi));
+}
+
+doc_bitset metadata_column::range(util::string_view lo,
+                                  util::string_view hi) const
+{
+    check_type(corpus::metadata::field_type::STRING);
+
+    auto first = lower_bound(lo);
+    auto last = static_cast<uint64_t>(
+        std::upper_bound(dictionary_.begin(), dictionary_.end(), hi)
+        - dictionary_.begin());
+    if (first >= last)
+        return doc_bitset{num_docs_};
+    return code_range(first, last - 1);
+}
+
+doc_bitset metadata_column::equal(util::string_view value) const
+{
+    check_type(corpus::metadata::field_type::STRING);
+
+    doc_bitset docs{num_docs_};
+    auto pos = lower_bound(value);
+    if (pos < dictionary_.size() && dictionary_[pos] == value)
+        add_string(pos, docs);
+    return docs;
+}
+
+doc_bitset metadata_column::any_of(const std::vector<std::string>& values) const
+{
+    check_type(corpus::metadata::field_type::STRING);
+
+    doc_bitset docs{num_docs_};
+    for (const auto& value : values)
+    {
+        auto pos = lower_bound(value);
+        if (pos < dictionary_.size() && dictionary_[pos] == value)
+            add_string(pos, docs);
+    }
+    return docs;
+}
+
+uint64_t metadata_column::lower_bound(util::string_view value) const
+{
+    return static_cast<uint64_t>(
+        std::lower_bound(dictionary_.begin(), dictionary_.end(), value)
+        - dictionary_.begin());
+}
+
+void metadata_column::add_string(uint64_t code, doc_bitset& docs) const
+{
+    if (!bitmaps_)
+    {
+        docs |= code_range(code, code);
+        return;
+    }
+
+    auto& words = docs.words();
+    auto bitmap = bitmaps_ + code * words.size();
+    for (uint64_t i = 0; i < words.size(); ++i)
+        words[i] |= bitmap[i];
+}
+
+doc_bitset metadata_column::code_range(uint64_t lo, uint64_t hi) const
+{
+    doc_bitset docs{num_docs_};
+    if (lo > hi)
+        return docs;
+
+    succinct::bit_vector_view bvv{{codes_, code_words_}, code_words_ * 64};
+    for (uint64_t b = 0; b < num_blocks_; ++b)
+    {
+        auto min = block_stats_[2 * b];
+        auto max = block_stats_[2 * b + 1];
+
+        // the block has nothing in range
+        if (max < lo || min > hi)
+            continue;
+
+        auto first = b * block_size;
+        auto last = std::min(first + block_size, num_docs_);
+
+        // the whole block is in range
+        if (lo <= min && max <= hi)
+        {
+            docs.set(doc_id{first}, doc_id{last});
+            continue;
+        }
+
+        // otherwise, decode the block; a zero-width column never gets
+        // here since all of its blocks have min == max
+        for (auto d = first; d < last; ++d)
+        {
+            auto c = base_ + bvv.extract(d * width_, width_);
+            if (lo <= c && c <= hi)
+                docs.set(doc_id{d});
+        }
+    }
+    return docs;
+}
+
+std::string metadata_column_path(const std::string& prefix, uint64_t field)
+{
+    return prefix + "/metadata.columns/" + std::to_string(field) + ".col";
+}
+
+void metadata_column::check_type(corpus::metadata::field_type type) const
+{
+    if (type != type_)
+        throw metadata_column_exception{
+            "metadata column type does not match requested type"};
+}
+}
+}
@@ -0,0 +1,208 @@
+/**
+ * @file metadata_column_writer.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include "meta/index/metadata_column.h"
+#include "meta/index/metadata_column_writer.h"
+#include "meta/io/binary.h"
+#include "meta/succinct/bit_vector.h"
+#include "meta/succinct/broadword.h"
+
+namespace meta
+{
+namespace index
+{
+
+metadata_column_writer::metadata_column_writer(
+    const std::string& filename, uint64_t field,
+    corpus::metadata::field_type type, uint64_t num_docs)
+    : filename_{filename},
+      field_{field},
+      type_{type},
+      codes_(num_docs),
+      active_{true}
+{
+    // nothing
+}
+
+metadata_column_writer::metadata_column_writer(metadata_column_writer&& other)
+    : filename_{std::move(other.filename_)},
+      field_{other.field_},
+      type_{other.type_},
+      codes_{std::move(other.codes_)},
+      dictionary_{std::move(other.dictionary_)},
+      active_{other.active_}
+{
+    other.active_ = false;
+}
+
+metadata_column_writer& metadata_column_writer::
+operator=(metadata_column_writer&& other)
+{
+    if (this != &other)
+    {
+        if (active_)
+            write();
+        filename_ = std::move(other.filename_);
+        field_ = other.field_;
+        type_ = other.type_;
+        codes_ = std::move(other.codes_);
+        dictionary_ = std::move(other.dictionary_);
+        active_ = other.active_;
+        other.active_ = false;
+    }
+    return *this;
+}
+
+metadata_column_writer::~metadata_column_writer()
+{
+    if (active_)
+        write();
+}
+
+uint64_t metadata_column_writer::field() const
+{
+    return field_;
+}
+
+void metadata_column_writer::insert(doc_id d_id,
+                                    const corpus::metadata::field& fld)
+{
+    if (fld.type != type_)
+        throw corpus::metadata_exception{
+            "schema mismatch when writing metadata column"};
+
+    switch (fld.type)
+    {
+        case corpus::metadata::field_type::SIGNED_INT:
+            codes_[d_id] = metadata_column::encode(fld.sign_int);
+            break;
+
+        case corpus::metadata::field_type::UNSIGNED_INT:
+            codes_[d_id] = fld.usign_int;
+            break;
+
+        case corpus::metadata::field_type::DOUBLE:
+            codes_[d_id] = metadata_column::encode(fld.doub);
+            break;
+
+        case corpus::metadata::field_type::STRING:
+        {
+            auto it = dictionary_.find(fld.str);
+            if (it == dictionary_.end())
+                it = dictionary_.emplace(fld.str, dictionary_.size()).first;
+            codes_[d_id] = it->second;
+            break;
+        }
+    }
+}
+
+void metadata_column_writer::write()
+{
+    active_ = false;
+
+    // sort the dictionary and remap ids so that codes are ordered
+    std::vector<std::string> dict;
+    if (type_ == corpus::metadata::field_type::STRING)
+    {
+        std::vector<std::pair<std::string, uint64_t>> entries(
+            dictionary_.begin(), dictionary_.end());
+        std::sort(entries.begin(), entries.end());
+
+        std::vector<uint64_t> remap(entries.size());
+        dict.reserve(entries.size());
+        for (uint64_t i = 0; i < entries.size(); ++i)
+        {
+            remap[entries[i].second] = i;
+            dict.emplace_back(std::move(entries[i].first));
+        }
+
+        for (auto& code : codes_)
+            code = remap[code];
+    }
+
+    uint64_t base = std::numeric_limits<uint64_t>::max();
+    uint64_t max = 0;
+    for (const auto& code : codes_)
+    {
+        base = std::min(base, code);
+        max = std::max(max, code);
+    }
+    if (codes_.empty())
+        base = 0;
+
+    uint64_t width = max > base ? succinct::broadword::msb(max - base) : 0;
+    uint64_t num_blocks
+        = (codes_.size() + metadata_column::block_size - 1)
+          / metadata_column::block_size;
+    uint64_t dict_bytes = 0;
+    for (const auto& str : dict)
+        dict_bytes += str.size() + 1;
+    uint64_t num_bitmaps
+        = dict.size() <= metadata_column::max_bitmaps ? dict.size() : 0;
+    uint64_t code_words = (codes_.size() * width + 63) / 64;
+
+    std::ofstream out{filename_, std::ios::binary};
+    io::write_binary(out, static_cast<uint64_t>(type_));
+    io::write_binary(out, static_cast<uint64_t>(codes_.size()));
+    io::write_binary(out, width);
+    io::write_binary(out, base);
+    io::write_binary(out, metadata_column::block_size);
+    io::write_binary(out, num_blocks);
+    io::write_binary(out, static_cast<uint64_t>(dict.size()));
+    io::write_binary(out, dict_bytes);
+    io::write_binary(out, num_bitmaps);
+    io::write_binary(out, code_words);
+
+    // zone maps
+    for (uint64_t b = 0; b < num_blocks; ++b)
+    {
+        auto begin = codes_.begin()
+                     + static_cast<std::ptrdiff_t>(
+                           b * metadata_column::block_size);
+        auto end = codes_.begin()
+                   + static_cast<std::ptrdiff_t>(std::min(
+                         (b + 1) * metadata_column::block_size, codes_.size()));
+        auto minmax = std::minmax_element(begin, end);
+        io::write_binary(out, *minmax.first);
+        io::write_binary(out, *minmax.second);
+    }
+
+    for (const auto& str : dict)
+        io::write_binary(out, str);
+    for (uint64_t i = dict_bytes; i % sizeof(uint64_t) != 0; ++i)
+        out.put('\0');
+
+    if (width > 0)
+    {
+        auto builder = succinct::make_bit_vector_builder(out);
+        for (const auto& code : codes_)
+            builder.write_bits({code - base, static_cast<uint8_t>(width)});
+    }
+
+    // build the bitmaps a few values at a time to bound memory usage
+    const uint64_t num_words = (codes_.size() + 63) / 64;
+    const uint64_t group_size = 8;
+    std::vector<uint64_t> bitmaps;
+    for (uint64_t first = 0; first < num_bitmaps; first += group_size)
+    {
+        auto last = std::min(first + group_size, num_bitmaps);
+        bitmaps.assign((last - first) * num_words, 0);
+        for (uint64_t d = 0; d < codes_.size(); ++d)
+        {
+            if (codes_[d] >= first && codes_[d] < last)
+                bitmaps[(codes_[d] - first) * num_words + d / 64]
+                    |= uint64_t{1} << (d % 64);
+        }
+        out.write(reinterpret_cast<const char*>(bitmaps.data()),
+                  static_cast<std::streamsize>(bitmaps.size()
+                                               * sizeof(uint64_t)));
+    }
+}
+}
+}
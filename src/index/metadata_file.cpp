@@ -4,6 +4,7 @@
  */
 
 #include "meta/index/metadata_file.h"
+#include "meta/io/filesystem.h"
 #include "meta/io/packed.h"
 
 namespace meta
@@ -54,6 +55,17 @@ metadata_file::metadata_file(const std::string& prefix)
         info.type = static_cast<corpus::metadata::field_type>(stream.get());
         schema_.emplace_back(std::move(info));
     }
+
+    columns_.resize(schema_.size());
+    for (uint64_t i = 0; i < schema_.size(); ++i)
+    {
+        auto path = metadata_column_path(prefix, i);
+        if (filesystem::file_exists(path))
+        {
+            columns_[i] = metadata_column{path};
+            schema_[i].column = true;
+        }
+    }
 }
 
 corpus::metadata metadata_file::get(doc_id d_id) const
@@ -70,5 +82,31 @@ uint64_t metadata_file::size() const
 {
     return index_.size();
 }
+
+const corpus::metadata::schema_type& metadata_file::schema() const
+{
+    return schema_;
+}
+
+bool metadata_file::has_column(const std::string& name) const
+{
+    for (uint64_t i = 0; i < schema_.size(); ++i)
+    {
+        if (schema_[i].name == name)
+            return static_cast<bool>(columns_[i]);
+    }
+    return false;
+}
+
+const metadata_column& metadata_file::column(const std::string& name) const
+{
+    for (uint64_t i = 0; i < schema_.size(); ++i)
+    {
+        if (schema_[i].name == name && columns_[i])
+            return *columns_[i];
+    }
+    throw corpus::metadata_exception{"no metadata column for field \"" + name
+                                     + "\""};
+}
 }
 }
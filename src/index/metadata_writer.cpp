@@ -3,7 +3,12 @@
  * @author Chase Geigle
  */
 
+#include <limits>
+
 #include "meta/index/metadata_writer.h"
+#include "meta/index/metadata_column.h"
+#include "meta/io/binary.h"
+#include "meta/io/filesystem.h"
 #include "meta/io/packed.h"
 
 namespace meta
@@ -36,44 +41,85 @@ metadata_writer::metadata_writer(const std::string& prefix, uint64_t num_docs,
         byte_pos_ += io::packed::write(db_file_, finfo.name);
         byte_pos_ += io::packed::write(db_file_, finfo.type);
     }
+
+    for (uint64_t i = 0; i < schema_.size(); ++i)
+    {
+        if (!schema_[i].column)
+            continue;
+
+        // columns are numbered by their position in the full schema,
+        // which includes the two mandatory fields
+        if (columns_.empty())
+            filesystem::make_directory(prefix + "/metadata.columns");
+        columns_.emplace_back(metadata_column_path(prefix, i + 2), i + 2,
+                              schema_[i].type, num_docs);
+    }
 }
 
 void metadata_writer::write(doc_id d_id, uint64_t length, uint64_t num_unique,
                             const std::vector<corpus::metadata::field>& mdata)
 {
-    std::lock_guard<std::mutex> lock{lock_};
-
-    seek_pos_[d_id] = byte_pos_;
-    // write "mandatory" metadata
-    byte_pos_ += io::packed::write(db_file_, length);
-    byte_pos_ += io::packed::write(db_file_, num_unique);
-
-    // write optional metadata
     if (mdata.size() != schema_.size())
         throw corpus::metadata_exception{
             "schema mismatch when writing metadata"};
 
+    // encode the fields into a buffer first so that we know the offset of
+    // each one before anything is written to the database
+    const auto num_fields = schema_.size() + 2;
+    row_buffer row{num_fields * sizeof(uint32_t)};
+    std::vector<uint32_t> offsets;
+    offsets.reserve(num_fields);
+
+    // write "mandatory" metadata
+    offsets.push_back(row.offset());
+    io::packed::write(row, length);
+    offsets.push_back(row.offset());
+    io::packed::write(row, num_unique);
+
+    // write optional metadata
     for (const auto& fld : mdata)
     {
+        offsets.push_back(row.offset());
         switch (fld.type)
         {
             case corpus::metadata::field_type::SIGNED_INT:
-                byte_pos_ += io::packed::write(db_file_, fld.sign_int);
+                io::packed::write(row, fld.sign_int);
                 break;
 
             case corpus::metadata::field_type::UNSIGNED_INT:
-                byte_pos_ += io::packed::write(db_file_, fld.usign_int);
+                io::packed::write(row, fld.usign_int);
                 break;
 
             case corpus::metadata::field_type::DOUBLE:
-                byte_pos_ += io::packed::write(db_file_, fld.doub);
+                io::packed::write(row, fld.doub);
                 break;
 
             case corpus::metadata::field_type::STRING:
-                byte_pos_ += io::packed::write(db_file_, fld.str);
+                io::packed::write(row, fld.str);
                 break;
         }
     }
+
+    std::lock_guard<std::mutex> lock{lock_};
+
+    seek_pos_[d_id] = byte_pos_;
+    for (const auto& offset : offsets)
+        byte_pos_ += io::write_binary(db_file_, offset);
+    db_file_.write(row.bytes.data(),
+                   static_cast<std::streamsize>(row.bytes.size()));
+    byte_pos_ += row.bytes.size();
+
+    for (auto& column : columns_)
+        column.insert(d_id, mdata[column.field() - 2]);
+}
+
+uint32_t metadata_writer::row_buffer::offset() const
+{
+    auto off = header_size + bytes.size();
+    if (off > std::numeric_limits<uint32_t>::max())
+        throw corpus::metadata_exception{
+            "metadata for a single document exceeds 4GB"};
+    return static_cast<uint32_t>(off);
 }
 }
 }
@@ -0,0 +1,294 @@
+/**
+ * @file near_duplicates.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include "meta/hashing/hash.h"
+#include "meta/hashing/probe_set.h"
+#include "meta/index/metadata_column.h"
+#include "meta/index/near_duplicates.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/succinct/broadword.h"
+#include "meta/util/progress.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/// Features are hashed with a fixed seed so that signatures (and so
+/// clusters) are the same from run to run
+const constexpr uint64_t feature_seed = 47;
+
+uint64_t hash_feature(const std::string& feature)
+{
+    hashing::farm_hash_seeded hasher{feature_seed};
+    hashing::hash_append(hasher, feature);
+    return static_cast<uint64_t>(hasher);
+}
+}
+
+near_duplicate_detector::near_duplicate_detector(const cpptoml::table& config,
+                                                 uint64_t num_docs)
+    : num_hashes_{static_cast<uint64_t>(
+          config.get_as<int64_t>("num-hashes").value_or(64))},
+      bands_{static_cast<uint64_t>(
+          config.get_as<int64_t>("bands").value_or(16))},
+      threshold_{config.get_as<double>("threshold").value_or(0.8)},
+      max_distance_{static_cast<uint64_t>(
+          config.get_as<int64_t>("max-distance").value_or(3))},
+      max_candidates_{static_cast<uint64_t>(
+          config.get_as<int64_t>("max-candidates").value_or(8))},
+      empty_(num_docs, 0)
+{
+    auto name = config.get_as<std::string>("method").value_or("minhash");
+    if (name == "minhash")
+    {
+        method_ = method::MINHASH;
+        if (num_hashes_ == 0 || bands_ == 0 || num_hashes_ % bands_ != 0)
+            throw near_duplicate_exception{
+                "near-duplicates bands must evenly divide num-hashes"};
+        if (threshold_ <= 0 || threshold_ > 1)
+            throw near_duplicate_exception{
+                "near-duplicates threshold must be on (0,1]"};
+
+        // the i-th minhash function is the top half of a * x + b for an
+        // odd a, which is a universal family over 64-bit feature hashes
+        std::mt19937_64 rng{feature_seed};
+        coefficients_.resize(2 * num_hashes_);
+        for (uint64_t i = 0; i < num_hashes_; ++i)
+        {
+            coefficients_[2 * i] = rng() | 1;
+            coefficients_[2 * i + 1] = rng();
+        }
+        minhashes_.resize(num_docs * num_hashes_);
+    }
+    else if (name == "simhash")
+    {
+        method_ = method::SIMHASH;
+        // by the pigeonhole principle, two fingerprints that differ in at
+        // most max_distance_ bits agree on at least one of
+        // max_distance_ + 1 bands
+        bands_ = max_distance_ + 1;
+        if (bands_ > 64)
+            throw near_duplicate_exception{
+                "near-duplicates max-distance must be less than 64"};
+        simhashes_.resize(num_docs);
+    }
+    else
+    {
+        throw near_duplicate_exception{"unknown near-duplicates method: "
+                                       + name};
+    }
+}
+
+auto near_duplicate_detector::signature_method() const -> method
+{
+    return method_;
+}
+
+void near_duplicate_detector::add(
+    doc_id d_id, const analyzers::feature_map<uint64_t>& counts)
+{
+    if (counts.empty())
+    {
+        empty_[d_id] = 1;
+        return;
+    }
+
+    if (method_ == method::MINHASH)
+    {
+        auto signature = minhashes_.begin() + d_id * num_hashes_;
+        std::fill(signature, signature + num_hashes_,
+                  std::numeric_limits<uint32_t>::max());
+        for (const auto& count : counts)
+        {
+            auto hash = hash_feature(count.key());
+            for (uint64_t i = 0; i < num_hashes_; ++i)
+            {
+                auto h = static_cast<uint32_t>(
+                    (coefficients_[2 * i] * hash + coefficients_[2 * i + 1])
+                    >> 32);
+                signature[i] = std::min(signature[i], h);
+            }
+        }
+        return;
+    }
+
+    // features are weighted equally: weighting them by their counts lets
+    // the most common words decide most of the bits, which makes
+    // unrelated documents look alike
+    int64_t weights[64] = {};
+    for (const auto& count : counts)
+    {
+        auto hash = hash_feature(count.key());
+        for (uint64_t bit = 0; bit < 64; ++bit)
+            weights[bit] += ((hash >> bit) & 1) ? 1 : -1;
+    }
+
+    uint64_t fingerprint = 0;
+    for (uint64_t bit = 0; bit < 64; ++bit)
+    {
+        if (weights[bit] > 0)
+            fingerprint |= uint64_t{1} << bit;
+    }
+    simhashes_[d_id] = fingerprint;
+}
+
+std::vector<uint64_t> near_duplicate_detector::band_keys(doc_id d_id) const
+{
+    std::vector<uint64_t> keys(bands_);
+    if (method_ == method::MINHASH)
+    {
+        auto rows = num_hashes_ / bands_;
+        auto signature = minhashes_.data() + d_id * num_hashes_;
+        for (uint64_t band = 0; band < bands_; ++band)
+        {
+            hashing::farm_hash_seeded hasher{feature_seed};
+            hasher(signature + band * rows, rows * sizeof(uint32_t));
+            keys[band] = static_cast<uint64_t>(hasher);
+        }
+        return keys;
+    }
+
+    auto fingerprint = simhashes_[d_id];
+    for (uint64_t band = 0; band < bands_; ++band)
+    {
+        auto begin = band * 64 / bands_;
+        auto end = (band + 1) * 64 / bands_;
+        auto mask = end - begin == 64 ? ~uint64_t{0}
+                                      : (uint64_t{1} << (end - begin)) - 1;
+        keys[band] = (fingerprint >> begin) & mask;
+    }
+    return keys;
+}
+
+bool near_duplicate_detector::similar(doc_id a, doc_id b) const
+{
+    if (method_ == method::MINHASH)
+    {
+        auto first = minhashes_.data() + a * num_hashes_;
+        auto second = minhashes_.data() + b * num_hashes_;
+        uint64_t matches = 0;
+        for (uint64_t i = 0; i < num_hashes_; ++i)
+            matches += first[i] == second[i];
+        return matches >= threshold_ * num_hashes_;
+    }
+
+    return succinct::broadword::popcount(simhashes_[a] ^ simhashes_[b])
+           <= max_distance_;
+}
+
+std::vector<doc_id> near_duplicate_detector::clusters() const
+{
+    std::vector<doc_id> clusters(empty_.size());
+    std::vector<std::unordered_map<uint64_t, std::vector<doc_id>>> tables(
+        bands_);
+
+    printing::progress progress{" > Clustering near-duplicates: ",
+                                empty_.size()};
+    for (doc_id d_id{0}; d_id < empty_.size(); ++d_id)
+    {
+        progress(d_id);
+        clusters[d_id] = d_id;
+        if (empty_[d_id])
+            continue;
+
+        auto keys = band_keys(d_id);
+        for (uint64_t band = 0; band < bands_ && clusters[d_id] == d_id;
+             ++band)
+        {
+            auto it = tables[band].find(keys[band]);
+            if (it == tables[band].end())
+                continue;
+
+            for (const auto& candidate : it->second)
+            {
+                if (similar(d_id, candidate))
+                {
+                    clusters[d_id] = candidate;
+                    break;
+                }
+            }
+        }
+
+        // only the first few cluster leaders are kept in each bucket, so
+        // every document is compared with a bounded number of candidates
+        if (clusters[d_id] != d_id)
+            continue;
+        for (uint64_t band = 0; band < bands_; ++band)
+        {
+            auto& bucket = tables[band][keys[band]];
+            if (bucket.size() < max_candidates_)
+                bucket.push_back(d_id);
+        }
+    }
+    return clusters;
+}
+
+std::vector<doc_id> find_near_duplicates(corpus::corpus& docs,
+                                         const analyzers::analyzer& analyzer,
+                                         near_duplicate_detector& detector,
+                                         uint64_t num_threads)
+{
+    std::mutex mutex;
+    {
+        printing::progress progress{" > Computing signatures: ", docs.size()};
+        auto task = [&]()
+        {
+            auto local = analyzer.clone();
+            while (true)
+            {
+                util::optional<corpus::document> doc;
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    if (!docs.has_next())
+                        return;
+                    doc = docs.next();
+                    progress(doc->id());
+                }
+                detector.add(doc->id(), local->analyze<uint64_t>(*doc));
+            }
+        };
+
+        num_threads = std::max<uint64_t>(num_threads, 1);
+        parallel::thread_pool pool{num_threads};
+        std::vector<std::future<void>> futures;
+        for (uint64_t i = 0; i < num_threads; ++i)
+            futures.emplace_back(pool.submit_task(task));
+        for (auto& fut : futures)
+            fut.get();
+    }
+    return detector.clusters();
+}
+
+std::vector<search_result>
+    collapse_near_duplicates(const std::vector<search_result>& results,
+                             const metadata_column& clusters,
+                             uint64_t num_results)
+{
+    std::vector<search_result> collapsed;
+    hashing::probe_set<uint64_t> seen;
+    for (const auto& result : results)
+    {
+        if (collapsed.size() == num_results)
+            break;
+
+        auto cluster = clusters.at<uint64_t>(result.d_id);
+        if (seen.find(cluster) != seen.end())
+            continue;
+        seen.emplace(cluster);
+        collapsed.push_back(result);
+    }
+    return collapsed;
+}
+}
+}
@@ -4,19 +4,65 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
 #include <unordered_map>
 #include "meta/corpus/document.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/postings_data.h"
 #include "meta/index/ranker/ranker.h"
 #include "meta/index/score_data.h"
+#include "meta/succinct/broadword.h"
 #include "meta/util/fixed_heap.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
 namespace index
 {
 
+namespace
+{
+/**
+ * Scratch space for term-at-a-time evaluation of one block of documents.
+ * Blocks are small enough to stay in cache, and the space is kept per
+ * thread so it is not allocated per query.
+ */
+struct accumulators
+{
+    /// The number of documents in a block
+    const static constexpr uint64_t block_size = 4096;
+
+    /// The partial score of each document
+    float scores[block_size];
+
+    /// The length of each document
+    uint64_t doc_sizes[block_size];
+
+    /// The number of unique terms in each document
+    uint64_t unique_terms[block_size];
+
+    /// One bit per document: whether it has been scored
+    uint64_t touched[block_size / 64];
+};
+
+/**
+ * Orders search results by score for a min-heap.
+ */
+struct result_comparator
+{
+    bool operator()(const search_result& a, const search_result& b) const
+    {
+        // comparison is reversed since we want a min-heap
+        return a.score > b.score;
+    }
+};
+
+using result_heap = util::fixed_heap<search_result, result_comparator>;
+}
+
+const constexpr uint64_t accumulators::block_size;
+const constexpr uint64_t ranker::max_term_at_a_time_terms;
+
 std::vector<search_result>
     ranker::score(inverted_index& idx, const corpus::document& query,
                   uint64_t num_results /* = 10 */,
@@ -26,21 +72,152 @@ std::vector<search_result>
     return score(idx, counts.begin(), counts.end(), num_results, filter);
 }
 
+void ranker::strategy(evaluation_strategy strategy)
+{
+    strategy_ = strategy;
+}
+
+evaluation_strategy ranker::strategy() const
+{
+    return strategy_;
+}
+
 std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
                                         uint64_t num_results,
                                         const filter_function_type& filter)
 {
+    static auto& score_time
+        = metrics::get_timer("meta_query_stage_seconds{stage=\"score\"}");
+    static auto& num_queries = metrics::get_counter("meta_queries_total");
+    static auto& num_term_at_a_time
+        = metrics::get_counter("meta_queries_term_at_a_time_total");
+    metrics::scoped_timer timer{score_time};
+    num_queries.add();
+
+    bool term_at_a_time = strategy_ == evaluation_strategy::TERM_AT_A_TIME
+                          || (strategy_ == evaluation_strategy::AUTOMATIC
+                              && prefer_term_at_a_time(ctx));
+    if (term_at_a_time)
+    {
+        num_term_at_a_time.add();
+        return rank_terms(ctx, num_results, filter);
+    }
+    return rank_documents(ctx, num_results, filter);
+}
+
+bool ranker::prefer_term_at_a_time(const detail::ranker_context& ctx)
+{
+    if (ctx.postings.empty()
+        || ctx.postings.size() > max_term_at_a_time_terms)
+        return false;
+
+    // merging visits every list for every document it scores, while
+    // accumulating touches each posting once but then has to scan a
+    // word of bits per 64 documents to find the ones that were scored
+    uint64_t total_postings = 0;
+    for (const auto& pc : ctx.postings)
+        total_postings += pc.doc_count;
+    auto merge_cost = total_postings * ctx.postings.size();
+    auto accumulate_cost = total_postings + ctx.idx.num_docs() / 64;
+    return accumulate_cost < merge_cost;
+}
+
+std::vector<search_result>
+    ranker::rank_terms(detail::ranker_context& ctx, uint64_t num_results,
+                       const filter_function_type& filter)
+{
+    static auto& num_postings
+        = metrics::get_counter("meta_query_postings_decoded_total");
+    thread_local accumulators acc;
+    std::fill(std::begin(acc.touched), std::end(acc.touched), 0);
+
     score_data sd{ctx.idx, ctx.idx.avg_doc_length(), ctx.idx.num_docs(),
                   ctx.idx.total_corpus_terms(), ctx.query_length};
+    result_heap results{num_results, result_comparator{}};
 
-    auto comp = [](const search_result& a, const search_result& b)
+    // the lists are accumulated one block of documents at a time, so that
+    // the scores (and the document lengths needed to compute them) stay
+    // in cache
+    uint64_t postings_decoded = 0;
+    while (ctx.cur_doc < ctx.idx.num_docs())
     {
-        // comparison is reversed since we want a min-heap
-        return a.score > b.score;
-    };
-    util::fixed_heap<search_result, decltype(comp)> results{num_results, comp};
+        uint64_t block_start
+            = ctx.cur_doc - ctx.cur_doc % accumulators::block_size;
+        uint64_t block_end = block_start + accumulators::block_size;
+
+        // each document's score is added up in the same order that
+        // rank_documents() uses, so the scores are bit-for-bit identical
+        doc_id next_doc{ctx.idx.num_docs()};
+        for (auto& pc : ctx.postings)
+        {
+            sd.t_id = pc.t_id;
+            sd.query_term_weight = pc.query_term_weight;
+            sd.doc_count = pc.doc_count;
+            sd.corpus_term_count = pc.corpus_term_count;
+
+            for (; pc.begin != pc.end && pc.begin->first < block_end;
+                 ++postings_decoded)
+            {
+                sd.d_id = pc.begin->first;
+                auto i = sd.d_id - block_start;
+                auto bit = uint64_t{1} << (i % 64);
+                if (!(acc.touched[i / 64] & bit))
+                {
+                    acc.touched[i / 64] |= bit;
+                    acc.doc_sizes[i] = ctx.idx.doc_size(sd.d_id);
+                    acc.unique_terms[i] = ctx.idx.unique_terms(sd.d_id);
+                    sd.doc_size = acc.doc_sizes[i];
+                    sd.doc_unique_terms = acc.unique_terms[i];
+                    acc.scores[i] = initial_score(sd);
+                }
+                sd.doc_size = acc.doc_sizes[i];
+                sd.doc_unique_terms = acc.unique_terms[i];
+                sd.doc_term_count = pc.begin->second;
+                acc.scores[i] += score_one(sd);
+
+                do
+                {
+                    ++pc.begin;
+                } while (pc.begin != pc.end && !filter(pc.begin->first));
+            }
+
+            if (pc.begin != pc.end && pc.begin->first < next_doc)
+                next_doc = pc.begin->first;
+        }
+
+        // documents are offered to the heap in increasing id order, just
+        // like rank_documents() does, so ties are broken the same way;
+        // whole words of unscored documents are skipped at once
+        for (uint64_t w = 0; w < accumulators::block_size / 64; ++w)
+        {
+            for (auto word = acc.touched[w]; word != 0; word &= word - 1)
+            {
+                auto i = w * 64 + succinct::broadword::lsb(word);
+                results.emplace(doc_id{block_start + i}, acc.scores[i]);
+            }
+            acc.touched[w] = 0;
+        }
+        ctx.cur_doc = next_doc;
+    }
+
+    num_postings.add(postings_decoded);
+    return results.extract_top();
+}
+
+std::vector<search_result>
+    ranker::rank_documents(detail::ranker_context& ctx, uint64_t num_results,
+                           const filter_function_type& filter)
+{
+    static auto& num_postings
+        = metrics::get_counter("meta_query_postings_decoded_total");
+
+    score_data sd{ctx.idx, ctx.idx.avg_doc_length(), ctx.idx.num_docs(),
+                  ctx.idx.total_corpus_terms(), ctx.query_length};
+
+    result_heap results{num_results, result_comparator{}};
 
     doc_id next_doc{ctx.idx.num_docs()};
+    uint64_t postings_decoded = 0;
     while (ctx.cur_doc < ctx.idx.num_docs())
     {
         sd.d_id = ctx.cur_doc;
@@ -63,6 +240,7 @@ std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
                 sd.doc_term_count = pc.begin->second;
 
                 score += score_one(sd);
+                ++postings_decoded;
 
                 // advance over this position in the current postings context
                 // until the next valid document
@@ -86,6 +264,7 @@ std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
         next_doc = doc_id{ctx.idx.num_docs()};
     }
 
+    num_postings.add(postings_decoded);
     return results.extract_top();
 }
 
@@ -0,0 +1,425 @@
+/**
+ * @file similarity_join.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+
+#include "meta/index/similarity_join.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/fixed_heap.h"
+#include "meta/util/metrics.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Orders neighbors from most to least similar, breaking ties by id so
+ * that the neighbor lists do not depend on the order pairs are found in.
+ */
+struct neighbor_comparator
+{
+    bool operator()(const search_result& a, const search_result& b) const
+    {
+        return a.score > b.score || (a.score == b.score && a.d_id < b.d_id);
+    }
+};
+
+/**
+ * The normalized document vectors, stored back to back. Features are
+ * numbered by rank (0 is the most frequent) and sorted within each
+ * document, so every vector starts with its most common features.
+ */
+struct doc_vectors
+{
+    /// Where each document's features begin (plus one past the end)
+    std::vector<uint64_t> offsets;
+
+    /// The rank of each feature
+    std::vector<uint32_t> features;
+
+    /// The weight of each feature
+    std::vector<float> weights;
+
+    /// Where each document's indexed suffix begins
+    std::vector<uint64_t> splits;
+
+    /// The most each document's unindexed prefix can add to a dot product
+    std::vector<float> prefix_bounds;
+
+    /// The largest weight in each document
+    std::vector<float> max_weights;
+};
+
+/**
+ * Reads, weights, and normalizes every document vector, and splits each
+ * into an unindexed prefix and an indexed suffix.
+ */
+doc_vectors load_vectors(forward_index& idx,
+                         const similarity_join_options& options,
+                         parallel::thread_pool& pool)
+{
+    auto num_docs = idx.num_docs();
+    if (idx.unique_terms() > std::numeric_limits<uint32_t>::max())
+        throw similarity_join_exception{"too many features to join"};
+
+    doc_vectors vecs;
+    vecs.offsets.resize(num_docs + 1);
+    parallel::parallel_blocks(num_docs, pool, [&](uint64_t begin, uint64_t end)
+                              {
+                                  for (doc_id d_id{begin}; d_id < end; ++d_id)
+                                  {
+                                      auto stream = idx.stream_for(d_id);
+                                      vecs.offsets[d_id + 1]
+                                          = stream ? stream->size() : 0;
+                                  }
+                              });
+    std::partial_sum(vecs.offsets.begin(), vecs.offsets.end(),
+                     vecs.offsets.begin());
+
+    auto nnz = vecs.offsets.back();
+    vecs.features.resize(nnz);
+    vecs.weights.resize(nnz);
+    std::vector<double> lengths(num_docs);
+    parallel::parallel_blocks(
+        num_docs, pool, [&](uint64_t begin, uint64_t end)
+        {
+            for (doc_id d_id{begin}; d_id < end; ++d_id)
+            {
+                auto stream = idx.stream_for(d_id);
+                if (!stream)
+                    continue;
+                auto pos = vecs.offsets[d_id];
+                for (const auto& count : *stream)
+                {
+                    vecs.features[pos] = static_cast<uint32_t>(count.first);
+                    vecs.weights[pos] = static_cast<float>(count.second);
+                    lengths[d_id] += count.second;
+                    ++pos;
+                }
+            }
+        });
+
+    // rank the features from most to least frequent, so that the common
+    // features end up in the unindexed prefixes and the inverted lists
+    // are short
+    std::vector<uint64_t> doc_freqs(idx.unique_terms());
+    for (const auto& feature : vecs.features)
+        ++doc_freqs[feature];
+    std::vector<uint32_t> by_freq(doc_freqs.size());
+    std::iota(by_freq.begin(), by_freq.end(), 0);
+    std::stable_sort(by_freq.begin(), by_freq.end(),
+                     [&](uint32_t a, uint32_t b)
+                     {
+                         return doc_freqs[a] > doc_freqs[b];
+                     });
+    std::vector<uint32_t> ranks(doc_freqs.size());
+    for (uint32_t rank = 0; rank < by_freq.size(); ++rank)
+        ranks[by_freq[rank]] = rank;
+
+    auto avg_length = num_docs == 0
+                          ? 0.0
+                          : std::accumulate(lengths.begin(), lengths.end(), 0.0)
+                                / num_docs;
+    auto weight = [&](uint32_t feature, double value, double length)
+    {
+        auto df = static_cast<double>(doc_freqs[feature]);
+        switch (options.weights)
+        {
+            case similarity_join_options::weighting::TF_IDF:
+                return std::log(1.0 + value) * std::log(1.0 + num_docs / df);
+            case similarity_join_options::weighting::BM25:
+            {
+                auto idf = std::log(1.0 + (num_docs - df + 0.5) / (df + 0.5));
+                auto norm = options.k1
+                            * (1.0 - options.b
+                               + options.b * length / avg_length);
+                return idf * (options.k1 + 1.0) * value / (value + norm);
+            }
+            default:
+                return value;
+        }
+    };
+
+    parallel::parallel_blocks(
+        num_docs, pool, [&](uint64_t begin, uint64_t end)
+        {
+            std::vector<std::pair<uint32_t, float>> entries;
+            for (doc_id d_id{begin}; d_id < end; ++d_id)
+            {
+                entries.clear();
+                double norm = 0;
+                for (auto i = vecs.offsets[d_id]; i < vecs.offsets[d_id + 1];
+                     ++i)
+                {
+                    auto w = weight(vecs.features[i], vecs.weights[i],
+                                    lengths[d_id]);
+                    // the filtering bounds assume no pair of features can
+                    // lower a dot product
+                    if (w < 0)
+                        throw similarity_join_exception{
+                            "similarity join requires non-negative weights"};
+                    entries.emplace_back(ranks[vecs.features[i]],
+                                         static_cast<float>(w));
+                    norm += w * w;
+                }
+                std::sort(entries.begin(), entries.end());
+                norm = std::sqrt(norm);
+
+                auto pos = vecs.offsets[d_id];
+                for (const auto& entry : entries)
+                {
+                    vecs.features[pos] = entry.first;
+                    vecs.weights[pos] = static_cast<float>(
+                        norm > 0 ? entry.second / norm : 0.0);
+                    ++pos;
+                }
+            }
+        });
+
+    std::vector<float> max_weights(doc_freqs.size());
+    for (uint64_t i = 0; i < nnz; ++i)
+        max_weights[vecs.features[i]]
+            = std::max(max_weights[vecs.features[i]], vecs.weights[i]);
+
+    // the prefix stays unindexed for as long as the most it could add to
+    // a dot product is below the threshold: that is at most its norm, and
+    // at most its dot product with the largest weight of every feature
+    vecs.splits.resize(num_docs);
+    vecs.prefix_bounds.resize(num_docs);
+    vecs.max_weights.resize(num_docs);
+    parallel::parallel_blocks(
+        num_docs, pool, [&](uint64_t begin, uint64_t end)
+        {
+            for (doc_id d_id{begin}; d_id < end; ++d_id)
+            {
+                auto first = vecs.offsets[d_id];
+                auto last = vecs.offsets[d_id + 1];
+                vecs.splits[d_id] = first;
+                vecs.prefix_bounds[d_id] = 0;
+                if (first < last)
+                    vecs.max_weights[d_id]
+                        = *std::max_element(vecs.weights.begin() + first,
+                                            vecs.weights.begin() + last);
+
+                double squares = 0;
+                double max_dot = 0;
+                for (auto i = first; i < last; ++i)
+                {
+                    double w = vecs.weights[i];
+                    squares += w * w;
+                    max_dot += w * max_weights[vecs.features[i]];
+                    auto bound = std::min(std::sqrt(squares), max_dot);
+                    if (bound >= options.threshold)
+                        break;
+                    vecs.splits[d_id] = i + 1;
+                    vecs.prefix_bounds[d_id] = static_cast<float>(bound);
+                }
+
+                // if rounding kept the whole vector under the threshold,
+                // index everything rather than lose the document
+                if (vecs.splits[d_id] == last)
+                {
+                    vecs.splits[d_id] = first;
+                    vecs.prefix_bounds[d_id] = 0;
+                }
+            }
+        });
+
+    return vecs;
+}
+
+/**
+ * An inverted index over the indexed suffixes of the document vectors.
+ * Each list is sorted by document id.
+ */
+struct suffix_index
+{
+    suffix_index(const doc_vectors& vecs, uint64_t num_features)
+        : offsets(num_features + 1, 0)
+    {
+        auto num_docs = vecs.splits.size();
+        for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        {
+            for (auto i = vecs.splits[d_id]; i < vecs.offsets[d_id + 1]; ++i)
+                ++offsets[vecs.features[i] + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        postings.resize(offsets.back());
+        std::vector<uint64_t> pos(offsets.begin(), offsets.end() - 1);
+        for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        {
+            for (auto i = vecs.splits[d_id]; i < vecs.offsets[d_id + 1]; ++i)
+                postings[pos[vecs.features[i]]++]
+                    = {d_id, vecs.weights[i]};
+        }
+    }
+
+    /// Where each feature's list begins (plus one past the end)
+    std::vector<uint64_t> offsets;
+
+    /// The documents containing each feature in their suffix
+    std::vector<std::pair<doc_id, float>> postings;
+};
+}
+
+std::vector<std::vector<search_result>>
+    similarity_join(forward_index& idx, const similarity_join_options& options)
+{
+    if (options.threshold <= 0 || options.threshold > 1)
+        throw similarity_join_exception{
+            "similarity join threshold must be on (0,1]"};
+    if (options.k == 0)
+        throw similarity_join_exception{"similarity join k must be positive"};
+
+    static auto& num_candidates
+        = metrics::get_counter("meta_similarity_join_candidates_total");
+    static auto& num_verified
+        = metrics::get_counter("meta_similarity_join_verified_total");
+
+    auto num_docs = idx.num_docs();
+    parallel::thread_pool pool{std::max<uint64_t>(options.num_threads, 1)};
+    auto vecs = load_vectors(idx, options, pool);
+    suffix_index index{vecs, idx.unique_terms()};
+
+    using heap_type = util::fixed_heap<search_result, neighbor_comparator>;
+    std::vector<heap_type> heaps;
+    heaps.reserve(num_docs);
+    for (uint64_t i = 0; i < num_docs; ++i)
+        heaps.emplace_back(options.k, neighbor_comparator{});
+    std::vector<std::mutex> locks(1024);
+    auto add_neighbor = [&](doc_id d_id, doc_id neighbor, float score)
+    {
+        std::lock_guard<std::mutex> lock{locks[d_id % locks.size()]};
+        heaps[d_id].emplace(neighbor, score);
+    };
+
+    // each document is joined with the documents before it, so every
+    // pair is found once; the work is handed out in small chunks since
+    // later documents have more to compare against
+    const uint64_t chunk_size = 64;
+    std::atomic<uint64_t> next_chunk{0};
+    auto task = [&]()
+    {
+        std::vector<float> scores(num_docs);
+        std::vector<uint8_t> seen(num_docs);
+        std::vector<doc_id> candidates;
+        uint64_t local_candidates = 0;
+        uint64_t local_verified = 0;
+
+        for (auto chunk = next_chunk++; chunk * chunk_size < num_docs;
+             chunk = next_chunk++)
+        {
+            auto last = std::min(num_docs, (chunk + 1) * chunk_size);
+            for (doc_id x{chunk * chunk_size}; x < last; ++x)
+            {
+                // x's features are visited from the rarest to the most
+                // common: a document first met at a feature shares nothing
+                // with x's rarer features (they would be in its indexed
+                // suffix too), so it can score at most the norm of the
+                // features not yet visited, and once that drops below the
+                // threshold the longest lists are only scanned for
+                // documents that are already candidates
+                //
+                // a unit vector y with |y| features has weights summing to
+                // at most sqrt(|y|), so x and y can only be similar if
+                // max(x) * sqrt(|y|) and max(y) * sqrt(|x|) both reach the
+                // threshold (the length filter)
+                candidates.clear();
+                double x_rest = 1.0;
+                auto x_size = vecs.offsets[x + 1] - vecs.offsets[x];
+                double x_max = vecs.max_weights[x];
+                for (auto i = vecs.offsets[x + 1]; i-- > vecs.offsets[x];)
+                {
+                    auto feature = vecs.features[i];
+                    auto w = vecs.weights[i];
+                    bool admit = std::sqrt(std::max(0.0, x_rest))
+                                 >= options.threshold;
+                    x_rest -= static_cast<double>(w) * w;
+
+                    for (auto p = index.offsets[feature];
+                         p < index.offsets[feature + 1]; ++p)
+                    {
+                        auto y = index.postings[p].first;
+                        if (y >= x)
+                            break;
+                        if (!seen[y])
+                        {
+                            if (!admit)
+                                continue;
+                            double y_size = vecs.offsets[y + 1]
+                                            - vecs.offsets[y];
+                            if (x_max * std::sqrt(y_size) < options.threshold
+                                || vecs.max_weights[y] * std::sqrt(x_size)
+                                       < options.threshold)
+                                continue;
+                            seen[y] = 1;
+                            scores[y] = 0;
+                            candidates.push_back(y);
+                        }
+                        scores[y] += w * index.postings[p].second;
+                    }
+                }
+
+                local_candidates += candidates.size();
+                for (const auto& y : candidates)
+                {
+                    seen[y] = 0;
+                    double score = scores[y];
+                    if (score + vecs.prefix_bounds[y] < options.threshold)
+                        continue;
+
+                    // add in the part of the dot product from y's prefix
+                    ++local_verified;
+                    auto xi = vecs.offsets[x];
+                    auto xend = vecs.offsets[x + 1];
+                    for (auto yi = vecs.offsets[y];
+                         yi < vecs.splits[y] && xi < xend;)
+                    {
+                        if (vecs.features[xi] < vecs.features[yi])
+                            ++xi;
+                        else if (vecs.features[yi] < vecs.features[xi])
+                            ++yi;
+                        else
+                            score += static_cast<double>(vecs.weights[xi++])
+                                     * vecs.weights[yi++];
+                    }
+
+                    if (score >= options.threshold)
+                    {
+                        auto similarity = static_cast<float>(
+                            std::min(score, 1.0));
+                        add_neighbor(x, y, similarity);
+                        add_neighbor(y, x, similarity);
+                    }
+                }
+            }
+        }
+        num_candidates.add(local_candidates);
+        num_verified.add(local_verified);
+    };
+
+    std::vector<std::future<void>> futures;
+    for (uint64_t i = 0; i < std::max<uint64_t>(options.num_threads, 1); ++i)
+        futures.emplace_back(pool.submit_task(task));
+    for (auto& fut : futures)
+        fut.get();
+
+    std::vector<std::vector<search_result>> neighbors(num_docs);
+    for (uint64_t i = 0; i < num_docs; ++i)
+        neighbors[i] = heaps[i].extract_top();
+    return neighbors;
+}
+}
+}
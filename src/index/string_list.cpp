@@ -3,27 +3,180 @@
  * @author Chase Geigle
  */
 
+#include <cstring>
+#include <fstream>
+
 #include "meta/index/string_list.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
 
 namespace meta
 {
 namespace index
 {
 
+namespace
+{
+/**
+ * Reads packed values directly out of the mapped string file.
+ */
+struct string_list_input_stream
+{
+    char get()
+    {
+        return *input_++;
+    }
+
+    const char*& input_;
+};
+}
+
 string_list::string_list(const std::string& path)
-    : string_file_{path}, index_{path + "_index"}
+    : string_file_{path}, index_{path + "_index"}, block_size_{0}
 {
-    // nothing
+    if (filesystem::file_exists(path + "_fc"))
+    {
+        std::ifstream header{path + "_fc", std::ios::binary};
+        io::packed::read(header, block_size_);
+        io::packed::read(header, size_);
+
+        uint64_t has_dictionary;
+        io::packed::read(header, has_dictionary);
+        uint64_t dict_size;
+        io::packed::read(header, dict_size);
+        dictionary_.resize(dict_size);
+        for (auto& prefix : dictionary_)
+            io::packed::read(header, prefix);
+
+        // a list with a dictionary stores a (possibly empty) reference
+        // at the start of every block, so remember that with an empty
+        // entry at position zero
+        if (has_dictionary)
+            dictionary_.insert(dictionary_.begin(), std::string{});
+    }
+    else
+    {
+        size_ = index_.size();
+    }
+}
+
+void string_list::decode(const char*& pos, std::string& str, bool head) const
+{
+    string_list_input_stream stream{pos};
+    if (head)
+    {
+        str.clear();
+        if (!dictionary_.empty())
+        {
+            uint64_t ref;
+            io::packed::read(stream, ref);
+            str = dictionary_.at(ref);
+        }
+    }
+    else
+    {
+        uint64_t lcp;
+        io::packed::read(stream, lcp);
+        str.resize(lcp);
+    }
+
+    auto len = std::strlen(pos);
+    str.append(pos, len);
+    pos += len + 1;
 }
 
 const char* string_list::at(uint64_t idx) const
 {
+    if (block_size_ != 0)
+        throw string_list_exception{
+            "front-coded string lists must be read with decode_at()"};
     return string_file_.begin() + index_[idx];
 }
 
+std::string string_list::decode_at(uint64_t idx) const
+{
+    if (block_size_ == 0)
+        return at(idx);
+
+    if (idx >= size_)
+        throw std::out_of_range{"string list index out of range"};
+
+    std::string str;
+    auto first = idx - idx % block_size_;
+    const char* pos = string_file_.begin() + index_[idx / block_size_];
+    for (auto i = first; i <= idx; ++i)
+        decode(pos, str, i == first);
+    return str;
+}
+
 uint64_t string_list::size() const
 {
-    return index_.size();
+    return size_;
+}
+
+uint64_t string_list::block_size() const
+{
+    return block_size_;
+}
+
+auto string_list::begin() const -> const_iterator
+{
+    return {this, 0};
+}
+
+auto string_list::end() const -> const_iterator
+{
+    return {this, size_};
+}
+
+string_list::const_iterator::const_iterator(const string_list* list,
+                                            uint64_t idx)
+    : list_{list}, idx_{idx}, pos_{nullptr}
+{
+    if (idx_ < list_->size_)
+    {
+        pos_ = list_->string_file_.begin()
+               + (list_->block_size_ == 0 ? list_->index_[idx_]
+                                          : list_->index_[0]);
+        read();
+    }
+}
+
+void string_list::const_iterator::read()
+{
+    if (list_->block_size_ == 0)
+    {
+        str_ = list_->string_file_.begin() + list_->index_[idx_];
+        return;
+    }
+    list_->decode(pos_, str_, idx_ % list_->block_size_ == 0);
+}
+
+const std::string& string_list::const_iterator::operator*() const
+{
+    return str_;
+}
+
+const std::string* string_list::const_iterator::operator->() const
+{
+    return &str_;
+}
+
+auto string_list::const_iterator::operator++() -> const_iterator&
+{
+    if (++idx_ < list_->size_)
+        read();
+    return *this;
+}
+
+bool string_list::const_iterator::operator==(const const_iterator& other) const
+{
+    return list_ == other.list_ && idx_ == other.idx_;
+}
+
+bool string_list::const_iterator::operator!=(const const_iterator& other) const
+{
+    return !(*this == other);
 }
 }
 }
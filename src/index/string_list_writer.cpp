@@ -3,26 +3,159 @@
  * @author Chase Geigle
  */
 
-#include "meta/io/binary.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/index/string_list.h"
 #include "meta/index/string_list_writer.h"
+#include "meta/io/binary.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+#include "meta/util/shim.h"
 
 namespace meta
 {
 namespace index
 {
 
+constexpr uint64_t string_list_writer::default_block_size;
+
+/**
+ * State needed while writing a front-coded list.
+ */
+struct string_list_writer::front_coder
+{
+    /// The largest number of prefixes kept in the dictionary (so that
+    /// every reference fits in a single byte)
+    const static constexpr uint64_t max_dictionary = 127;
+
+    /// The number of blocks whose heads are sampled to pick prefixes
+    const static constexpr uint64_t sample_blocks = 256;
+
+    front_coder(uint64_t num_strings, uint64_t blk_size, bool use_dict)
+        : size{num_strings},
+          block_size{blk_size},
+          sample_size{use_dict ? std::min(num_strings, sample_blocks * blk_size)
+                               : 0}
+    {
+        // nothing
+    }
+
+    /**
+     * Picks the dictionary prefixes from the buffered block heads.
+     */
+    void choose_dictionary();
+
+    /// The number of strings in the list
+    uint64_t size;
+
+    /// The number of strings per block
+    uint64_t block_size;
+
+    /// The number of leading strings to buffer before encoding anything
+    uint64_t sample_size;
+
+    /// The number of strings received within the sample
+    uint64_t sampled = 0;
+
+    /// The index of the next string to be encoded
+    uint64_t next = 0;
+
+    /// Strings that arrived before the ones preceding them
+    std::unordered_map<uint64_t, std::string> pending;
+
+    /// The last string encoded
+    std::string previous;
+
+    /// Common prefixes, longest first
+    std::vector<std::string> dictionary;
+};
+
+constexpr uint64_t string_list_writer::front_coder::max_dictionary;
+constexpr uint64_t string_list_writer::front_coder::sample_blocks;
+
+void string_list_writer::front_coder::choose_dictionary()
+{
+    // candidate prefixes end just after a separator character
+    std::unordered_map<std::string, uint64_t> counts;
+    for (uint64_t idx = 0; idx < sample_size; idx += block_size)
+    {
+        auto it = pending.find(idx);
+        if (it == pending.end())
+            continue;
+        const auto& str = it->second;
+        for (uint64_t i = 3; i < str.size(); ++i)
+        {
+            if (std::string{"/.:_-?=&"}.find(str[i]) != std::string::npos)
+                ++counts[str.substr(0, i + 1)];
+        }
+    }
+
+    // score each prefix by the bytes it would save, counting the byte
+    // used to refer to it
+    std::vector<std::pair<uint64_t, std::string>> scored;
+    for (auto& pr : counts)
+    {
+        if (pr.second < 2)
+            continue;
+        scored.emplace_back(pr.second * (pr.first.size() - 1), pr.first);
+    }
+    std::sort(scored.begin(), scored.end(),
+              [](const std::pair<uint64_t, std::string>& a,
+                 const std::pair<uint64_t, std::string>& b) {
+                  return a.first > b.first
+                         || (a.first == b.first && a.second < b.second);
+              });
+
+    auto num = std::min<uint64_t>(scored.size(), max_dictionary);
+    for (uint64_t i = 0; i < num; ++i)
+        dictionary.push_back(std::move(scored[i].second));
+    std::stable_sort(dictionary.begin(), dictionary.end(),
+                     [](const std::string& a, const std::string& b) {
+                         return a.size() > b.size();
+                     });
+}
+
 string_list_writer::string_list_writer(const std::string& path, uint64_t size)
-    : string_file_{path},
+    : path_{path},
+      string_file_{path},
       write_pos_{0},
       index_{path + "_index", size}
 {
-    // nothing
+    // the reader recognizes a front-coded list by its header file, so one
+    // left over from an earlier list at this path must go (a front-coded
+    // list writes a new one when it finishes)
+    filesystem::delete_file(path + "_fc");
+}
+
+string_list_writer::string_list_writer(const std::string& path, uint64_t size,
+                                       const cpptoml::table& config)
+    : string_list_writer{path, size}
+{
+    if (!config.get_as<bool>("front-coding").value_or(false))
+        return;
+
+    auto block_size = config.get_as<int64_t>("front-coding-block-size")
+                          .value_or(static_cast<int64_t>(default_block_size));
+    if (block_size <= 0)
+        throw string_list_exception{
+            "front-coding-block-size must be positive"};
+    auto blk_size = static_cast<uint64_t>(block_size);
+    auto use_dict = config.get_as<bool>("prefix-dictionary").value_or(false);
+
+    index_ = util::disk_vector<uint64_t>{path + "_index",
+                                         (size + blk_size - 1) / blk_size};
+    coder_ = make_unique<front_coder>(size, blk_size, use_dict);
 }
 
 string_list_writer::string_list_writer(string_list_writer&& other)
-    : string_file_{std::move(other.string_file_)},
+    : path_{std::move(other.path_)},
+      string_file_{std::move(other.string_file_)},
       write_pos_{std::move(other.write_pos_)},
-      index_{std::move(other.index_)}
+      index_{std::move(other.index_)},
+      coder_{std::move(other.coder_)}
 {
     // nothing
 }
@@ -31,19 +164,135 @@ string_list_writer& string_list_writer::operator=(string_list_writer&& other)
 {
     if (this != &other)
     {
+        if (coder_)
+            finish();
+        path_ = std::move(other.path_);
         string_file_ = std::move(other.string_file_);
         write_pos_ = std::move(other.write_pos_);
         index_ = std::move(other.index_);
+        coder_ = std::move(other.coder_);
     }
     return *this;
 }
 
+string_list_writer::~string_list_writer()
+{
+    if (coder_)
+        finish();
+}
+
 void string_list_writer::insert(uint64_t idx, const std::string& elem)
 {
     std::lock_guard<std::mutex> lock{mutex_};
-    index_[idx] = write_pos_;
-    io::write_binary(string_file_, elem);
-    write_pos_ += elem.length() + 1;
+    if (!coder_)
+    {
+        index_[idx] = write_pos_;
+        io::write_binary(string_file_, elem);
+        write_pos_ += elem.length() + 1;
+        return;
+    }
+
+    auto& coder = *coder_;
+    if (idx < coder.next || idx >= coder.size)
+        throw std::out_of_range{"invalid index for string list insert"};
+
+    if (coder.sampled < coder.sample_size)
+    {
+        // hold everything until the sample needed to choose the prefix
+        // dictionary is complete
+        coder.pending[idx] = elem;
+        if (idx < coder.sample_size)
+            ++coder.sampled;
+        if (coder.sampled < coder.sample_size)
+            return;
+        coder.choose_dictionary();
+    }
+    else if (idx != coder.next)
+    {
+        coder.pending[idx] = elem;
+        return;
+    }
+    else
+    {
+        encode(elem);
+    }
+
+    for (auto it = coder.pending.find(coder.next); it != coder.pending.end();
+         it = coder.pending.find(coder.next))
+    {
+        encode(it->second);
+        coder.pending.erase(it);
+    }
+}
+
+void string_list_writer::encode(const std::string& elem)
+{
+    auto& coder = *coder_;
+    auto& out = string_file_.stream();
+
+    if (coder.next % coder.block_size == 0)
+    {
+        index_[coder.next / coder.block_size] = write_pos_;
+
+        uint64_t start = 0;
+        if (coder.sample_size > 0)
+        {
+            uint64_t ref = 0;
+            for (uint64_t i = 0; i < coder.dictionary.size(); ++i)
+            {
+                const auto& prefix = coder.dictionary[i];
+                if (elem.compare(0, prefix.size(), prefix) == 0)
+                {
+                    ref = i + 1;
+                    start = prefix.size();
+                    break;
+                }
+            }
+            write_pos_ += io::packed::write(out, ref);
+        }
+        write_pos_ += io::packed::write(
+            out, util::string_view{elem}.substr(start));
+    }
+    else
+    {
+        const auto& prev = coder.previous;
+        auto len = std::min(prev.size(), elem.size());
+        uint64_t lcp = static_cast<uint64_t>(
+            std::mismatch(prev.begin(), prev.begin() + len, elem.begin()).first
+            - prev.begin());
+        write_pos_ += io::packed::write(out, lcp);
+        write_pos_ += io::packed::write(
+            out, util::string_view{elem}.substr(lcp));
+    }
+
+    coder.previous = elem;
+    ++coder.next;
+}
+
+void string_list_writer::finish()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto& coder = *coder_;
+
+    // a list that never filled its sample still needs its dictionary, and
+    // any strings that were never inserted are written as empty strings
+    if (coder.sampled < coder.sample_size)
+        coder.choose_dictionary();
+    while (coder.next < coder.size)
+    {
+        auto it = coder.pending.find(coder.next);
+        encode(it == coder.pending.end() ? std::string{} : it->second);
+    }
+
+    std::ofstream header{path_ + "_fc", std::ios::binary};
+    io::packed::write(header, coder.block_size);
+    io::packed::write(header, coder.size);
+    io::packed::write(header, static_cast<uint64_t>(coder.sample_size > 0));
+    io::packed::write(header, static_cast<uint64_t>(coder.dictionary.size()));
+    for (const auto& prefix : coder.dictionary)
+        io::packed::write(header, util::string_view{prefix});
+
+    coder_ = nullptr;
 }
 }
 }
@@ -50,6 +50,13 @@ int main(int argc, char* argv[])
     std::string prefix = *config->get_as<std::string>("prefix") + "/"
                          + *config->get_as<std::string>("dataset") + "/";
 
+    // Look up the full-text field once rather than on every result
+    util::optional<corpus::metadata::accessor<util::string_view>>
+        content_field;
+    if (corpus::has_field(idx->metadata_schema(), "content"))
+        content_field = corpus::metadata::accessor<util::string_view>{
+            idx->metadata_schema(), "content"};
+
     std::cout << "Enter a query, or blank to quit." << std::endl << std::endl;
 
     std::string text;
@@ -83,12 +90,11 @@ int main(int argc, char* argv[])
                   + " (score = " + std::to_string(result.score) + ", docid = "
                   + std::to_string(result.d_id) + ")";
             std::cout << output << std::endl;
-            auto mdata = idx->metadata(result.d_id);
-            if (auto content = mdata.get<std::string>("content"))
+            if (content_field)
             {
-                auto len
-                    = std::min(std::string::size_type{77}, content->size());
-                std::cout << content->substr(0, len) << "..." << std::endl
+                auto mdata = idx->metadata(result.d_id);
+                auto content = mdata.get(*content_field);
+                std::cout << content.substr(0, 77) << "..." << std::endl
                           << std::endl;
             }
             if (result_num++ == 5)
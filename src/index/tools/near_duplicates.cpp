@@ -0,0 +1,64 @@
+/**
+ * @file near_duplicates.cpp
+ * @author agent
+ */
+
+#include <iostream>
+#include <thread>
+
+#include "cpptoml.h"
+#include "meta/analyzers/analyzer.h"
+#include "meta/corpus/corpus_factory.h"
+#include "meta/index/near_duplicates.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+
+using namespace meta;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " config.toml" << std::endl;
+        std::cerr << "Prints every document that is a near-duplicate of an "
+                     "earlier document in the corpus, followed by the id of "
+                     "the first document of its cluster. Detection is "
+                     "configured by the [near-duplicates] table."
+                  << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+    auto dedup_config = config->get_table("near-duplicates");
+    if (!dedup_config)
+        dedup_config = cpptoml::make_table();
+
+    auto num_threads = static_cast<uint64_t>(
+        config->get_as<int64_t>("indexer-num-threads")
+            .value_or(std::thread::hardware_concurrency()));
+
+    auto docs = corpus::make_corpus(*config);
+    auto analyzer = analyzers::load(*config);
+    index::near_duplicate_detector detector{*dedup_config, docs->size()};
+    auto clusters
+        = index::find_near_duplicates(*docs, *analyzer, detector, num_threads);
+
+    uint64_t num_duplicates = 0;
+    for (doc_id d_id{0}; d_id < clusters.size(); ++d_id)
+    {
+        if (clusters[d_id] == d_id)
+            continue;
+        ++num_duplicates;
+        std::cout << d_id << "\t" << clusters[d_id] << "\n";
+    }
+
+    LOG(info) << num_duplicates << " of " << clusters.size()
+              << " documents are near-duplicates" << ENDLG;
+    return 0;
+}
@@ -65,6 +65,13 @@ int main(int argc, char* argv[])
                   << ENDLG;
     }
 
+    // Look up the full-text field once rather than on every result
+    util::optional<corpus::metadata::accessor<util::string_view>>
+        content_field;
+    if (corpus::has_field(idx->metadata_schema(), "content"))
+        content_field = corpus::metadata::accessor<util::string_view>{
+            idx->metadata_schema(), "content"};
+
     std::string content;
     auto elapsed_seconds = common::time(
         [&]()
@@ -91,12 +98,11 @@ int main(int argc, char* argv[])
                                   + ", docid = " + std::to_string(result.d_id)
                                   + ")";
                     std::cout << output << std::endl;
-                    auto mdata = idx->metadata(result.d_id);
-                    if (auto content = mdata.get<std::string>("content"))
+                    if (content_field)
                     {
-                        auto len = std::min(std::string::size_type{77},
-                                            content->size());
-                        std::cout << content->substr(0, len) << "..."
+                        auto mdata = idx->metadata(result.d_id);
+                        auto snippet = mdata.get(*content_field);
+                        std::cout << snippet.substr(0, 77) << "..."
                                   << std::endl
                                   << std::endl;
                     }
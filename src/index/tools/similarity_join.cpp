@@ -0,0 +1,78 @@
+/**
+ * @file similarity_join.cpp
+ * @author agent
+ */
+
+#include <iostream>
+
+#include "cpptoml.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/similarity_join.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+
+using namespace meta;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " config.toml" << std::endl;
+        std::cerr << "Prints the most similar documents of every document in "
+                     "the forward index, as tab-separated id:score pairs. "
+                     "The join is configured by the [similarity-join] table "
+                     "(weighting = \"raw\", \"tf-idf\", or \"bm25\", "
+                     "threshold, k)."
+                  << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+    auto join_config = config->get_table("similarity-join");
+    if (!join_config)
+        join_config = cpptoml::make_table();
+
+    index::similarity_join_options options;
+    auto weighting
+        = join_config->get_as<std::string>("weighting").value_or("tf-idf");
+    if (weighting == "raw")
+        options.weights = index::similarity_join_options::weighting::RAW;
+    else if (weighting == "tf-idf")
+        options.weights = index::similarity_join_options::weighting::TF_IDF;
+    else if (weighting == "bm25")
+        options.weights = index::similarity_join_options::weighting::BM25;
+    else
+    {
+        std::cerr << "Unknown weighting: " << weighting << std::endl;
+        return 1;
+    }
+    options.threshold
+        = join_config->get_as<double>("threshold").value_or(options.threshold);
+    options.k = static_cast<uint64_t>(
+        join_config->get_as<int64_t>("k").value_or(options.k));
+
+    auto idx = index::make_index<index::forward_index>(*config);
+    auto neighbors = index::similarity_join(*idx, options);
+
+    uint64_t num_pairs = 0;
+    for (doc_id d_id{0}; d_id < neighbors.size(); ++d_id)
+    {
+        if (neighbors[d_id].empty())
+            continue;
+        std::cout << d_id;
+        for (const auto& result : neighbors[d_id])
+            std::cout << "\t" << result.d_id << ":" << result.score;
+        std::cout << "\n";
+        num_pairs += neighbors[d_id].size();
+    }
+
+    LOG(info) << num_pairs << " neighbors found for " << neighbors.size()
+              << " documents" << ENDLG;
+    return 0;
+}
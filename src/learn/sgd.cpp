@@ -3,18 +3,159 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
 #include <cmath>
+#include <mutex>
 #include <numeric>
+#include <stdexcept>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include "meta/io/packed.h"
 #include "meta/learn/sgd.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/metrics.h"
 
 namespace meta
 {
 namespace learn
 {
 
+const constexpr double sgd_model::default_adam_learning_rate;
+const constexpr std::size_t sgd_model::sync_interval;
+const constexpr std::size_t sgd_model::gradient_chunk_size;
+
+namespace
+{
+/**
+ * Computes the dot product of a sparse vector with a dense array of
+ * weights. With AVX2, the weights of four features are gathered at a
+ * time; otherwise, four independent sums keep the loads from waiting on
+ * one another.
+ */
+double sparse_dot(const feature_vector& x, const double* weights)
+{
+    auto it = x.begin();
+    auto size = x.size();
+    std::size_t i = 0;
+    double result = 0;
+#ifdef __AVX2__
+    static_assert(sizeof(*it) == 2 * sizeof(uint64_t),
+                  "feature pairs must be an id followed by a value");
+    auto sum = _mm256_setzero_pd();
+    for (; i + 4 <= size; i += 4)
+    {
+        // each load holds two (id, value) pairs; unpacking splits the ids
+        // from the values (in the same shuffled order)
+        auto first = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(&it[i]));
+        auto second = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(&it[i + 2]));
+        auto ids = _mm256_unpacklo_epi64(first, second);
+        auto values = _mm256_castsi256_pd(_mm256_unpackhi_epi64(first, second));
+        auto gathered = _mm256_i64gather_pd(weights, ids, sizeof(double));
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(gathered, values));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    double sums[4] = {0, 0, 0, 0};
+    for (; i + 4 <= size; i += 4)
+    {
+        sums[0] += weights[it[i].first] * it[i].second;
+        sums[1] += weights[it[i + 1].first] * it[i + 1].second;
+        sums[2] += weights[it[i + 2].first] * it[i + 2].second;
+        sums[3] += weights[it[i + 3].first] * it[i + 3].second;
+    }
+    result = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#endif
+    for (; i < size; ++i)
+        result += weights[it[i].first] * it[i].second;
+    return result;
+}
+
+/**
+ * Reads a per-feature value that other threads may be updating in
+ * sgd_model::train_parallel(). Hogwild training lets threads race on the
+ * same feature, so while it runs every access to the shared arrays is a
+ * relaxed atomic load or store: an update may still be lost, but no value
+ * is torn and the race is well-defined. On common hardware these compile
+ * to plain loads and stores.
+ */
+double shared_load(const double& value)
+{
+#ifdef __GNUC__
+    double result;
+    __atomic_load(&value, &result, __ATOMIC_RELAXED);
+    return result;
+#else
+    // aligned 8-byte accesses are atomic on the platforms other compilers
+    // target, and volatile keeps them from being split or elided
+    return *static_cast<const volatile double*>(&value);
+#endif
+}
+
+/**
+ * Writes a per-feature value that other threads may be reading in
+ * sgd_model::train_parallel() (see shared_load()).
+ */
+void shared_store(double& value, double new_value)
+{
+#ifdef __GNUC__
+    __atomic_store(&value, &new_value, __ATOMIC_RELAXED);
+#else
+    *static_cast<volatile double*>(&value) = new_value;
+#endif
+}
+
+/**
+ * The sparse dot product for train_parallel(), reading each weight with
+ * shared_load() rather than gathering several at once.
+ */
+double shared_dot(const feature_vector& x, const double* weights)
+{
+    double result = 0;
+    for (const auto& pr : x)
+        result += shared_load(weights[pr.first]) * pr.second;
+    return result;
+}
+
+/**
+ * Applies the cumulative L1 penalty of Tsuruoka, Tsujii, and Ananiadou to
+ * a weight.
+ * @param weight The stored weight
+ * @param penalty The penalty applied to the weight so far; updated
+ * @param u The total penalty every weight could have received so far
+ * @param scale The scale the weight is stored with
+ * @return the penalized weight
+ */
+double apply_l1_penalty(double weight, double& penalty, double u, double scale)
+{
+    auto z = weight * scale;
+    if (z > 0)
+        weight = std::max(0.0, z - (u + penalty)) / scale;
+    else
+        weight = std::min(0.0, z + (u - penalty)) / scale;
+    penalty += (scale * weight) - z;
+    return weight;
+}
+
+/**
+ * Throws if a vector has a feature beyond the end of the weights. Sparse
+ * vectors are sorted, so only the last feature needs to be checked.
+ */
+void check_features(const feature_vector& x, std::size_t num_features)
+{
+    if (!x.empty() && (x.end() - 1)->first >= num_features)
+        throw std::out_of_range{"feature id out of range for sgd_model"};
+}
+}
+
 sgd_model::sgd_model(std::size_t num_features, options_type options)
     : weights_(num_features),
+      scales_(num_features),
+      grad_squared_(num_features),
       scale_{1.0},
       update_scale_{0.0},
       lr_{options.learning_rate},
@@ -22,7 +163,8 @@ sgd_model::sgd_model(std::size_t num_features, options_type options)
       l1_regularization_{options.l1_regularizer},
       t_{0}
 {
-    // nothing
+    if (l1_regularization_ > 0)
+        cumulative_penalty_.resize(num_features);
 }
 
 sgd_model::sgd_model(std::istream& in)
@@ -30,11 +172,13 @@ sgd_model::sgd_model(std::istream& in)
     auto size = io::packed::read<std::size_t>(in);
 
     weights_.resize(size);
-    for (auto& weight_val : weights_)
+    scales_.resize(size);
+    grad_squared_.resize(size);
+    for (std::size_t i = 0; i < size; ++i)
     {
-        io::packed::read(in, weight_val.weight);
-        io::packed::read(in, weight_val.scale);
-        io::packed::read(in, weight_val.grad_squared);
+        io::packed::read(in, weights_[i]);
+        io::packed::read(in, scales_[i]);
+        io::packed::read(in, grad_squared_[i]);
     }
     io::packed::read(in, bias_.weight);
     io::packed::read(in, bias_.grad_squared);
@@ -44,16 +188,19 @@ sgd_model::sgd_model(std::istream& in)
     io::packed::read(in, l2_regularization_);
     io::packed::read(in, l1_regularization_);
     io::packed::read(in, t_);
+
+    if (l1_regularization_ > 0)
+        cumulative_penalty_.resize(size);
 }
 
 void sgd_model::save(std::ostream& out) const
 {
     io::packed::write(out, weights_.size());
-    for (const auto& weight_val : weights_)
+    for (std::size_t i = 0; i < weights_.size(); ++i)
     {
-        io::packed::write(out, weight_val.weight);
-        io::packed::write(out, weight_val.scale);
-        io::packed::write(out, weight_val.grad_squared);
+        io::packed::write(out, weights_[i]);
+        io::packed::write(out, scales_[i]);
+        io::packed::write(out, grad_squared_[i]);
     }
     io::packed::write(out, bias_.weight);
     io::packed::write(out, bias_.grad_squared);
@@ -67,50 +214,61 @@ void sgd_model::save(std::ostream& out) const
 
 double sgd_model::predict(const feature_vector& x) const
 {
-    auto val = scale_ * bias_.weight;
-    for (const auto& pr : x)
-        val += pr.second * scale_ * weights_.at(pr.first).weight;
-    return val;
+    check_features(x, weights_.size());
+    return scale_ * (bias_.weight + sparse_dot(x, weights_.data()));
+}
+
+std::size_t sgd_model::num_features() const
+{
+    return weights_.size();
+}
+
+double sgd_model::weight(std::size_t feature) const
+{
+    return weights_[feature];
+}
+
+double sgd_model::bias() const
+{
+    return bias_.weight;
+}
+
+double sgd_model::scale() const
+{
+    return scale_;
 }
 
 double sgd_model::train_one(const feature_vector& x, double expected_label,
                             const loss::loss_function& loss)
 {
+    static auto& updates = metrics::get_counter("meta_learn_sgd_updates_total");
+    updates.add();
+    check_features(x, weights_.size());
+
     t_ += 1;
 
-    auto predicted = 0.0;
     for (const auto& pr : x)
     {
         auto abs_val = std::abs(pr.second);
-        auto& weight_val = weights_.at(pr.first);
-        if (abs_val > weight_val.scale)
+        auto& scale = scales_[pr.first];
+        if (abs_val > scale)
         {
-            weight_val.weight *= weight_val.scale / abs_val;
-            weight_val.scale = abs_val;
+            weights_[pr.first] *= scale / abs_val;
+            scale = abs_val;
         }
 
-        if (weight_val.scale > 0)
-            update_scale_ += (pr.second * pr.second)
-                             / (weight_val.scale * weight_val.scale);
-
-        predicted += pr.second * scale_ * weight_val.weight;
+        if (scale > 0)
+            update_scale_ += (pr.second * pr.second) / (scale * scale);
     }
 
     // handle the bias (we treat it as always being 1)
     update_scale_ += 1.0;
-    predicted += scale_ * bias_.weight;
+    auto predicted = scale_ * (bias_.weight + sparse_dot(x, weights_.data()));
 
     auto error_derivative = loss.derivative(predicted, expected_label);
     scale_ *= (1.0 - lr_ * l2_regularization_);
 
-    // renormalize if scalar is too small
-    if (scale_ < 1e-10)
-    {
-        for (auto& weight_val : weights_)
-            weight_val.weight *= scale_;
-        bias_.weight *= scale_;
-        scale_ = 1;
-    }
+    renormalize();
 
     auto delta
         = -lr_ * std::sqrt(t_ / update_scale_) * error_derivative / scale_;
@@ -122,17 +280,16 @@ double sgd_model::train_one(const feature_vector& x, double expected_label,
                 continue;
 
             // update using NAG update equation
-            auto& weight_val = weights_.at(pr.first);
-            weight_val.grad_squared
+            auto& grad_squared = grad_squared_[pr.first];
+            grad_squared
                 += error_derivative * error_derivative * pr.second * pr.second;
-            weight_val.weight
-                += delta * 1.0
-                   / (weight_val.scale * std::sqrt(weight_val.grad_squared))
+            weights_[pr.first]
+                += delta * 1.0 / (scales_[pr.first] * std::sqrt(grad_squared))
                    * pr.second;
 
             // handle the L1 penalization
             if (l1_regularization_ > 0)
-                penalize(weight_val);
+                penalize(pr.first, t_);
         }
 
         // handle the bias (we treat it as always being 1)
@@ -143,27 +300,331 @@ double sgd_model::train_one(const feature_vector& x, double expected_label,
     return loss.loss(predicted, expected_label);
 }
 
-void sgd_model::penalize(weight_type& weight_val)
+double sgd_model::train_parallel(const std::vector<example_type>& examples,
+                                 const loss::loss_function& loss,
+                                 parallel::thread_pool& pool)
 {
-    auto u = t_ * lr_ * l1_regularization_;
-    auto z = weight_val.weight * scale_;
-    if (z > 0)
+    static auto& updates = metrics::get_counter("meta_learn_sgd_updates_total");
+
+    auto num_threads = std::max<std::size_t>(pool.thread_ids().size(), 1);
+    auto round_size = num_threads * sync_interval;
+    double total_loss = 0;
+    std::mutex mutex;
+    for (std::size_t first = 0; first < examples.size(); first += round_size)
     {
-        weight_val.weight
-            = std::max(0.0, z - (u + weight_val.cumulative_penalty)) / scale_;
+        auto last = std::min(examples.size(), first + round_size);
+        hogwild_state merged;
+        parallel::parallel_blocks(
+            last - first, pool, [&](uint64_t begin, uint64_t end)
+            {
+                hogwild_state state;
+                for (auto i = first + begin; i < first + end; ++i)
+                    train_shared(*examples[i].first, examples[i].second, loss,
+                                 state);
+
+                std::lock_guard<std::mutex> lock{mutex};
+                merged.t += state.t;
+                merged.update_scale += state.update_scale;
+                merged.bias_weight += state.bias_weight;
+                merged.bias_grad_squared += state.bias_grad_squared;
+                merged.loss += state.loss;
+            });
+
+        // every thread trained against the scale from the start of the
+        // round, so the shrinking for the whole round is applied here
+        t_ += merged.t;
+        update_scale_ += merged.update_scale;
+        bias_.weight += merged.bias_weight;
+        bias_.grad_squared += merged.bias_grad_squared;
+        scale_ *= std::pow(1.0 - lr_ * l2_regularization_,
+                           static_cast<double>(merged.t));
+        renormalize();
+        total_loss += merged.loss;
     }
-    else
+    updates.add(examples.size());
+    return total_loss;
+}
+
+void sgd_model::train_shared(const feature_vector& x, double expected_label,
+                             const loss::loss_function& loss,
+                             hogwild_state& state)
+{
+    // this mirrors train_one(), except that the global state is read from
+    // the last synchronization plus this thread's changes since then, and
+    // the per-feature state is shared with the other threads
+    check_features(x, weights_.size());
+    state.t += 1;
+
+    for (const auto& pr : x)
+    {
+        auto abs_val = std::abs(pr.second);
+        auto scale = shared_load(scales_[pr.first]);
+        if (abs_val > scale)
+        {
+            shared_store(weights_[pr.first],
+                         shared_load(weights_[pr.first]) * scale / abs_val);
+            shared_store(scales_[pr.first], abs_val);
+            scale = abs_val;
+        }
+
+        if (scale > 0)
+            state.update_scale += (pr.second * pr.second) / (scale * scale);
+    }
+
+    state.update_scale += 1.0;
+    auto predicted = scale_ * (bias_.weight + state.bias_weight
+                               + shared_dot(x, weights_.data()));
+
+    auto error_derivative = loss.derivative(predicted, expected_label);
+    auto t = t_ + state.t;
+    auto delta = -lr_ * std::sqrt(t / (update_scale_ + state.update_scale))
+                 * error_derivative / scale_;
+    if (delta != 0.0)
+    {
+        for (const auto& pr : x)
+        {
+            if (pr.second == 0.0)
+                continue;
+
+            auto grad_squared
+                = shared_load(grad_squared_[pr.first])
+                  + error_derivative * error_derivative * pr.second * pr.second;
+            shared_store(grad_squared_[pr.first], grad_squared);
+            auto weight = shared_load(weights_[pr.first])
+                          + delta * 1.0 / (shared_load(scales_[pr.first])
+                                           * std::sqrt(grad_squared))
+                                * pr.second;
+
+            if (l1_regularization_ > 0)
+            {
+                auto penalty = shared_load(cumulative_penalty_[pr.first]);
+                weight = apply_l1_penalty(weight, penalty,
+                                          t * lr_ * l1_regularization_, scale_);
+                shared_store(cumulative_penalty_[pr.first], penalty);
+            }
+            shared_store(weights_[pr.first], weight);
+        }
+
+        state.bias_grad_squared += error_derivative * error_derivative;
+        state.bias_weight
+            += delta * 1.0
+               / std::sqrt(bias_.grad_squared + state.bias_grad_squared);
+    }
+
+    state.loss += loss.loss(predicted, expected_label);
+}
+
+double sgd_model::train_batch(const std::vector<example_type>& batch,
+                              const loss::loss_function& loss,
+                              parallel::thread_pool& pool,
+                              const training_options_type& options)
+{
+    static auto& updates = metrics::get_counter("meta_learn_sgd_updates_total");
+    if (batch.empty())
+        return 0;
+
+    /**
+     * The summed gradient of a feature over part of a batch, and the
+     * largest absolute value the feature took there.
+     */
+    struct feature_gradient
+    {
+        std::size_t id;
+        double gradient;
+        double max_value;
+    };
+
+    /**
+     * The summed gradient of one chunk of the batch, with its features in
+     * increasing order.
+     */
+    struct chunk_gradient
+    {
+        std::vector<feature_gradient> features;
+        double bias = 0;
+        double loss = 0;
+    };
+
+    auto num_chunks
+        = (batch.size() + gradient_chunk_size - 1) / gradient_chunk_size;
+    std::vector<chunk_gradient> chunks(num_chunks);
+    parallel::parallel_blocks(
+        num_chunks, pool, [&](uint64_t begin, uint64_t end)
+        {
+            for (auto c = begin; c < end; ++c)
+            {
+                auto& chunk = chunks[c];
+                auto first = c * gradient_chunk_size;
+                auto last = std::min(batch.size(), first + gradient_chunk_size);
+                for (auto i = first; i < last; ++i)
+                {
+                    const auto& x = *batch[i].first;
+                    check_features(x, weights_.size());
+                    auto predicted
+                        = scale_
+                          * (bias_.weight + sparse_dot(x, weights_.data()));
+                    auto derivative
+                        = loss.derivative(predicted, batch[i].second);
+                    chunk.loss += loss.loss(predicted, batch[i].second);
+                    if (derivative == 0.0)
+                        continue;
+
+                    chunk.bias += derivative;
+                    for (const auto& pr : x)
+                        chunk.features.push_back({pr.first,
+                                                  derivative * pr.second,
+                                                  std::abs(pr.second)});
+                }
+
+                // a stable sort keeps the order in which each feature's
+                // terms are summed fixed
+                auto& features = chunk.features;
+                std::stable_sort(features.begin(), features.end(),
+                                 [](const feature_gradient& a,
+                                    const feature_gradient& b)
+                                 {
+                                     return a.id < b.id;
+                                 });
+                std::size_t size = 0;
+                for (const auto& fg : features)
+                {
+                    if (size > 0 && features[size - 1].id == fg.id)
+                    {
+                        auto& merged = features[size - 1];
+                        merged.gradient += fg.gradient;
+                        merged.max_value = std::max(merged.max_value,
+                                                    fg.max_value);
+                    }
+                    else
+                    {
+                        features[size++] = fg;
+                    }
+                }
+                features.resize(size);
+            }
+        });
+
+    // the chunks are summed in order, so the gradient does not depend on
+    // how they were divided among the threads; the feature scales are
+    // updated as in train_one()
+    if (batch_gradient_.size() != weights_.size())
+        batch_gradient_.assign(weights_.size(), 0.0);
+    std::vector<std::size_t> touched;
+    double bias_gradient = 0;
+    double total_loss = 0;
+    for (const auto& chunk : chunks)
+    {
+        for (const auto& fg : chunk.features)
+        {
+            if (batch_gradient_[fg.id] == 0.0)
+                touched.push_back(fg.id);
+            batch_gradient_[fg.id] += fg.gradient;
+
+            auto& scale = scales_[fg.id];
+            if (fg.max_value > scale)
+            {
+                weights_[fg.id] *= scale / fg.max_value;
+                scale = fg.max_value;
+            }
+        }
+        bias_gradient += chunk.bias;
+        total_loss += chunk.loss;
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    // the objective is the average loss, so the L2 penalty is applied once
+    // per batch rather than once per instance
+    scale_ *= (1.0 - lr_ * l2_regularization_);
+    renormalize();
+
+    batch_steps_ += 1;
+    t_ += batch.size();
+    auto batch_size = static_cast<double>(batch.size());
+    auto adam = options.optimizer == optimizer_type::ADAM;
+    if (adam && first_moments_.size() != weights_.size())
+    {
+        first_moments_.assign(weights_.size(), 0.0);
+        second_moments_.assign(weights_.size(), 0.0);
+    }
+    auto correction1 = 1.0 - std::pow(options.beta1, batch_steps_);
+    auto correction2 = 1.0 - std::pow(options.beta2, batch_steps_);
+
+    // computes the change to an effective weight given its gradient and
+    // optimizer statistics
+    auto step = [&](double gradient, double& first, double& second)
+    {
+        if (adam)
+        {
+            first = options.beta1 * first + (1.0 - options.beta1) * gradient;
+            second = options.beta2 * second
+                     + (1.0 - options.beta2) * gradient * gradient;
+            return -lr_ * (first / correction1)
+                   / (std::sqrt(second / correction2) + options.epsilon);
+        }
+        second += gradient * gradient;
+        return -lr_ * gradient / (std::sqrt(second) + options.epsilon);
+    };
+
+    double unused = 0;
+    for (const auto& feature : touched)
+    {
+        auto gradient = batch_gradient_[feature] / batch_size;
+        batch_gradient_[feature] = 0;
+        if (scales_[feature] == 0.0)
+            continue;
+
+        auto delta = adam ? step(gradient, first_moments_[feature],
+                                 second_moments_[feature])
+                          : step(gradient, unused, grad_squared_[feature]);
+
+        // as in NAG, the step is taken in units of the feature's scale so
+        // that features of very different magnitudes learn equally fast
+        weights_[feature] += delta / (scales_[feature] * scale_);
+
+        if (l1_regularization_ > 0)
+            penalize(feature, batch_steps_);
+    }
+
+    auto gradient = bias_gradient / batch_size;
+    auto delta = adam ? step(gradient, bias_moments_.first,
+                             bias_moments_.second)
+                      : step(gradient, unused, bias_.grad_squared);
+    bias_.weight += delta / scale_;
+
+    updates.add(batch.size());
+    return total_loss;
+}
+
+void sgd_model::penalize(std::size_t feature, std::size_t t)
+{
+    weights_[feature]
+        = apply_l1_penalty(weights_[feature], cumulative_penalty_[feature],
+                           t * lr_ * l1_regularization_, scale_);
+}
+
+void sgd_model::renormalize()
+{
+    if (scale_ < 1e-10)
     {
-        weight_val.weight
-            = std::min(0.0, z + (u - weight_val.cumulative_penalty)) / scale_;
+        for (auto& weight : weights_)
+            weight *= scale_;
+        bias_.weight *= scale_;
+        scale_ = 1;
     }
-    weight_val.cumulative_penalty += (scale_ * weight_val.weight) - z;
 }
 
 void sgd_model::reset()
 {
-    std::fill(weights_.begin(), weights_.end(), weight_type{});
-    bias_ = weight_type{};
+    std::fill(weights_.begin(), weights_.end(), 0.0);
+    std::fill(scales_.begin(), scales_.end(), 0.0);
+    std::fill(grad_squared_.begin(), grad_squared_.end(), 0.0);
+    std::fill(cumulative_penalty_.begin(), cumulative_penalty_.end(), 0.0);
+    first_moments_.clear();
+    second_moments_.clear();
+    batch_steps_ = 0;
+    bias_moments_ = {};
+    bias_ = bias_type{};
     scale_ = 1;
     update_scale_ = 0;
     t_ = 0;
@@ -172,18 +633,74 @@ void sgd_model::reset()
 double sgd_model::l2norm() const
 {
     auto norm = 0.0;
-    for (const auto& w : weights_)
-        norm += scale_ * w.weight * w.weight;
+    for (const auto& weight : weights_)
+        norm += scale_ * weight * weight;
     return norm;
 }
 
 double sgd_model::l1norm() const
 {
     return std::accumulate(weights_.begin(), weights_.end(), 0.0,
-                           [](double accum, const weight_type& w)
+                           [](double accum, double weight)
                            {
-                               return accum + std::abs(w.weight);
+                               return accum + std::abs(weight);
                            });
 }
+
+sgd_model::training_options_type
+    make_training_options(const cpptoml::table& config)
+{
+    sgd_model::training_options_type options;
+
+    if (auto num_threads = config.get_as<int64_t>("num-threads"))
+        options.num_threads
+            = static_cast<std::size_t>(std::max<int64_t>(*num_threads, 1));
+
+    if (auto batch_size = config.get_as<int64_t>("batch-size"))
+    {
+        if (*batch_size < 0)
+            throw sgd_exception{"batch-size must be non-negative"};
+        options.batch_size = static_cast<std::size_t>(*batch_size);
+    }
+
+    if (auto optimizer = config.get_as<std::string>("optimizer"))
+    {
+        if (*optimizer == "adagrad")
+            options.optimizer = sgd_model::optimizer_type::ADAGRAD;
+        else if (*optimizer == "adam")
+            options.optimizer = sgd_model::optimizer_type::ADAM;
+        else
+            throw sgd_exception{"unknown optimizer: " + *optimizer};
+    }
+
+    if (auto beta1 = config.get_as<double>("beta1"))
+        options.beta1 = *beta1;
+
+    if (auto beta2 = config.get_as<double>("beta2"))
+        options.beta2 = *beta2;
+
+    return options;
+}
+
+sgd_model::options_type
+    make_model_options(const cpptoml::table& config,
+                       const sgd_model::training_options_type& training)
+{
+    sgd_model::options_type options;
+
+    if (auto alpha = config.get_as<double>("learning-rate"))
+        options.learning_rate = *alpha;
+    else if (training.batch_size > 0
+             && training.optimizer == sgd_model::optimizer_type::ADAM)
+        options.learning_rate = sgd_model::default_adam_learning_rate;
+
+    if (auto l2_lambda = config.get_as<double>("l2-regularization"))
+        options.l2_regularizer = *l2_lambda;
+
+    if (auto l1_lambda = config.get_as<double>("l1-regularization"))
+        options.l1_regularizer = *l1_lambda;
+
+    return options;
+}
 }
 }
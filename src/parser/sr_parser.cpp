@@ -197,6 +197,7 @@ void sr_parser::train(std::vector<parse_tree>& trees, training_options options)
 
     // update weights to be average over all parameters
     model_.update(for_avg.weights(), -1.0f / total_updates);
+    model_.compile();
 }
 
 auto sr_parser::train_batch(training_batch batch, parallel::thread_pool& pool,
@@ -450,6 +451,7 @@ void sr_parser::load(const std::string& prefix)
     io::gzifstream model{model_file};
     io::packed::read(model, beam_size_);
     model_.load(model);
+    model_.compile();
 }
 }
 }
@@ -18,18 +18,21 @@ const constexpr size_t sgd::default_max_iter;
 sgd::sgd(dataset_view_type docs,
          std::unique_ptr<learn::loss::loss_function> loss,
          learn::sgd_model::options_type options, double gamma, size_t max_iter,
-         bool calibrate)
+         bool calibrate, learn::sgd_model::training_options_type training)
     : model_{docs.total_features(), options},
       gamma_{gamma},
       max_iter_{max_iter},
+      training_{training},
       loss_{std::move(loss)}
 {
     if (calibrate)
     {
-        model_.calibrate(docs, *loss_, [&](const learn::instance& inst)
+        model_.calibrate(docs, *loss_,
+                         [&](const learn::instance& inst)
                          {
                              return docs.label(inst);
-                         });
+                         },
+                         training_);
     }
     train(std::move(docs));
 }
@@ -57,6 +60,17 @@ void sgd::save(std::ostream& out) const
 
 void sgd::train(dataset_view_type docs)
 {
+    if (training_.num_threads > 1 || training_.batch_size > 0)
+    {
+        model_.train_batches(docs,
+                             [&](const learn::instance& inst)
+                             {
+                                 return docs.label(inst);
+                             },
+                             *loss_, training_, gamma_, max_iter_);
+        return;
+    }
+
     size_t t = 0;
     double avg_loss = 0;
     double prev_avg_loss = 0;
@@ -106,16 +120,8 @@ std::unique_ptr<regressor> make_regressor<sgd>(const cpptoml::table& config,
         throw regressor_factory::exception{
             "loss function must be specified for sgd in config"};
 
-    learn::sgd_model::options_type options;
-
-    if (auto alpha = config.get_as<double>("learning-rate"))
-        options.learning_rate = *alpha;
-
-    if (auto l2_lambda = config.get_as<double>("l2-regularization"))
-        options.l2_regularizer = *l2_lambda;
-
-    if (auto l1_lambda = config.get_as<double>("l1-regularization"))
-        options.l1_regularizer = *l1_lambda;
+    auto training_options = learn::make_training_options(config);
+    auto options = learn::make_model_options(config, training_options);
 
     auto gamma = config.get_as<double>("convergence-threshold")
                      .value_or(sgd::default_gamma);
@@ -126,7 +132,7 @@ std::unique_ptr<regressor> make_regressor<sgd>(const cpptoml::table& config,
 
     return make_unique<sgd>(std::move(training),
                             learn::loss::make_loss_function(*loss), options,
-                            gamma, max_iter, calibrate);
+                            gamma, max_iter, calibrate, training_options);
 }
 }
 }
@@ -12,6 +12,7 @@
 #include "meta/sequence/crf/crf.h"
 #include "meta/sequence/crf/scorer.h"
 #include "meta/util/mapping.h"
+#include "meta/util/metrics.h"
 #include "meta/util/optional.h"
 #include "meta/util/progress.h"
 #include "meta/util/time.h"
@@ -342,6 +343,10 @@ double crf::epoch(parameters params, printing::progress& progress,
                   uint64_t iter, const std::vector<uint64_t>& indices,
                   const std::vector<sequence>& examples, scorer& scorer)
 {
+    static auto& epoch_time
+        = metrics::get_timer("meta_sequence_crf_epoch_seconds");
+    metrics::scoped_timer timer{epoch_time};
+
     double sum_loss = 0;
     for (uint64_t i = 0; i < indices.size(); ++i)
     {
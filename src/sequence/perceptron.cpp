@@ -49,6 +49,7 @@ perceptron::perceptron(const std::string& prefix) : perceptron()
     analyzer_.load(prefix);
     io::gzifstream file{prefix + "/tagger.model.gz"};
     model_.load(file);
+    model_.compile();
 }
 
 void perceptron::tag(sequence& seq) const
@@ -133,6 +134,7 @@ void perceptron::train(std::vector<sequence>& sequences,
 
     // update weights to be average over all parameters
     model_.update(for_avg.weights(), -1.0 / total_updates);
+    model_.compile();
 }
 
 void perceptron::save(const std::string& prefix) const
@@ -7,6 +7,7 @@
 #include "meta/index/postings_data.h"
 #include "meta/logging/logger.h"
 #include "meta/topics/lda_cvb.h"
+#include "meta/util/metrics.h"
 #include "meta/util/progress.h"
 
 namespace meta
@@ -40,10 +41,16 @@ lda_cvb::lda_cvb(std::shared_ptr<index::forward_index> idx, uint64_t num_topics,
 void lda_cvb::run(uint64_t num_iters, double convergence)
 {
     initialize();
+    auto& iteration_time = metrics::get_timer(
+        "meta_topics_iteration_seconds{model=\"lda_cvb\"}");
     for (uint64_t i = 0; i < num_iters; ++i)
     {
         std::stringstream ss;
-        double max_change = perform_iteration(i);
+        double max_change;
+        {
+            metrics::scoped_timer timer{iteration_time};
+            max_change = perform_iteration(i);
+        }
         ss << "Iteration " << i + 1
            << " maximum change in gamma: " << max_change;
         std::string spacing(static_cast<std::size_t>(
@@ -73,7 +80,8 @@ void lda_cvb::initialize()
 
         uint64_t i = 0; // i here is the inter-document term id, since we need
                         // to handle each word occurrence separately
-        for (auto& freq : idx_->search_primary(d)->counts())
+        auto stream = idx_->stream_for(d);
+        for (const auto& freq : *stream)
         {
             for (uint64_t count = 0; count < freq.second; ++count)
             {
@@ -110,7 +118,8 @@ double lda_cvb::perform_iteration(uint64_t iter)
         uint64_t i = 0; // term number within document---constructed
                         // so that each occurrence of the same term
                         // can still be assigned a different topic
-        for (auto& freq : idx_->search_primary(d)->counts())
+        auto stream = idx_->stream_for(d);
+        for (const auto& freq : *stream)
         {
             for (uint64_t count = 0; count < freq.second; ++count)
             {
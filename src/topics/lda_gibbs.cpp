@@ -9,6 +9,7 @@
 #include "meta/index/postings_data.h"
 #include "meta/logging/logger.h"
 #include "meta/topics/lda_gibbs.h"
+#include "meta/util/metrics.h"
 #include "meta/util/progress.h"
 
 namespace meta
@@ -54,9 +55,14 @@ void lda_gibbs::run(uint64_t num_iters, double convergence /* = 1e-6 */)
     ss << spacing;
     LOG(progress) << '\r' << ss.str() << '\n' << ENDLG;
 
+    auto& iteration_time = metrics::get_timer(
+        "meta_topics_iteration_seconds{model=\"lda_gibbs\"}");
     for (uint64_t i = 0; i < num_iters; ++i)
     {
-        perform_iteration(i + 1);
+        {
+            metrics::scoped_timer timer{iteration_time};
+            perform_iteration(i + 1);
+        }
         double likelihood_update = corpus_log_likelihood();
         double ratio = std::fabs((likelihood - likelihood_update) / likelihood);
         likelihood = likelihood_update;
@@ -128,7 +134,8 @@ void lda_gibbs::perform_iteration(uint64_t iter, bool init /* = false */)
         uint64_t n = 0; // term number within document---constructed
                         // so that each occurrence of the same term
                         // can still be assigned a different topic
-        for (const auto& freq : idx_->search_primary(i)->counts())
+        auto stream = idx_->stream_for(i);
+        for (const auto& freq : *stream)
         {
             for (uint64_t j = 0; j < freq.second; ++j)
             {
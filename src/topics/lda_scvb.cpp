@@ -52,7 +52,8 @@ void lda_scvb::initialize(std::mt19937& rng)
 
         doc_topic_count_[d].resize(num_topics_);
 
-        for (auto& freq : idx_->search_primary(d)->counts())
+        auto stream = idx_->stream_for(d);
+        for (const auto& freq : *stream)
         {
             double sum = 0;
             std::vector<double> gamma(num_topics_);
@@ -89,7 +90,8 @@ void lda_scvb::perform_iteration(uint64_t iter, const std::vector<doc_id>& docs)
         auto d = docs[j];
         // burn-in phase
         double t = 0;
-        for (const auto& freq : idx_->search_primary(d)->counts())
+        auto stream = idx_->stream_for(d);
+        for (const auto& freq : *stream)
         {
             double sum = 0;
             for (topic_id k{0}; k < num_topics_; ++k)
@@ -112,7 +114,7 @@ void lda_scvb::perform_iteration(uint64_t iter, const std::vector<doc_id>& docs)
         }
 
         // normal phase
-        for (const auto& freq : idx_->search_primary(d)->counts())
+        for (const auto& freq : *stream)
         {
             double sum = 0;
             for (topic_id k{0}; k < num_topics_; ++k)
@@ -51,7 +51,8 @@ void parallel_lda_gibbs::perform_iteration(uint64_t iter,
         size_t n = 0; // term number within document---constructed
                       // so that each occurrence of the same term
                       // can still be assigned a different topic
-        for (const auto& freq : idx_->search_primary(i)->counts())
+        auto stream = idx_->stream_for(i);
+        for (const auto& freq : *stream)
         {
             for (size_t j = 0; j < freq.second; ++j)
             {
@@ -3,10 +3,16 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include <unicode/translit.h>
+#include <unicode/ustring.h>
 
 #include "detail.h"
 #include "meta/utf/transformer.h"
+#include "meta/utf/utf.h"
 #include "meta/util/pimpl.tcc"
 
 namespace meta
@@ -33,13 +39,16 @@ class transformer::impl
             icu_id, UTRANS_FORWARD, status));
         if (!translit_ || !U_SUCCESS(status))
             throw std::runtime_error{"failed to create transformer"};
+        preserves_ascii_ = probe_ascii();
     }
 
     /**
-     * Copy constructs an impl
+     * Copy constructs an impl. The copy starts with an empty cache.
      * @param other The impl to copy
      */
-    impl(const impl& other) : translit_{other.translit_->clone()}
+    impl(const impl& other)
+        : translit_{other.translit_->clone()},
+          preserves_ascii_{other.preserves_ascii_}
     {
         // nothing
     }
@@ -54,16 +63,98 @@ class transformer::impl
      */
     std::string convert(const std::string& str)
     {
-        auto icu_str = icu::UnicodeString::fromUTF8(str);
-        translit_->transliterate(icu_str);
-        return icu_to_u8str(icu_str);
+        if (preserves_ascii_ && is_ascii(str))
+            return str;
+
+        // tokens are Zipf distributed, so most conversions are repeats
+        auto it = cache_.find(str);
+        if (it != cache_.end())
+            return it->second;
+
+        auto result = transliterate(str);
+        if (cache_.size() == max_cache_size)
+            cache_.clear();
+        cache_.emplace(str, result);
+        return result;
     }
 
   private:
+    /// The maximum number of conversions to remember
+    static constexpr std::size_t max_cache_size = 1 << 16;
+
+    /**
+     * Runs the internal Transliterator, reusing the conversion buffers
+     * between calls.
+     * @param str The string to convert
+     * @return the converted string, encoded in utf8
+     */
+    std::string transliterate(const std::string& str)
+    {
+        // a utf8 string never has fewer bytes than its utf16 form has
+        // code units
+        auto capacity = static_cast<int32_t>(str.size());
+        auto buf = buffer_.getBuffer(std::max(capacity, 1));
+        int32_t length = 0;
+        auto status = U_ZERO_ERROR;
+        u_strFromUTF8WithSub(buf, buffer_.getCapacity(), &length, str.data(),
+                             capacity, 0xfffd, nullptr, &status);
+        buffer_.releaseBuffer(U_SUCCESS(status) ? length : 0);
+        if (!U_SUCCESS(status))
+            buffer_ = icu::UnicodeString::fromUTF8(str);
+
+        translit_->transliterate(buffer_);
+
+        std::string result;
+        result.reserve(str.size());
+        buffer_.toUTF8String(result);
+        return result;
+    }
+
+    /**
+     * Determines whether the transliterator leaves ASCII text unchanged
+     * (as, e.g., "Any-Latin; Latin-ASCII" does), in which case ASCII-only
+     * strings can skip ICU entirely. Every printable character is tried
+     * on its own and together, along with some words to catch
+     * context-sensitive rules like title-casing.
+     *
+     * @return whether ASCII input was always left unchanged
+     */
+    bool probe_ascii()
+    {
+        std::vector<std::string> probes
+            = {"hello", "Hello", "HELLO", "hello world", "it's", "e.g.",
+               "a1b2", "  ", "<s>"};
+        std::string printable;
+        for (char c = ' '; c <= '~'; ++c)
+        {
+            printable += c;
+            probes.emplace_back(1, c);
+        }
+        probes.push_back(printable);
+
+        for (const auto& probe : probes)
+        {
+            if (transliterate(probe) != probe)
+                return false;
+        }
+        return true;
+    }
+
     /// A pointer to the internal Transliterator
     std::unique_ptr<icu::Transliterator> translit_;
+
+    /// Whether ASCII-only strings are returned unchanged
+    bool preserves_ascii_;
+
+    /// Buffer for the utf16 form of the string being converted
+    icu::UnicodeString buffer_;
+
+    /// Recent conversions of non-ASCII (or non-preserved) strings
+    std::unordered_map<std::string, std::string> cache_;
 };
 
+constexpr std::size_t transformer::impl::max_cache_size;
+
 transformer::transformer(const std::string& id) : impl_{id}
 {
     icu_handle::get();
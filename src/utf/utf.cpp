@@ -38,6 +38,23 @@ void utf8_append_codepoint(std::string& dest, UChar32 codepoint)
 }
 }
 
+namespace
+{
+/**
+ * Lowercases an ASCII-only string.
+ */
+std::string ascii_tolower(const std::string& str)
+{
+    auto result = str;
+    for (auto& c : result)
+    {
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    return result;
+}
+}
+
 std::string to_utf8(const std::string& str, const std::string& charset)
 {
     icu_handle::get();
@@ -76,6 +93,8 @@ std::u16string to_utf16(const std::string& str)
 
 std::string tolower(const std::string& str)
 {
+    if (is_ascii(str))
+        return ascii_tolower(str);
     return transform(str, [](uint32_t cp)
                      {
                          return u_tolower(static_cast<UChar32>(cp));
@@ -84,6 +103,16 @@ std::string tolower(const std::string& str)
 
 std::string toupper(const std::string& str)
 {
+    if (is_ascii(str))
+    {
+        auto result = str;
+        for (auto& c : result)
+        {
+            if (c >= 'a' && c <= 'z')
+                c = static_cast<char>(c - 'a' + 'A');
+        }
+        return result;
+    }
     return transform(str, [](uint32_t cp)
                      {
                          return u_toupper(static_cast<UChar32>(cp));
@@ -92,6 +121,9 @@ std::string toupper(const std::string& str)
 
 std::string foldcase(const std::string& str)
 {
+    // default case folding maps ASCII exactly as lowercasing does
+    if (is_ascii(str))
+        return ascii_tolower(str);
     return transform(str, [](uint32_t cp)
                      {
                          return u_foldCase(static_cast<UChar32>(cp),
@@ -101,16 +133,24 @@ std::string foldcase(const std::string& str)
 
 bool isalpha(uint32_t codepoint)
 {
+    if (codepoint < 0x80)
+        return (codepoint >= 'a' && codepoint <= 'z')
+               || (codepoint >= 'A' && codepoint <= 'Z');
     return u_isalpha(static_cast<UChar32>(codepoint));
 }
 
 bool isblank(uint32_t codepoint)
 {
+    if (codepoint < 0x80)
+        return codepoint == ' ' || codepoint == '\t';
     return u_isblank(static_cast<UChar32>(codepoint));
 }
 
 uint64_t length(const std::string& str)
 {
+    if (is_ascii(str))
+        return str.size();
+
     const char* s = str.c_str();
     auto length = static_cast<int32_t>(str.length());
     uint64_t count = 0;
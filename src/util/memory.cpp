@@ -0,0 +1,220 @@
+/**
+ * @file memory.cpp
+ * @author agent
+ */
+
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "meta/util/memory.h"
+#include "meta/util/printing.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace memory
+{
+
+namespace
+{
+/**
+ * Raises a high-water mark to at least the given value.
+ */
+void raise(std::atomic<uint64_t>& mark, uint64_t value)
+{
+    auto current = mark.load(std::memory_order_relaxed);
+    while (value > current
+           && !mark.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed))
+    {
+        // current was reloaded; try again
+    }
+}
+
+/**
+ * The global set of categories and recorded stages.
+ */
+struct accounting
+{
+    /// Protects the maps (but not the categories themselves)
+    std::mutex mutex;
+
+    /// The categories, by name
+    std::map<std::string, std::unique_ptr<category>> categories;
+
+    /// The stages that have ended
+    std::vector<stage_usage> stages;
+};
+
+accounting& get_accounting()
+{
+    static accounting acct;
+    return acct;
+}
+}
+
+category::category(std::string name)
+    : name_{std::move(name)}, live_{0}, peak_{0}, stage_peak_{0}
+{
+    // nothing
+}
+
+void category::allocate(uint64_t bytes)
+{
+    auto live = live_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    raise(peak_, live);
+    raise(stage_peak_, live);
+}
+
+void category::deallocate(uint64_t bytes)
+{
+    live_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void category::update(uint64_t old_bytes, uint64_t new_bytes)
+{
+    if (new_bytes > old_bytes)
+        allocate(new_bytes - old_bytes);
+    else
+        deallocate(old_bytes - new_bytes);
+}
+
+const std::string& category::name() const
+{
+    return name_;
+}
+
+uint64_t category::live() const
+{
+    return live_.load(std::memory_order_relaxed);
+}
+
+uint64_t category::peak() const
+{
+    return peak_.load(std::memory_order_relaxed);
+}
+
+uint64_t category::stage_peak() const
+{
+    return stage_peak_.load(std::memory_order_relaxed);
+}
+
+void category::reset_stage_peak()
+{
+    stage_peak_.store(live(), std::memory_order_relaxed);
+}
+
+category& get_category(const std::string& name)
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    auto& cat = acct.categories[name];
+    if (!cat)
+        cat = make_unique<category>(name);
+    return *cat;
+}
+
+uint64_t total_live()
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    uint64_t total = 0;
+    for (const auto& pr : acct.categories)
+        total += pr.second->live();
+    return total;
+}
+
+stage::stage(std::string name) : name_{std::move(name)}
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    for (auto& pr : acct.categories)
+        pr.second->reset_stage_peak();
+}
+
+stage::~stage()
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    stage_usage usage;
+    usage.name = std::move(name_);
+    for (const auto& pr : acct.categories)
+    {
+        auto peak = pr.second->stage_peak();
+        if (peak > 0)
+            usage.peaks.emplace_back(pr.first, peak);
+    }
+    acct.stages.push_back(std::move(usage));
+}
+
+std::vector<stage_usage> stages()
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    return acct.stages;
+}
+
+void clear_stages()
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    acct.stages.clear();
+}
+
+std::string stage_summary(uint64_t first)
+{
+    std::stringstream ss;
+    auto recorded = stages();
+    for (auto i = first; i < recorded.size(); ++i)
+    {
+        const auto& usage = recorded[i];
+        ss << usage.name << ":";
+        if (usage.peaks.empty())
+            ss << " (nothing tracked)";
+        for (const auto& peak : usage.peaks)
+            ss << " " << peak.first << "="
+               << printing::bytes_to_units(static_cast<double>(peak.second));
+        ss << "\n";
+    }
+    return ss.str();
+}
+
+std::string to_json()
+{
+    auto& acct = get_accounting();
+    std::lock_guard<std::mutex> lock{acct.mutex};
+    std::stringstream ss;
+    ss << "{\"categories\":{";
+    bool first = true;
+    for (const auto& pr : acct.categories)
+    {
+        if (!first)
+            ss << ",";
+        first = false;
+        ss << "\"" << pr.first << "\":{\"live\":" << pr.second->live()
+           << ",\"peak\":" << pr.second->peak() << "}";
+    }
+
+    ss << "},\"stages\":[";
+    first = true;
+    for (const auto& usage : acct.stages)
+    {
+        if (!first)
+            ss << ",";
+        first = false;
+        ss << "{\"name\":\"" << usage.name << "\",\"peaks\":{";
+        for (uint64_t i = 0; i < usage.peaks.size(); ++i)
+        {
+            if (i > 0)
+                ss << ",";
+            ss << "\"" << usage.peaks[i].first
+               << "\":" << usage.peaks[i].second;
+        }
+        ss << "}}";
+    }
+    ss << "]}";
+    return ss.str();
+}
+}
+}
@@ -0,0 +1,289 @@
+/**
+ * @file metrics.cpp
+ * @author agent
+ */
+
+#include <sstream>
+
+#include "meta/succinct/broadword.h"
+#include "meta/util/metrics.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace metrics
+{
+
+namespace detail
+{
+std::atomic<bool> enabled_flag{false};
+
+uint64_t thread_shard()
+{
+    static std::atomic<uint64_t> next_shard{0};
+    thread_local uint64_t shard
+        = next_shard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+}
+
+void set_enabled(bool enable)
+{
+    detail::enabled_flag.store(enable, std::memory_order_relaxed);
+}
+
+constexpr uint64_t counter::num_shards;
+
+counter::counter()
+{
+    // nothing
+}
+
+uint64_t counter::value() const
+{
+    uint64_t total = 0;
+    for (const auto& s : shards_)
+        total += s.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void counter::reset()
+{
+    for (auto& s : shards_)
+        s.value.store(0, std::memory_order_relaxed);
+}
+
+constexpr uint64_t histogram::sub_bucket_bits;
+constexpr uint64_t histogram::sub_buckets;
+constexpr uint64_t histogram::num_buckets;
+
+histogram::histogram(double scale) : scale_{scale}
+{
+    reset();
+}
+
+uint64_t histogram::bucket(uint64_t value)
+{
+    if (value < sub_buckets)
+        return value;
+
+    // position of the highest set bit, minus the bits kept below it
+    auto shift = succinct::broadword::msb(value) - 1 - sub_bucket_bits;
+    return (shift + 1) * sub_buckets + (value >> shift) - sub_buckets;
+}
+
+uint64_t histogram::upper_bound(uint64_t idx)
+{
+    if (idx < sub_buckets)
+        return idx;
+
+    auto shift = idx / sub_buckets - 1;
+    auto mantissa = idx % sub_buckets + sub_buckets;
+    // wraps around to the largest value for the very last bucket
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t histogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+double histogram::sum() const
+{
+    return static_cast<double>(sum_.load(std::memory_order_relaxed)) * scale_;
+}
+
+double histogram::quantile(double q) const
+{
+    uint64_t total = 0;
+    for (const auto& b : buckets_)
+        total += b.load(std::memory_order_relaxed);
+    if (total == 0)
+        return 0;
+
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (uint64_t i = 0; i < num_buckets; ++i)
+    {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return static_cast<double>(upper_bound(i)) * scale_;
+    }
+    return static_cast<double>(upper_bound(num_buckets - 1)) * scale_;
+}
+
+double histogram::scale() const
+{
+    return scale_;
+}
+
+void histogram::reset()
+{
+    for (auto& b : buckets_)
+        b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+}
+
+counter& registry::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto& ptr = counters_[name];
+    if (!ptr)
+        ptr = make_unique<metrics::counter>();
+    return *ptr;
+}
+
+histogram& registry::histogram(const std::string& name, double scale)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto& ptr = histograms_[name];
+    if (!ptr)
+        ptr = make_unique<metrics::histogram>(scale);
+    return *ptr;
+}
+
+histogram& registry::timer(const std::string& name)
+{
+    return histogram(name, 1e-9);
+}
+
+namespace
+{
+/**
+ * Splits a metric name into its base name and its label set (without
+ * braces), e.g. `a_total{x="y"}` becomes `a_total` and `x="y"`.
+ */
+std::pair<std::string, std::string> split_labels(const std::string& name)
+{
+    auto pos = name.find('{');
+    if (pos == std::string::npos)
+        return {name, ""};
+    return {name.substr(0, pos), name.substr(pos + 1, name.size() - pos - 2)};
+}
+
+/**
+ * @return the name with an additional label added to its label set
+ */
+std::string with_label(const std::string& base, const std::string& labels,
+                       const std::string& extra)
+{
+    if (labels.empty() && extra.empty())
+        return base;
+    if (labels.empty())
+        return base + "{" + extra + "}";
+    if (extra.empty())
+        return base + "{" + labels + "}";
+    return base + "{" + labels + "," + extra + "}";
+}
+
+/**
+ * Escapes a string for use as a JSON string literal.
+ */
+std::string json_string(const std::string& str)
+{
+    std::string result = "\"";
+    for (const auto& c : str)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+}
+
+std::string registry::to_json() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::stringstream ss;
+    ss.precision(9);
+    ss << "{\"counters\":{";
+    bool first = true;
+    for (const auto& pr : counters_)
+    {
+        if (!first)
+            ss << ",";
+        first = false;
+        ss << json_string(pr.first) << ":" << pr.second->value();
+    }
+
+    ss << "},\"histograms\":{";
+    first = true;
+    for (const auto& pr : histograms_)
+    {
+        if (!first)
+            ss << ",";
+        first = false;
+        const auto& hist = *pr.second;
+        ss << json_string(pr.first) << ":{\"count\":" << hist.count()
+           << ",\"sum\":" << hist.sum() << ",\"p50\":" << hist.quantile(0.5)
+           << ",\"p90\":" << hist.quantile(0.9)
+           << ",\"p99\":" << hist.quantile(0.99)
+           << ",\"max\":" << hist.quantile(1.0) << "}";
+    }
+    ss << "}}";
+    return ss.str();
+}
+
+std::string registry::to_prometheus() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::stringstream ss;
+    ss.precision(9);
+
+    std::string last_type;
+    for (const auto& pr : counters_)
+    {
+        auto parts = split_labels(pr.first);
+        if (parts.first != last_type)
+        {
+            ss << "# TYPE " << parts.first << " counter\n";
+            last_type = parts.first;
+        }
+        ss << pr.first << " " << pr.second->value() << "\n";
+    }
+
+    for (const auto& pr : histograms_)
+    {
+        auto parts = split_labels(pr.first);
+        if (parts.first != last_type)
+        {
+            ss << "# TYPE " << parts.first << " histogram\n";
+            last_type = parts.first;
+        }
+
+        const auto& hist = *pr.second;
+        hist.for_each_bucket([&](double upper, uint64_t cumulative) {
+            std::stringstream le;
+            le.precision(9);
+            le << "le=\"" << upper << "\"";
+            ss << with_label(parts.first + "_bucket", parts.second, le.str())
+               << " " << cumulative << "\n";
+        });
+        ss << with_label(parts.first + "_bucket", parts.second, "le=\"+Inf\"")
+           << " " << hist.count() << "\n";
+        ss << with_label(parts.first + "_sum", parts.second, "") << " "
+           << hist.sum() << "\n";
+        ss << with_label(parts.first + "_count", parts.second, "") << " "
+           << hist.count() << "\n";
+    }
+    return ss.str();
+}
+
+void registry::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto& pr : counters_)
+        pr.second->reset();
+    for (auto& pr : histograms_)
+        pr.second->reset();
+}
+
+registry& get_registry()
+{
+    static registry reg;
+    return reg;
+}
+}
+}
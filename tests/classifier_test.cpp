@@ -6,16 +6,67 @@
 
 #include <fstream>
 #include <iostream>
+#include <cmath>
+#include <limits>
 #include <random>
+#include <sstream>
+#include <unordered_map>
 
 #include "bandit/bandit.h"
 #include "classifier_test_helper.h"
 #include "cpptoml.h"
+#include "meta/corpus/synthetic_corpus.h"
 
 using namespace bandit;
 using namespace meta;
 
 namespace {
+/**
+ * Writes a small synthetic line corpus.
+ * @param prefix The directory to write the corpus and its indexes to
+ * @param num_labels The number of classes in the corpus
+ * @return the configuration for indexing the corpus
+ */
+std::shared_ptr<cpptoml::table>
+make_synthetic_config(const std::string& prefix, uint64_t num_labels) {
+    corpus::synthetic_corpus::options opts;
+    opts.num_docs = 200;
+    opts.vocab_size = 500;
+    opts.length_mean = 20;
+    opts.num_labels = num_labels;
+    corpus::synthetic_corpus{opts}.write(prefix, "docs");
+
+    auto cfg = cpptoml::make_table();
+    cfg->insert("prefix", prefix);
+    cfg->insert("dataset", "docs");
+    cfg->insert("corpus", "line.toml");
+    cfg->insert("index", prefix + "/idx");
+    auto anas = cpptoml::make_table_array();
+    auto ana = cpptoml::make_table();
+    ana->insert("method", "ngram-word");
+    ana->insert<int64_t>("ngram", 1);
+    auto filters = cpptoml::make_table_array();
+    auto tok = cpptoml::make_table();
+    tok->insert("type", "whitespace-tokenizer");
+    filters->push_back(tok);
+    ana->insert("filter", filters);
+    anas->push_back(ana);
+    cfg->insert("analyzers", anas);
+    return cfg;
+}
+
+/**
+ * Writes a small synthetic line corpus and indexes it.
+ * @param prefix The directory to write the corpus and index to
+ * @param num_labels The number of classes in the corpus
+ * @return the forward index of the corpus
+ */
+std::shared_ptr<index::forward_index>
+make_synthetic_index(const std::string& prefix, uint64_t num_labels) {
+    auto cfg = make_synthetic_config(prefix, num_labels);
+    return index::make_index<index::forward_index>(*cfg);
+}
+
 void run_tests(const std::string& index_type) {
 
     using namespace classify;
@@ -57,6 +108,18 @@ void run_tests(const std::string& index_type) {
             }, 0.89);
         });
 
+        it("should create KNN classifier over an HNSW graph with CV", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", knn::id.to_string());
+            cfg->insert("k", 10);
+            auto hnsw_cfg = cpptoml::make_table();
+            hnsw_cfg->insert("ef", 100);
+            cfg->insert("hnsw", hnsw_cfg);
+            check_cv(f_idx, [&](multiclass_dataset_view docs) {
+                return make_classifier(*cfg, std::move(docs), i_idx);
+            }, 0.85);
+        });
+
         it("should create nearest centroid classifier with CV", [&]() {
             check_cv(f_idx, [&](multiclass_dataset_view docs) {
                 return make_unique<nearest_centroid>(std::move(docs), i_idx);
@@ -70,6 +133,29 @@ void run_tests(const std::string& index_type) {
                    return make_unique<nearest_centroid>(std::move(docs), i_idx);
                }, 0.85);
            });
+
+        it("should classify a batch in parallel the same as one at a time",
+           [&]() {
+               multiclass_dataset dataset{f_idx};
+               multiclass_dataset_view docs{dataset, std::mt19937_64{47}};
+               auto cls = make_unique<knn>(docs, i_idx, 10,
+                                           make_unique<index::okapi_bm25>());
+               parallel::thread_pool pool{3};
+
+               std::stringstream expected;
+               std::stringstream actual;
+               cls->test(docs).print(expected);
+               cls->classify_batch(docs, pool).print(actual);
+               AssertThat(actual.str(), Equals(expected.str()));
+
+               std::vector<classifier::feature_vector> instances;
+               for (const auto& instance : docs)
+                   instances.push_back(instance.weights);
+               auto labels = cls->classify_batch(instances, pool);
+               AssertThat(labels.size(), Equals(instances.size()));
+               for (uint64_t i = 0; i < labels.size(); ++i)
+                   AssertThat(labels[i], Equals(cls->classify(instances[i])));
+           });
     });
 
     describe_msg
@@ -112,11 +198,91 @@ void run_tests(const std::string& index_type) {
             check_cv(f_idx, *perc_sgd_cfg, 0.93);
         });
 
+        it("should cross-validate the same with parallel folds", [&]() {
+            multiclass_dataset dataset{f_idx};
+            auto run = [&](uint64_t max_parallel_folds) {
+                multiclass_dataset_view docs{dataset, std::mt19937_64{47}};
+                std::stringstream ss;
+                auto creator = [&](multiclass_dataset_view fold) {
+                    return make_classifier(*hinge_sgd_cfg, std::move(fold));
+                };
+                cross_validate(creator, docs, 5, false, max_parallel_folds)
+                    .print(ss);
+                return ss.str();
+            };
+            auto sequential = run(1);
+            AssertThat(run(3), Equals(sequential));
+            AssertThat(run(5), Equals(sequential));
+        });
+
         it("should run one-vs-all using SGD with train/test split", [&]() {
             check_split(f_idx, *hinge_sgd_cfg, 0.91);
             check_split(f_idx, *perc_sgd_cfg, 0.90);
         });
 
+        it("should run one-vs-all using Hogwild SGD with CV", [&]() {
+            auto sequential = check_cv(f_idx, *hinge_sgd_cfg, 0.94);
+
+            // Hogwild's unsynchronized updates may cost a little accuracy,
+            // but it should converge to about the same models
+            hinge_base_cfg->insert<int64_t>("num-threads", 4);
+            check_cv(f_idx, *hinge_sgd_cfg, sequential - 0.02);
+            hinge_base_cfg->erase("num-threads");
+        });
+
+        it("should run one-vs-all using mini-batch SGD with CV", [&]() {
+            hinge_base_cfg->insert<int64_t>("batch-size", 16);
+            check_cv(f_idx, *hinge_sgd_cfg, 0.88);
+            hinge_base_cfg->insert("optimizer", "adam");
+            check_cv(f_idx, *hinge_sgd_cfg, 0.88);
+            hinge_base_cfg->erase("optimizer");
+            hinge_base_cfg->erase("batch-size");
+        });
+
+        it("should train the same mini-batch SGD on any number of threads",
+           [&]() {
+               hinge_base_cfg->insert<int64_t>("batch-size", 128);
+               multiclass_dataset dset{f_idx};
+               multiclass_dataset_view docs{dset, std::mt19937_64{47}};
+               auto single = make_classifier(*hinge_sgd_cfg, docs);
+               hinge_base_cfg->insert<int64_t>("num-threads", 3);
+               auto multi = make_classifier(*hinge_sgd_cfg, docs);
+               for (const auto& instance : docs)
+                   AssertThat(multi->classify(instance.weights),
+                              Equals(single->classify(instance.weights)));
+               hinge_base_cfg->erase("num-threads");
+               hinge_base_cfg->erase("batch-size");
+           });
+
+        it("should classify the same with packed one-vs-all weights", [&]() {
+            multiclass_dataset dset{f_idx};
+            multiclass_dataset_view docs{dset, std::mt19937_64{47}};
+            auto unpacked = make_classifier(*hinge_sgd_cfg, docs);
+            AssertThat(dynamic_cast<one_vs_all&>(*unpacked).compiled(),
+                       IsFalse());
+
+            hinge_sgd_cfg->insert<int64_t>("packed-weights-mb", 1024);
+            auto cls = make_classifier(*hinge_sgd_cfg, docs);
+            hinge_sgd_cfg->erase("packed-weights-mb");
+            auto& ova = dynamic_cast<one_vs_all&>(*cls);
+            AssertThat(ova.compiled(), IsTrue());
+
+            const auto& first = *docs.begin();
+            ova.train_one(first.weights, docs.label(first));
+            AssertThat(ova.compiled(), IsFalse());
+
+            std::vector<class_label> expected;
+            for (const auto& instance : docs)
+                expected.push_back(ova.classify(instance.weights));
+
+            ova.compile();
+            AssertThat(ova.compiled(), IsTrue());
+            uint64_t i = 0;
+            for (const auto& instance : docs)
+                AssertThat(ova.classify(instance.weights),
+                           Equals(expected[i++]));
+        });
+
         // disable l2 regularization and add a harsh l1 regularizer
         hinge_base_cfg->insert("l2-regularization", 0.0);
         hinge_base_cfg->insert("l1-regularization", 1e-4);
@@ -152,12 +318,37 @@ void run_tests(const std::string& index_type) {
             check_cv(f_idx, *cfg, 0.89);
         });
 
+        it("should run mini-batch logistic regression with CV", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", logistic_regression::id.to_string());
+            cfg->insert<int64_t>("batch-size", 16);
+            check_cv(f_idx, *cfg, 0.85);
+        });
+
         it("should run logistic regression with train/test split", [&]() {
             auto cfg = cpptoml::make_table();
             cfg->insert("method", logistic_regression::id.to_string());
             check_split(f_idx, *cfg, 0.87);
         });
 
+        it("should run linear-svm with CV", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", linear_svm::id.to_string());
+            check_cv(f_idx, *cfg, 0.90);
+            cfg->insert("loss", "l1-svm");
+            check_cv(f_idx, *cfg, 0.90);
+            cfg->insert("loss", "logistic");
+            check_cv(f_idx, *cfg, 0.88);
+        });
+
+        it("should run linear-svm with train/test split", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", linear_svm::id.to_string());
+            check_split(f_idx, *cfg, 0.86);
+            cfg->insert("loss", "logistic");
+            check_split(f_idx, *cfg, 0.85);
+        });
+
         it("should run winnow with CV", [&]() {
             auto cfg = cpptoml::make_table();
             cfg->insert("method", winnow::id.to_string());
@@ -221,6 +412,16 @@ go_bandit([]() {
                 }, 0.89);
         });
 
+        it("should save and load KNN models over an HNSW graph", [&]() {
+            tests::run_save_load_single(
+                f_idx, [&](multiclass_dataset_view docs) {
+                    index::hnsw_options options;
+                    options.num_threads = 2;
+                    return make_unique<knn>(std::move(docs), i_idx, 10,
+                                            options, 100);
+                }, 0.82);
+        });
+
         it("should save and load nearest centroid models", [&]() {
             tests::run_save_load_single(
                 f_idx, [&](multiclass_dataset_view docs) {
@@ -257,6 +458,12 @@ go_bandit([]() {
             tests::run_save_load_single(f_idx, *cfg, 0.87);
         });
 
+        it("should save and load linear-svm models", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", linear_svm::id.to_string());
+            tests::run_save_load_single(f_idx, *cfg, 0.86);
+        });
+
         it("should save and load winnow models", [&]() {
             auto cfg = cpptoml::make_table();
             cfg->insert("method", winnow::id.to_string());
@@ -276,6 +483,199 @@ go_bandit([]() {
 
     filesystem::remove_all("ceeaus");
 
+    describe("[classifier] linear-svm on a single class", [&]() {
+        using namespace classify;
+
+        const std::string prefix = "linear-svm-one-class";
+        filesystem::remove_all(prefix);
+
+        it("should predict the only class it was trained on", [&]() {
+            auto idx = make_synthetic_index(prefix, 1);
+            multiclass_dataset dset{idx};
+            multiclass_dataset_view docs{dset};
+            AssertThat(docs.total_labels(), Equals(1ul));
+
+            linear_svm svm{docs};
+            auto label = docs.label(*docs.begin());
+            for (const auto& instance : docs)
+                AssertThat(svm.classify(instance.weights), Equals(label));
+        });
+
+        filesystem::remove_all(prefix);
+    });
+
+    describe("[classifier] naive-bayes log-probability table", [&]() {
+        using namespace classify;
+
+        const std::string prefix = "naive-bayes-table";
+        filesystem::remove_all(prefix);
+        auto idx = make_synthetic_index(prefix, 3);
+        multiclass_dataset dset{idx};
+        multiclass_dataset_view docs{dset};
+
+        it("should predict the same when trained on any number of threads",
+           [&]() {
+               naive_bayes single{docs, naive_bayes::default_alpha,
+                                  naive_bayes::default_beta, 1};
+               naive_bayes multi{docs, naive_bayes::default_alpha,
+                                 naive_bayes::default_beta, 4};
+               for (const auto& instance : docs)
+                   AssertThat(multi.classify(instance.weights),
+                              Equals(single.classify(instance.weights)));
+           });
+
+        it("should predict the same after saving and loading", [&]() {
+            naive_bayes nb{docs};
+            std::stringstream model;
+            nb.save(model);
+            auto loaded = load_classifier(model);
+            for (const auto& instance : docs)
+                AssertThat(loaded->classify(instance.weights),
+                           Equals(nb.classify(instance.weights)));
+        });
+
+        it("should score terms past the end of the table as unseen", [&]() {
+            // with a symmetric prior, every class gives a term it has not
+            // seen probability alpha / (tokens in the class + alpha * V)
+            const auto alpha = naive_bayes::default_alpha;
+            const auto beta = naive_bayes::default_beta;
+            std::unordered_map<class_label, double> tokens;
+            std::unordered_map<class_label, double> num_docs;
+            for (const auto& instance : docs) {
+                auto lbl = docs.label(instance);
+                num_docs[lbl] += 1;
+                for (const auto& count : instance.weights)
+                    tokens[lbl] += count.second;
+            }
+
+            naive_bayes nb{docs};
+            auto num_terms = docs.total_features();
+            auto num_labels = static_cast<double>(docs.total_labels());
+            for (double count : {1.0, 10.0, 100.0, 1000.0}) {
+                class_label expected;
+                auto best = std::numeric_limits<double>::lowest();
+                for (const auto& pr : num_docs) {
+                    auto score
+                        = std::log((pr.second + beta)
+                                   / (docs.size() + beta * num_labels))
+                          + count * std::log(alpha
+                                             / (tokens[pr.first]
+                                                + alpha * num_terms));
+                    if (score > best) {
+                        best = score;
+                        expected = pr.first;
+                    }
+                }
+
+                for (uint64_t past : {0ul, 1ul, 1000000ul}) {
+                    learn::feature_vector doc;
+                    doc.emplace_back(term_id{num_terms + past}, count);
+                    AssertThat(nb.classify(doc), Equals(expected));
+                }
+            }
+        });
+
+        filesystem::remove_all(prefix);
+    });
+
+    describe("[classifier] parallel cross-validation folds", [&]() {
+        using namespace classify;
+
+        auto sgd_cfg = cpptoml::make_table();
+        sgd_cfg->insert("method", sgd::id.to_string());
+
+        it("should allow the requested folds for thread-safe classifiers",
+           [&]() {
+               AssertThat(max_parallel_folds(*sgd_cfg, 1), Equals(1u));
+               AssertThat(max_parallel_folds(*sgd_cfg, 4), Equals(4u));
+           });
+
+        it("should run svm_wrapper folds one at a time", [&]() {
+            auto svm_cfg = cpptoml::make_table();
+            svm_cfg->insert("method", svm_wrapper::id.to_string());
+            AssertThat(max_parallel_folds(*svm_cfg, 4), Equals(1u));
+
+            auto ova_cfg = cpptoml::make_table();
+            ova_cfg->insert("method", one_vs_all::id.to_string());
+            ova_cfg->insert("base", svm_cfg);
+            AssertThat(max_parallel_folds(*ova_cfg, 4), Equals(1u));
+        });
+
+        it("should reject a non-positive number of folds", [&]() {
+            AssertThrows(classifier_exception,
+                         max_parallel_folds(*sgd_cfg, 0));
+            AssertThrows(classifier_exception,
+                         max_parallel_folds(*sgd_cfg, -1));
+        });
+    });
+
+    describe("[classifier] knn model format", [&]() {
+        using namespace classify;
+
+        const std::string prefix = "knn-format";
+        filesystem::remove_all(prefix);
+        auto cfg = make_synthetic_config(prefix, 3);
+        auto f_idx = index::make_index<index::forward_index>(*cfg);
+        auto i_idx = index::make_index<index::inverted_index>(*cfg);
+        multiclass_dataset dset{f_idx};
+        multiclass_dataset_view docs{dset};
+        knn model{docs, i_idx, 5, make_unique<index::okapi_bm25>()};
+
+        auto check_loaded = [&](std::istream& in) {
+            auto loaded = load_classifier(in);
+            for (const auto& instance : docs)
+                AssertThat(loaded->classify(instance.weights),
+                           Equals(model.classify(instance.weights)));
+        };
+
+        it("should load the models it saves", [&]() {
+            std::stringstream saved;
+            model.save(saved);
+            check_loaded(saved);
+        });
+
+        it("should load models saved before the format was versioned",
+           [&]() {
+               std::stringstream saved;
+               io::packed::write(saved, knn::id);
+               io::packed::write(saved, false);
+               io::packed::write(saved, i_idx->index_name());
+               io::packed::write(saved, uint16_t{5});
+               index::okapi_bm25{}.save(saved);
+               io::packed::write(saved, docs.size());
+               for (const auto& instance : docs)
+                   io::packed::write(saved, doc_id(instance.id));
+               check_loaded(saved);
+           });
+
+        it("should reject models saved in a newer format", [&]() {
+            std::stringstream saved;
+            io::packed::write(saved, knn::id);
+            io::packed::write(saved, knn::format_version + 1);
+            AssertThrows(knn_exception, load_classifier(saved));
+        });
+
+        it("should classify a batch on several threads once loaded", [&]() {
+            // the loaded model ranks against a freshly loaded inverted
+            // index, whose corpus statistics are first read by the batch
+            std::stringstream saved;
+            model.save(saved);
+            auto loaded = load_classifier(saved);
+
+            std::vector<learn::feature_vector> instances;
+            for (const auto& instance : docs)
+                instances.push_back(instance.weights);
+
+            parallel::thread_pool pool{4};
+            auto labels = loaded->classify_batch(instances, pool);
+            AssertThat(labels.size(), Equals(instances.size()));
+            for (std::size_t i = 0; i < instances.size(); ++i)
+                AssertThat(labels[i], Equals(model.classify(instances[i])));
+        });
+
+        filesystem::remove_all(prefix);
+    });
+
     describe("[classifier] confusion matrix", [&]() {
 
         // We have 3 classes {A, B, C} and get the following predictions:
@@ -25,8 +25,8 @@ namespace tests {
 template <class Index, class Creator,
           class = typename std::enable_if<!std::is_same<
               typename std::decay<Creator>::type, cpptoml::table>::value>::type>
-inline void check_cv(Index& idx, Creator&& creator, double min_accuracy,
-                     bool even_split = false) {
+inline double check_cv(Index& idx, Creator&& creator, double min_accuracy,
+                       bool even_split = false) {
     using namespace classify;
 
     multiclass_dataset dataset{idx};
@@ -36,13 +36,14 @@ inline void check_cv(Index& idx, Creator&& creator, double min_accuracy,
         = cross_validate(std::forward<Creator>(creator), mcdv, 5, even_split);
     AssertThat(mtx.accuracy(),
                Is().GreaterThan(min_accuracy).And().LessThan(100.0));
+    return mtx.accuracy();
 }
 
 template <class Index>
-inline void check_cv(Index& idx, const cpptoml::table& config,
-                     double min_accuracy, bool even_split = false) {
+inline double check_cv(Index& idx, const cpptoml::table& config,
+                       double min_accuracy, bool even_split = false) {
     using namespace classify;
-    check_cv(idx, [&](multiclass_dataset_view docs) {
+    return check_cv(idx, [&](multiclass_dataset_view docs) {
         return make_classifier(config, std::move(docs));
     }, min_accuracy, even_split);
 }
@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <unordered_set>
@@ -13,6 +14,7 @@
 #include "cpptoml.h"
 #include "meta/index/forward_index.h"
 #include "meta/index/postings_data.h"
+#include "meta/index/value_codec.h"
 #include "meta/io/filesystem.h"
 
 using namespace bandit;
@@ -142,6 +144,35 @@ void bcancer_forward_test(const cpptoml::table& conf) {
     check_bcancer_expected(*idx);
     check_bcancer_doc_id(*idx);
 }
+
+/**
+ * Checks that a forward index's values were stored in the given compact
+ * format: every value read back is a float (for "float") or a whole
+ * number of quantization steps (for "quantized").
+ */
+void check_compact_values(const cpptoml::table& conf,
+                          const std::string& format) {
+    auto values_file = *conf.get_as<std::string>("index")
+                       + "/fwd/postings.values";
+    AssertThat(filesystem::file_exists(values_file), IsTrue());
+    auto codec = index::value_codec::load(values_file);
+    AssertThat(index::value_codec::to_string(codec.fmt), Equals(format));
+
+    auto idx = index::make_index<index::forward_index>(conf);
+    for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id) {
+        auto pdata = idx->search_primary(d_id);
+        for (const auto& count : pdata->counts()) {
+            if (codec.fmt == index::value_codec::format::QUANTIZED) {
+                auto steps = count.second / codec.scale;
+                AssertThat(steps, EqualsWithDelta(std::round(steps), 1e-6));
+            } else {
+                auto as_float = static_cast<float>(count.second);
+                AssertThat(static_cast<double>(as_float),
+                           Equals(count.second));
+            }
+        }
+    }
+}
 }
 
 go_bandit([]() {
@@ -224,6 +255,27 @@ go_bandit([]() {
         });
     });
 
+    describe("[forward-index] with compact values", []() {
+
+        for (const auto& format : {"float", "quantized"}) {
+            it(std::string{"should store values as "} + format, [=]() {
+                filesystem::remove_all("bcancer");
+                auto cfg = create_libsvm_config();
+                cfg->insert("forward-index-values", std::string{format});
+                bcancer_forward_test(*cfg);
+                check_compact_values(*cfg, format);
+            });
+        }
+
+        it("should reject unknown formats", []() {
+            filesystem::remove_all("bcancer");
+            auto cfg = create_libsvm_config();
+            cfg->insert("forward-index-values", "bfloat");
+            AssertThrows(index::forward_index_exception,
+                         index::make_index<index::forward_index>(*cfg));
+        });
+    });
+
     describe("[forward-index] with zlib", []() {
 
         filesystem::remove_all("ceeaus");
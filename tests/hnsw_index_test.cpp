@@ -0,0 +1,149 @@
+/**
+ * @file hnsw_index_test.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "bandit/bandit.h"
+#include "meta/index/hnsw_index.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+using vector_type = index::hnsw_index::vector_type;
+
+vector_type make_vector(std::mt19937& rng) {
+    // each vector leans toward one of a few topics, so neighbors exist
+    std::uniform_int_distribution<uint64_t> topic_dist{0, 19};
+    std::uniform_int_distribution<uint64_t> term_dist{0, 1999};
+    std::uniform_real_distribution<double> weight_dist{0.5, 2.0};
+    auto topic = topic_dist(rng);
+
+    vector_type vec;
+    for (uint64_t i = 0; i < 30; ++i) {
+        auto t_id = i % 2 == 0 ? topic * 100 + term_dist(rng) % 100
+                               : term_dist(rng);
+        vec.emplace_back(term_id{t_id}, weight_dist(rng));
+    }
+    std::sort(vec.begin(), vec.end(), [](const std::pair<term_id, double>& a,
+                                         const std::pair<term_id, double>& b) {
+        return a.first < b.first;
+    });
+    vec.erase(std::unique(vec.begin(), vec.end(),
+                          [](const std::pair<term_id, double>& a,
+                             const std::pair<term_id, double>& b) {
+                              return a.first == b.first;
+                          }),
+              vec.end());
+    return vec;
+}
+
+double cosine(const vector_type& a, const vector_type& b) {
+    double dot = 0;
+    double a_norm = 0;
+    double b_norm = 0;
+    for (const auto& weight : a)
+        a_norm += weight.second * weight.second;
+    for (const auto& weight : b)
+        b_norm += weight.second * weight.second;
+    for (uint64_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i].first < b[j].first)
+            ++i;
+        else if (b[j].first < a[i].first)
+            ++j;
+        else
+            dot += a[i++].second * b[j++].second;
+    }
+    return dot / std::sqrt(a_norm * b_norm);
+}
+
+/**
+ * @return the fraction of the true 10 nearest neighbors of the queries
+ * that the index finds
+ */
+double recall(const index::hnsw_index& idx,
+              const std::vector<std::pair<doc_id, vector_type>>& docs,
+              const std::vector<vector_type>& queries, uint64_t ef) {
+    uint64_t found = 0;
+    for (const auto& query : queries) {
+        std::vector<std::pair<double, doc_id>> exact;
+        for (const auto& doc : docs)
+            exact.emplace_back(-cosine(query, doc.second), doc.first);
+        std::sort(exact.begin(), exact.end());
+
+        auto results = idx.search(query, 10, ef);
+        AssertThat(results.size(), Equals(uint64_t{10}));
+        for (uint64_t i = 0; i < 10; ++i) {
+            found += std::any_of(results.begin(), results.end(),
+                                 [&](const index::search_result& result) {
+                                     return result.d_id == exact[i].second;
+                                 });
+        }
+    }
+    return static_cast<double>(found) / (10 * queries.size());
+}
+}
+
+go_bandit([]() {
+    describe("[hnsw index]", []() {
+        std::mt19937 rng{47};
+        std::vector<std::pair<doc_id, vector_type>> docs;
+        for (uint64_t i = 0; i < 2000; ++i)
+            docs.emplace_back(doc_id{i}, make_vector(rng));
+        std::vector<vector_type> queries;
+        for (uint64_t i = 0; i < 50; ++i)
+            queries.push_back(make_vector(rng));
+
+        index::hnsw_options options;
+        options.num_threads = 4;
+        index::hnsw_index idx{docs, options};
+
+        it("should find most of the nearest neighbors", [&]() {
+            AssertThat(idx.size(), Equals(docs.size()));
+            AssertThat(recall(idx, docs, queries, 100),
+                       Is().GreaterThan(0.9));
+        });
+
+        it("should find more neighbors with a larger ef", [&]() {
+            AssertThat(recall(idx, docs, queries, 200),
+                       Is().GreaterThan(recall(idx, docs, queries, 10)));
+        });
+
+        it("should score neighbors by cosine similarity", [&]() {
+            auto results = idx.search(docs[7].second, 5, 50);
+            AssertThat(results.front().d_id, Equals(doc_id{7}));
+            AssertThat(results.front().score,
+                       EqualsWithDelta(1.0f, 0.0001f));
+            for (uint64_t i = 1; i < results.size(); ++i)
+                AssertThat(results[i].score,
+                           Is().Not().GreaterThan(results[i - 1].score));
+        });
+
+        it("should search the same once loaded", [&]() {
+            std::stringstream ss;
+            idx.save(ss);
+            index::hnsw_index loaded{ss};
+            AssertThat(loaded.size(), Equals(idx.size()));
+            for (const auto& query : queries) {
+                auto expected = idx.search(query, 10, 50);
+                auto results = loaded.search(query, 10, 50);
+                AssertThat(results.size(), Equals(expected.size()));
+                for (uint64_t i = 0; i < results.size(); ++i)
+                    AssertThat(results[i].d_id, Equals(expected[i].d_id));
+            }
+        });
+
+        it("should reject too few links", [&]() {
+            index::hnsw_options bad;
+            bad.m = 1;
+            AssertThrows(index::hnsw_exception,
+                         index::hnsw_index(docs, bad));
+        });
+    });
+});
@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include "bandit/bandit.h"
@@ -53,6 +54,14 @@ void check_term_id(Index& idx) {
         AssertThat(first, Equals(count.first));
         AssertThat(second, EqualsWithDelta(count.second, 0.001));
     }
+
+    // the stream should agree without building a postings_data
+    std::vector<std::pair<doc_id, uint64_t>> buffer;
+    auto stream = idx.stream_for(t_id);
+    AssertThat(stream->decode(buffer) == pdata->counts(), IsTrue());
+    for (const auto& count : pdata->counts())
+        AssertThat(idx.term_freq(t_id, count.first), Equals(count.second));
+    AssertThat(idx.term_freq(t_id, doc_id{idx.num_docs()}), Equals(0ul));
 }
 
 void check_full_text(corpus::corpus& docs, const cpptoml::table& config) {
@@ -148,6 +157,51 @@ go_bandit([]() {
         });
     });
 
+    describe("[inverted-index] in memory", []() {
+
+        auto line_cfg = tests::create_config("line");
+        auto ram_cfg = tests::create_config("line");
+        ram_cfg->insert("index-in-memory", true);
+
+        it("should create the index", [&]() {
+            filesystem::remove_all("ceeaus");
+            auto idx = index::make_index<index::inverted_index>(*ram_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should load the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*ram_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should match the index on disk", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*line_cfg);
+            auto ram_idx = index::make_index<index::inverted_index>(*ram_cfg);
+            AssertThat(ram_idx->unique_terms(), Equals(idx->unique_terms()));
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id) {
+                auto text = idx->term_text(t_id);
+                AssertThat(ram_idx->term_text(t_id), Equals(text));
+                AssertThat(ram_idx->get_term_id(text), Equals(t_id));
+                AssertThat(ram_idx->doc_freq(t_id),
+                           Equals(idx->doc_freq(t_id)));
+                AssertThat(ram_idx->total_num_occurences(t_id),
+                           Equals(idx->total_num_occurences(t_id)));
+
+                auto stream = idx->stream_for(t_id);
+                auto ram_stream = ram_idx->stream_for(t_id);
+                AssertThat(std::equal(stream->begin(), stream->end(),
+                                      ram_stream->begin()),
+                           IsTrue());
+            }
+            AssertThat(ram_idx->get_term_id("not-a-term"),
+                       Equals(term_id{idx->unique_terms()}));
+            for (const auto& d_id : idx->docs())
+                AssertThat(ram_idx->lbl_id(d_id), Equals(idx->lbl_id(d_id)));
+        });
+    });
+
     describe("[inverted-index] with zlib", []() {
 
         filesystem::remove_all("ceeaus");
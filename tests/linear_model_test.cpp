@@ -0,0 +1,102 @@
+/**
+ * @file linear_model_test.cpp
+ * @author agent
+ */
+
+#include <random>
+#include <sstream>
+
+#include "bandit/bandit.h"
+#include "meta/classify/models/linear_model.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+    describe("[linear model]", []() {
+        using model_type = classify::linear_model<std::string, float, uint64_t>;
+        using feature_vector = std::vector<std::pair<std::string, float>>;
+
+        std::mt19937 rng{47};
+        std::uniform_int_distribution<uint64_t> feature_dist{0, 199};
+        std::uniform_int_distribution<uint64_t> class_dist{0, 69};
+        std::uniform_real_distribution<float> weight_dist{-1, 1};
+
+        model_type model;
+        for (uint64_t i = 0; i < 2000; ++i)
+            model.update(class_dist(rng), std::to_string(feature_dist(rng)),
+                         weight_dist(rng));
+
+        std::vector<feature_vector> docs(100);
+        for (auto& doc : docs) {
+            // some features are unknown to the model
+            for (uint64_t i = 0; i < 20; ++i)
+                doc.emplace_back(std::to_string(feature_dist(rng) + 20),
+                                 weight_dist(rng));
+        }
+
+        auto odd = [](uint64_t cid) { return cid % 2 == 1; };
+
+        std::vector<uint64_t> best;
+        std::vector<uint64_t> best_odd;
+        std::vector<model_type::scored_classes> top;
+        std::vector<model_type::scored_classes> top_odd;
+        for (const auto& doc : docs) {
+            best.push_back(model.best_class(doc));
+            best_odd.push_back(model.best_class(doc, odd));
+            top.push_back(model.best_classes(doc, 5));
+            top_odd.push_back(model.best_classes(doc, 5, odd));
+        }
+
+        it("should score the same once compiled", [&]() {
+            model.compile();
+            AssertThat(model.compiled(), IsTrue());
+            for (uint64_t i = 0; i < docs.size(); ++i) {
+                AssertThat(model.best_class(docs[i]), Equals(best[i]));
+                AssertThat(model.best_class(docs[i], odd),
+                           Equals(best_odd[i]));
+                AssertThat(model.best_classes(docs[i], 5), Equals(top[i]));
+                AssertThat(model.best_classes(docs[i], 5, odd),
+                           Equals(top_odd[i]));
+            }
+        });
+
+        it("should stay sparse when the compiled weights would not fit",
+           [&]() {
+               model.compile(1024);
+               AssertThat(model.compiled(), IsFalse());
+               for (uint64_t i = 0; i < docs.size(); ++i) {
+                   AssertThat(model.best_class(docs[i]), Equals(best[i]));
+                   AssertThat(model.best_classes(docs[i], 5, odd),
+                              Equals(top_odd[i]));
+               }
+           });
+
+        it("should return the default class when no feature is known",
+           [&]() {
+               feature_vector unknown{{"unknown", 1.0f}};
+               AssertThat(model.best_class(unknown), Equals(uint64_t{0}));
+               AssertThat(model.best_classes(unknown, 5).empty(), IsTrue());
+           });
+
+        it("should discard the compiled weights when updated", [&]() {
+            model.update(0, "unknown", 1.0f);
+            AssertThat(model.compiled(), IsFalse());
+            feature_vector unknown{{"unknown", 1.0f}};
+            AssertThat(model.best_class(unknown), Equals(uint64_t{0}));
+            AssertThat(model.best_classes(unknown, 5).size(),
+                       Equals(uint64_t{1}));
+        });
+
+        it("should compile a loaded model", [&]() {
+            std::stringstream ss;
+            model.save(ss);
+            model_type loaded;
+            loaded.load(ss);
+            loaded.compile();
+            for (const auto& doc : docs)
+                AssertThat(loaded.best_class(doc),
+                           Equals(model.best_class(doc)));
+        });
+    });
+});
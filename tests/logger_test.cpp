@@ -0,0 +1,115 @@
+/**
+ * @file logger_test.cpp
+ * @author agent
+ */
+
+#include <sstream>
+#include <thread>
+
+#include "bandit/bandit.h"
+#include "meta/logging/logger.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+using logging::logger;
+
+logger::sink message_sink(std::ostream& stream) {
+    return {stream, logger::severity_level::trace,
+            [](const logger::log_line& ll) { return ll.str() + "\n"; }};
+}
+
+void log_to(logger& log, logger::severity_level sev, const std::string& msg) {
+    logger::log_line{log, sev, __LINE__, __FILE__} << msg
+                                                    << logger::log_line::endlg;
+}
+}
+
+go_bandit([]() {
+
+    describe("[logger]", []() {
+
+        it("should write synchronously by default", []() {
+            std::stringstream ss;
+            logger log;
+            log.add_sink(message_sink(ss));
+            AssertThat(log.async(), IsFalse());
+            log_to(log, logger::severity_level::info, "hello");
+            AssertThat(ss.str(), Equals("hello\n"));
+        });
+
+        it("should write every line in asynchronous mode", []() {
+            std::stringstream ss;
+            logger log;
+            log.add_sink(message_sink(ss));
+            log.start_async(1 << 16);
+            AssertThat(log.async(), IsTrue());
+
+            const uint64_t num_threads = 4;
+            const uint64_t per_thread = 1000;
+            std::vector<std::thread> threads;
+            for (uint64_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&]() {
+                    for (uint64_t i = 0; i < per_thread; ++i)
+                        log_to(log, logger::severity_level::info, "line");
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+            log.flush();
+
+            uint64_t lines = 0;
+            std::string line;
+            while (std::getline(ss, line)) {
+                AssertThat(line, Equals("line"));
+                ++lines;
+            }
+            AssertThat(lines, Equals(num_threads * per_thread));
+            log.stop_async();
+            AssertThat(log.async(), IsFalse());
+        });
+
+        it("should write queued lines when stopped", []() {
+            std::stringstream ss;
+            logger log;
+            log.add_sink(message_sink(ss));
+            log.start_async();
+            for (int i = 0; i < 10; ++i)
+                log_to(log, logger::severity_level::debug, std::to_string(i));
+            log.stop_async();
+            AssertThat(ss.str(), Equals("0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n"));
+        });
+
+        it("should rate limit repeated lines", []() {
+            std::stringstream ss;
+            logger log;
+            log.add_sink(message_sink(ss));
+            log.set_rate_limit(5);
+            for (int i = 0; i < 100; ++i)
+                log_to(log, logger::severity_level::warning, "repeated");
+            AssertThat(log.dropped(), IsGreaterThan(0ul));
+            log_to(log, logger::severity_level::error, "important");
+
+            uint64_t repeated = 0;
+            uint64_t important = 0;
+            uint64_t reports = 0;
+            std::string line;
+            while (std::getline(ss, line)) {
+                if (line == "repeated")
+                    ++repeated;
+                else if (line == "important")
+                    ++important;
+                else if (line.find("rate limited") != std::string::npos)
+                    ++reports;
+            }
+            // at most two windows' worth of lines if a second boundary
+            // was crossed
+            AssertThat(repeated, IsLessThan(11ul));
+            AssertThat(important, Equals(1ul));
+            AssertThat(reports, IsGreaterThan(0ul));
+            AssertThat(log.dropped(), Equals(0ul));
+        });
+    });
+});
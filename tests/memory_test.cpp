@@ -0,0 +1,101 @@
+/**
+ * @file memory_test.cpp
+ * @author agent
+ */
+
+#include <thread>
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "meta/util/memory.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+struct test_tag {
+    static const char* name() {
+        return "test/tracked-vector";
+    }
+};
+}
+
+go_bandit([]() {
+
+    describe("[memory]", []() {
+
+        it("should track live and peak bytes", []() {
+            memory::category cat{"test"};
+            cat.allocate(100);
+            cat.allocate(50);
+            cat.deallocate(120);
+            AssertThat(cat.live(), Equals(30ul));
+            AssertThat(cat.peak(), Equals(150ul));
+
+            cat.update(30, 80);
+            AssertThat(cat.live(), Equals(80ul));
+            cat.update(80, 10);
+            AssertThat(cat.live(), Equals(10ul));
+            AssertThat(cat.peak(), Equals(150ul));
+        });
+
+        it("should count from many threads", []() {
+            memory::category cat{"test"};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&]() {
+                    for (int i = 0; i < 10000; ++i) {
+                        cat.allocate(8);
+                        cat.deallocate(8);
+                    }
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+            AssertThat(cat.live(), Equals(0ul));
+            AssertThat(cat.peak(), IsLessThanOrEqualTo(32ul));
+        });
+
+        it("should charge tracked containers to their category", []() {
+            auto& cat = memory::get_category(test_tag::name());
+            auto before = cat.live();
+            {
+                memory::tracked_vector<uint64_t, test_tag> vec;
+                vec.reserve(1000);
+                AssertThat(cat.live(),
+                           Equals(before + 1000 * sizeof(uint64_t)));
+            }
+            AssertThat(cat.live(), Equals(before));
+        });
+
+        it("should record peaks per stage", []() {
+            auto& cat = memory::get_category("test/stages");
+            auto first = memory::stages().size();
+            {
+                memory::stage stage{"first"};
+                cat.allocate(1000);
+                cat.deallocate(1000);
+            }
+            {
+                memory::stage stage{"second"};
+                cat.allocate(10);
+            }
+            cat.deallocate(10);
+
+            auto stages = memory::stages();
+            AssertThat(stages.size(), Equals(first + 2));
+
+            auto peak = [&](const memory::stage_usage& usage) {
+                for (const auto& pr : usage.peaks) {
+                    if (pr.first == "test/stages")
+                        return pr.second;
+                }
+                return uint64_t{0};
+            };
+            AssertThat(stages[first].name, Equals("first"));
+            AssertThat(peak(stages[first]), Equals(1000ul));
+            AssertThat(stages[first + 1].name, Equals("second"));
+            AssertThat(peak(stages[first + 1]), Equals(10ul));
+        });
+    });
+});
@@ -9,6 +9,8 @@
 #include "meta/corpus/metadata.h"
 #include "meta/corpus/metadata_parser.h"
 #include "cpptoml.h"
+#include "meta/index/metadata_file.h"
+#include "meta/index/metadata_writer.h"
 #include "meta/io/filesystem.h"
 
 using namespace bandit;
@@ -138,5 +140,127 @@ go_bandit([]() {
 
             filesystem::delete_file(filename);
         });
+
+        it("should read fields through accessors", [&]() {
+            options_type options = {{"path", "string"},
+                                    {"id", "uint"},
+                                    {"response", "double"},
+                                    {"position", "int"}};
+            auto config = create_metadata_config(options);
+            const std::string dir = "meta-test-metadata-db";
+            filesystem::remove_all(dir);
+            filesystem::make_directory(dir);
+
+            {
+                index::metadata_writer writer{
+                    dir, 2, corpus::metadata_schema(*config)};
+                using field = corpus::metadata::field;
+                writer.write(doc_id{0}, 10, 5,
+                             {field{std::string{"/my/path1"}},
+                              field{uint64_t{345}}, field{9.345},
+                              field{int64_t{7}}});
+                writer.write(doc_id{1}, 20, 7,
+                             {field{std::string{"/my/path2"}},
+                              field{uint64_t{346}}, field{-0.4},
+                              field{int64_t{-1}}});
+            }
+
+            index::metadata_file mdf{dir};
+            AssertThat(mdf.size(), Equals(2ul));
+            AssertThat(mdf.schema().size(), Equals(6ul));
+
+            using corpus::metadata;
+            metadata::accessor<util::string_view> path{mdf.schema(), "path"};
+            metadata::accessor<uint64_t> length{mdf.schema(), "length"};
+            metadata::accessor<uint64_t> id{mdf.schema(), "id"};
+            metadata::accessor<double> response{mdf.schema(), "response"};
+            metadata::accessor<int64_t> position{mdf.schema(), "position"};
+
+            const double delta = 0.0000001;
+            auto md = mdf.get(doc_id{1});
+            AssertThat(md.get(path), Equals(util::string_view{"/my/path2"}));
+            AssertThat(md.get(length), Equals(20ul));
+            AssertThat(md.get(id), Equals(346ul));
+            AssertThat(md.get(response), EqualsWithDelta(-0.4, delta));
+            AssertThat(md.get(position), Equals(-1));
+
+            md = mdf.get(doc_id{0});
+            AssertThat(md.get(position), Equals(7));
+            AssertThat(md.get(path), Equals(util::string_view{"/my/path1"}));
+            AssertThat(*md.get<std::string>("path"), Equals("/my/path1"));
+            AssertThat(*md.get<uint64_t>("unique-terms"), Equals(5ul));
+
+            AssertThrows(corpus::metadata_exception,
+                         (metadata::accessor<uint64_t>{mdf.schema(), "path"}));
+            AssertThrows(
+                corpus::metadata_exception,
+                (metadata::accessor<std::string>{mdf.schema(), "missing"}));
+
+            filesystem::remove_all(dir);
+        });
+
+        it("should filter documents on metadata columns", [&]() {
+            using corpus::metadata;
+            metadata::schema_type schema;
+            schema.emplace_back("year", metadata::field_type::SIGNED_INT, true);
+            schema.emplace_back("source", metadata::field_type::STRING, true);
+            schema.emplace_back("score", metadata::field_type::DOUBLE, true);
+            schema.emplace_back("title", metadata::field_type::STRING);
+
+            const std::string dir = "meta-test-metadata-columns";
+            const uint64_t num_docs = 3000;
+            const std::vector<std::string> sources = {"nyt", "wsj", "ap"};
+            filesystem::remove_all(dir);
+            filesystem::make_directory(dir);
+
+            {
+                index::metadata_writer writer{dir, num_docs, schema};
+                using field = metadata::field;
+                for (uint64_t d = 0; d < num_docs; ++d)
+                {
+                    auto year = static_cast<int64_t>(d / 100) - 10;
+                    writer.write(doc_id{d}, 1, 1,
+                                 {field{year}, field{sources[d % 3]},
+                                  field{static_cast<double>(d) / 2 - 100},
+                                  field{std::string{"title"}}});
+                }
+            }
+
+            index::metadata_file mdf{dir};
+            AssertThat(mdf.has_column("year"), IsTrue());
+            AssertThat(mdf.has_column("title"), IsFalse());
+
+            const auto& year = mdf.column("year");
+            AssertThat(year.at<int64_t>(doc_id{0}), Equals(-10));
+            AssertThat(year.at<int64_t>(doc_id{2999}), Equals(19));
+
+            auto recent = year.range(int64_t{-2}, int64_t{5});
+            AssertThat(recent.count(), Equals(800ul));
+            AssertThat(recent.test(doc_id{799}), IsFalse());
+            AssertThat(recent.test(doc_id{800}), IsTrue());
+            AssertThat(recent.test(doc_id{1599}), IsTrue());
+            AssertThat(recent.test(doc_id{1600}), IsFalse());
+
+            const auto& source = mdf.column("source");
+            AssertThat(source.at<util::string_view>(doc_id{4}),
+                       Equals(util::string_view{"wsj"}));
+            AssertThat(source.equal("nyt").count(), Equals(1000ul));
+            AssertThat(source.equal("reuters").count(), Equals(0ul));
+            auto filter = recent & source.any_of({"nyt", "ap"});
+            AssertThat(filter.count(), Equals(534ul));
+            for (const auto& d_id : filter.docs())
+            {
+                AssertThat(static_cast<uint64_t>(d_id) % 3 != 1, IsTrue());
+                AssertThat(filter(d_id), IsTrue());
+            }
+
+            const auto& score = mdf.column("score");
+            AssertThat(score.at<double>(doc_id{1}),
+                       EqualsWithDelta(-99.5, 0.0001));
+            AssertThat(score.range(-1.0, 1.0).count(), Equals(5ul));
+            AssertThat((~score.range(-1.0, 1.0)).count(), Equals(2995ul));
+
+            filesystem::remove_all(dir);
+        });
     });
 });
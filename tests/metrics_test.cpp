@@ -0,0 +1,104 @@
+/**
+ * @file metrics_test.cpp
+ * @author agent
+ */
+
+#include <thread>
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "meta/util/metrics.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+
+    describe("[metrics]", []() {
+
+        it("should ignore updates while disabled", []() {
+            metrics::set_enabled(false);
+            metrics::counter c;
+            metrics::histogram h;
+            c.add(5);
+            h.record(10);
+            { metrics::scoped_timer timer{h}; }
+            AssertThat(c.value(), Equals(0ul));
+            AssertThat(h.count(), Equals(0ul));
+        });
+
+        it("should count from many threads", []() {
+            metrics::set_enabled(true);
+            metrics::counter c;
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&]() {
+                    for (int i = 0; i < 10000; ++i)
+                        c.add();
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+            AssertThat(c.value(), Equals(40000ul));
+            c.reset();
+            AssertThat(c.value(), Equals(0ul));
+            metrics::set_enabled(false);
+        });
+
+        it("should bucket values with bounded relative error", []() {
+            for (uint64_t v : {0ul, 1ul, 15ul, 16ul, 17ul, 1000ul, 123456789ul,
+                               ~0ul}) {
+                auto idx = metrics::histogram::bucket(v);
+                AssertThat(idx, IsLessThan(metrics::histogram::num_buckets));
+                auto upper = metrics::histogram::upper_bound(idx);
+                AssertThat(upper, IsGreaterThanOrEqualTo(v));
+                AssertThat(static_cast<double>(upper - v),
+                           IsLessThanOrEqualTo(static_cast<double>(v) / 16));
+                if (idx > 0) {
+                    AssertThat(metrics::histogram::upper_bound(idx - 1),
+                               IsLessThan(v));
+                }
+            }
+        });
+
+        it("should compute quantiles", []() {
+            metrics::set_enabled(true);
+            metrics::histogram h;
+            for (uint64_t v = 1; v <= 1000; ++v)
+                h.record(v);
+            AssertThat(h.count(), Equals(1000ul));
+            AssertThat(h.sum(), EqualsWithDelta(500500.0, 0.01));
+            AssertThat(h.quantile(0.5), IsGreaterThanOrEqualTo(500.0));
+            AssertThat(h.quantile(0.5), IsLessThan(500.0 * 1.07));
+            AssertThat(h.quantile(1.0), IsGreaterThanOrEqualTo(1000.0));
+            AssertThat(h.quantile(1.0), IsLessThan(1000.0 * 1.07));
+            metrics::set_enabled(false);
+        });
+
+        it("should dump metrics as JSON and Prometheus text", []() {
+            metrics::set_enabled(true);
+            metrics::registry reg;
+            reg.counter("test_events_total{kind=\"a\"}").add(3);
+            AssertThat(&reg.counter("test_events_total{kind=\"a\"}"),
+                       Equals(&reg.counter("test_events_total{kind=\"a\"}")));
+            reg.timer("test_latency_seconds").record(2000);
+            metrics::set_enabled(false);
+
+            auto json = reg.to_json();
+            AssertThat(json, Contains("\"test_events_total{kind=\\\"a\\\"}\":3"));
+            AssertThat(json, Contains("\"test_latency_seconds\":{\"count\":1"));
+
+            auto prom = reg.to_prometheus();
+            AssertThat(prom, Contains("# TYPE test_events_total counter\n"));
+            AssertThat(prom, Contains("test_events_total{kind=\"a\"} 3\n"));
+            AssertThat(prom, Contains("# TYPE test_latency_seconds histogram\n"));
+            AssertThat(prom,
+                       Contains("test_latency_seconds_bucket{le=\"+Inf\"} 1\n"));
+            AssertThat(prom, Contains("test_latency_seconds_count 1\n"));
+
+            reg.reset();
+            AssertThat(reg.counter("test_events_total{kind=\"a\"}").value(),
+                       Equals(0ul));
+        });
+    });
+});
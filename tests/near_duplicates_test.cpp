@@ -0,0 +1,136 @@
+/**
+ * @file near_duplicates_test.cpp
+ * @author agent
+ */
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/metadata_column.h"
+#include "meta/index/near_duplicates.h"
+#include "meta/io/filesystem.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+analyzers::feature_map<uint64_t> make_doc(uint64_t first, uint64_t last) {
+    analyzers::feature_map<uint64_t> counts;
+    for (uint64_t i = first; i < last; ++i)
+        counts["word" + std::to_string(i)] = 1 + i % 3;
+    return counts;
+}
+
+std::vector<doc_id> cluster(const cpptoml::table& config) {
+    index::near_duplicate_detector detector{config, 6};
+
+    // 1 and 4 share 95 of 105 features with 0; 2 and 3 are unrelated;
+    // 5 is empty
+    auto near = make_doc(0, 95);
+    for (uint64_t i = 1000; i < 1010; ++i)
+        near["word" + std::to_string(i)] = 1;
+    detector.add(doc_id{0}, make_doc(0, 100));
+    detector.add(doc_id{1}, near);
+    detector.add(doc_id{2}, make_doc(200, 300));
+    detector.add(doc_id{3}, make_doc(300, 400));
+    detector.add(doc_id{4}, make_doc(0, 100));
+    detector.add(doc_id{5}, {});
+    return detector.clusters();
+}
+}
+
+go_bandit([]() {
+
+    describe("[near-duplicates]", []() {
+
+        it("should cluster with minhash", []() {
+            auto config = cpptoml::make_table();
+            auto clusters = cluster(*config);
+            std::vector<doc_id> expected
+                = {doc_id{0}, doc_id{0}, doc_id{2},
+                   doc_id{3}, doc_id{0}, doc_id{5}};
+            AssertThat(clusters, Equals(expected));
+
+            // a stricter threshold separates the near-duplicate
+            config->insert("threshold", 0.99);
+            clusters = cluster(*config);
+            AssertThat(clusters[1], Equals(doc_id{1}));
+            AssertThat(clusters[4], Equals(doc_id{0}));
+        });
+
+        it("should cluster with simhash", []() {
+            auto config = cpptoml::make_table();
+            config->insert("method", std::string{"simhash"});
+            config->insert("max-distance", int64_t{0});
+            auto clusters = cluster(*config);
+            AssertThat(clusters[2], Equals(doc_id{2}));
+            AssertThat(clusters[3], Equals(doc_id{3}));
+            AssertThat(clusters[4], Equals(doc_id{0}));
+            AssertThat(clusters[5], Equals(doc_id{5}));
+        });
+
+        it("should reject invalid settings", []() {
+            auto config = cpptoml::make_table();
+            config->insert("method", std::string{"bloomhash"});
+            AssertThrows(index::near_duplicate_exception,
+                         index::near_duplicate_detector(*config, 1));
+
+            config->insert("method", std::string{"minhash"});
+            config->insert("bands", int64_t{7});
+            AssertThrows(index::near_duplicate_exception,
+                         index::near_duplicate_detector(*config, 1));
+        });
+    });
+
+    describe("[near-duplicates] while indexing", []() {
+
+        auto config = tests::create_config("line");
+        auto dedup = cpptoml::make_table();
+        config->insert("near-duplicates", dedup);
+
+        it("should record clusters as metadata", [&]() {
+            filesystem::remove_all("ceeaus");
+            auto idx = index::make_index<index::inverted_index>(*config);
+            AssertThat(idx->num_docs(), Equals(1008ul));
+
+            const auto& column = idx->column("near-duplicate-of");
+            uint64_t num_duplicates = 0;
+            for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id) {
+                auto cluster = column.at<uint64_t>(d_id);
+                AssertThat(cluster, Is().LessThanOrEqualTo(d_id));
+                if (cluster != d_id) {
+                    ++num_duplicates;
+                    AssertThat(column.at<uint64_t>(doc_id{cluster}),
+                               Equals(cluster));
+                }
+            }
+            // the corpus contains a few duplicated essays
+            AssertThat(num_duplicates, Is().GreaterThan(0ul));
+        });
+
+        it("should drop duplicates from the postings", [&]() {
+            filesystem::remove_all("ceeaus");
+            dedup->insert("action", std::string{"drop"});
+            auto idx = index::make_index<index::inverted_index>(*config);
+            AssertThat(idx->num_docs(), Equals(1008ul));
+
+            const auto& column = idx->column("near-duplicate-of");
+            for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id) {
+                if (column.at<uint64_t>(d_id) != d_id)
+                    AssertThat(idx->doc_size(d_id), Equals(0ul));
+                else
+                    AssertThat(idx->doc_size(d_id), Is().GreaterThan(0ul));
+            }
+        });
+
+        it("should reject unknown actions", [&]() {
+            filesystem::remove_all("ceeaus");
+            dedup->insert("action", std::string{"hide"});
+            AssertThrows(index::inverted_index::exception,
+                         index::make_index<index::inverted_index>(*config));
+        });
+
+        filesystem::remove_all("ceeaus");
+    });
+});
@@ -9,6 +9,7 @@
 
 #include "bandit/bandit.h"
 #include "meta/util/time.h"
+#include "meta/parallel/mpsc_queue.h"
 #include "meta/parallel/parallel_for.h"
 #include "meta/parallel/thread_pool.h"
 
@@ -81,4 +82,58 @@ go_bandit([]() {
             AssertThat(sum, Equals(std::size_t{16}));
         });
     });
+
+    describe("[parallel] mpsc queue", []() {
+
+        it("should reject pushes when full", []() {
+            parallel::mpsc_queue<int> queue{4};
+            AssertThat(queue.capacity(), Equals(4ul));
+            for (int i = 0; i < 4; ++i)
+                AssertThat(queue.try_push(int{i}), IsTrue());
+            AssertThat(queue.try_push(4), IsFalse());
+
+            int val;
+            AssertThat(queue.try_pop(val), IsTrue());
+            AssertThat(val, Equals(0));
+            AssertThat(queue.try_push(4), IsTrue());
+            for (int i = 1; i <= 4; ++i) {
+                AssertThat(queue.try_pop(val), IsTrue());
+                AssertThat(val, Equals(i));
+            }
+            AssertThat(queue.try_pop(val), IsFalse());
+        });
+
+        it("should deliver every element from many producers", []() {
+            parallel::mpsc_queue<std::pair<uint64_t, uint64_t>> queue{64};
+            const uint64_t num_producers = 4;
+            const uint64_t per_producer = 20000;
+
+            std::vector<std::thread> producers;
+            for (uint64_t p = 0; p < num_producers; ++p) {
+                producers.emplace_back([&, p]() {
+                    for (uint64_t i = 0; i < per_producer; ++i) {
+                        while (!queue.try_push({p, i}))
+                            std::this_thread::yield();
+                    }
+                });
+            }
+
+            // every producer's elements must arrive in order
+            std::vector<uint64_t> next(num_producers, 0);
+            std::pair<uint64_t, uint64_t> elem;
+            for (uint64_t n = 0; n < num_producers * per_producer;) {
+                if (!queue.try_pop(elem)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                AssertThat(elem.second, Equals(next[elem.first]));
+                ++next[elem.first];
+                ++n;
+            }
+
+            for (auto& t : producers)
+                t.join();
+            AssertThat(queue.try_pop(elem), IsFalse());
+        });
+    });
 });
@@ -49,6 +49,42 @@ void test_rank(Ranker& r, Index& idx, const std::string& encoding) {
                    Is().GreaterThanOrEqualTo(ranking[i].score));
     }
 }
+
+template <class Ranker, class Index>
+void test_strategies(Ranker& r, Index& idx) {
+    auto filter = [](doc_id d_id) { return d_id % 3 != 0; };
+    for (const auto& text : {"character", "the character", "a japanese student",
+                             "smoking should be banned at all restaurants"}) {
+        corpus::document query;
+        query.content(text);
+
+        r.strategy(index::evaluation_strategy::DOCUMENT_AT_A_TIME);
+        auto merged = r.score(idx, query, 20);
+        auto merged_filtered = r.score(idx, query, 20, filter);
+
+        r.strategy(index::evaluation_strategy::TERM_AT_A_TIME);
+        auto accumulated = r.score(idx, query, 20);
+        auto accumulated_filtered = r.score(idx, query, 20, filter);
+        r.strategy(index::evaluation_strategy::AUTOMATIC);
+
+        AssertThat(accumulated.size(), Equals(merged.size()));
+        for (uint64_t i = 0; i < merged.size(); ++i) {
+            AssertThat(accumulated[i].d_id, Equals(merged[i].d_id));
+            AssertThat(accumulated[i].score, Equals(merged[i].score));
+        }
+
+        AssertThat(accumulated_filtered.size(),
+                   Equals(merged_filtered.size()));
+        for (uint64_t i = 0; i < merged_filtered.size(); ++i) {
+            AssertThat(accumulated_filtered[i].d_id,
+                       Equals(merged_filtered[i].d_id));
+            AssertThat(accumulated_filtered[i].d_id % 3,
+                       Is().Not().EqualTo(0ul));
+            AssertThat(accumulated_filtered[i].score,
+                       Equals(merged_filtered[i].score));
+        }
+    }
+}
 }
 
 go_bandit([]() {
@@ -87,6 +123,19 @@ go_bandit([]() {
             test_rank(r, *idx, encoding);
         });
 
+        it("should rank identically term-at-a-time", [&]() {
+            index::absolute_discount ad;
+            test_strategies(ad, *idx);
+            index::dirichlet_prior dp;
+            test_strategies(dp, *idx);
+            index::jelinek_mercer jm;
+            test_strategies(jm, *idx);
+            index::okapi_bm25 bm25;
+            test_strategies(bm25, *idx);
+            index::pivoted_length pl;
+            test_strategies(pl, *idx);
+        });
+
         idx = nullptr;
         filesystem::remove_all("ceeaus");
     });
@@ -5,6 +5,7 @@
 
 #include "bandit/bandit.h"
 #include "meta/index/make_index.h"
+#include "meta/learn/sgd.h"
 #include "meta/regression/regressor_factory.h"
 #include "meta/stats/running_stats.h"
 
@@ -12,9 +13,9 @@ using namespace bandit;
 using namespace meta;
 
 namespace {
-void check_cv(const cpptoml::table& cfg,
-              const regression::regression_dataset& dataset,
-              regression::metrics expected) {
+regression::metrics check_cv(const cpptoml::table& cfg,
+                             const regression::regression_dataset& dataset,
+                             regression::metrics expected) {
 
     regression::regression_dataset_view rdv{dataset, std::mt19937{47}};
     auto results = regression::cross_validate(cfg, rdv, 5);
@@ -38,6 +39,21 @@ void check_cv(const cpptoml::table& cfg,
     AssertThat(mse.mean(), Is().GreaterThan(0.0).And().LessThan(
                                expected.mean_squared_error));
     AssertThat(r2.mean(), Is().GreaterThan(expected.r2_score));
+    return {mae.mean(), med_ae.mean(), mse.mean(), r2.mean()};
+}
+
+/**
+ * @param measured The metrics of a baseline run
+ * @param slack The fraction by which another run may be worse
+ * @return bounds for check_cv() that allow each error to grow and the r2
+ * score to shrink by the given fraction
+ */
+regression::metrics within(const regression::metrics& measured,
+                           double slack) {
+    return {measured.mean_absolute_error * (1 + slack),
+            measured.median_absolute_error * (1 + slack),
+            measured.mean_squared_error * (1 + slack),
+            measured.r2_score * (1 - slack)};
 }
 }
 
@@ -97,6 +113,66 @@ go_bandit([]() {
                cfg->insert("l1-regularization", 1e-5);
                check_cv(*cfg, dataset, {3.90, 2.69, 33.08, 0.60});
            });
+
+        it("should create an SGD regressor trained on several threads",
+           [&]() {
+               auto cfg = cpptoml::make_table();
+               cfg->insert("method", "sgd");
+               cfg->insert("loss", "least-squares");
+               auto sequential
+                   = check_cv(*cfg, dataset, {3.91, 2.65, 32.85, 0.61});
+
+               // Hogwild's unsynchronized updates may cost a little
+               // accuracy, but it should converge to about the same model
+               cfg->insert<int64_t>("num-threads", 2);
+               check_cv(*cfg, dataset, within(sequential, 0.1));
+           });
+
+        it("should create an SGD regressor trained on mini-batches", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", "sgd");
+            cfg->insert("loss", "least-squares");
+            auto sequential
+                = check_cv(*cfg, dataset, {3.91, 2.65, 32.85, 0.61});
+
+            // averaging the gradients over a batch should converge to
+            // about the same model as updating on every instance
+            cfg->insert<int64_t>("batch-size", 8);
+            cfg->insert<int64_t>("num-threads", 2);
+            cfg->insert<int64_t>("max-iter", 50);
+            check_cv(*cfg, dataset, within(sequential, 0.1));
+            cfg->insert("optimizer", "adam");
+            check_cv(*cfg, dataset, within(sequential, 0.1));
+        });
+
+        it("should reject invalid training options", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert<int64_t>("batch-size", -1);
+            AssertThrows(learn::sgd_exception,
+                         learn::make_training_options(*cfg));
+
+            cfg->insert<int64_t>("batch-size", 8);
+            cfg->insert("optimizer", "rmsprop");
+            AssertThrows(learn::sgd_exception,
+                         learn::make_training_options(*cfg));
+        });
+
+        it("should default the learning rate by optimizer", [&]() {
+            using learn::sgd_model;
+            auto cfg = cpptoml::make_table();
+            cfg->insert<int64_t>("batch-size", 8);
+            auto rate = [&]() {
+                auto training = learn::make_training_options(*cfg);
+                return learn::make_model_options(*cfg, training).learning_rate;
+            };
+            AssertThat(rate(), Equals(sgd_model::default_learning_rate));
+
+            cfg->insert("optimizer", "adam");
+            AssertThat(rate(), Equals(sgd_model::default_adam_learning_rate));
+
+            cfg->insert("learning-rate", 0.1);
+            AssertThat(rate(), Equals(0.1));
+        });
     });
 
     f_idx = nullptr;
@@ -0,0 +1,145 @@
+/**
+ * @file similarity_join_test.cpp
+ * @author agent
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/similarity_join.h"
+#include "meta/io/filesystem.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+using vector_type = std::unordered_map<term_id, double>;
+
+std::vector<vector_type> raw_vectors(index::forward_index& idx) {
+    std::vector<vector_type> vecs(idx.num_docs());
+    for (doc_id d_id{0}; d_id < idx.num_docs(); ++d_id) {
+        double norm = 0;
+        for (const auto& count : *idx.stream_for(d_id)) {
+            vecs[d_id][count.first] = count.second;
+            norm += count.second * count.second;
+        }
+        norm = std::sqrt(norm);
+        for (auto& weight : vecs[d_id])
+            weight.second /= norm;
+    }
+    return vecs;
+}
+
+double cosine(const vector_type& a, const vector_type& b) {
+    double dot = 0;
+    for (const auto& weight : a) {
+        auto it = b.find(weight.first);
+        if (it != b.end())
+            dot += weight.second * it->second;
+    }
+    return dot;
+}
+
+void check_join(index::forward_index& idx, double threshold, uint64_t k) {
+    index::similarity_join_options options;
+    options.weights = index::similarity_join_options::weighting::RAW;
+    options.threshold = threshold;
+    options.k = k;
+    options.num_threads = 2;
+    auto neighbors = index::similarity_join(idx, options);
+    AssertThat(neighbors.size(), Equals(idx.num_docs()));
+
+    auto vecs = raw_vectors(idx);
+    for (doc_id x{0}; x < idx.num_docs(); ++x) {
+        std::vector<std::pair<double, doc_id>> expected;
+        for (doc_id y{0}; y < idx.num_docs(); ++y) {
+            if (y == x)
+                continue;
+            auto score = cosine(vecs[x], vecs[y]);
+            if (score >= threshold)
+                expected.emplace_back(score, y);
+        }
+
+        std::sort(expected.begin(), expected.end(),
+                  [](const std::pair<double, doc_id>& a,
+                     const std::pair<double, doc_id>& b) {
+                      return a.first > b.first;
+                  });
+        AssertThat(neighbors[x].size(),
+                   Equals(std::min<uint64_t>(expected.size(), k)));
+        for (uint64_t i = 0; i < neighbors[x].size(); ++i) {
+            AssertThat(neighbors[x][i].score,
+                       EqualsWithDelta(expected[i].first, 1e-4));
+            AssertThat(cosine(vecs[x], vecs[neighbors[x][i].d_id]),
+                       EqualsWithDelta(neighbors[x][i].score, 1e-4));
+        }
+    }
+}
+}
+
+go_bandit([]() {
+
+    describe("[similarity-join]", []() {
+
+        filesystem::remove_all("ceeaus");
+        auto cfg = tests::create_config("line");
+        auto idx = index::make_index<index::forward_index>(*cfg);
+
+        it("should find every pair above a high threshold",
+           [&]() { check_join(*idx, 0.8, 5); });
+
+        it("should find every pair above a low threshold",
+           [&]() { check_join(*idx, 0.3, 10); });
+
+        it("should order neighbors by score, then by id", [&]() {
+            index::similarity_join_options options;
+            options.threshold = 0.2;
+            auto neighbors = index::similarity_join(*idx, options);
+            for (const auto& list : neighbors) {
+                for (uint64_t i = 1; i < list.size(); ++i) {
+                    AssertThat(list[i - 1].score,
+                               IsGreaterThanOrEqualTo(list[i].score));
+                    if (list[i - 1].score == list[i].score)
+                        AssertThat(list[i - 1].d_id, IsLessThan(list[i].d_id));
+                }
+            }
+        });
+
+        it("should be the same with any number of threads", [&]() {
+            index::similarity_join_options options;
+            options.weights = index::similarity_join_options::weighting::BM25;
+            options.threshold = 0.4;
+            options.num_threads = 1;
+            auto serial = index::similarity_join(*idx, options);
+            options.num_threads = 4;
+            auto parallel = index::similarity_join(*idx, options);
+            AssertThat(parallel.size(), Equals(serial.size()));
+            for (uint64_t i = 0; i < serial.size(); ++i) {
+                AssertThat(parallel[i].size(), Equals(serial[i].size()));
+                for (uint64_t j = 0; j < serial[i].size(); ++j) {
+                    AssertThat(parallel[i][j].d_id, Equals(serial[i][j].d_id));
+                    AssertThat(parallel[i][j].score,
+                               Equals(serial[i][j].score));
+                }
+            }
+        });
+
+        it("should reject invalid thresholds", [&]() {
+            index::similarity_join_options options;
+            options.threshold = 0;
+            AssertThrows(index::similarity_join_exception,
+                         index::similarity_join(*idx, options));
+            options.threshold = 1.5;
+            AssertThrows(index::similarity_join_exception,
+                         index::similarity_join(*idx, options));
+        });
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+});
@@ -8,6 +8,7 @@
 #include <fstream>
 
 #include "bandit/bandit.h"
+#include "cpptoml.h"
 #include "meta/index/string_list.h"
 #include "meta/index/string_list_writer.h"
 #include "meta/io/binary.h"
@@ -95,5 +96,88 @@ go_bandit([]() {
             AssertThat(list.at(4), Equals("dog"));
             AssertThat(list.at(3), Equals("a no good very dead ex-parrot"));
         });
+
+        it("should read front-coded strings", [&]() {
+            file_guard f{"meta-tmp-string-list.bin"};
+            file_guard fi{"meta-tmp-string-list.bin_index"};
+            file_guard ff{"meta-tmp-string-list.bin_fc"};
+            using namespace index;
+
+            std::vector<std::string> paths;
+            for (uint64_t i = 0; i < 1000; ++i) {
+                auto site = i % 7 == 0 ? "http://www.example.com/"
+                                       : "http://news.example.org/";
+                paths.push_back(site + std::to_string(i / 10) + "/doc-"
+                                + std::to_string(i) + ".html");
+            }
+            paths[500] = "";
+            paths[501] = "unrelated";
+
+            auto config = cpptoml::make_table();
+            config->insert("front-coding", true);
+            config->insert("front-coding-block-size", int64_t{8});
+            config->insert("prefix-dictionary", true);
+            {
+                string_list_writer writer{"meta-tmp-string-list.bin",
+                                          paths.size(), *config};
+                // insert out of order to exercise buffering
+                for (uint64_t i = 0; i < paths.size(); i += 2)
+                    writer.insert(i + 1, paths[i + 1]);
+                for (uint64_t i = 0; i < paths.size(); i += 2)
+                    writer.insert(i, paths[i]);
+            }
+
+            string_list list{"meta-tmp-string-list.bin"};
+            AssertThat(list.size(), Equals(paths.size()));
+            AssertThat(list.block_size(), Equals(8ul));
+            for (uint64_t i = 0; i < paths.size(); i += 37)
+                AssertThat(list.decode_at(i), Equals(paths[i]));
+            AssertThat(list.decode_at(999), Equals(paths[999]));
+            AssertThrows(string_list_exception, list.at(0));
+
+            uint64_t idx = 0;
+            for (const auto& str : list)
+                AssertThat(str, Equals(paths[idx++]));
+            AssertThat(idx, Equals(paths.size()));
+
+            // the front-coded file is much smaller than the strings
+            uint64_t total = 0;
+            for (const auto& str : paths)
+                total += str.size() + 1;
+            AssertThat(filesystem::file_size("meta-tmp-string-list.bin"),
+                       IsLessThan(total / 2));
+        });
+
+        it("should read verbatim strings written over a front-coded list",
+           [&]() {
+               file_guard f{"meta-tmp-string-list.bin"};
+               file_guard fi{"meta-tmp-string-list.bin_index"};
+               file_guard ff{"meta-tmp-string-list.bin_fc"};
+               using namespace index;
+
+               auto config = cpptoml::make_table();
+               config->insert("front-coding", true);
+               config->insert("front-coding-block-size", int64_t{2});
+               {
+                   string_list_writer writer{"meta-tmp-string-list.bin", 3,
+                                             *config};
+                   writer.insert(0, "prefix-one");
+                   writer.insert(1, "prefix-two");
+                   writer.insert(2, "prefix-three");
+               }
+               {
+                   string_list_writer writer{"meta-tmp-string-list.bin", 3};
+                   writer.insert(0, "cat");
+                   writer.insert(1, "dog");
+                   writer.insert(2, "ex-parrot");
+               }
+
+               string_list list{"meta-tmp-string-list.bin"};
+               AssertThat(list.block_size(), Equals(0ul));
+               AssertThat(list.size(), Equals(3ul));
+               AssertThat(list.at(0), Equals("cat"));
+               AssertThat(list.at(1), Equals("dog"));
+               AssertThat(list.decode_at(2), Equals("ex-parrot"));
+           });
     });
 });
@@ -0,0 +1,105 @@
+/**
+ * @file synthetic_corpus_test.cpp
+ * @author agent
+ */
+
+#include <fstream>
+
+#include "bandit/bandit.h"
+#include "cpptoml.h"
+#include "meta/corpus/corpus_factory.h"
+#include "meta/corpus/synthetic_corpus.h"
+#include "meta/io/filesystem.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+corpus::synthetic_corpus::options make_options(uint64_t threads) {
+    corpus::synthetic_corpus::options opts;
+    opts.num_docs = 500;
+    opts.threads = threads;
+    opts.vocab_size = 2000;
+    opts.length_mean = 50;
+    opts.num_labels = 3;
+    opts.num_queries = 10;
+    return opts;
+}
+
+std::string read_file(const std::string& filename) {
+    std::ifstream file{filename};
+    return std::string{std::istreambuf_iterator<char>{file},
+                       std::istreambuf_iterator<char>{}};
+}
+}
+
+go_bandit([]() {
+
+    describe("[synthetic-corpus]", []() {
+        const std::string prefix = "synthetic-corpus-test";
+        filesystem::remove_all(prefix);
+
+        it("should generate documents deterministically", []() {
+            corpus::synthetic_corpus gen{make_options(1)};
+            auto first = gen.generate(42);
+            auto second = gen.generate(42);
+            AssertThat(first.words, Equals(second.words));
+            AssertThat(first.label, Equals(second.label));
+            AssertThat(gen.text(first), Equals(gen.text(second)));
+
+            auto opts = make_options(1);
+            AssertThat(first.words.size(),
+                       IsGreaterThanOrEqualTo(opts.min_length));
+            AssertThat(first.words.size(),
+                       IsLessThanOrEqualTo(opts.max_length));
+            for (const auto& word : first.words)
+                AssertThat(word, IsLessThan(opts.vocab_size));
+        });
+
+        it("should write the same corpus regardless of threads", [&]() {
+            corpus::synthetic_corpus{make_options(1)}.write(prefix, "one");
+            corpus::synthetic_corpus{make_options(4)}.write(prefix, "four");
+            for (const auto& ext : {".dat", ".dat.labels", "-queries.txt",
+                                    "-qrels.txt"}) {
+                AssertThat(read_file(prefix + "/one/one" + ext),
+                           Equals(read_file(prefix + "/four/four" + ext)));
+            }
+        });
+
+        it("should write a readable line corpus", [&]() {
+            auto config = cpptoml::make_table();
+            config->insert("prefix", prefix);
+            config->insert("dataset", "one");
+            config->insert("corpus", "line.toml");
+
+            corpus::synthetic_corpus gen{make_options(1)};
+            auto docs = corpus::make_corpus(*config);
+            AssertThat(docs->size(), Equals(500ul));
+            for (uint64_t id = 0; id < 10; ++id) {
+                auto doc = docs->next();
+                auto expected = gen.generate(id);
+                AssertThat(doc.label(),
+                           Equals(class_label{gen.label(expected)}));
+                AssertThat(doc.content(), Equals(gen.text(expected)));
+            }
+        });
+
+        it("should judge each query relevant to its source document", [&]() {
+            std::ifstream qrels{prefix + "/one/one-qrels.txt"};
+            std::vector<uint64_t> sources(10, 0);
+            uint64_t qid;
+            uint64_t d_id;
+            int relevance;
+            while (qrels >> qid >> d_id >> relevance) {
+                AssertThat(qid, IsLessThan(10ul));
+                if (relevance == 2)
+                    ++sources[qid];
+            }
+            for (const auto& count : sources)
+                AssertThat(count, Equals(1ul));
+        });
+
+        filesystem::remove_all(prefix);
+    });
+});
@@ -100,6 +100,38 @@ go_bandit([]() {
             check_expected(*norm, expected);
         });
 
+        it("should transform ASCII tokens when the rule changes ASCII",
+           [&]() {
+               auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+               auto norm = make_unique<filters::icu_filter>(std::move(tok),
+                                                            "Any-Upper");
+               norm->set_content("hello wörld");
+               std::vector<std::string> expected = {"HELLO", " ", "WÖRLD"};
+               check_expected(*norm, expected);
+           });
+
+        it("should pass ASCII tokens through when the rule keeps ASCII",
+           [&]() {
+               auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+               auto norm = make_unique<filters::icu_filter>(
+                   std::move(tok), "Any-Latin; Latin-ASCII");
+               norm->set_content("It's e.g. <s> a1b2 café naïve");
+               std::vector<std::string> expected
+                   = {"It's", " ", "e.g.", " ",    "<s>", " ",
+                      "a1b2", " ", "cafe", " ",   "naive"};
+               check_expected(*norm, expected);
+           });
+
+        it("should transform repeated tokens the same way", [&]() {
+            auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+            auto norm = make_unique<filters::icu_filter>(std::move(tok),
+                                                         "Greek-Latin");
+            norm->set_content("λόγος λόγος λόγος");
+            std::vector<std::string> expected
+                = {"lógos", " ", "lógos", " ", "lógos"};
+            check_expected(*norm, expected);
+        });
+
         it("should fail to create transliterator on bad input", [&]() {
             auto tok = make_unique<tokenizers::whitespace_tokenizer>();
             AssertThrows(std::runtime_error, make_unique<filters::icu_filter>(
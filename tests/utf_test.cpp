@@ -0,0 +1,99 @@
+/**
+ * @file utf_test.cpp
+ * @author agent
+ */
+
+#include <string>
+
+#include "bandit/bandit.h"
+#include "meta/utf/transformer.h"
+#include "meta/utf/utf.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+    describe("[utf] is_ascii", []() {
+        it("should accept the empty string",
+           []() { AssertThat(utf::is_ascii(""), IsTrue()); });
+
+        it("should accept every ASCII byte", []() {
+            std::string all;
+            for (int c = 1; c < 0x80; ++c)
+                all += static_cast<char>(c);
+            AssertThat(utf::is_ascii(all), IsTrue());
+        });
+
+        it("should reject a high-bit byte at either end", []() {
+            AssertThat(utf::is_ascii("\x80hello"), IsFalse());
+            AssertThat(utf::is_ascii("hello\x80"), IsFalse());
+            AssertThat(utf::is_ascii("hello\xff"), IsFalse());
+            AssertThat(utf::is_ascii("caf\xc3\xa9"), IsFalse());
+        });
+    });
+
+    describe("[utf] ASCII fast paths", []() {
+        it("should change case of ASCII and mixed strings", []() {
+            AssertThat(utf::tolower("HeLLo, World!"), Equals("hello, world!"));
+            AssertThat(utf::toupper("HeLLo, World!"), Equals("HELLO, WORLD!"));
+            AssertThat(utf::foldcase("HeLLo"), Equals("hello"));
+            AssertThat(utf::tolower("CAFÉ Au LAIT"), Equals("café au lait"));
+            AssertThat(utf::toupper("café au lait"), Equals("CAFÉ AU LAIT"));
+        });
+
+        it("should count code points in ASCII and mixed strings", []() {
+            AssertThat(utf::length(""), Equals(0u));
+            AssertThat(utf::length("hello"), Equals(5u));
+            AssertThat(utf::length("héllo"), Equals(5u));
+        });
+
+        it("should remove code points from ASCII and mixed strings", []() {
+            auto is_vowel = [](uint32_t c) {
+                return c == 'a' || c == 'e' || c == 'o' || c == 0xe9;
+            };
+            AssertThat(utf::remove_if("hello world", is_vowel),
+                       Equals("hll wrld"));
+            AssertThat(utf::remove_if("héllo wörld", is_vowel),
+                       Equals("hll wörld"));
+        });
+
+        it("should map code points in ASCII and mixed strings", []() {
+            auto accent = [](uint32_t c) { return c == 'e' ? 0xe9u : c; };
+            AssertThat(utf::transform("ecole", accent), Equals("écolé"));
+            AssertThat(utf::transform("ecolé", accent), Equals("écolé"));
+        });
+    });
+
+    describe("[utf] transformer", []() {
+        it("should transform ASCII when the rule changes it", []() {
+            utf::transformer upper{"Any-Upper"};
+            AssertThat(upper("hello"), Equals("HELLO"));
+            AssertThat(upper("it's e.g. <s>"), Equals("IT'S E.G. <S>"));
+        });
+
+        it("should leave ASCII alone when the rule keeps it", []() {
+            utf::transformer ascii{"Any-Latin; Latin-ASCII"};
+            AssertThat(ascii(""), Equals(""));
+            AssertThat(ascii("hello, world!"), Equals("hello, world!"));
+        });
+
+        it("should transform mixed ASCII and non-ASCII strings", []() {
+            utf::transformer ascii{"Any-Latin; Latin-ASCII"};
+            AssertThat(ascii("café au lait"), Equals("cafe au lait"));
+            utf::transformer upper{"Any-Upper"};
+            AssertThat(upper("café au lait"), Equals("CAFÉ AU LAIT"));
+        });
+
+        it("should give the same result for repeated strings", []() {
+            utf::transformer ascii{"Any-Latin; Latin-ASCII"};
+            auto first = ascii("naïve café");
+            AssertThat(first, Equals("naive cafe"));
+            for (int i = 0; i < 3; ++i)
+                AssertThat(ascii("naïve café"), Equals(first));
+
+            // a copy starts with an empty cache, and must agree
+            auto copy = ascii;
+            AssertThat(copy("naïve café"), Equals(first));
+        });
+    });
+});